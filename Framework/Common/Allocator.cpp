@@ -1,5 +1,7 @@
 #include "Allocator.h"
+#include "VirtualMemory.h"
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
 
 #ifndef ALIGN
@@ -9,14 +11,17 @@
 namespace Corona
 {
     Allocator::Allocator()
-        : m_pPageList(nullptr), m_pFreeList(nullptr), 
-        m_szDataSize(0), m_szPageSize(0), 
-        m_szAlignmentSize(0), m_szBlockSize(0), m_nBlockPerPage(0) 
+        : m_pPartialPageList(nullptr), m_pFullPageList(nullptr), m_pEmptyPageList(nullptr),
+        m_pRegions(nullptr), m_pRemoteFreeList(nullptr),
+        m_szDataSize(0), m_szPageSize(0), m_szPageHeaderSize(sizeof(PageHeader)),
+        m_szAlignmentSize(0), m_szBlockSize(0), m_nBlockPerPage(0),
+        m_nPages(0), m_nBlocks(0), m_nFreeblocks(0), m_nEmptyPages(0), m_nPeakUsedBlocks(0)
     {
     }
 
     Allocator::Allocator(size_t data_size, size_t page_size, size_t alignment)
-        : m_pPageList(nullptr), m_pFreeList(nullptr)
+        : m_pPartialPageList(nullptr), m_pFullPageList(nullptr), m_pEmptyPageList(nullptr),
+        m_pRegions(nullptr), m_pRemoteFreeList(nullptr)
     {
         Reset(data_size, page_size, alignment);
     }
@@ -46,94 +51,294 @@ namespace Corona
 
         m_szAlignmentSize = m_szBlockSize - minimal_size;
 
-        m_nBlockPerPage = uint32_t((m_szPageSize - sizeof(PageHeader)) / m_szBlockSize);
+        // pages are aligned to their size (which is 2^n as well) and the page header
+        // is padded, so every block of the page is naturally aligned
+#if defined(_DEBUG)
+        assert(page_size >= alignment && ((page_size & (page_size-1))) == 0);
+#endif
+        m_szPageHeaderSize = ALIGN(sizeof(PageHeader), alignment);
+
+        m_nBlockPerPage = uint32_t((m_szPageSize - m_szPageHeaderSize) / m_szBlockSize);
     }
 
-    void* Allocator::Allocate()
+    PageHeader* Allocator::AllocatePage()
     {
-        if(!m_pFreeList)
+        static_assert(kPagesPerRegion == 32, "the committed mask has a bit per page of a region");
+        static const uint32_t kFullRegion = ~0u;
+
+        // the first region with an uncommitted page, or a new one
+        PageRegion* pRegion = m_pRegions;
+        while (pRegion && pRegion->nCommittedMask == kFullRegion) pRegion = pRegion->pNext;
+        if (!pRegion)
         {
-            // allocate a new page
-            PageHeader* pNewPage = reinterpret_cast<PageHeader*>(new uint8_t[m_szPageSize]);
-            ++m_nPages;
-            m_nBlocks += m_nBlockPerPage;
-            m_nFreeblocks += m_nBlockPerPage;
+            void* pBase = ReserveVirtualMemory(m_szPageSize * kPagesPerRegion, m_szPageSize);
+            if (!pBase) return nullptr;
+
+            pRegion = reinterpret_cast<PageRegion*>(malloc(sizeof(PageRegion)));
+            if (!pRegion)
+            {
+                ReleaseVirtualMemory(pBase, m_szPageSize * kPagesPerRegion);
+                return nullptr;
+            }
+
+            pRegion->pBase = reinterpret_cast<uint8_t*>(pBase);
+            pRegion->nCommittedMask = 0;
+            pRegion->pNext = m_pRegions;
+            m_pRegions = pRegion;
+        }
+
+        uint32_t slot = 0;
+        while (pRegion->nCommittedMask & (1u << slot)) slot++;
+
+        PageHeader* pNewPage = reinterpret_cast<PageHeader*>(pRegion->pBase + slot * m_szPageSize);
+        if (!CommitVirtualMemory(pNewPage, m_szPageSize)) return nullptr;
+        pRegion->nCommittedMask |= 1u << slot;
+
+        ++m_nPages;
+        m_nBlocks += m_nBlockPerPage;
+        m_nFreeblocks += m_nBlockPerPage;
 
 #if defined(_DEBUG)
-            FillFreePage(pNewPage);
+        FillFreePage(pNewPage);
 #endif
 
-            // Add the new page to the head of pagelist
-            if(m_pPageList)
-            {
-                pNewPage->pNext = m_pPageList;
-            }
+        BlockHeader* pBlock = FirstBlock(pNewPage);
+        // link each block in the page (the last one terminates the chain)
+        for(uint32_t i = 0; i < m_nBlockPerPage - 1; i++)
+        {
+            pBlock->pNext = NextBlock(pBlock);
+            pBlock = NextBlock(pBlock);
+        }
+        pBlock->pNext = nullptr;
 
-            m_pPageList = pNewPage;
+        pNewPage->pFreeList = FirstBlock(pNewPage);
+        pNewPage->nFreeBlocks = m_nBlockPerPage;
 
-            BlockHeader* pBlock = pNewPage->Blocks();
-            // link each block in the page
-            for(uint32_t i = 0; i < m_nBlockPerPage; i++)
-            {
-                pBlock->pNext = NextBlock(pBlock);
-                pBlock = NextBlock(pBlock);
-            }
-            pBlock->pNext = nullptr;
+        // a new page is empty until the first block is popped
+        LinkPage(m_pEmptyPageList, pNewPage);
+        ++m_nEmptyPages;
+
+        return pNewPage;
+    }
+
+    void Allocator::ReleasePage(PageHeader* pPage)
+    {
+        uint8_t* p = reinterpret_cast<uint8_t*>(pPage);
+        size_t region_size = m_szPageSize * kPagesPerRegion;
 
-            m_pFreeList = pNewPage->Blocks();
+        PageRegion** ppRegion = &m_pRegions;
+        while (*ppRegion && (p < (*ppRegion)->pBase || p >= (*ppRegion)->pBase + region_size))
+        {
+            ppRegion = &(*ppRegion)->pNext;
+        }
+        assert(*ppRegion);
+
+        PageRegion* pRegion = *ppRegion;
+        pRegion->nCommittedMask &= ~(1u << uint32_t((p - pRegion->pBase) / m_szPageSize));
+        if (pRegion->nCommittedMask)
+        {
+            DecommitVirtualMemory(pPage, m_szPageSize);
+            return;
         }
 
-        BlockHeader* freeBlock = m_pFreeList;
-        m_pFreeList = m_pFreeList->pNext;
+        *ppRegion = pRegion->pNext;
+        ReleaseVirtualMemory(pRegion->pBase, region_size);
+        free(pRegion);
+    }
+
+    BlockHeader* Allocator::PopBlock()
+    {
+        PageHeader* pPage = m_pPartialPageList;
+        if(!pPage)
+        {
+            // reuse an empty page before asking the OS for a new one
+            pPage = m_pEmptyPageList ? m_pEmptyPageList : AllocatePage();
+            if(!pPage) return nullptr;
+
+            UnlinkPage(m_pEmptyPageList, pPage);
+            --m_nEmptyPages;
+            LinkPage(m_pPartialPageList, pPage);
+        }
+
+        BlockHeader* freeBlock = pPage->pFreeList;
+        pPage->pFreeList = freeBlock->pNext;
+        --pPage->nFreeBlocks;
         --m_nFreeblocks;
 
+        if(!pPage->nFreeBlocks)
+        {
+            UnlinkPage(m_pPartialPageList, pPage);
+            LinkPage(m_pFullPageList, pPage);
+        }
+
+        uint32_t used = m_nBlocks - m_nFreeblocks;
+        if(used > m_nPeakUsedBlocks) m_nPeakUsedBlocks = used;
+
 #if defined(_DEBUG)
         FillAllocatedBlock(freeBlock);
 #endif
 
-        return reinterpret_cast<void*>(freeBlock);
+        return freeBlock;
     }
 
-    void Allocator::Free(void* p)
+    void Allocator::PushBlock(BlockHeader* pBlock)
     {
-        BlockHeader* block = reinterpret_cast<BlockHeader*>(p);
-
 #if defined(_DEBUG)
-        FillFreeBlock(block);
+        FillFreeBlock(pBlock);
 #endif
 
-        block->pNext = m_pFreeList;
-        m_pFreeList = block;
+        PageHeader* pPage = PageOf(pBlock);
+        if(!pPage->nFreeBlocks)
+        {
+            UnlinkPage(m_pFullPageList, pPage);
+            LinkPage(m_pPartialPageList, pPage);
+        }
+
+        pBlock->pNext = pPage->pFreeList;
+        pPage->pFreeList = pBlock;
+        ++pPage->nFreeBlocks;
         ++m_nFreeblocks;
+
+        if(pPage->nFreeBlocks == m_nBlockPerPage)
+        {
+            // keep it around until the next trim, it may well be needed again soon
+            UnlinkPage(m_pPartialPageList, pPage);
+            LinkPage(m_pEmptyPageList, pPage);
+            ++m_nEmptyPages;
+        }
+    }
+
+    void* Allocator::Allocate()
+    {
+        if(!m_pPartialPageList)
+        {
+            ReclaimRemoteFrees();
+        }
+
+        return reinterpret_cast<void*>(PopBlock());
+    }
+
+    uint32_t Allocator::AllocateBatch(BlockHeader*& pChain, uint32_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if(!m_pPartialPageList)
+        {
+            ReclaimRemoteFrees();
+        }
+
+        pChain = nullptr;
+        uint32_t n = 0;
+        while(n < count)
+        {
+            // hand out what we have before growing by another page
+            if(n > 0 && !m_pPartialPageList && !m_pEmptyPageList) break;
+
+            BlockHeader* freeBlock = PopBlock();
+            if(!freeBlock) break;
+
+            freeBlock->pNext = pChain;
+            pChain = freeBlock;
+            ++n;
+        }
+
+        return n;
+    }
+
+    void Allocator::FreeRemote(BlockHeader* pHead, BlockHeader* pTail)
+    {
+        // lock-free push of the whole chain, the consumer always takes the entire
+        // list with an exchange so there is no ABA hazard here
+        BlockHeader* pOldHead = m_pRemoteFreeList.load(std::memory_order_relaxed);
+        do
+        {
+            pTail->pNext = pOldHead;
+        } while(!m_pRemoteFreeList.compare_exchange_weak(pOldHead, pHead,
+                    std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void Allocator::FreeRemote(void* p)
+    {
+        BlockHeader* block = reinterpret_cast<BlockHeader*>(p);
+        FreeRemote(block, block);
+    }
+
+    void Allocator::ReclaimRemoteFrees()
+    {
+        BlockHeader* pBlock = m_pRemoteFreeList.exchange(nullptr, std::memory_order_acquire);
+        while(pBlock)
+        {
+            BlockHeader* pNext = pBlock->pNext;
+            PushBlock(pBlock);
+            pBlock = pNext;
+        }
+    }
+
+    void Allocator::Free(void* p)
+    {
+        PushBlock(reinterpret_cast<BlockHeader*>(p));
+    }
+
+    size_t Allocator::Trim(bool force)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        ReclaimRemoteFrees();
+
+        uint32_t used = m_nBlocks - m_nFreeblocks;
+        uint32_t keep_blocks = (force || m_nPeakUsedBlocks < used) ? used : m_nPeakUsedBlocks;
+        uint32_t keep_pages = m_nBlockPerPage ? (keep_blocks + m_nBlockPerPage - 1) / m_nBlockPerPage : 0;
+
+        size_t released = 0;
+        while(m_pEmptyPageList && m_nPages > keep_pages)
+        {
+            PageHeader* pPage = m_pEmptyPageList;
+            UnlinkPage(m_pEmptyPageList, pPage);
+            --m_nEmptyPages;
+
+            --m_nPages;
+            m_nBlocks -= m_nBlockPerPage;
+            m_nFreeblocks -= m_nBlockPerPage;
+
+            ReleasePage(pPage);
+            released += m_szPageSize;
+        }
+
+        // start a new observation window
+        m_nPeakUsedBlocks = used;
+
+        return released;
     }
 
     void Allocator::FreeAll()
     {
-        PageHeader* pPage = m_pPageList;
-        while(pPage)
+        // every page lives in a region
+        while(m_pRegions)
         {
-            PageHeader* _p = pPage;
-            pPage = pPage->pNext;
+            PageRegion* pRegion = m_pRegions;
+            m_pRegions = pRegion->pNext;
 
-            delete[] reinterpret_cast<uint8_t*>(_p);
+            ReleaseVirtualMemory(pRegion->pBase, m_szPageSize * kPagesPerRegion);
+            free(pRegion);
         }
 
-        m_pPageList = nullptr;
-        m_pFreeList = nullptr;
+        m_pPartialPageList = nullptr;
+        m_pFullPageList = nullptr;
+        m_pEmptyPageList = nullptr;
+        m_pRemoteFreeList.store(nullptr, std::memory_order_relaxed);
 
         m_nPages = 0;
         m_nBlocks = 0;
         m_nFreeblocks = 0;
+        m_nEmptyPages = 0;
+        m_nPeakUsedBlocks = 0;
     }
 
 #if defined(_DEBUG)
     void Allocator::FillFreePage(PageHeader* pPage)
     {
-        // page header
-        pPage->pNext = nullptr;
-
         // blocks
-        BlockHeader* pBlock = pPage->Blocks();
+        BlockHeader* pBlock = FirstBlock(pPage);
         for(uint32_t i = 0; i < m_nBlockPerPage; i++)
         {
             FillFreeBlock(pBlock);
@@ -162,9 +367,35 @@ namespace Corona
     }
 #endif
 
+    BlockHeader* Allocator::FirstBlock(PageHeader* pPage)
+    {
+        return reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(pPage) + m_szPageHeaderSize);
+    }
+
     BlockHeader* Allocator::NextBlock(BlockHeader *pBlock)
     {
         return reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(pBlock) + m_szBlockSize);
     }
+
+    PageHeader* Allocator::PageOf(BlockHeader* pBlock)
+    {
+        return reinterpret_cast<PageHeader*>(reinterpret_cast<size_t>(pBlock) & ~(m_szPageSize - 1));
+    }
+
+    void Allocator::LinkPage(PageHeader*& pList, PageHeader* pPage)
+    {
+        pPage->pPrev = nullptr;
+        pPage->pNext = pList;
+        if (pList) pList->pPrev = pPage;
+        pList = pPage;
+    }
+
+    void Allocator::UnlinkPage(PageHeader*& pList, PageHeader* pPage)
+    {
+        if (pPage->pPrev) pPage->pPrev->pNext = pPage->pNext;
+        else pList = pPage->pNext;
+        if (pPage->pNext) pPage->pNext->pPrev = pPage->pPrev;
+        pPage->pNext = pPage->pPrev = nullptr;
+    }
 }
 
@@ -1,6 +1,8 @@
 #pragma once
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 
 namespace Corona
 {
@@ -10,13 +12,25 @@ namespace Corona
         BlockHeader* pNext;
     };
 
+    // pages are aligned to the page size, so the page of a block is found by masking its address
     struct PageHeader
     {
         PageHeader* pNext;
-        BlockHeader* Blocks()
-        {
-            return reinterpret_cast<BlockHeader*>(this + 1);
-        }
+        PageHeader* pPrev;
+        // free blocks of this page
+        BlockHeader* pFreeList;
+        uint32_t nFreeBlocks;
+    };
+
+    // pages are carved out of reserved regions so that a page does not cost a
+    // mapping of its own, trimmed pages are decommitted and a region is
+    // released once none of its pages is committed
+    struct PageRegion
+    {
+        PageRegion* pNext;
+        uint8_t* pBase;
+        // bit i is set while page i of the region is committed
+        uint32_t nCommittedMask;
     };
 
     class Allocator
@@ -27,6 +41,9 @@ namespace Corona
         static const uint8_t PATTERN_ALLOC = 0xFD;
         static const uint8_t PATTERN_FREE = 0xFE;
 
+        // pages reserved at a time
+        static const uint32_t kPagesPerRegion = 32;
+
         Allocator();
         Allocator(size_t data_size, size_t page_size, size_t alignment);
         ~Allocator();
@@ -35,10 +52,33 @@ namespace Corona
         void Reset(size_t data_size, size_t page_size, size_t alignment);
 
         // alloc and free blocks
+        // (not synchronized, only call these when a single thread owns the allocator)
         void* Allocate();
         void Free(void* p);
         void FreeAll();
 
+        // releases the empty pages that are not needed to hold the peak number of
+        // blocks in use since the last trim, with force only the pages holding
+        // live blocks are kept. Returns the number of bytes given back to the OS.
+        size_t Trim(bool force = false);
+
+        // thread-safe batch interface used by the per-thread caches of MemoryManager.
+        // pops up to count blocks as a linked chain, returns the number of blocks popped
+        uint32_t AllocateBatch(BlockHeader*& pChain, uint32_t count);
+        // pushes a linked chain of blocks back without taking the lock
+        void FreeRemote(BlockHeader* pHead, BlockHeader* pTail);
+        void FreeRemote(void* p);
+
+        size_t GetBlockSize() const { return m_szBlockSize; }
+        size_t GetDataSize() const { return m_szDataSize; }
+        size_t GetPageSize() const { return m_szPageSize; }
+
+        uint32_t GetPageCount() const { return m_nPages; }
+        uint32_t GetBlockCount() const { return m_nBlocks; }
+        uint32_t GetFreeBlockCount() const { return m_nFreeblocks; }
+        uint32_t GetEmptyPageCount() const { return m_nEmptyPages; }
+        uint32_t GetUsedBlockCount() const { return m_nBlocks - m_nFreeblocks; }
+
     private:
 #if defined(_DEBUG)
         // fill a free page with debug patterns
@@ -51,17 +91,54 @@ namespace Corona
         void FillAllocatedBlock(BlockHeader* pBlock);
 #endif
 
+        // gets the first block of a page (behind the padded page header)
+        BlockHeader* FirstBlock(PageHeader* pPage);
+
         // gets the next block
         BlockHeader* NextBlock(BlockHeader* pBlock);
 
-        // the page list
-        PageHeader* m_pPageList;
+        // gets the page a block belongs to
+        PageHeader* PageOf(BlockHeader* pBlock);
+
+        // allocates a new page and links its blocks into the page free list
+        PageHeader* AllocatePage();
+
+        // decommits an empty page, releasing its region when that was the last page
+        void ReleasePage(PageHeader* pPage);
+
+        // pops a block from the first page with free blocks
+        BlockHeader* PopBlock();
+
+        // pushes a block back to its page
+        void PushBlock(BlockHeader* pBlock);
+
+        static void LinkPage(PageHeader*& pList, PageHeader* pPage);
+        static void UnlinkPage(PageHeader*& pList, PageHeader* pPage);
+
+        // moves the blocks freed by other threads into the free list
+        void ReclaimRemoteFrees();
+
+        // pages with some free blocks, allocations are served from the head
+        PageHeader* m_pPartialPageList;
+
+        // pages with no free block
+        PageHeader* m_pFullPageList;
+
+        // pages with no allocated block, kept until trimmed
+        PageHeader* m_pEmptyPageList;
+
+        // reservations the pages come from
+        PageRegion* m_pRegions;
+
+        // blocks freed through FreeRemote, waiting to be reclaimed
+        std::atomic<BlockHeader*> m_pRemoteFreeList;
 
-        // the free block list
-        BlockHeader* m_pFreeList;
+        // guards the page lists in the batch interface and in Trim()
+        std::mutex m_Mutex;
 
         size_t m_szDataSize;
         size_t m_szPageSize;
+        size_t m_szPageHeaderSize;
         size_t m_szAlignmentSize;
         size_t m_szBlockSize;
         uint32_t m_nBlockPerPage;
@@ -70,9 +147,12 @@ namespace Corona
         uint32_t m_nPages;
         uint32_t m_nBlocks;
         uint32_t m_nFreeblocks;
+        uint32_t m_nEmptyPages;
+        // high-water mark of the blocks in use since the last trim
+        uint32_t m_nPeakUsedBlocks;
 
         // disable copy & assignment
         Allocator(const Allocator& clone);
         Allocator& operator=(const Allocator& rhs);
     };
-}
\ No newline at end of file
+}
@@ -1,24 +1,248 @@
 #include "AssetLoader.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include "AssetPack.h"
+#include "FileMapping.h"
+#include "IoUring.h"
+#include "VirtualMemory.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace Corona
 {
+    // "Scene\\a/./b/../c.png" -> "Scene/a/c.png", the key of the file index
+    static std::string NormalizeAssetPath(const char* name)
+    {
+        std::vector<std::string> segments;
+        std::string segment;
+
+        for (const char* p = name; ; p++)
+        {
+            if (*p == '/' || *p == '\\' || *p == '\0')
+            {
+                if (segment == "..")
+                {
+                    if (!segments.empty() && segments.back() != "..")
+                        segments.pop_back();
+                    else
+                        segments.push_back(segment);
+                }
+                else if (!segment.empty() && segment != ".")
+                {
+                    segments.push_back(segment);
+                }
+                segment.clear();
+
+                if (*p == '\0') break;
+            }
+            else
+            {
+                segment += *p;
+            }
+        }
+
+        std::string result;
+        for (auto& s : segments)
+        {
+            if (!result.empty()) result += '/';
+            result += s;
+        }
+
+        return result;
+    }
+
+    // what an AssetFilePtr points to: a file on disk or an entry of a mounted pack
+    struct AssetFile
+    {
+        FILE* fp;
+        BufferView data;
+        size_t position;
+    };
+
+    static size_t ReadAssetFile(AssetFile* file, void* dst, size_t size)
+    {
+        if (file->fp) return fread(dst, 1, size, file->fp);
+
+        size_t available = file->data.GetDataSize() - file->position;
+        if (size > available) size = available;
+        if (size) memcpy(dst, file->data.GetData() + file->position, size);
+        file->position += size;
+        return size;
+    }
+
+    typedef std::chrono::steady_clock StreamClock;
+
+    // ranges of the same file closer than this are read as one, the gap costs
+    // no more than the page it is on
+    static const size_t kStreamMergeGap = 4096;
+
+    struct AsyncReadRequest
+    {
+        AssetLoader* pLoader;
+        std::string path;
+        int32_t nPriority;
+        uint64_t nSequence;
+        AssetLoader::AsyncReadCallback callback;
+        BufferView data;
+        std::atomic<AsyncReadState> state;
+
+        // streaming reads, see AssetLoader::StreamRead()
+        bool bStreaming = false;
+        size_t szOffset = 0;
+        size_t szSize = 0;
+        StreamClock::time_point tQueued;
+        StreamClock::time_point tDeadline = StreamClock::time_point::max();
+        // the requests a merged read serves, it has no handle of its own
+        std::vector<std::shared_ptr<AsyncReadRequest>> children;
+    };
+
+    // "<scene>.prefetch", the first line tells the version of the format
+    static const char* kManifestExtension = ".prefetch";
+    static const char* kManifestHeader = "CPREFETCH 1";
+
+    // prefetched files are read behind anything asked for
+    static const int32_t kPrefetchPriority = INT32_MIN;
+
+    // fault the pages in on the I/O thread, not on the main thread that uses them
+    static void TouchPages(const BufferView& data)
+    {
+        const size_t page_size = GetVirtualPageSize();
+        volatile uint8_t sink = 0;
+        for (size_t offset = 0; offset < data.GetDataSize(); offset += page_size)
+        {
+            sink = sink + data.GetData()[offset];
+        }
+    }
+
     int AssetLoader::Initialize()
     {
+        {
+            std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+            BuildFileIndex();
+        }
+
+        if (!m_strBuildCacheDirectory.empty())
+            m_BuildCache.Open(m_strBuildCacheDirectory);
+
+        StartIoThreads();
         return 0;
     }
 
     void AssetLoader::Finalize()
     {
+        StopIoThreads();
+
+        {
+            // reads nobody picked up any more, they never complete
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+            m_QueuedReads.insert(m_QueuedReads.end(), m_StreamQueue.begin(), m_StreamQueue.end());
+            for (auto& pRequest : m_QueuedReads)
+            {
+                for (auto& pChild : pRequest->children)
+                {
+                    pChild->callback = nullptr;
+                    pChild->state = AsyncReadState::Cancelled;
+                }
+                pRequest->callback = nullptr;
+                pRequest->state = AsyncReadState::Cancelled;
+            }
+            m_QueuedReads.clear();
+            m_StreamQueue.clear();
+            for (auto& pRequest : m_FinishedReads)
+            {
+                pRequest->callback = nullptr;
+            }
+            m_FinishedReads.clear();
+            for (auto& pRequest : m_StreamCompleted)
+            {
+                pRequest->callback = nullptr;
+            }
+            m_StreamCompleted.clear();
+            m_StreamingStats.nInFlight = 0;
+        }
+        m_ReadFinished.notify_all();
+
+        m_FileWatches.clear();
+        m_FileWatcher.Finalize();
+        m_BuildCache.Close();
+
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
         m_strSearchPath.clear();
+        m_FileIndex.clear();
+        m_MissingFiles.clear();
+        m_bFileIndexValid = false;
+        m_Packs.clear();
     }
 
     void AssetLoader::Tick()
     {
+        StreamClock::time_point now = StreamClock::now();
+        if (m_tLastTick != StreamClock::time_point()) m_LastFrameTime = now - m_tLastTick;
+        m_tLastTick = now;
+
+        if (m_FileWatcher.IsWatching())
+        {
+            std::vector<std::string> changed;
+            m_FileWatcher.Poll(changed);
 
+            // the callbacks may watch and unwatch files themselves
+            std::vector<std::pair<std::string, FileChangedCallback>> calls;
+            for (auto& path : changed)
+            {
+                for (auto& watch : m_FileWatches)
+                {
+                    if (watch.second.path == path)
+                        calls.emplace_back(watch.second.name, watch.second.callback);
+                }
+            }
+
+            for (auto& call : calls)
+            {
+                call.second(call.first);
+            }
+        }
+
+        ScheduleStreamingReads();
+
+        std::vector<std::shared_ptr<AsyncReadRequest>> finished;
+        {
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+            finished.swap(m_FinishedReads);
+        }
+
+        for (auto& pRequest : finished)
+        {
+            // streaming reads wait for the decode budget
+            if (pRequest->bStreaming)
+            {
+                m_StreamCompleted.push_back(std::move(pRequest));
+                continue;
+            }
+
+            AsyncReadCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(m_ReadMutex);
+                // dropped right here, it may hold the handle of its own request
+                callback.swap(pRequest->callback);
+            }
+
+            if (callback && pRequest->state != AsyncReadState::Cancelled)
+                callback(AsyncReadHandle(pRequest));
+        }
+
+        DeliverStreamingReads();
     }
 
     bool AssetLoader::AddSearchPath(const char* path)
     {
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
         std::vector<std::string>::iterator src = m_strSearchPath.begin();
 
         // if exists, stop adding the new path.
@@ -30,16 +254,20 @@ namespace Corona
         }
 
         m_strSearchPath.push_back(path);
+        // rescanned on the next lookup, several paths are usually added in a row
+        m_bFileIndexValid = false;
         return true;
     }
 
     bool AssetLoader::RemoveSearchPath(const char* path)
     {
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
         std::vector<std::string>::iterator src = m_strSearchPath.begin();
 
         while (src != m_strSearchPath.end()) {
             if (!(*src).compare(path)) {
                 m_strSearchPath.erase(src);
+                m_bFileIndexValid = false;
                 return true;
             }
             src++;
@@ -48,71 +276,90 @@ namespace Corona
         return true;
     }
 
-    bool AssetLoader::FileExists(const char *filePath)
+    void AssetLoader::RescanFiles()
     {
-        AssetFilePtr fp = OpenFile(filePath, MY_OPEN_BINARY);
-        if (fp != nullptr) {
-            CloseFile(fp);
-            return true;
-        }
-        return false;
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+        m_bFileIndexValid = false;
     }
 
-    const std::string AssetLoader::GetFilePath(const char* name)
+    void AssetLoader::BuildFileIndex()
     {
-        FILE *fp = nullptr;
-        // loop N times up the hierarchy, testing at each level
+        m_FileIndex.clear();
+        m_MissingFiles.clear();
+
+        // the roots in the order OpenFile used to probe them: each search path and
+        // then the working directory, at up to 10 '../' levels. A file found under
+        // an earlier root hides the same relative path under later ones.
+        // "../" in front of an absolute search path, or a walk up that ends at
+        // the file system root, reaches the same directory again: scan it once
+        std::vector<std::filesystem::path> scanned;
+
         std::string upPath;
-        std::string fullPath;
-        // find path in parent hierarchy in 10 loops like '../' '../../'
-        for (int32_t i = 0; i < 10; i++) 
+        for (int32_t i = 0; i < 10; i++)
         {
-            std::vector<std::string>::iterator src = m_strSearchPath.begin();
-            bool looping = true;
-            while (looping) 
+            std::vector<std::string> roots;
+            for (auto& searchPath : m_strSearchPath)
             {
-                fullPath.assign(upPath);  // reset to current upPath.
-                if (src != m_strSearchPath.end()) 
-                {
-                    fullPath.append(*src);
-                    fullPath.append("/Asset/");
-                    src++;
-                }
-                else 
-                {
-                    fullPath.append("Asset/");
-                    looping = false;
-                }
-                fullPath.append(name);
+                roots.push_back(upPath + searchPath + "/Asset/");
+            }
+            roots.push_back(upPath + "Asset/");
 
-                fp = fopen(fullPath.c_str(), "rb");
+            for (auto& root : roots)
+            {
+                std::error_code ec;
+                if (!std::filesystem::is_directory(root, ec)) continue;
+
+                std::filesystem::path canonical = std::filesystem::canonical(root, ec);
+                if (ec || std::find(scanned.begin(), scanned.end(), canonical) != scanned.end()) continue;
+                scanned.push_back(canonical);
+
+                auto it = std::filesystem::recursive_directory_iterator(root,
+                    std::filesystem::directory_options::skip_permission_denied, ec);
+                for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+                {
+                    if (!it->is_regular_file(ec)) continue;
 
-                if (fp)
-                    return fullPath;
+                    // entries are root + relative path, the root keeps its spelling
+                    std::string fullPath = it->path().generic_string();
+                    std::string key = NormalizeAssetPath(fullPath.c_str() + root.size());
+                    m_FileIndex.emplace(std::move(key), std::move(fullPath));
+                }
             }
 
             upPath.append("../");
         }
 
-        printf("Cannot find file!");
-        return name;
+        m_bFileIndexValid = true;
+#ifdef _DEBUG
+        fprintf(stderr, "Indexed %zu asset files\n", m_FileIndex.size());
+#endif
     }
 
-    AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name, AssetOpenMode mode)
+    // "../x" leaves the roots, the scan does not see it
+    static bool IsBelowRoots(const std::string& key)
     {
-        FILE *fp = nullptr;
+        return key != ".." && key.compare(0, 3, "../") != 0;
+    }
+
+    bool AssetLoader::ProbeFile(const char* name, std::string& fullPath)
+    {
+        std::vector<std::string> searchPath;
+        {
+            std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+            searchPath = m_strSearchPath;
+        }
+
         // loop N times up the hierarchy, testing at each level
         std::string upPath;
-        std::string fullPath;
         // find path in parent hierarchy in 10 loops like '../' '../../'
         for (int32_t i = 0; i < 10; i++) 
         {
-            std::vector<std::string>::iterator src = m_strSearchPath.begin();
+            std::vector<std::string>::iterator src = searchPath.begin();
             bool looping = true;
             while (looping) 
             {
                 fullPath.assign(upPath);  // reset to current upPath.
-                if (src != m_strSearchPath.end()) 
+                if (src != searchPath.end()) 
                 {
                     fullPath.append(*src);
                     fullPath.append("/Asset/");
@@ -125,34 +372,201 @@ namespace Corona
                 }
                 fullPath.append(name);
 #ifdef _DEBUG
-                fprintf(stderr, "Trying to open %s\n", fullPath.c_str());
+                fprintf(stderr, "Probing %s\n", fullPath.c_str());
 #endif
-                switch(mode) 
-                {
-                    // TODO
-                    case MY_OPEN_TEXT:
+                std::error_code ec;
+                if (std::filesystem::is_regular_file(fullPath, ec)) return true;
+            }
+
+            upPath.append("../");
+        }
+
+        return false;
+    }
+
+    bool AssetLoader::FileExists(const char *filePath)
+    {
+        std::shared_ptr<AssetPack> pPack;
+        if (FindInPacks(filePath, pPack)) return true;
+
+        std::string fullPath;
+        return ResolveFilePath(filePath, fullPath);
+    }
+
+    bool AssetLoader::ResolveFilePath(const char* name, std::string& fullPath)
+    {
+        std::string key = NormalizeAssetPath(name);
+        {
+            std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+            if (!m_bFileIndexValid) BuildFileIndex();
+
+            auto it = m_FileIndex.find(key);
+            if (it != m_FileIndex.end())
+            {
+                fullPath = it->second;
+                return true;
+            }
+            // below the roots the scan has seen every file
+            if (IsBelowRoots(key) || m_MissingFiles.count(key)) return false;
+        }
+
+        bool found = ProbeFile(name, fullPath);
+
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+        if (found)
+            m_FileIndex[key] = fullPath;
+        else
+            m_MissingFiles.insert(key);
+        return found;
+    }
+
+    const std::string AssetLoader::GetFilePath(const char* name)
+    {
+        std::shared_ptr<AssetPack> pPack;
+        if (FindInPacks(name, pPack))
+            return name;
+
+        std::string fullPath;
+        if (ResolveFilePath(name, fullPath))
+            return fullPath;
+
+        printf("Cannot find file!");
+        return name;
+    }
+
+    AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name, AssetOpenMode mode)
+    {
+        const char* fopenMode = "rb";
+        switch(mode) 
+        {
+            // TODO
+            case MY_OPEN_TEXT:
 #ifdef UNIX
-                    fp = fopen(fullPath.c_str(), "r");
+            fopenMode = "r";
 #elif WIN32
-                    // The file has to be read as a binary to get correct character counts on Windows
-                    fp = fopen(fullPath.c_str(), "rb");
+            // The file has to be read as a binary to get correct character counts on Windows
+            fopenMode = "rb";
 #endif
-                    break;
-                    case MY_OPEN_BINARY:
-                    fp = fopen(fullPath.c_str(), "rb");
-                    break;
-                }
+            break;
+            case MY_OPEN_BINARY:
+            fopenMode = "rb";
+            break;
+        }
 
-                if (fp)
-                    return (AssetFilePtr)fp;
+        std::shared_ptr<AssetPack> pPack;
+        if (const AssetPackEntry* pEntry = FindInPacks(name, pPack))
+        {
+            TraceRead(name, 0, 0);
+            return (AssetFilePtr)new AssetFile{ nullptr, pPack->Read(*pEntry), 0 };
+        }
+
+        FILE* fp = nullptr;
+        std::string fullPath;
+        if (ResolveFilePath(name, fullPath))
+        {
+            fp = fopen(fullPath.c_str(), fopenMode);
+            if (!fp)
+            {
+                // deleted since the scan
+                std::string key = NormalizeAssetPath(name);
+                std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+                m_FileIndex.erase(key);
+                m_MissingFiles.insert(key);
             }
+        }
 
-            upPath.append("../");
+        if (fp) TraceRead(name, 0, 0);
+
+        return fp ? (AssetFilePtr)new AssetFile{ fp, BufferView(), 0 } : nullptr;
+    }
+
+    bool AssetLoader::MountPack(const char* path)
+    {
+        auto pPack = std::make_shared<AssetPack>();
+        if (!pPack->Open(path))
+        {
+            // a pack shipped below Asset/, or one written there since the scan:
+            // mounting is rare enough to walk the hierarchy for it
+            std::string fullPath;
+            if ((!ResolveFilePath(path, fullPath) && !ProbeFile(path, fullPath)) || !pPack->Open(fullPath.c_str()))
+            {
+                fprintf(stderr, "Cannot mount pack '%s'\n", path);
+                return false;
+            }
         }
 
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+        for (auto& pMounted : m_Packs)
+        {
+            if (pMounted->GetPath() == pPack->GetPath()) return true;
+        }
+        m_Packs.push_back(std::move(pPack));
+        return true;
+    }
+
+    bool AssetLoader::UnmountPack(const char* path)
+    {
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+        for (auto it = m_Packs.begin(); it != m_Packs.end(); it++)
+        {
+            // views already handed out keep their pack mapped
+            if ((*it)->GetPath() == path)
+            {
+                m_Packs.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const AssetPackEntry* AssetLoader::FindInPacks(const char* name, std::shared_ptr<AssetPack>& pPack)
+    {
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+        if (m_Packs.empty()) return nullptr;
+
+        std::string key = NormalizeAssetPath(name);
+        for (auto& pMounted : m_Packs)
+        {
+            if (const AssetPackEntry* pEntry = pMounted->Find(key.c_str()))
+            {
+                pPack = pMounted;
+                return pEntry;
+            }
+        }
         return nullptr;
     }
 
+    uint32_t AssetLoader::WatchFile(const char* name, FileChangedCallback callback)
+    {
+        // packed files do not change under us
+        std::shared_ptr<AssetPack> pPack;
+        std::string path;
+        if (FindInPacks(name, pPack) || !ResolveFilePath(name, path))
+            return 0;
+
+        if (!m_FileWatcher.Watch(path))
+            return 0;
+
+        uint32_t id = ++m_nFileWatchId;
+        m_FileWatches[id] = { name, path, std::move(callback) };
+        return id;
+    }
+
+    void AssetLoader::UnwatchFile(uint32_t id)
+    {
+        auto it = m_FileWatches.find(id);
+        if (it == m_FileWatches.end()) return;
+
+        std::string path = std::move(it->second.path);
+        m_FileWatches.erase(it);
+
+        for (auto& watch : m_FileWatches)
+        {
+            if (watch.second.path == path) return;
+        }
+        m_FileWatcher.Unwatch(path);
+    }
+
     Buffer AssetLoader::SyncOpenAndReadText(const char *filePath)
     {
 		AssetFilePtr fp = OpenFile(filePath, MY_OPEN_TEXT);
@@ -161,14 +575,15 @@ namespace Corona
 		if (fp) {
 			size_t length = GetSize(fp);
 
-			uint8_t* data = new uint8_t[length + 1];
-			length = fread(data, 1, length, static_cast<FILE*>(fp));
+			// the buffer owns memory of the memory manager, it must not be new[]-ed
+			buff = Buffer(length + 1, 4, MemoryTag::Transient);
+			uint8_t* data = buff.GetData();
+			length = ReadAssetFile(static_cast<AssetFile*>(fp), data, length);
 #ifdef _DEBUG
 			fprintf(stderr, "Read file '%s', %zu bytes\n", filePath, length);
 #endif
 
 			data[length] = '\0';
-			buff.SetData(data, length + 1);
 
 			CloseFile(fp);
 		}
@@ -187,12 +602,11 @@ namespace Corona
 		if (fp) {
 			size_t length = GetSize(fp);
 
-			uint8_t* data = new uint8_t[length];
-			fread(data, length, 1, static_cast<FILE*>(fp));
+			buff = Buffer(length, 4, MemoryTag::Transient);
+			ReadAssetFile(static_cast<AssetFile*>(fp), buff.GetData(), length);
 #ifdef _DEBUG
 			fprintf(stderr, "Read file '%s', %zu bytes\n", filePath, length);
 #endif
-			buff.SetData(data, length);
 
 			CloseFile(fp);
 		}
@@ -203,15 +617,737 @@ namespace Corona
 		return buff;
     }
 
+    BufferView AssetLoader::MapFile(const char* filePath)
+    {
+        BufferView data = MapFileUntraced(filePath);
+        if (data.GetDataSize()) TraceRead(filePath, 0, 0);
+        return data;
+    }
+
+    BufferView AssetLoader::MapFileUntraced(const char* filePath)
+    {
+        std::shared_ptr<AssetPack> pPack;
+        if (const AssetPackEntry* pEntry = FindInPacks(filePath, pPack))
+            return pPack->Read(*pEntry);
+
+        auto pMapping = std::make_shared<FileMapping>();
+        if (pMapping->Open(GetFilePath(filePath).c_str()))
+        {
+#ifdef _DEBUG
+            fprintf(stderr, "Mapped file '%s', %zu bytes\n", filePath, pMapping->GetDataSize());
+#endif
+            const uint8_t* pData = pMapping->GetData();
+            size_t size = pMapping->GetDataSize();
+            return BufferView(std::move(pMapping), pData, size);
+        }
+
+        // empty files and file systems without mapping support
+        return BufferView(SyncOpenAndReadBinary(filePath));
+    }
+
+    AsyncReadHandle AssetLoader::AsyncRead(const char* filePath, int32_t priority, AsyncReadCallback callback)
+    {
+        TraceRead(filePath, 0, 0);
+
+        auto pRequest = std::make_shared<AsyncReadRequest>();
+        pRequest->pLoader = this;
+        pRequest->path = filePath;
+        pRequest->nPriority = priority;
+        pRequest->callback = std::move(callback);
+        pRequest->state = AsyncReadState::Queued;
+
+        {
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+            pRequest->nSequence = m_nReadSequence++;
+            m_QueuedReads.push_back(pRequest);
+        }
+        m_ReadQueued.notify_one();
+
+        return AsyncReadHandle(pRequest);
+    }
+
+    AsyncReadHandle AssetLoader::StreamRead(const char* filePath, const StreamingRead& read, AsyncReadCallback callback)
+    {
+        TraceRead(filePath, read.szOffset, read.szSize);
+
+        auto pRequest = std::make_shared<AsyncReadRequest>();
+        pRequest->pLoader = this;
+        pRequest->path = filePath;
+        pRequest->nPriority = read.nPriority;
+        pRequest->callback = std::move(callback);
+        pRequest->state = AsyncReadState::Queued;
+        pRequest->bStreaming = true;
+        pRequest->szOffset = read.szOffset;
+        pRequest->szSize = read.szSize;
+        pRequest->tQueued = StreamClock::now();
+        if (read.fDeadlineMs > 0.0)
+            pRequest->tDeadline = pRequest->tQueued + std::chrono::duration_cast<StreamClock::duration>(
+                std::chrono::duration<double, std::milli>(read.fDeadlineMs));
+
+        // the rest of the file, the budget needs to know how much that is
+        if (!pRequest->szSize)
+        {
+            std::shared_ptr<AssetPack> pPack;
+            std::string fullPath;
+            size_t file_size = 0;
+            if (const AssetPackEntry* pEntry = FindInPacks(filePath, pPack))
+            {
+                file_size = static_cast<size_t>(pEntry->nSize);
+            }
+            else if (ResolveFilePath(filePath, fullPath))
+            {
+                std::error_code ec;
+                file_size = static_cast<size_t>(std::filesystem::file_size(fullPath, ec));
+                if (ec) file_size = 0;
+            }
+            pRequest->szSize = file_size > read.szOffset ? file_size - read.szOffset : 0;
+        }
+
+        std::lock_guard<std::mutex> lock(m_ReadMutex);
+        pRequest->nSequence = m_nReadSequence++;
+        m_StreamQueue.push_back(pRequest);
+
+        return AsyncReadHandle(pRequest);
+    }
+
+    void AssetLoader::SetStreamingBudget(size_t bytesPerFrame, double decodeMsPerFrame)
+    {
+        std::lock_guard<std::mutex> lock(m_ReadMutex);
+        m_szStreamBytesPerFrame = bytesPerFrame;
+        m_fStreamDecodeMsPerFrame = decodeMsPerFrame;
+    }
+
+    StreamingStats AssetLoader::GetStreamingStats()
+    {
+        std::lock_guard<std::mutex> lock(m_ReadMutex);
+        StreamingStats stats = m_StreamingStats;
+        stats.nQueued = m_StreamQueue.size();
+        stats.nCompleted = m_StreamCompleted.size();
+        stats.fAverageLatencyMs = stats.nDelivered ? m_fTotalLatencyMs / stats.nDelivered : 0.0;
+        return stats;
+    }
+
+    void AssetLoader::ScheduleStreamingReads()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+            m_StreamingStats.szBytesLastFrame = 0;
+            if (m_StreamQueue.empty()) return;
+
+            // due: waiting another frame would miss the deadline
+            StreamClock::time_point due_by = m_tLastTick + m_LastFrameTime;
+            std::stable_sort(m_StreamQueue.begin(), m_StreamQueue.end(),
+                [due_by](const std::shared_ptr<AsyncReadRequest>& a, const std::shared_ptr<AsyncReadRequest>& b) {
+                    bool a_due = a->tDeadline <= due_by;
+                    bool b_due = b->tDeadline <= due_by;
+                    if (a_due != b_due) return a_due;
+                    if (a_due && a->tDeadline != b->tDeadline) return a->tDeadline < b->tDeadline;
+                    if (a->nPriority != b->nPriority) return a->nPriority > b->nPriority;
+                    return a->nSequence < b->nSequence;
+                });
+
+            size_t count = 0;
+            size_t bytes = 0;
+            for (; count < m_StreamQueue.size(); count++)
+            {
+                const AsyncReadRequest& request = *m_StreamQueue[count];
+                bool due = request.tDeadline <= due_by;
+                if (!due && count > 0 && m_szStreamBytesPerFrame && bytes + request.szSize > m_szStreamBytesPerFrame) break;
+                bytes += request.szSize;
+            }
+
+            std::vector<std::shared_ptr<AsyncReadRequest>> reads(m_StreamQueue.begin(), m_StreamQueue.begin() + count);
+            m_StreamQueue.erase(m_StreamQueue.begin(), m_StreamQueue.begin() + count);
+            IssueStreamingReads(reads);
+            m_StreamingStats.szBytesLastFrame = bytes;
+        }
+        m_ReadQueued.notify_all();
+    }
+
+    void AssetLoader::IssueStreamingReads(std::vector<std::shared_ptr<AsyncReadRequest>>& reads)
+    {
+        std::sort(reads.begin(), reads.end(),
+            [](const std::shared_ptr<AsyncReadRequest>& a, const std::shared_ptr<AsyncReadRequest>& b) {
+                if (a->path != b->path) return a->path < b->path;
+                return a->szOffset < b->szOffset;
+            });
+
+        for (size_t first = 0; first < reads.size();)
+        {
+            // neighbouring ranges of the same file
+            size_t last = first + 1;
+            size_t end = reads[first]->szOffset + reads[first]->szSize;
+            while (last < reads.size() && reads[last]->path == reads[first]->path && reads[last]->szOffset <= end + kStreamMergeGap)
+            {
+                end = std::max(end, reads[last]->szOffset + reads[last]->szSize);
+                last++;
+            }
+
+            m_StreamingStats.nIssuedReads++;
+            m_StreamingStats.nInFlight += last - first;
+
+            if (last - first == 1)
+            {
+                m_QueuedReads.push_back(std::move(reads[first]));
+                first = last;
+                continue;
+            }
+
+            auto pMerged = std::make_shared<AsyncReadRequest>();
+            pMerged->pLoader = this;
+            pMerged->path = reads[first]->path;
+            pMerged->nPriority = reads[first]->nPriority;
+            pMerged->nSequence = reads[first]->nSequence;
+            pMerged->state = AsyncReadState::Queued;
+            pMerged->bStreaming = true;
+            pMerged->szOffset = reads[first]->szOffset;
+            pMerged->szSize = end - reads[first]->szOffset;
+            for (size_t i = first; i < last; i++)
+            {
+                pMerged->nPriority = std::max(pMerged->nPriority, reads[i]->nPriority);
+                pMerged->nSequence = std::min(pMerged->nSequence, reads[i]->nSequence);
+                reads[i]->state = AsyncReadState::Reading;
+                pMerged->children.push_back(std::move(reads[i]));
+            }
+
+            m_StreamingStats.nMergedReads += last - first - 1;
+            m_QueuedReads.push_back(std::move(pMerged));
+            first = last;
+        }
+    }
+
+    void AssetLoader::DeliverStreamingReads()
+    {
+        m_StreamingStats.fDecodeMsLastFrame = 0.0;
+        if (m_StreamCompleted.empty()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+            std::stable_sort(m_StreamCompleted.begin(), m_StreamCompleted.end(),
+                [](const std::shared_ptr<AsyncReadRequest>& a, const std::shared_ptr<AsyncReadRequest>& b) {
+                    if (a->nPriority != b->nPriority) return a->nPriority > b->nPriority;
+                    return a->nSequence < b->nSequence;
+                });
+        }
+
+        StreamClock::time_point start = StreamClock::now();
+        double spent_ms = 0.0;
+        size_t count = 0;
+        for (; count < m_StreamCompleted.size(); count++)
+        {
+            if (count > 0 && m_fStreamDecodeMsPerFrame > 0.0 && spent_ms >= m_fStreamDecodeMsPerFrame) break;
+
+            auto& pRequest = m_StreamCompleted[count];
+            AsyncReadCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(m_ReadMutex);
+                callback.swap(pRequest->callback);
+            }
+            if (pRequest->state == AsyncReadState::Cancelled) continue;
+
+            StreamClock::time_point now = StreamClock::now();
+            double latency_ms = std::chrono::duration<double, std::milli>(now - pRequest->tQueued).count();
+            m_StreamingStats.nDelivered++;
+            m_StreamingStats.fMaxLatencyMs = std::max(m_StreamingStats.fMaxLatencyMs, latency_ms);
+            m_fTotalLatencyMs += latency_ms;
+            if (now > pRequest->tDeadline) m_StreamingStats.nMissedDeadlines++;
+
+            if (callback) callback(AsyncReadHandle(pRequest));
+            spent_ms = std::chrono::duration<double, std::milli>(StreamClock::now() - start).count();
+        }
+
+        m_StreamCompleted.erase(m_StreamCompleted.begin(), m_StreamCompleted.begin() + count);
+        m_StreamingStats.fDecodeMsLastFrame = spent_ms;
+    }
+
+    void AssetLoader::BeginLoadTrace()
+    {
+        std::lock_guard<std::mutex> lock(m_TraceMutex);
+        m_Trace.clear();
+        m_TracedReads.clear();
+        m_bTracing = true;
+    }
+
+    std::vector<LoadTraceEntry> AssetLoader::EndLoadTrace()
+    {
+        std::lock_guard<std::mutex> lock(m_TraceMutex);
+        m_bTracing = false;
+        m_TracedReads.clear();
+
+        std::vector<LoadTraceEntry> trace;
+        trace.swap(m_Trace);
+        return trace;
+    }
+
+    void AssetLoader::TraceRead(const char* name, size_t offset, size_t size)
+    {
+        if (!m_bTracing) return;
+
+        // names of the same file spelled differently are one file
+        std::string file = NormalizeAssetPath(name);
+        std::lock_guard<std::mutex> lock(m_TraceMutex);
+        if (!m_bTracing || m_TracedReads.count(file)) return;
+
+        if (offset || size)
+        {
+            // a range of a file not read as a whole (yet)
+            std::string range = file + '|' + std::to_string(offset) + '|' + std::to_string(size);
+            if (!m_TracedReads.insert(std::move(range)).second) return;
+        }
+        else
+        {
+            m_TracedReads.insert(std::move(file));
+        }
+
+        LoadTraceEntry entry;
+        entry.name = name;
+        entry.szOffset = offset;
+        entry.szSize = size;
+        m_Trace.push_back(std::move(entry));
+    }
+
+    bool AssetLoader::WriteLoadManifest(const char* sceneName, const std::vector<LoadTraceEntry>& manifest)
+    {
+        std::shared_ptr<AssetPack> pPack;
+        std::string scenePath;
+        if (FindInPacks(sceneName, pPack) || !ResolveFilePath(sceneName, scenePath))
+            return false;
+
+        std::string path = scenePath + kManifestExtension;
+        FILE* fp = fopen(path.c_str(), "wb");
+        if (!fp)
+        {
+            fprintf(stderr, "Cannot write load manifest '%s'\n", path.c_str());
+            return false;
+        }
+
+        // one "offset size name" per line, the name last as it may have spaces
+        fprintf(fp, "%s\n", kManifestHeader);
+        for (auto& entry : manifest)
+        {
+            fprintf(fp, "%zu %zu %s\n", entry.szOffset, entry.szSize, entry.name.c_str());
+        }
+
+        bool written = !ferror(fp);
+        written = (fclose(fp) == 0) && written;
+        if (!written) return false;
+
+        // known without a scan, the next load of the scene reads it
+        std::string key = NormalizeAssetPath((std::string(sceneName) + kManifestExtension).c_str());
+        std::lock_guard<std::mutex> lock(m_FileIndexMutex);
+        m_FileIndex[key] = path;
+        m_MissingFiles.erase(key);
+        return true;
+    }
+
+    bool AssetLoader::ReadLoadManifest(const char* sceneName, std::vector<LoadTraceEntry>& manifest)
+    {
+        manifest.clear();
+
+        std::string name = std::string(sceneName) + kManifestExtension;
+        std::shared_ptr<AssetPack> pPack;
+        std::string path;
+        if (!FindInPacks(name.c_str(), pPack) && !ResolveFilePath(name.c_str(), path))
+            return false;
+
+        BufferView data = MapFile(name.c_str());
+        const char* p = reinterpret_cast<const char*>(data.GetData());
+        const char* end = p + data.GetDataSize();
+
+        bool header = false;
+        while (p < end)
+        {
+            const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!eol) eol = end;
+            std::string line(p, eol);
+            p = eol + 1;
+
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!header)
+            {
+                // an older format, rewritten by the next load
+                if (line != kManifestHeader) return false;
+                header = true;
+                continue;
+            }
+
+            LoadTraceEntry entry;
+            int name_start = 0;
+            if (sscanf(line.c_str(), "%zu %zu %n", &entry.szOffset, &entry.szSize, &name_start) < 2 ||
+                name_start <= 0 || line[name_start] == '\0')
+                continue;
+            entry.name = line.substr(name_start);
+            manifest.push_back(std::move(entry));
+        }
+
+        return header;
+    }
+
+    size_t AssetLoader::Prefetch(const std::vector<LoadTraceEntry>& manifest)
+    {
+        size_t bytes = 0;
+
+        for (auto& entry : manifest)
+        {
+            std::shared_ptr<AssetPack> pPack;
+            std::string path;
+            uint64_t offset = entry.szOffset;
+            uint64_t size = entry.szSize;
+            uint64_t file_size = 0;
+
+            if (const AssetPackEntry* pEntry = FindInPacks(entry.name.c_str(), pPack))
+            {
+                // the range of the entry within the pack, compressed ones inflate as a whole
+                path = pPack->GetPath();
+                if (pEntry->nFlags & PACK_ENTRY_ZLIB)
+                {
+                    offset = 0;
+                    size = pEntry->nStoredSize;
+                }
+                else
+                {
+                    if (offset >= pEntry->nSize) continue;
+                    if (!size || size > pEntry->nSize - offset) size = pEntry->nSize - offset;
+                }
+                offset += pEntry->nOffset;
+                file_size = offset + size;
+            }
+            else if (!ResolveFilePath(entry.name.c_str(), path))
+            {
+                continue;
+            }
+
+#if defined(__linux__)
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+
+            struct stat st;
+            if (!file_size && fstat(fd, &st) == 0) file_size = static_cast<uint64_t>(st.st_size);
+            if (offset < file_size)
+            {
+                if (!size || size > file_size - offset) size = file_size - offset;
+
+                // queues the reads and returns, the page cache fills in the background
+                if (posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED) == 0)
+                    bytes += static_cast<size_t>(size);
+            }
+            close(fd);
+#else
+            // the I/O threads map the files and fault their pages in, after any other read
+            if (!file_size)
+            {
+                std::error_code ec;
+                file_size = std::filesystem::file_size(path, ec);
+                if (ec) continue;
+            }
+            if (offset < file_size)
+            {
+                if (!size || size > file_size - offset) size = file_size - offset;
+                AsyncRead(entry.name.c_str(), kPrefetchPriority);
+                bytes += static_cast<size_t>(size);
+            }
+#endif
+        }
+
+        return bytes;
+    }
+
+    void AssetLoader::StartIoThreads()
+    {
+        StopIoThreads();
+
+        m_bStopIoThreads = false;
+        for (uint32_t i = 0; i < m_nIoThreadCount; i++)
+        {
+            m_IoThreads.emplace_back(&AssetLoader::IoThread, this);
+        }
+    }
+
+    void AssetLoader::StopIoThreads()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+            m_bStopIoThreads = true;
+        }
+        m_ReadQueued.notify_all();
+
+        for (auto& thread : m_IoThreads)
+        {
+            thread.join();
+        }
+        m_IoThreads.clear();
+    }
+
+    bool AssetLoader::SetIoBackend(IoBackend backend)
+    {
+        if (backend == IoBackend::IoUring && !IoUringFileReader::IsSupported())
+        {
+            m_IoBackend = IoBackend::Stdio;
+            return false;
+        }
+
+        m_IoBackend = backend;
+        return true;
+    }
+
+    bool AssetLoader::ReadMapped(const char* name, BufferView& data)
+    {
+        if (!FileExists(name)) return false;
+
+        // traced when it was asked for
+        data = MapFileUntraced(name);
+        TouchPages(data);
+
+        return true;
+    }
+
+    bool AssetLoader::ReadRange(const AsyncReadRequest& request, BufferView& data)
+    {
+        BufferView file;
+        std::shared_ptr<AssetPack> pPack;
+        if (const AssetPackEntry* pEntry = FindInPacks(request.path.c_str(), pPack))
+            file = pPack->Read(*pEntry);
+        else if (FileExists(request.path.c_str()))
+            file = MapFileUntraced(request.path.c_str());
+        else
+            return false;
+
+        if (request.szOffset > file.GetDataSize()) return false;
+
+        data = file.SubView(request.szOffset, std::min(request.szSize, file.GetDataSize() - request.szOffset));
+        TouchPages(data);
+
+        return true;
+    }
+
+    void AssetLoader::ReadBatched(IoUringFileReader& reader, const std::vector<std::shared_ptr<AsyncReadRequest>>& batch,
+                                  std::vector<BufferView>& data, std::vector<bool>& found)
+    {
+        std::vector<std::string> paths;
+        std::vector<size_t> requests;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            // ranges come out of a mapping, the ring reads whole files
+            if (batch[i]->bStreaming)
+            {
+                found[i] = ReadRange(*batch[i], data[i]);
+                continue;
+            }
+
+            // packed files are in memory already
+            std::shared_ptr<AssetPack> pPack;
+            if (const AssetPackEntry* pEntry = FindInPacks(batch[i]->path.c_str(), pPack))
+            {
+                data[i] = pPack->Read(*pEntry);
+                found[i] = true;
+                continue;
+            }
+
+            std::string fullPath;
+            if (ResolveFilePath(batch[i]->path.c_str(), fullPath))
+            {
+                paths.push_back(std::move(fullPath));
+                requests.push_back(i);
+            }
+        }
+
+        std::vector<Buffer> buffers;
+        std::vector<bool> succeeded;
+        bool ring_ok = reader.ReadFiles(paths, buffers, succeeded);
+
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            size_t request = requests[i];
+            if (!succeeded[i] && !ring_ok)
+            {
+                // the ring broke, what it did not read goes the stdio way
+                found[request] = ReadMapped(batch[request]->path.c_str(), data[request]);
+                continue;
+            }
+
+            found[request] = succeeded[i];
+            data[request] = BufferView(std::move(buffers[i]));
+        }
+    }
+
+    void AssetLoader::IoThread()
+    {
+        // a ring per thread, the stdio path when the kernel has none
+        IoUringFileReader reader;
+        bool batched = (m_IoBackend == IoBackend::IoUring) && reader.Initialize();
+
+        std::vector<std::shared_ptr<AsyncReadRequest>> batch;
+        std::vector<BufferView> data;
+        std::vector<bool> found;
+
+        std::unique_lock<std::mutex> lock(m_ReadMutex);
+        while (true)
+        {
+            m_ReadQueued.wait(lock, [this] { return m_bStopIoThreads || !m_QueuedReads.empty(); });
+            if (m_bStopIoThreads) break;
+
+            // highest priority first, in the order of the requests otherwise
+            size_t batch_size = batched ? reader.GetBatchSize() : 1;
+            while (batch.size() < batch_size && !m_QueuedReads.empty())
+            {
+                auto next = std::max_element(m_QueuedReads.begin(), m_QueuedReads.end(),
+                    [](const std::shared_ptr<AsyncReadRequest>& a, const std::shared_ptr<AsyncReadRequest>& b) {
+                        if (a->nPriority != b->nPriority) return a->nPriority < b->nPriority;
+                        return a->nSequence > b->nSequence;
+                    });
+                (*next)->state = AsyncReadState::Reading;
+                batch.push_back(std::move(*next));
+                m_QueuedReads.erase(next);
+            }
+
+            lock.unlock();
+
+            data.assign(batch.size(), BufferView());
+            found.assign(batch.size(), false);
+            if (batched)
+            {
+                ReadBatched(reader, batch, data, found);
+                // a broken ring is finalized, the thread goes on with stdio
+                batched = reader.IsAvailable();
+            }
+            else
+            {
+                for (size_t i = 0; i < batch.size(); i++)
+                {
+                    found[i] = batch[i]->bStreaming ? ReadRange(*batch[i], data[i]) : ReadMapped(batch[i]->path.c_str(), data[i]);
+                }
+            }
+
+            lock.lock();
+
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                if (batch[i]->bStreaming)
+                    m_StreamingStats.nInFlight -= std::max<size_t>(batch[i]->children.size(), 1);
+
+                // a merged read hands every request its own part
+                for (auto& pChild : batch[i]->children)
+                {
+                    if (pChild->state == AsyncReadState::Cancelled) continue;
+
+                    size_t offset = pChild->szOffset - batch[i]->szOffset;
+                    bool complete = found[i] && offset <= data[i].GetDataSize();
+                    if (complete) pChild->data = data[i].SubView(offset, std::min(pChild->szSize, data[i].GetDataSize() - offset));
+                    pChild->state = complete ? AsyncReadState::Done : AsyncReadState::Failed;
+                    m_FinishedReads.push_back(std::move(pChild));
+                }
+
+                // nobody wants the content of cancelled reads any more
+                if (!batch[i]->children.empty() || batch[i]->state == AsyncReadState::Cancelled) continue;
+
+                batch[i]->data = std::move(data[i]);
+                batch[i]->state = found[i] ? AsyncReadState::Done : AsyncReadState::Failed;
+                m_FinishedReads.push_back(std::move(batch[i]));
+            }
+            batch.clear();
+            data.clear();
+            m_ReadFinished.notify_all();
+        }
+    }
+
+    void AssetLoader::CancelRead(AsyncReadRequest& request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_ReadMutex);
+
+            auto is_request = [&request](const std::shared_ptr<AsyncReadRequest>& pRequest) { return pRequest.get() == &request; };
+            auto it = std::find_if(m_QueuedReads.begin(), m_QueuedReads.end(), is_request);
+            if (it != m_QueuedReads.end()) m_QueuedReads.erase(it);
+            it = std::find_if(m_StreamQueue.begin(), m_StreamQueue.end(), is_request);
+            if (it != m_StreamQueue.end()) m_StreamQueue.erase(it);
+
+            request.state = AsyncReadState::Cancelled;
+            request.callback = nullptr;
+            request.data = BufferView();
+        }
+        m_ReadFinished.notify_all();
+    }
+
+    void AssetLoader::SetReadPriority(AsyncReadRequest& request, int32_t priority)
+    {
+        // the queue is searched for the highest priority, no reordering needed
+        std::lock_guard<std::mutex> lock(m_ReadMutex);
+        request.nPriority = priority;
+    }
+
+    void AssetLoader::WaitForRead(const AsyncReadRequest& request)
+    {
+        std::unique_lock<std::mutex> lock(m_ReadMutex);
+
+        // a streaming read the scheduler holds back is issued right away,
+        // Tick() will not run while the main thread waits
+        auto it = std::find_if(m_StreamQueue.begin(), m_StreamQueue.end(),
+            [&request](const std::shared_ptr<AsyncReadRequest>& pRequest) { return pRequest.get() == &request; });
+        if (it != m_StreamQueue.end())
+        {
+            std::vector<std::shared_ptr<AsyncReadRequest>> reads(1, std::move(*it));
+            m_StreamQueue.erase(it);
+            IssueStreamingReads(reads);
+            m_ReadQueued.notify_one();
+        }
+
+        m_ReadFinished.wait(lock, [&request] {
+            return request.state != AsyncReadState::Queued && request.state != AsyncReadState::Reading;
+        });
+    }
+
+    AsyncReadState AsyncReadHandle::GetState() const
+    {
+        return m_pRequest ? m_pRequest->state.load() : AsyncReadState::Cancelled;
+    }
+
+    bool AsyncReadHandle::IsReady() const
+    {
+        AsyncReadState state = GetState();
+        return state == AsyncReadState::Done || state == AsyncReadState::Failed;
+    }
+
+    void AsyncReadHandle::Wait() const
+    {
+        if (m_pRequest) m_pRequest->pLoader->WaitForRead(*m_pRequest);
+    }
+
+    const std::string& AsyncReadHandle::GetPath() const
+    {
+        static const std::string empty;
+        return m_pRequest ? m_pRequest->path : empty;
+    }
+
+    const BufferView& AsyncReadHandle::GetData() const
+    {
+        static const BufferView empty;
+        return (m_pRequest && GetState() == AsyncReadState::Done) ? m_pRequest->data : empty;
+    }
+
+    void AsyncReadHandle::Cancel()
+    {
+        if (m_pRequest) m_pRequest->pLoader->CancelRead(*m_pRequest);
+    }
+
+    void AsyncReadHandle::SetPriority(int32_t priority)
+    {
+        if (m_pRequest) m_pRequest->pLoader->SetReadPriority(*m_pRequest, priority);
+    }
+
     void AssetLoader::CloseFile(AssetFilePtr& fp)
     {
-        fclose((FILE*)fp);
+        AssetFile* file = static_cast<AssetFile*>(fp);
+        if (file->fp) fclose(file->fp);
+        delete file;
         fp = nullptr;
     }
 
     size_t AssetLoader::GetSize(const AssetFilePtr& fp)
     {
-        FILE* _fp = static_cast<FILE*>(fp);
+        AssetFile* file = static_cast<AssetFile*>(fp);
+        if (!file->fp) return file->data.GetDataSize();
+
+        FILE* _fp = file->fp;
 
         long pos = ftell(_fp);
         fseek(_fp, 0, SEEK_END);
@@ -230,14 +1366,22 @@ namespace Corona
             return 0;
         }
 
-        sz = fread(buf.GetData(), buf.GetDataSize(), 1, static_cast<FILE*>(fp));
+        // 1 when the buffer was filled, like fread of a single element
+        sz = (ReadAssetFile(static_cast<AssetFile*>(fp), buf.GetData(), buf.GetDataSize()) == buf.GetDataSize()) ? 1 : 0;
 
         return sz;
     }
 
     int32_t AssetLoader::Seek(AssetFilePtr fp, long offset, AssetSeekBase where)
     {
-        return fseek(static_cast<FILE*>(fp), offset, static_cast<int>(where));
+        AssetFile* file = static_cast<AssetFile*>(fp);
+        if (file->fp) return fseek(file->fp, offset, static_cast<int>(where));
+
+        long base = (where == MY_SEEK_SET) ? 0 : (where == MY_SEEK_CUR) ? (long)file->position : (long)file->data.GetDataSize();
+        if (base + offset < 0 || base + offset > (long)file->data.GetDataSize()) return -1;
+
+        file->position = static_cast<size_t>(base + offset);
+        return 0;
     }
 
 }
\ No newline at end of file
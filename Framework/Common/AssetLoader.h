@@ -1,17 +1,110 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "IRuntimeModule.h"
 #include "Buffer.h"
+#include "BufferView.h"
+#include "BuildCache.h"
+#include "FileWatcher.h"
 
 namespace Corona 
 {
+    struct AsyncReadRequest;
+    class AssetPack;
+    struct AssetPackEntry;
+    class IoUringFileReader;
+
+    enum class AsyncReadState
+    {
+        Queued,
+        Reading,
+        Done,
+        Failed,     // the file does not exist
+        Cancelled
+    };
+
+    // Future-like handle of an AssetLoader::AsyncRead(), copies refer to the same read.
+    class AsyncReadHandle
+    {
+    public:
+        AsyncReadHandle() {}
+
+        bool IsValid(void) const { return m_pRequest != nullptr; }
+        AsyncReadState GetState(void) const;
+        // the read has finished, successfully or not
+        bool IsReady(void) const;
+        // blocks until the read has finished, the callback still waits for Tick()
+        void Wait(void) const;
+
+        const std::string& GetPath(void) const;
+        // content of the file, empty until the read is done
+        const BufferView& GetData(void) const;
+
+        // the callback will not be called, a read already in flight still completes
+        void Cancel(void);
+        // higher priorities are read first, only matters while the read is queued
+        void SetPriority(int32_t priority);
+
+    private:
+        friend class AssetLoader;
+        explicit AsyncReadHandle(std::shared_ptr<AsyncReadRequest> pRequest) : m_pRequest(std::move(pRequest)) {}
+
+        std::shared_ptr<AsyncReadRequest> m_pRequest;
+    };
+
+    // A read through the streaming scheduler, see AssetLoader::StreamRead().
+    struct StreamingRead
+    {
+        size_t  szOffset = 0;
+        size_t  szSize = 0;             // 0 reads up to the end of the file
+        int32_t nPriority = 0;          // higher first, e.g. the negated distance to the camera
+        double  fDeadlineMs = 0.0;      // from now, 0 for none. Reads due ignore the byte budget.
+    };
+
+    struct StreamingStats
+    {
+        size_t   nQueued;               // waiting for the scheduler
+        size_t   nInFlight;             // issued to the I/O threads
+        size_t   nCompleted;            // read, waiting for their callbacks
+        uint64_t nIssuedReads;          // reads the scheduler sent to the I/O threads
+        uint64_t nMergedReads;          // requests served by the read of a neighbour
+        uint64_t nDelivered;
+        uint64_t nMissedDeadlines;      // delivered after their deadline
+        size_t   szBytesLastFrame;      // issued by the last Tick()
+        double   fDecodeMsLastFrame;    // spent in callbacks by the last Tick()
+        double   fAverageLatencyMs;     // from StreamRead() to the callback
+        double   fMaxLatencyMs;
+    };
+
+    // A file, or a range of it, read while a load trace was recorded.
+    struct LoadTraceEntry
+    {
+        std::string name;               // as it was asked for
+        size_t      szOffset = 0;
+        size_t      szSize = 0;         // 0 up to the end of the file
+
+        bool operator==(const LoadTraceEntry& other) const
+        {
+            return name == other.name && szOffset == other.szOffset && szSize == other.szSize;
+        }
+        bool operator!=(const LoadTraceEntry& other) const { return !(*this == other); }
+    };
+
     class AssetLoader : public IRuntimeModule
     {
     public:
-        virtual ~AssetLoader() {};
+        virtual ~AssetLoader() { StopIoThreads(); };
 
         virtual int Initialize();
         virtual void Finalize();
@@ -36,8 +129,14 @@ namespace Corona
 
         bool RemoveSearchPath(const char* path);
 
+        // Files below the Asset/ roots are found through an index scanned once,
+        // a file created there since is not known until the next scan. Changing
+        // the search paths scans again, or this does.
+        void RescanFiles(void);
+
         bool FileExists(const char *filePath);
 
+        // path to open the file with, the name itself for files in a mounted pack
         const std::string GetFilePath(const char* name);
 
         AssetFilePtr OpenFile(const char* name, AssetOpenMode mode);
@@ -46,6 +145,84 @@ namespace Corona
 
         Buffer SyncOpenAndReadBinary(const char *filePath);
 
+        // Read-only view of the whole file. The file is memory mapped when the OS
+        // allows it (pages come in on demand and are shared between processes),
+        // otherwise it is read into a buffer. Empty view if the file is missing.
+        BufferView MapFile(const char* filePath);
+
+        // Mounts a Corona pack (see AssetPack.h), either a path of its own or below
+        // Asset/. Files in mounted packs hide loose files, earlier mounts hide later
+        // ones. Views handed out stay valid after the pack is unmounted.
+        bool MountPack(const char* path);
+        bool UnmountPack(const char* path);
+
+        typedef std::function<void(const std::string&)> FileChangedCallback;
+
+        // Calls back from Tick() with the name the file was watched under whenever
+        // it is written to. Returns the id for UnwatchFile(), 0 when the file is
+        // missing or comes from a mounted pack. Main thread only.
+        uint32_t WatchFile(const char* name, FileChangedCallback callback);
+        void UnwatchFile(uint32_t id);
+
+        typedef std::function<void(const AsyncReadHandle&)> AsyncReadCallback;
+
+        // Reads the whole file (as MapFile does) on one of the I/O threads. The
+        // callback is called from Tick() on the main thread once the read has
+        // finished, unless the read was cancelled before.
+        AsyncReadHandle AsyncRead(const char* filePath, int32_t priority = 0, AsyncReadCallback callback = nullptr);
+
+        // Reads a range of a file through the streaming scheduler. Every Tick()
+        // issues the queued reads, due ones first and then by priority, up to the
+        // bytes-per-frame budget, merging adjacent ranges of the same file into one
+        // read. Callbacks run in Tick() by priority up to the decode budget, the
+        // rest waits for the next frame.
+        AsyncReadHandle StreamRead(const char* filePath, const StreamingRead& read, AsyncReadCallback callback = nullptr);
+
+        // 0 for no limit. Every Tick() still issues and delivers at least one read.
+        void SetStreamingBudget(size_t bytesPerFrame, double decodeMsPerFrame);
+
+        // call it from the main thread
+        StreamingStats GetStreamingStats(void);
+
+        // Records the files and ranges read through the loader, from any thread,
+        // in the order they are first asked for, until EndLoadTrace(). A file
+        // read twice is listed once.
+        void BeginLoadTrace(void);
+        std::vector<LoadTraceEntry> EndLoadTrace(void);
+
+        // The trace of a scene load, saved next to the scene as "<scene>.prefetch".
+        // Writing fails for scenes in a mounted pack, a manifest packed with the
+        // scene is read like any other file.
+        bool WriteLoadManifest(const char* sceneName, const std::vector<LoadTraceEntry>& manifest);
+        bool ReadLoadManifest(const char* sceneName, std::vector<LoadTraceEntry>& manifest);
+
+        // Starts reading ahead everything the manifest lists and returns at once,
+        // so the parser finds the files in the page cache. On Linux the kernel is
+        // asked for all of the ranges up front (posix_fadvise), elsewhere the I/O
+        // threads read the files. Files gone since are skipped. Returns the bytes
+        // asked for.
+        size_t Prefetch(const std::vector<LoadTraceEntry>& manifest);
+
+        // Directory of the build cache opened by the next Initialize(), relative to
+        // the working directory. Empty turns the cache off.
+        void SetBuildCacheDirectory(const char* directory) { m_strBuildCacheDirectory = directory; }
+        // cooked data of the loaders, see BuildCache.h
+        BuildCache& GetBuildCache(void) { return m_BuildCache; }
+
+        // number of I/O threads started by the next Initialize()
+        void SetIoThreadCount(uint32_t count) { m_nIoThreadCount = count ? count : 1; }
+
+        enum class IoBackend
+        {
+            Stdio,      // one file at a time, memory mapped (MapFile)
+            IoUring     // queued files in batches through Linux io_uring
+        };
+
+        // backend of the I/O threads started by the next Initialize(), false and
+        // Stdio when the kernel does not support io_uring
+        bool SetIoBackend(IoBackend backend);
+        IoBackend GetIoBackend(void) const { return m_IoBackend; }
+
         size_t SyncRead(const AssetFilePtr& fp, Buffer& buf);
 
         void CloseFile(AssetFilePtr& fp);
@@ -69,7 +246,90 @@ namespace Corona
         }
 
     private:
+        friend class AsyncReadHandle;
+
+        // every file below the Asset/ roots, relative path -> path to open.
+        // BuildFileIndex() expects m_FileIndexMutex to be held.
+        void BuildFileIndex();
+        // GetFilePath() without the fallback to the name
+        bool ResolveFilePath(const char* name, std::string& fullPath);
+        const AssetPackEntry* FindInPacks(const char* name, std::shared_ptr<AssetPack>& pPack);
+        // the old walk up the hierarchy, only for names outside of the roots like "../x"
+        bool ProbeFile(const char* name, std::string& fullPath);
+
+        // adds the read to the load trace if one is recorded
+        void TraceRead(const char* name, size_t offset, size_t size);
+        // MapFile() for the I/O threads, their reads were traced when asked for
+        BufferView MapFileUntraced(const char* filePath);
+
+        void StartIoThreads();
+        void StopIoThreads();
+        void IoThread();
+        bool ReadMapped(const char* name, BufferView& data);
+        bool ReadRange(const AsyncReadRequest& request, BufferView& data);
+        void ReadBatched(IoUringFileReader& reader, const std::vector<std::shared_ptr<AsyncReadRequest>>& batch,
+                         std::vector<BufferView>& data, std::vector<bool>& found);
+        void CancelRead(AsyncReadRequest& request);
+        void SetReadPriority(AsyncReadRequest& request, int32_t priority);
+        void WaitForRead(const AsyncReadRequest& request);
+
+        // the streaming scheduler, run by Tick()
+        void ScheduleStreamingReads(void);
+        void DeliverStreamingReads(void);
+        // merges and queues the reads for the I/O threads, m_ReadMutex is held
+        void IssueStreamingReads(std::vector<std::shared_ptr<AsyncReadRequest>>& reads);
+
         std::vector<std::string> m_strSearchPath;
+
+        // the I/O threads resolve paths too
+        std::mutex m_FileIndexMutex;
+        std::unordered_map<std::string, std::string> m_FileIndex;
+        // names looked up and not found, until the next scan
+        std::unordered_set<std::string> m_MissingFiles;
+        bool m_bFileIndexValid = false;
+        std::vector<std::shared_ptr<AssetPack>> m_Packs;
+
+        uint32_t m_nIoThreadCount = 2;
+        IoBackend m_IoBackend = IoBackend::Stdio;
+        std::vector<std::thread> m_IoThreads;
+
+        std::mutex m_ReadMutex;
+        std::condition_variable m_ReadQueued;
+        std::condition_variable m_ReadFinished;
+        std::vector<std::shared_ptr<AsyncReadRequest>> m_QueuedReads;
+        std::vector<std::shared_ptr<AsyncReadRequest>> m_FinishedReads;
+        uint64_t m_nReadSequence = 0;
+        bool m_bStopIoThreads = false;
+
+        // streaming reads not issued yet (under m_ReadMutex) and read ones
+        // waiting for their callbacks (main thread only)
+        std::vector<std::shared_ptr<AsyncReadRequest>> m_StreamQueue;
+        std::vector<std::shared_ptr<AsyncReadRequest>> m_StreamCompleted;
+        size_t m_szStreamBytesPerFrame = 0;
+        double m_fStreamDecodeMsPerFrame = 0.0;
+        StreamingStats m_StreamingStats = {};
+        double m_fTotalLatencyMs = 0.0;
+        std::chrono::steady_clock::time_point m_tLastTick;
+        std::chrono::steady_clock::duration m_LastFrameTime = std::chrono::steady_clock::duration::zero();
+
+        std::atomic<bool> m_bTracing{ false };
+        std::mutex m_TraceMutex;
+        std::vector<LoadTraceEntry> m_Trace;
+        std::unordered_set<std::string> m_TracedReads;
+
+        std::string m_strBuildCacheDirectory = "Cache";
+        BuildCache m_BuildCache;
+
+        // files watched for changes, main thread only
+        struct FileWatch
+        {
+            std::string name;
+            std::string path;
+            FileChangedCallback callback;
+        };
+        FileWatcher m_FileWatcher;
+        std::unordered_map<uint32_t, FileWatch> m_FileWatches;
+        uint32_t m_nFileWatchId = 0;
     };
 
     extern AssetLoader* g_pAssetLoader;
@@ -0,0 +1,193 @@
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "FileMapping.h"
+#include "zlib/zlib.h"
+
+namespace Corona
+{
+    uint64_t HashAssetPath(const char* path)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const char* p = path; *p; p++)
+        {
+            hash ^= static_cast<uint8_t>(*p);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool AssetPack::Open(const char* path)
+    {
+        auto pMapping = std::make_shared<FileMapping>();
+        if (!pMapping->Open(path)) return false;
+
+        const uint8_t* pData = pMapping->GetData();
+        size_t size = pMapping->GetDataSize();
+        if (size < sizeof(AssetPackHeader)) return false;
+
+        const AssetPackHeader* pHeader = reinterpret_cast<const AssetPackHeader*>(pData);
+        size_t toc_size = sizeof(AssetPackHeader) + pHeader->nEntryCount * sizeof(AssetPackEntry) + pHeader->nNamesSize;
+        if (pHeader->nMagic != kPackMagic || pHeader->nVersion != kPackVersion || toc_size > size)
+        {
+            fprintf(stderr, "'%s' is no Corona pack\n", path);
+            return false;
+        }
+
+        const AssetPackEntry* pEntries = reinterpret_cast<const AssetPackEntry*>(pHeader + 1);
+        const char* pNames = reinterpret_cast<const char*>(pEntries + pHeader->nEntryCount);
+        for (uint32_t i = 0; i < pHeader->nEntryCount; i++)
+        {
+            const AssetPackEntry& entry = pEntries[i];
+            if (entry.nOffset > size || entry.nStoredSize > size - entry.nOffset || entry.nNameOffset >= pHeader->nNamesSize)
+            {
+                fprintf(stderr, "Pack '%s' is truncated\n", path);
+                return false;
+            }
+        }
+        if (pHeader->nNamesSize && pNames[pHeader->nNamesSize - 1] != '\0') return false;
+
+        m_strPath = path;
+        m_File = BufferView(std::move(pMapping), pData, size);
+        m_pHeader = pHeader;
+        m_pEntries = pEntries;
+        m_pNames = pNames;
+        return true;
+    }
+
+    const AssetPackEntry* AssetPack::Find(const char* name) const
+    {
+        if (!m_pHeader) return nullptr;
+
+        uint64_t hash = HashAssetPath(name);
+        const AssetPackEntry* pEnd = m_pEntries + m_pHeader->nEntryCount;
+        const AssetPackEntry* pEntry = std::lower_bound(m_pEntries, pEnd, hash,
+            [](const AssetPackEntry& entry, uint64_t h) { return entry.nHash < h; });
+
+        for (; pEntry != pEnd && pEntry->nHash == hash; pEntry++)
+        {
+            if (!strcmp(GetEntryName(*pEntry), name)) return pEntry;
+        }
+
+        return nullptr;
+    }
+
+    BufferView AssetPack::Read(const AssetPackEntry& entry) const
+    {
+        if (!(entry.nFlags & PACK_ENTRY_ZLIB))
+            return m_File.SubView(static_cast<size_t>(entry.nOffset), static_cast<size_t>(entry.nStoredSize));
+
+        Buffer inflated(static_cast<size_t>(entry.nSize), 4, MemoryTag::Transient);
+        uLongf size = static_cast<uLongf>(entry.nSize);
+        int result = uncompress(inflated.GetData(), &size, m_File.GetData() + entry.nOffset, static_cast<uLong>(entry.nStoredSize));
+        if (result != Z_OK || size != entry.nSize)
+        {
+            fprintf(stderr, "Cannot inflate '%s' from '%s'\n", GetEntryName(entry), m_strPath.c_str());
+            return BufferView();
+        }
+
+        return BufferView(std::move(inflated));
+    }
+
+    void AssetPackWriter::AddFile(const std::string& name, const BufferView& data, bool compress)
+    {
+        m_Sources.push_back({ name, data, compress });
+    }
+
+    static bool WritePadding(FILE* fp, uint64_t& offset)
+    {
+        static const uint8_t zeros[kPackAlignment] = {};
+        uint64_t padding = (kPackAlignment - offset % kPackAlignment) % kPackAlignment;
+        offset += padding;
+        return fwrite(zeros, 1, static_cast<size_t>(padding), fp) == padding;
+    }
+
+    bool AssetPackWriter::Write(const char* path, int level)
+    {
+        // compress first, the table of contents needs the stored sizes. An empty
+        // view stores the file as it is.
+        std::vector<BufferView> compressed(m_Sources.size());
+        for (size_t i = 0; i < m_Sources.size(); i++)
+        {
+            const Source& source = m_Sources[i];
+            if (!source.bCompress || source.data.IsEmpty()) continue;
+
+            // what zlib makes of a file depends on its version too
+            std::string key = "zlib" + std::to_string(level) + ':' + source.name;
+            std::vector<BuildInput> inputs;
+            if (m_pBuildCache)
+            {
+                inputs.push_back(BuildCache::HashInput(source.data));
+                if (m_pBuildCache->Find(key, ZLIB_VERNUM, inputs, compressed[i])) continue;
+            }
+
+            uLongf size = compressBound(static_cast<uLong>(source.data.GetDataSize()));
+            std::vector<uint8_t> deflated(size);
+            if (compress2(deflated.data(), &size, source.data.GetData(), static_cast<uLong>(source.data.GetDataSize()), level) == Z_OK
+                && size <= source.data.GetDataSize() - source.data.GetDataSize() / 8)
+            {
+                deflated.resize(size);
+                compressed[i] = BufferView(std::move(deflated));
+            }
+            // otherwise not worth inflating on every load, remembered as such
+
+            if (m_pBuildCache) m_pBuildCache->Store(key, ZLIB_VERNUM, inputs, compressed[i]);
+        }
+
+        // the data follows the table of contents in the order of the files
+        std::vector<AssetPackEntry> entries(m_Sources.size());
+        std::string names;
+        uint64_t offset = sizeof(AssetPackHeader) + m_Sources.size() * sizeof(AssetPackEntry);
+        for (auto& source : m_Sources) offset += source.name.size() + 1;
+        offset = (offset + kPackAlignment - 1) & ~(kPackAlignment - 1);
+
+        for (size_t i = 0; i < m_Sources.size(); i++)
+        {
+            AssetPackEntry& entry = entries[i];
+            entry.nHash = HashAssetPath(m_Sources[i].name.c_str());
+            entry.nOffset = offset;
+            entry.nSize = m_Sources[i].data.GetDataSize();
+            entry.nStoredSize = compressed[i].IsEmpty() ? entry.nSize : compressed[i].GetDataSize();
+            entry.nNameOffset = static_cast<uint32_t>(names.size());
+            entry.nFlags = compressed[i].IsEmpty() ? 0u : static_cast<uint32_t>(PACK_ENTRY_ZLIB);
+
+            names.append(m_Sources[i].name);
+            names.push_back('\0');
+
+            offset = (offset + entry.nStoredSize + kPackAlignment - 1) & ~(kPackAlignment - 1);
+        }
+
+        std::vector<AssetPackEntry> toc(entries);
+        std::stable_sort(toc.begin(), toc.end(),
+            [](const AssetPackEntry& a, const AssetPackEntry& b) { return a.nHash < b.nHash; });
+
+        FILE* fp = fopen(path, "wb");
+        if (!fp)
+        {
+            fprintf(stderr, "Cannot create '%s'\n", path);
+            return false;
+        }
+
+        AssetPackHeader header = { kPackMagic, kPackVersion, static_cast<uint32_t>(toc.size()), static_cast<uint32_t>(names.size()) };
+        bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+        ok = ok && (toc.empty() || fwrite(toc.data(), sizeof(AssetPackEntry), toc.size(), fp) == toc.size());
+        ok = ok && fwrite(names.data(), 1, names.size(), fp) == names.size();
+
+        offset = sizeof(header) + toc.size() * sizeof(AssetPackEntry) + names.size();
+        for (size_t i = 0; ok && i < m_Sources.size(); i++)
+        {
+            ok = WritePadding(fp, offset);
+
+            const uint8_t* pData = compressed[i].IsEmpty() ? m_Sources[i].data.GetData() : compressed[i].GetData();
+            size_t size = static_cast<size_t>(entries[i].nStoredSize);
+            ok = ok && (size == 0 || fwrite(pData, 1, size, fp) == size);
+            offset += size;
+        }
+
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok) fprintf(stderr, "Cannot write '%s'\n", path);
+        return ok;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BufferView.h"
+#include "BuildCache.h"
+
+namespace Corona
+{
+    // Layout of a Corona pack (.cpk), little endian:
+    //   AssetPackHeader
+    //   AssetPackEntry[nEntryCount]   table of contents, sorted by the hash of the path
+    //   char[nNamesSize]              the relative paths below Asset/, '\0' terminated
+    //   entry data                    every entry starts at a kPackAlignment offset
+    // Uncompressed entries are served straight out of a single mapping of the pack.
+    static const uint32_t kPackMagic = 0x4B415043;   // "CPAK"
+    static const uint32_t kPackVersion = 1;
+    static const uint64_t kPackAlignment = 4096;
+
+    struct AssetPackHeader
+    {
+        uint32_t nMagic;
+        uint32_t nVersion;
+        uint32_t nEntryCount;
+        uint32_t nNamesSize;
+    };
+
+    enum AssetPackEntryFlags : uint32_t
+    {
+        PACK_ENTRY_ZLIB = 1     // stored zlib compressed
+    };
+
+    struct AssetPackEntry
+    {
+        uint64_t nHash;         // HashAssetPath() of the name
+        uint64_t nOffset;       // from the start of the pack
+        uint64_t nStoredSize;   // bytes in the pack
+        uint64_t nSize;         // bytes after decompression
+        uint32_t nNameOffset;   // into the names
+        uint32_t nFlags;
+    };
+
+    // FNV-1a of a normalized relative path like "Scene/FlightHelmet/FlightHelmet.gltf"
+    uint64_t HashAssetPath(const char* path);
+
+    // A mounted pack, read only. Safe to use from several threads.
+    class AssetPack
+    {
+    public:
+        AssetPack() : m_pHeader(nullptr), m_pEntries(nullptr), m_pNames(nullptr) {}
+
+        // maps the pack, false if it is missing or no valid pack
+        bool Open(const char* path);
+
+        // entry of a normalized relative path, nullptr if it is not in the pack
+        const AssetPackEntry* Find(const char* name) const;
+
+        // content of the entry: a view into the mapping, or a buffer with the
+        // inflated data for compressed entries. Empty if it does not inflate.
+        BufferView Read(const AssetPackEntry& entry) const;
+
+        const std::string& GetPath(void) const { return m_strPath; }
+        uint32_t GetEntryCount(void) const { return m_pHeader ? m_pHeader->nEntryCount : 0; }
+        const AssetPackEntry& GetEntry(uint32_t index) const { return m_pEntries[index]; }
+        const char* GetEntryName(const AssetPackEntry& entry) const { return m_pNames + entry.nNameOffset; }
+
+    private:
+        std::string m_strPath;
+        BufferView m_File;
+        const AssetPackHeader* m_pHeader;
+        const AssetPackEntry* m_pEntries;
+        const char* m_pNames;
+    };
+
+    // Builds a pack out of files added one by one.
+    class AssetPackWriter
+    {
+    public:
+        // compressed entries are looked up in and added to the cache
+        void SetBuildCache(BuildCache* pCache) { m_pBuildCache = pCache; }
+
+        // name is the normalized relative path. Compressed entries are stored
+        // compressed only when that saves at least an eighth of the size.
+        void AddFile(const std::string& name, const BufferView& data, bool compress);
+
+        // level: zlib compression level, 1 (fast) to 9 (small)
+        bool Write(const char* path, int level = 6);
+
+    private:
+        struct Source
+        {
+            std::string name;
+            BufferView data;
+            bool bCompress;
+        };
+
+        std::vector<Source> m_Sources;
+        BuildCache* m_pBuildCache = nullptr;
+    };
+}
@@ -30,6 +30,13 @@ namespace Corona
             return ret;
         }
 
+        if ((ret = g_pImageCache->Initialize()) != 0)
+        {
+            cerr << "Failed. err = " << ret;
+            return ret;
+        }
+        g_pImageCache->SetMaxTextureSize(m_Config.maxTextureSize);
+
         if ((ret = g_pSceneManager->Initialize()) != 0)
         {
             cerr << "Failed. err = " << ret;
@@ -89,6 +96,7 @@ namespace Corona
         g_pGraphicsManager->Finalize();
         // g_pPhysicsManager->Finalize();
         g_pSceneManager->Finalize();
+        g_pImageCache->Finalize();
         g_pAssetLoader->Finalize();
         g_pMemoryManager->Finalize();
     }
@@ -98,6 +106,7 @@ namespace Corona
     {
         g_pMemoryManager->Tick();
         g_pAssetLoader->Tick();
+        g_pImageCache->Tick();
         g_pSceneManager->Tick();
         g_pInputManager->Tick();
         // g_pPhysicsManager->Tick();
@@ -3,6 +3,7 @@
 #include "GraphicsManager.h"
 #include "MemoryManager.h"
 #include "AssetLoader.h"
+#include "ImageCache.h"
 #include "SceneManager.h"
 #include "InputManager.h"
 #include "IPhysicsManager.h"
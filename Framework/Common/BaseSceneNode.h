@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include "geommath.h"
+#include "PoolAllocator.h"
 #include "Tree.h"
 #include "SceneObject.h"
 
@@ -27,7 +28,8 @@ namespace Corona
 		// ? index
 		uint32_t Index;
 
-		std::vector<std::shared_ptr<SceneNode>> m_Children;
+		// owned by the node pools of the scene
+		pooled::vector<SceneNode*, MemoryTag::Scene> m_Children;
 
 		// std::map<int, std::shared_ptr<SceneObjectAnimationClip>> m_AnimationClips;
 		Matrix4X4f Matrix;
@@ -79,10 +81,10 @@ namespace Corona
 
 		const std::string GetName() const { return m_strName; };
 
-		void AppendChild(std::shared_ptr<SceneNode> &&sub_node)
+		void AppendChild(SceneNode *sub_node)
 		{
 			sub_node->m_Parent = this;
-			m_Children.push_back(std::move(sub_node));
+			m_Children.push_back(sub_node);
 		}
 
 	public:
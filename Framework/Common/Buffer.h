@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <string.h>
 #include "MemoryManager.h"
 
 namespace Corona
@@ -10,16 +11,17 @@ namespace Corona
     class Buffer 
     {
     public:
-        Buffer() : m_pData(nullptr), m_szSize(0), m_szAlignment(alignof(uint32_t)) {}
+        Buffer() : m_pData(nullptr), m_szSize(0), m_szAlignment(alignof(uint32_t)), m_Tag(MemoryTag::General) {}
 
-        Buffer(size_t size, size_t alignment = 4) : m_szSize(size), m_szAlignment(alignment) { m_pData = reinterpret_cast<uint8_t*>(g_pMemoryManager->Allocate(size, alignment)); }
+        Buffer(size_t size, size_t alignment = 4, MemoryTag tag = MemoryTag::General) : m_szSize(size), m_szAlignment(alignment), m_Tag(tag) { m_pData = reinterpret_cast<uint8_t*>(g_pMemoryManager->AllocateAligned(size, alignment, tag)); }
 
         Buffer(const Buffer& rhs) 
         { 
-            m_pData = reinterpret_cast<uint8_t*>(g_pMemoryManager->Allocate(rhs.m_szSize, rhs.m_szAlignment)); 
+            m_pData = reinterpret_cast<uint8_t*>(g_pMemoryManager->AllocateAligned(rhs.m_szSize, rhs.m_szAlignment, rhs.m_Tag)); 
             memcpy(m_pData, rhs.m_pData, rhs.m_szSize);
             m_szSize =  rhs.m_szSize;
             m_szAlignment = rhs.m_szAlignment;
+            m_Tag = rhs.m_Tag;
         }
 
         Buffer(Buffer&& rhs) 
@@ -27,6 +29,7 @@ namespace Corona
             m_pData = rhs.m_pData;
             m_szSize = rhs.m_szSize;
             m_szAlignment = rhs.m_szAlignment;
+            m_Tag = rhs.m_Tag;
             rhs.m_pData = nullptr;
             rhs.m_szSize = 0;
             rhs.m_szAlignment = 4;
@@ -40,44 +43,50 @@ namespace Corona
             } 
             else 
             {
-                if (m_pData) g_pMemoryManager->Free(m_pData, m_szSize); 
-                m_pData = reinterpret_cast<uint8_t*>(g_pMemoryManager->Allocate(rhs.m_szSize, rhs.m_szAlignment)); 
+                if (m_pData) g_pMemoryManager->FreeAligned(m_pData, m_szSize, m_szAlignment, m_Tag); 
+                m_pData = reinterpret_cast<uint8_t*>(g_pMemoryManager->AllocateAligned(rhs.m_szSize, rhs.m_szAlignment, rhs.m_Tag)); 
                 memcpy(m_pData, rhs.m_pData, rhs.m_szSize);
                 m_szSize =  rhs.m_szSize;
                 m_szAlignment = rhs.m_szAlignment;
+                m_Tag = rhs.m_Tag;
             }
             return *this; 
         }
 
         Buffer& operator = (Buffer&& rhs) 
         { 
-            if (m_pData) g_pMemoryManager->Free(m_pData, m_szSize); 
+            if (m_pData) g_pMemoryManager->FreeAligned(m_pData, m_szSize, m_szAlignment, m_Tag); 
             m_pData = rhs.m_pData;
             m_szSize = rhs.m_szSize;
             m_szAlignment = rhs.m_szAlignment;
+            m_Tag = rhs.m_Tag;
             rhs.m_pData = nullptr;
             rhs.m_szSize = 0;
             rhs.m_szAlignment = 4;
             return *this; 
         }
 
-        ~Buffer() { if (m_pData) g_pMemoryManager->Free(m_pData, m_szSize); m_pData = nullptr; }
+        ~Buffer() { if (m_pData) g_pMemoryManager->FreeAligned(m_pData, m_szSize, m_szAlignment, m_Tag); m_pData = nullptr; }
 
         uint8_t* GetData(void) { return m_pData; };
         const uint8_t* GetData(void) const { return m_pData; };
         size_t GetDataSize(void) const { return m_szSize; }
 
-		void SetData(uint8_t* data, size_t size) {
+		// takes over memory from g_pMemoryManager->AllocateAligned(size, alignment, tag)
+		void SetData(uint8_t* data, size_t size, size_t alignment = 4, MemoryTag tag = MemoryTag::General) {
 			if (m_pData != nullptr) {
-				delete[] m_pData;
+				g_pMemoryManager->FreeAligned(m_pData, m_szSize, m_szAlignment, m_Tag);
 			}
 			m_pData = data;
 			m_szSize = size;
+			m_szAlignment = alignment;
+			m_Tag = tag;
 		}
 
     protected:
         uint8_t* m_pData;
         size_t m_szSize;
         size_t m_szAlignment;
+        MemoryTag m_Tag;
     };
 }
\ No newline at end of file
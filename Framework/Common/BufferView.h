@@ -0,0 +1,69 @@
+#pragma once
+
+#include <assert.h>
+#include <memory>
+#include <vector>
+#include "Buffer.h"
+
+namespace Corona
+{
+    // Immutable slice (offset, length, stride) of a reference-counted backing store.
+    // Copies and sub-views share the store without copying any bytes, the store is
+    // released together with the last view that refers to it.
+    class BufferView
+    {
+    public:
+        BufferView() : m_pData(nullptr), m_szSize(0), m_szStride(0) {}
+
+        // takes the memory of the buffer over, nothing is copied
+        explicit BufferView(Buffer&& buf) : m_szStride(0)
+        {
+            auto pStorage = std::make_shared<Buffer>(std::move(buf));
+            m_pData = pStorage->GetData();
+            m_szSize = pStorage->GetDataSize();
+            m_pStorage = std::move(pStorage);
+        }
+
+        explicit BufferView(std::vector<uint8_t>&& bytes) : m_szStride(0)
+        {
+            auto pStorage = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+            m_pData = pStorage->data();
+            m_szSize = pStorage->size();
+            m_pStorage = std::move(pStorage);
+        }
+
+        // a view of [data, data + size) kept valid by storage, e.g. a file mapping
+        BufferView(std::shared_ptr<const void> storage, const uint8_t* data, size_t size)
+            : m_pStorage(std::move(storage)), m_pData(data), m_szSize(size), m_szStride(0)
+        {
+        }
+
+        // a view of size bytes from offset on, sharing the backing store
+        BufferView SubView(size_t offset, size_t size, size_t stride = 0) const
+        {
+            assert(offset <= m_szSize && size <= m_szSize - offset);
+
+            BufferView view(*this);
+            view.m_pData = m_pData + offset;
+            view.m_szSize = size;
+            view.m_szStride = stride;
+            return view;
+        }
+
+        const uint8_t* GetData(void) const { return m_pData; }
+        size_t GetDataSize(void) const { return m_szSize; }
+        // distance between two elements, 0 when the view is not an array of elements
+        size_t GetStride(void) const { return m_szStride; }
+        size_t GetElementCount(void) const { return m_szStride ? m_szSize / m_szStride : 0; }
+        bool IsEmpty(void) const { return m_szSize == 0; }
+
+        // number of views sharing the backing store
+        long GetUseCount(void) const { return m_pStorage.use_count(); }
+
+    private:
+        std::shared_ptr<const void> m_pStorage;
+        const uint8_t* m_pData;
+        size_t m_szSize;
+        size_t m_szStride;
+    };
+}
@@ -0,0 +1,186 @@
+#include "BuildCache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "AssetPack.h"
+#include "FileMapping.h"
+
+namespace Corona
+{
+    uint64_t BuildCache::HashContent(const uint8_t* pData, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, pData + i, 8);
+            hash = (hash ^ word) * 1099511628211ull;
+            hash ^= hash >> 32;
+        }
+        for (; i < size; i++)
+        {
+            hash = (hash ^ pData[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool BuildCache::Open(const std::string& directory)
+    {
+        Close();
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (!std::filesystem::is_directory(directory, ec))
+        {
+            fprintf(stderr, "Cannot open build cache '%s'\n", directory.c_str());
+            return false;
+        }
+
+        m_strDirectory = directory;
+        return true;
+    }
+
+    void BuildCache::Close()
+    {
+        m_strDirectory.clear();
+    }
+
+    std::string BuildCache::GetArtifactPath(const std::string& key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.cbc", (unsigned long long)HashAssetPath(key.c_str()));
+        return (std::filesystem::path(m_strDirectory) / name).string();
+    }
+
+    bool BuildCache::Find(const std::string& key, uint32_t version, const std::vector<BuildInput>& inputs, BufferView& data)
+    {
+        data = BufferView();
+        if (!IsOpen()) return false;
+
+        auto pMapping = std::make_shared<FileMapping>();
+        if (!pMapping->Open(GetArtifactPath(key).c_str()))
+        {
+            m_nMisses++;
+            return false;
+        }
+
+        const uint8_t* pFile = pMapping->GetData();
+        size_t size = pMapping->GetDataSize();
+
+        BuildCacheHeader header;
+        if (size < sizeof(header))
+        {
+            m_nStale++;
+            return false;
+        }
+        memcpy(&header, pFile, sizeof(header));
+
+        uint64_t inputs_end = sizeof(header) + uint64_t(header.nInputCount) * sizeof(BuildInput);
+        uint64_t key_end = inputs_end + header.nKeySize;
+        uint64_t data_offset = (key_end + kBuildCacheAlignment - 1) & ~(kBuildCacheAlignment - 1);
+        if (header.nMagic != kBuildCacheMagic || header.nFormat != kBuildCacheFormat ||
+            data_offset > size || header.nDataSize != size - data_offset)
+        {
+            m_nStale++;
+            return false;
+        }
+
+        // a key of the same hash
+        if (header.nKeySize != key.size() || memcmp(pFile + inputs_end, key.data(), key.size()) != 0)
+        {
+            m_nMisses++;
+            return false;
+        }
+
+        bool current = header.nVersion == version && header.nInputCount == inputs.size();
+        for (size_t i = 0; current && i < inputs.size(); i++)
+        {
+            BuildInput input;
+            memcpy(&input, pFile + sizeof(header) + i * sizeof(BuildInput), sizeof(input));
+            current = input == inputs[i];
+        }
+        if (!current)
+        {
+            m_nStale++;
+            return false;
+        }
+
+        data = BufferView(std::move(pMapping), pFile + data_offset, static_cast<size_t>(header.nDataSize));
+        m_nHits++;
+        return true;
+    }
+
+    bool BuildCache::Store(const std::string& key, uint32_t version, const std::vector<BuildInput>& inputs,
+                           const std::vector<BufferView>& parts)
+    {
+        if (!IsOpen()) return false;
+
+        BuildCacheHeader header = {};
+        header.nMagic = kBuildCacheMagic;
+        header.nFormat = kBuildCacheFormat;
+        header.nVersion = version;
+        header.nInputCount = static_cast<uint32_t>(inputs.size());
+        header.nKeySize = static_cast<uint32_t>(key.size());
+        for (auto& part : parts) header.nDataSize += part.GetDataSize();
+
+        // written aside and renamed over the old artifact, readers never see half of one
+        std::string path = GetArtifactPath(key);
+        std::string temp = path + '.' + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                                                        static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count())) +
+                           '.' + std::to_string(m_nTempFile++);
+
+        FILE* fp = fopen(temp.c_str(), "wb");
+        if (!fp) return false;
+
+        static const uint8_t zeros[kBuildCacheAlignment] = {};
+        uint64_t key_end = sizeof(header) + inputs.size() * sizeof(BuildInput) + key.size();
+        size_t padding = static_cast<size_t>((kBuildCacheAlignment - key_end % kBuildCacheAlignment) % kBuildCacheAlignment);
+
+        bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+        ok = ok && (inputs.empty() || fwrite(inputs.data(), sizeof(BuildInput), inputs.size(), fp) == inputs.size());
+        ok = ok && fwrite(key.data(), 1, key.size(), fp) == key.size();
+        ok = ok && fwrite(zeros, 1, padding, fp) == padding;
+        for (auto& part : parts)
+        {
+            ok = ok && (part.IsEmpty() || fwrite(part.GetData(), 1, part.GetDataSize(), fp) == part.GetDataSize());
+        }
+        ok = (fclose(fp) == 0) && ok;
+
+        std::error_code ec;
+        if (ok) std::filesystem::rename(temp, path, ec);
+        if (!ok || ec)
+        {
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+
+        m_nStores++;
+        return true;
+    }
+
+    void BuildCache::Clear()
+    {
+        if (!IsOpen()) return;
+
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator(m_strDirectory, ec))
+        {
+            if (entry.path().extension() == ".cbc") std::filesystem::remove(entry.path(), ec);
+        }
+    }
+
+    BuildCache::Stats BuildCache::GetStats() const
+    {
+        Stats stats;
+        stats.nHits = m_nHits;
+        stats.nMisses = m_nMisses;
+        stats.nStale = m_nStale;
+        stats.nStores = m_nStores;
+        return stats;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BufferView.h"
+
+namespace Corona
+{
+    // An input of a cooked artifact, known by its content.
+    struct BuildInput
+    {
+        uint64_t nHash;
+        uint64_t nSize;
+
+        bool operator==(const BuildInput& other) const { return nHash == other.nHash && nSize == other.nSize; }
+        bool operator!=(const BuildInput& other) const { return !(*this == other); }
+    };
+
+    // Layout of an artifact file, little endian:
+    //   BuildCacheHeader
+    //   BuildInput[nInputCount]
+    //   char[nKeySize]             the key, to tell keys of the same hash apart
+    //   data                       at a kBuildCacheAlignment offset
+    static const uint32_t kBuildCacheMagic = 0x43424F43;     // "COBC"
+    static const uint32_t kBuildCacheFormat = 1;
+    static const uint64_t kBuildCacheAlignment = 16;
+
+    struct BuildCacheHeader
+    {
+        uint32_t nMagic;
+        uint32_t nFormat;
+        uint32_t nVersion;      // of the processor that made the data
+        uint32_t nInputCount;
+        uint32_t nKeySize;
+        uint32_t nReserved;
+        uint64_t nDataSize;
+    };
+
+    // On-disk cache of cooked data: decoded textures, converted vertex data,
+    // compressed pack entries. Every artifact records the content of the inputs
+    // it was made of and the version of the processor that made it, a lookup
+    // only hits while both still match. Each artifact is a file of its own,
+    // named after a hash of its key and replaced atomically, so processes may
+    // share the directory. Safe to use from several threads.
+    class BuildCache
+    {
+    public:
+        struct Stats
+        {
+            uint64_t nHits;
+            uint64_t nMisses;       // nothing cooked for the key
+            uint64_t nStale;        // cooked from other inputs or by another version
+            uint64_t nStores;
+        };
+
+        BuildCache() {}
+        BuildCache(const BuildCache&) = delete;
+        BuildCache& operator=(const BuildCache&) = delete;
+
+        // creates the directory if needed, false if it cannot
+        bool Open(const std::string& directory);
+        void Close(void);
+        bool IsOpen(void) const { return !m_strDirectory.empty(); }
+        const std::string& GetDirectory(void) const { return m_strDirectory; }
+
+        // The data cooked for key from exactly these inputs by this version of
+        // the processor, mapped. False when there is none, data is left empty.
+        bool Find(const std::string& key, uint32_t version, const std::vector<BuildInput>& inputs, BufferView& data);
+
+        // Replaces whatever key had, the data is the parts one after the other.
+        bool Store(const std::string& key, uint32_t version, const std::vector<BuildInput>& inputs,
+                   const std::vector<BufferView>& parts);
+        bool Store(const std::string& key, uint32_t version, const std::vector<BuildInput>& inputs, const BufferView& data)
+        {
+            return Store(key, version, inputs, std::vector<BufferView>{ data });
+        }
+
+        // drops every artifact
+        void Clear(void);
+
+        Stats GetStats(void) const;
+
+        // FNV-1a over 8 byte words, good enough to tell contents apart
+        static uint64_t HashContent(const uint8_t* pData, size_t size);
+        static BuildInput HashInput(const BufferView& data)
+        {
+            return { HashContent(data.GetData(), data.GetDataSize()), data.GetDataSize() };
+        }
+
+    private:
+        std::string GetArtifactPath(const std::string& key) const;
+
+        std::string m_strDirectory;
+        std::atomic<uint64_t> m_nHits{ 0 };
+        std::atomic<uint64_t> m_nMisses{ 0 };
+        std::atomic<uint64_t> m_nStale{ 0 };
+        std::atomic<uint64_t> m_nStores{ 0 };
+        std::atomic<uint32_t> m_nTempFile{ 0 };
+    };
+}
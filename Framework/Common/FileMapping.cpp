@@ -0,0 +1,93 @@
+#include "FileMapping.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Corona
+{
+#if defined(_WIN32)
+    bool FileMapping::Open(const char* path)
+    {
+        Close();
+
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        // the view keeps the file and the mapping object alive by itself
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+
+        if (!p) return false;
+
+        m_pData = static_cast<const uint8_t*>(p);
+        m_szSize = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void FileMapping::Close()
+    {
+        if (m_pData) UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+        m_szSize = 0;
+    }
+#else
+    bool FileMapping::Open(const char* path)
+    {
+        Close();
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // the mapping holds its own reference to the file
+        close(fd);
+
+        if (p == MAP_FAILED) return false;
+
+        // parsers walk assets front to back: read ahead aggressively, start now
+#if defined(MADV_SEQUENTIAL)
+        madvise(p, size, MADV_SEQUENTIAL);
+#endif
+#if defined(MADV_WILLNEED)
+        madvise(p, size, MADV_WILLNEED);
+#endif
+
+        m_pData = static_cast<const uint8_t*>(p);
+        m_szSize = size;
+        return true;
+    }
+
+    void FileMapping::Close()
+    {
+        if (m_pData) munmap(const_cast<uint8_t*>(m_pData), m_szSize);
+        m_pData = nullptr;
+        m_szSize = 0;
+    }
+#endif
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Corona
+{
+    // Read-only view of a whole file mapped into the address space. Pages are
+    // read in on first touch and shared with every process mapping the same file,
+    // nothing is copied into the heap. The view stays valid until Close().
+    class FileMapping
+    {
+    public:
+        FileMapping() : m_pData(nullptr), m_szSize(0) {}
+        ~FileMapping() { Close(); }
+
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+
+        // false when the file is missing, empty or cannot be mapped
+        bool Open(const char* path);
+        void Close();
+
+        const uint8_t* GetData(void) const { return m_pData; }
+        size_t GetDataSize(void) const { return m_szSize; }
+        bool IsOpen(void) const { return m_pData != nullptr; }
+
+    private:
+        const uint8_t* m_pData;
+        size_t m_szSize;
+    };
+}
@@ -0,0 +1,195 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <system_error>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Corona
+{
+    // how often files without notifications are looked at
+    static const std::chrono::milliseconds kPollInterval(250);
+
+    bool FileWatcher::Watch(const std::string& path)
+    {
+        std::error_code ec;
+        File file;
+        file.tWrite = std::filesystem::last_write_time(path, ec);
+        if (!ec) file.szSize = std::filesystem::file_size(path, ec);
+        if (ec) return false;
+
+        if (m_Files.find(path) != m_Files.end()) return true;
+
+        std::filesystem::path absolute = std::filesystem::absolute(path, ec).lexically_normal();
+        if (ec) return false;
+        file.directory = absolute.parent_path().string();
+        file.bNotified = false;
+
+#if defined(__linux__)
+        if (m_nInotifyFd < 0 && !m_bInotifyFailed)
+        {
+            m_nInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            m_bInotifyFailed = m_nInotifyFd < 0;
+        }
+
+        if (m_nInotifyFd >= 0)
+        {
+            auto dir = m_Directories.find(file.directory);
+            if (dir == m_Directories.end())
+            {
+                // editors often write a new file and rename it over the old one
+                int watch = inotify_add_watch(m_nInotifyFd, file.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                if (watch >= 0)
+                {
+                    dir = m_Directories.emplace(file.directory, Directory{ watch, {} }).first;
+                    m_WatchDirectories[watch] = file.directory;
+                }
+            }
+
+            if (dir != m_Directories.end())
+            {
+                dir->second.files[absolute.filename().string()] = path;
+                file.bNotified = true;
+            }
+        }
+#endif
+
+        m_Files.emplace(path, std::move(file));
+        return true;
+    }
+
+    void FileWatcher::Unwatch(const std::string& path)
+    {
+        auto it = m_Files.find(path);
+        if (it == m_Files.end()) return;
+
+#if defined(__linux__)
+        auto dir = m_Directories.find(it->second.directory);
+        if (it->second.bNotified && dir != m_Directories.end())
+        {
+            auto& files = dir->second.files;
+            for (auto file = files.begin(); file != files.end(); ++file)
+            {
+                if (file->second == path)
+                {
+                    files.erase(file);
+                    break;
+                }
+            }
+
+            if (files.empty())
+            {
+                inotify_rm_watch(m_nInotifyFd, dir->second.nWatch);
+                m_WatchDirectories.erase(dir->second.nWatch);
+                m_Directories.erase(dir);
+            }
+        }
+#endif
+
+        m_Files.erase(it);
+    }
+
+    void FileWatcher::Finalize()
+    {
+#if defined(__linux__)
+        if (m_nInotifyFd >= 0) close(m_nInotifyFd);
+#endif
+        m_nInotifyFd = -1;
+        m_bInotifyFailed = false;
+        m_Directories.clear();
+        m_WatchDirectories.clear();
+        m_Files.clear();
+    }
+
+    void FileWatcher::DropDirectory(int watch)
+    {
+        auto it = m_WatchDirectories.find(watch);
+        if (it == m_WatchDirectories.end()) return;
+
+        // the files left are polled from now on
+        auto dir = m_Directories.find(it->second);
+        if (dir != m_Directories.end())
+        {
+            for (auto& file : dir->second.files)
+            {
+                auto f = m_Files.find(file.second);
+                if (f != m_Files.end()) f->second.bNotified = false;
+            }
+            m_Directories.erase(dir);
+        }
+        m_WatchDirectories.erase(it);
+    }
+
+    void FileWatcher::Poll(std::vector<std::string>& changed)
+    {
+        size_t first = changed.size();
+
+#if defined(__linux__)
+        if (m_nInotifyFd >= 0)
+        {
+            alignas(struct inotify_event) char events[4096];
+            ssize_t size;
+            while ((size = read(m_nInotifyFd, events, sizeof(events))) > 0)
+            {
+                for (char* p = events; p < events + size; )
+                {
+                    const struct inotify_event* pEvent = reinterpret_cast<const struct inotify_event*>(p);
+                    p += sizeof(struct inotify_event) + pEvent->len;
+
+                    if (pEvent->mask & IN_Q_OVERFLOW)
+                    {
+                        // events were lost, any file may have changed
+                        for (auto& file : m_Files)
+                        {
+                            if (file.second.bNotified) changed.push_back(file.first);
+                        }
+                        continue;
+                    }
+
+                    if (pEvent->mask & IN_IGNORED)
+                    {
+                        // the directory is gone
+                        DropDirectory(pEvent->wd);
+                        continue;
+                    }
+
+                    auto dir = m_WatchDirectories.find(pEvent->wd);
+                    if (dir == m_WatchDirectories.end() || pEvent->len == 0) continue;
+
+                    auto& files = m_Directories[dir->second].files;
+                    auto file = files.find(pEvent->name);
+                    if (file != files.end()) changed.push_back(file->second);
+                }
+            }
+        }
+#endif
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - m_tLastPoll >= kPollInterval)
+        {
+            m_tLastPoll = now;
+            for (auto& file : m_Files)
+            {
+                if (file.second.bNotified) continue;
+
+                std::error_code ec;
+                auto time = std::filesystem::last_write_time(file.first, ec);
+                uintmax_t size = ec ? 0 : std::filesystem::file_size(file.first, ec);
+                // missing for the moment, e.g. while it is being replaced
+                if (ec) continue;
+
+                if (time != file.second.tWrite || size != file.second.szSize)
+                {
+                    file.second.tWrite = time;
+                    file.second.szSize = size;
+                    changed.push_back(file.first);
+                }
+            }
+        }
+
+        std::sort(changed.begin() + first, changed.end());
+        changed.erase(std::unique(changed.begin() + first, changed.end()), changed.end());
+    }
+}
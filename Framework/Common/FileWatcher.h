@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Corona
+{
+    // Tells which of the watched files were written to. On Linux the directories
+    // of the files are watched through inotify, nothing is touched until a file
+    // changes. Elsewhere, or when inotify runs out of watches, the modification
+    // times are polled a few times a second. Not thread safe, the AssetLoader
+    // polls it from Tick().
+    class FileWatcher
+    {
+    public:
+        FileWatcher() {}
+        ~FileWatcher() { Finalize(); }
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // false when the file does not exist
+        bool Watch(const std::string& path);
+        void Unwatch(const std::string& path);
+        // stops watching everything
+        void Finalize();
+
+        // appends the watched files written to since the last call, each once and
+        // spelled as they were passed to Watch()
+        void Poll(std::vector<std::string>& changed);
+
+        bool IsWatching(void) const { return !m_Files.empty(); }
+        // the OS reports the changes, nothing is polled
+        bool IsNotified(void) const { return m_nInotifyFd >= 0; }
+
+    private:
+        struct File
+        {
+            std::filesystem::file_time_type tWrite;
+            uintmax_t szSize;
+            std::string directory;      // absolute, key of m_Directories
+            bool bNotified;             // by inotify, otherwise polled
+        };
+
+        // inotify watches whole directories
+        struct Directory
+        {
+            int nWatch;
+            std::unordered_map<std::string, std::string> files;     // file name -> path as watched
+        };
+
+        void DropDirectory(int watch);
+
+        std::unordered_map<std::string, File> m_Files;
+        std::chrono::steady_clock::time_point m_tLastPoll;
+
+        int m_nInotifyFd = -1;
+        bool m_bInotifyFailed = false;
+        std::unordered_map<std::string, Directory> m_Directories;
+        std::unordered_map<int, std::string> m_WatchDirectories;
+    };
+}
@@ -0,0 +1,112 @@
+#include "FrameArena.h"
+#include <cstdlib>
+
+#ifndef ALIGN
+#define ALIGN(x, a) (((x) + ((a) - 1)) & ~((a) - 1))
+#endif
+
+namespace Corona
+{
+    // growth granularity of the arena and minimal size of an overflow chunk
+    static const size_t kArenaGranularity = 64 * 1024;
+
+    FrameArena::FrameArena()
+        : m_pBase(nullptr), m_szCapacity(0), m_szOffset(0),
+        m_pOverflowList(nullptr), m_pOverflowCursor(nullptr), m_pOverflowEnd(nullptr),
+        m_szOverflowSize(0), m_szPeakSize(0)
+    {
+    }
+
+    FrameArena::~FrameArena()
+    {
+        Finalize();
+    }
+
+    void FrameArena::Initialize(size_t capacity)
+    {
+        Finalize();
+
+        m_szCapacity = ALIGN(capacity, kArenaGranularity);
+        m_pBase = reinterpret_cast<uint8_t*>(malloc(m_szCapacity));
+    }
+
+    void FrameArena::Finalize()
+    {
+        FreeOverflow();
+
+        free(m_pBase);
+        m_pBase = nullptr;
+        m_szCapacity = 0;
+        m_szOffset = 0;
+        m_szPeakSize = 0;
+    }
+
+    void* FrameArena::Allocate(size_t size, size_t alignment)
+    {
+        // align the address, not the offset, malloc only guarantees 16 bytes
+        size_t base = reinterpret_cast<size_t>(m_pBase);
+        size_t offset = ALIGN(base + m_szOffset, alignment) - base;
+
+        if (m_pBase && offset + size <= m_szCapacity)
+        {
+            m_szOffset = offset + size;
+            return m_pBase + offset;
+        }
+
+        return AllocateOverflow(size, alignment);
+    }
+
+    void* FrameArena::AllocateOverflow(size_t size, size_t alignment)
+    {
+        size_t cursor = ALIGN(reinterpret_cast<size_t>(m_pOverflowCursor), alignment);
+        if (!m_pOverflowCursor || cursor + size > reinterpret_cast<size_t>(m_pOverflowEnd))
+        {
+            size_t chunk_size = ALIGN(sizeof(OverflowChunk) + size + alignment, kArenaGranularity);
+            OverflowChunk* pChunk = reinterpret_cast<OverflowChunk*>(malloc(chunk_size));
+            if (!pChunk) return nullptr;
+
+            pChunk->pNext = m_pOverflowList;
+            pChunk->szSize = chunk_size;
+            m_pOverflowList = pChunk;
+
+            m_pOverflowCursor = reinterpret_cast<uint8_t*>(pChunk + 1);
+            m_pOverflowEnd = reinterpret_cast<uint8_t*>(pChunk) + chunk_size;
+            cursor = ALIGN(reinterpret_cast<size_t>(m_pOverflowCursor), alignment);
+        }
+
+        m_szOverflowSize += cursor + size - reinterpret_cast<size_t>(m_pOverflowCursor);
+        m_pOverflowCursor = reinterpret_cast<uint8_t*>(cursor + size);
+
+        return reinterpret_cast<void*>(cursor);
+    }
+
+    void FrameArena::FreeOverflow()
+    {
+        while (m_pOverflowList)
+        {
+            OverflowChunk* pChunk = m_pOverflowList;
+            m_pOverflowList = pChunk->pNext;
+            free(pChunk);
+        }
+
+        m_pOverflowCursor = nullptr;
+        m_pOverflowEnd = nullptr;
+        m_szOverflowSize = 0;
+    }
+
+    void FrameArena::Reset()
+    {
+        size_t used = GetUsedSize();
+        if (used > m_szPeakSize) m_szPeakSize = used;
+
+        if (m_pOverflowList)
+        {
+            // the frame did not fit, grow to the peak so the next one will
+            size_t peak = m_szPeakSize;
+            Initialize(peak + peak / 4);
+            m_szPeakSize = peak;
+        }
+
+        m_szOffset = 0;
+    }
+}
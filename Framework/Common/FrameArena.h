@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace Corona
+{
+    // Linear (bump-pointer) allocator for data that only lives for one frame.
+    // Nothing is freed one by one, the whole arena is reset when its frame index
+    // is reused. Not synchronized, it belongs to the thread that renders the frame.
+    class FrameArena
+    {
+    public:
+        static const size_t kDefaultAlignment = 16;
+
+        FrameArena();
+        ~FrameArena();
+
+        void Initialize(size_t capacity);
+        void Finalize();
+
+        void* Allocate(size_t size, size_t alignment = kDefaultAlignment);
+
+        // drops every allocation of the frame, if the frame did not fit into the
+        // arena it is grown to the peak usage so the next frames do not overflow
+        void Reset();
+
+        size_t GetCapacity() const { return m_szCapacity; }
+        size_t GetUsedSize() const { return m_szOffset + m_szOverflowSize; }
+        size_t GetPeakSize() const { return m_szPeakSize; }
+
+    private:
+        struct OverflowChunk
+        {
+            OverflowChunk* pNext;
+            size_t szSize;
+        };
+
+        void* AllocateOverflow(size_t size, size_t alignment);
+        void FreeOverflow();
+
+        uint8_t* m_pBase;
+        size_t m_szCapacity;
+        size_t m_szOffset;
+
+        // chunks taken from the heap when a frame does not fit into the arena
+        OverflowChunk* m_pOverflowList;
+        uint8_t* m_pOverflowCursor;
+        uint8_t* m_pOverflowEnd;
+        size_t m_szOverflowSize;
+
+        size_t m_szPeakSize;
+
+        // disable copy & assignment
+        FrameArena(const FrameArena& clone);
+        FrameArena& operator=(const FrameArena& rhs);
+    };
+
+    // STL allocator adapter, deallocate is a no-op as the memory goes away on FrameArena::Reset()
+    template<typename T>
+    class FrameAllocator
+    {
+    public:
+        typedef T value_type;
+
+        explicit FrameAllocator(FrameArena& arena) noexcept : m_pArena(&arena) {}
+
+        template<typename U>
+        FrameAllocator(const FrameAllocator<U>& other) noexcept : m_pArena(other.m_pArena) {}
+
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(m_pArena->Allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, size_t) noexcept {}
+
+        template<typename U>
+        bool operator==(const FrameAllocator<U>& rhs) const noexcept { return m_pArena == rhs.m_pArena; }
+
+        template<typename U>
+        bool operator!=(const FrameAllocator<U>& rhs) const noexcept { return m_pArena != rhs.m_pArena; }
+
+    private:
+        FrameArena* m_pArena;
+
+        template<typename U>
+        friend class FrameAllocator;
+    };
+}
@@ -23,7 +23,7 @@ namespace Corona
             uint32_t width = 1920, uint32_t height = 1080, const char* app_name="Corona Engine") :
             redBits(r), greenBits(g), blueBits(b), alphaBits(a),
             depthBits(d), stencilBits(s), msaaSamples(msaa),
-            screenWidth(width), screenHeight(height), appName(app_name)
+            screenWidth(width), screenHeight(height), maxTextureSize(0), appName(app_name)
         {}
 
 		uint32_t redBits; ///< red color channel depth in bits
@@ -35,6 +35,7 @@ namespace Corona
 		uint32_t msaaSamples; ///< MSAA samples
 		uint32_t screenWidth;
 		uint32_t screenHeight;
+		uint32_t maxTextureSize; ///< larger side of the loaded textures in pixel, 0 for no limit
         const char* appName;
 
         friend std::ostream& operator<<(std::ostream& out, const GfxConfiguration& conf)
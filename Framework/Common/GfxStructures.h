@@ -31,7 +31,7 @@ namespace Corona
 
     struct DrawBatchContext
     {
-        std::shared_ptr<SceneNode> node;
+        Handle<SceneNode> node;
         std::shared_ptr<SceneObjectMaterial> material;
         Matrix4X4f trans;
 
@@ -41,7 +41,7 @@ namespace Corona
     struct Frame
     {
         DrawFrameContext frameContext;
-        std::vector<std::shared_ptr<DrawBatchContext>> batchContexts;
+        pooled::vector<std::shared_ptr<DrawBatchContext>> batchContexts;
         intptr_t shadowMap;
         uint32_t shadowMapCount;
 
@@ -1,5 +1,8 @@
 #include <iostream>
+#include <set>
 #include "GraphicsManager.h"
+#include "AssetLoader.h"
+#include "MemoryManager.h"
 #include "SceneManager.h"
 #include "IApplication.h"
 #include "ForwardRenderPass.h"
@@ -15,6 +18,7 @@ namespace Corona
     {
         int result = 0;
         m_Frames.resize(kFrameCount);
+        g_pMemoryManager->InitializeFrameArenas(kFrameCount);
         InitConstants();
         // m_DrawPasses.push_back(make_shared<ShadowMapPass>());
         m_DrawPasses.push_back(make_shared<ForwardRenderPass>());
@@ -24,11 +28,47 @@ namespace Corona
 
     void GraphicsManager::Finalize()
     {
+        UnwatchShaderFiles();
+        // the batch contexts live in MemoryManager pools
+        m_Frames.clear();
     }
 
     void GraphicsManager::Tick()
     {
-        if (g_pSceneManager->IsSceneChanged())
+        // scratch data of the frame we are about to rebuild is no longer referenced
+        g_pMemoryManager->BeginFrame(m_nFrameIndex);
+
+        bool rebuild = g_pSceneManager->IsSceneChanged();
+        if (!rebuild)
+        {
+            if (m_bShadersChanged)
+            {
+                cout << "[GraphicsManager] Detected Shader Change, reload shaders ..." << endl;
+                m_bShadersChanged = false;
+                rebuild = !ReloadShaders();
+            }
+
+            // only the objects whose files changed
+            set<string> textures;
+            for (auto& pObject : g_pSceneManager->GetChangedSceneObjects())
+            {
+                if (rebuild) break;
+
+                if (pObject->GetType() == SceneObjectType::kSceneObjectTypeTexture)
+                {
+                    auto pTexture = static_pointer_cast<SceneObjectTexture>(pObject);
+                    // materials sharing an image have a texture object each
+                    if (textures.insert(pTexture->GetName()).second)
+                        rebuild = !UpdateTexture(*pTexture);
+                }
+                else if (pObject->GetType() == SceneObjectType::kSceneObjectTypeMesh)
+                {
+                    rebuild = !UpdateGeometry(*static_pointer_cast<SceneObjectMesh>(pObject));
+                }
+            }
+        }
+
+        if (rebuild)
         {
             cout << "[GraphicsManager] Detected Scene Change, reinitialize buffers ..." << endl;
             ClearBuffers();
@@ -37,29 +77,36 @@ namespace Corona
             InitializeShaders();
             InitializeBuffers();
             g_pSceneManager->NotifySceneIsRenderingQueued();
+            m_bShadersChanged = false;
         }
+        g_pSceneManager->NotifySceneObjectChangesQueued();
 
         UpdateConstants();
 
         Clear();
         Draw();
+
+        m_nFrameIndex = (m_nFrameIndex + 1) % kFrameCount;
     }
 
     void GraphicsManager::UpdateConstants()
     {
         // update scene object position
         auto& frame = m_Frames[m_nFrameIndex];
+		auto& scene = g_pSceneManager->GetSceneForRendering();
 
-        for (auto dbc : frame.batchContexts)
+        for (auto& dbc : frame.batchContexts)
         {
-            dbc->trans = dbc->node->Transforms.matrix;
+            if (auto pNode = scene.GetNode(dbc->node))
+            {
+                dbc->trans = pNode->Transforms.matrix;
+            }
         }
 
         // TODO: Update scene nodes before update constants (temporary for test)
-		auto& scene = g_pSceneManager->GetSceneForRendering();
-		for (auto& root_node : scene.RootNodes) // should calculate only those needed (camera, light, etc.)
+		for (auto pRootNode : scene.RootNodes) // should calculate only those needed (camera, light, etc.)
 		{
-			root_node.lock()->UpdateTransforms();
+			pRootNode->UpdateTransforms();
 		}
 		// TODO: use this function to get boundbox and BVH
 		// CalculateSceneDimensions();
@@ -113,7 +160,10 @@ namespace Corona
     void GraphicsManager::InitConstants()
     {
         // Initialize the world/model matrix to the identity matrix.
-        BuildIdentityMatrix(m_Frames[m_nFrameIndex].m_worldMatrix);
+        for (auto& frame : m_Frames)
+        {
+            BuildIdentityMatrix(frame.m_worldMatrix);
+        }
     }
 
     bool GraphicsManager::InitializeShaders()
@@ -129,12 +179,7 @@ namespace Corona
 
     void GraphicsManager::InitCameraMatrix()
     {
-		auto& scene = g_pSceneManager->GetSceneForRendering();
-		auto pCameraNode = scene.GetFirstCameraNode();
-// 		if (pCameraNode)
-// 		{
-// 			pCameraNode->InitMatrix();
-// 		}
+        // nothing to set up, CalculateCameraMatrix() reads the first camera node every frame
     }
 
     void GraphicsManager::CalculateCameraMatrix()
@@ -243,10 +288,10 @@ namespace Corona
 
         // TODO: Add light-pos camera to get shadowMap
         int i = 0;
-        for (auto LightNode : scene.LightNodes)
+        for (auto hLightNode : scene.LightNodes)
         {
             Light light;
-            auto pLightNode = LightNode.second.lock();
+            auto pLightNode = scene.GetNode(hLightNode);
             if (!pLightNode) continue;
             if (!pLightNode->m_Parent)
             {
@@ -258,15 +303,15 @@ namespace Corona
 				Transform(direction, trans_ptr);
 				light.m_lightDirection = direction.xyz;
 
-                auto pOrientationNode = pLightNode->m_Children;
-                auto pLight = scene.LinearLights[pOrientationNode[0]->lightIndex].lock();
+                auto& pOrientationNode = pLightNode->m_Children;
+                auto pLight = scene.LinearLights[pOrientationNode[0]->lightIndex];
                 if (pLight)
                 {
                     light.m_lightColor = pLight->GetColor().xyz;
                     light.m_lightIntensity = pLight->GetIntensity();
                     if (pLight->GetType() == SceneObjectType::kSceneObjectTypeLightSpot)
                     {
-                        auto pSpotLight = dynamic_pointer_cast<SceneObjectSpotLight>(pLight);
+                        auto pSpotLight = dynamic_cast<SceneObjectSpotLight*>(pLight);
                         light.m_fallOffStart = pSpotLight->GetInnerConeAngle();
                         light.m_fallOffEnd = pSpotLight->GetOuterConeAngle();
                     }
@@ -298,6 +343,38 @@ namespace Corona
         cout << "[GraphicsManager] GraphicsManager::ClearBuffers()" << endl;
     }
 
+    bool GraphicsManager::UpdateTexture(SceneObjectTexture&)
+    {
+        return false;
+    }
+
+    bool GraphicsManager::UpdateGeometry(SceneObjectMesh&)
+    {
+        return false;
+    }
+
+    bool GraphicsManager::ReloadShaders()
+    {
+        return false;
+    }
+
+    void GraphicsManager::WatchShaderFile(const char* name)
+    {
+        if (m_ShaderWatches.find(name) != m_ShaderWatches.end()) return;
+
+        uint32_t id = g_pAssetLoader->WatchFile(name, [this](const std::string&) { m_bShadersChanged = true; });
+        if (id) m_ShaderWatches[name] = id;
+    }
+
+    void GraphicsManager::UnwatchShaderFiles()
+    {
+        for (auto& watch : m_ShaderWatches)
+        {
+            g_pAssetLoader->UnwatchFile(watch.second);
+        }
+        m_ShaderWatches.clear();
+    }
+
     void GraphicsManager::RenderBuffers()
     {
         cout << "[GraphicsManager] GraphicsManager::RenderBuffers()" << endl;
@@ -351,8 +428,9 @@ namespace Corona
     void GraphicsManager::DrawEdgeList(const EdgeList& edges, const Vector3f& color)
     {
         PointList point_list;
+        point_list.reserve(edges.size() * 2);
 
-        for (auto edge : edges)
+        for (auto& edge : edges)
         {
             point_list.push_back(edge->first);
             point_list.push_back(edge->second);
@@ -439,10 +517,14 @@ namespace Corona
         //  ****|/       |/*********
         //  ****5--------6**********
 
+        // points and edges only live for this frame, take them from the frame arena
+        auto point_allocator = g_pMemoryManager->GetFrameAllocator<Point>();
+        auto edge_allocator = g_pMemoryManager->GetFrameAllocator<Edge>();
+
         // vertices
         PointPtr points[8];
         for (int i = 0; i < 8; i++)
-            points[i] = make_shared<Point>(bbMin);
+            points[i] = allocate_shared<Point>(point_allocator, bbMin);
         *points[0] = *points[2] = *points[3] = *points[7] = bbMax;
         points[0]->data[0] = bbMin[0];
         points[2]->data[1] = bbMin[1];
@@ -453,24 +535,25 @@ namespace Corona
 
         // edges
         EdgeList edges;
+        edges.reserve(12);
         
         // top
-        edges.push_back(make_shared<Edge>(make_pair(points[0], points[3])));
-        edges.push_back(make_shared<Edge>(make_pair(points[3], points[2])));
-        edges.push_back(make_shared<Edge>(make_pair(points[2], points[1])));
-        edges.push_back(make_shared<Edge>(make_pair(points[1], points[0])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[0], points[3])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[3], points[2])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[2], points[1])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[1], points[0])));
 
         // bottom
-        edges.push_back(make_shared<Edge>(make_pair(points[4], points[7])));
-        edges.push_back(make_shared<Edge>(make_pair(points[7], points[6])));
-        edges.push_back(make_shared<Edge>(make_pair(points[6], points[5])));
-        edges.push_back(make_shared<Edge>(make_pair(points[5], points[4])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[4], points[7])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[7], points[6])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[6], points[5])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[5], points[4])));
 
         // side
-        edges.push_back(make_shared<Edge>(make_pair(points[0], points[4])));
-        edges.push_back(make_shared<Edge>(make_pair(points[1], points[5])));
-        edges.push_back(make_shared<Edge>(make_pair(points[2], points[6])));
-        edges.push_back(make_shared<Edge>(make_pair(points[3], points[7])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[0], points[4])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[1], points[5])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[2], points[6])));
+        edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[3], points[7])));
 
         DrawEdgeList(edges, color);
     }
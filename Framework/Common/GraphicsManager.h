@@ -1,4 +1,6 @@
 #pragma once
+#include <string>
+#include <unordered_map>
 #include "GfxStructures.h"
 #include "IRuntimeModule.h"
 #include "IDrawPass.h"
@@ -60,6 +62,15 @@ namespace Corona
         virtual bool InitializeBuffers();
         virtual void ClearBuffers();
 
+        // Single objects the scene manager reloaded. False when the renderer
+        // cannot update them in place, the buffers are all built again then.
+        virtual bool UpdateTexture(SceneObjectTexture& texture);
+        virtual bool UpdateGeometry(SceneObjectMesh& mesh);
+        virtual bool ReloadShaders();
+        // ReloadShaders() once one of the files changes
+        void WatchShaderFile(const char* name);
+        void UnwatchShaderFiles();
+
         virtual void InitConstants();
         virtual void InitCameraMatrix();
         virtual void CalculateCameraMatrix();
@@ -95,6 +106,9 @@ namespace Corona
 
         std::vector<Frame> m_Frames;
         std::vector<std::shared_ptr<IDrawPass>> m_DrawPasses;
+
+        std::unordered_map<std::string, uint32_t> m_ShaderWatches;
+        bool m_bShadersChanged = false;
     };
 
     extern GraphicsManager* g_pGraphicsManager;
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+#include "MemoryManager.h"
+
+namespace Corona
+{
+    // 32-bit reference to an object of a HandlePool<T>: the low bits index the
+    // slot, the high bits hold the generation of the slot when the handle was made.
+    // A destroyed object bumps the generation, so stale handles resolve to nullptr.
+    template<typename T>
+    class Handle
+    {
+    public:
+        static const uint32_t kIndexBits = 20;
+        static const uint32_t kGenerationBits = 12;
+        static const uint32_t kMaxIndex = (1u << kIndexBits) - 1;
+        static const uint32_t kMaxGeneration = (1u << kGenerationBits) - 1;
+
+        Handle() : m_nValue(0) {}
+        Handle(uint32_t index, uint32_t generation) : m_nValue((generation << kIndexBits) | index) {}
+
+        uint32_t GetIndex() const { return m_nValue & kMaxIndex; }
+        uint32_t GetGeneration() const { return m_nValue >> kIndexBits; }
+        uint32_t GetValue() const { return m_nValue; }
+
+        // generations start at 1, so 0 is never a live handle
+        bool IsValid() const { return m_nValue != 0; }
+        explicit operator bool() const { return IsValid(); }
+
+        bool operator==(const Handle& rhs) const { return m_nValue == rhs.m_nValue; }
+        bool operator!=(const Handle& rhs) const { return m_nValue != rhs.m_nValue; }
+
+    private:
+        uint32_t m_nValue;
+    };
+
+    // Typed object pool addressed by generational handles. Objects are constructed in
+    // place in fixed-size pages taken from the MemoryManager, they never move, so
+    // pointers from Get() stay valid until the object is destroyed. Freed slots are
+    // reused first. Not synchronized.
+    template<typename T>
+    class HandlePool
+    {
+    public:
+        static const size_t kPageSize = 16 * 1024;
+
+        explicit HandlePool(MemoryTag tag = MemoryTag::Scene)
+            : m_nFreeList(kInvalidIndex), m_nSlotCount(0), m_nSize(0), m_Tag(tag) {}
+
+        ~HandlePool()
+        {
+            Clear();
+            for (auto pPage : m_Pages)
+            {
+                g_pMemoryManager->FreeAligned(pPage, kSlotsPerPage * sizeof(Slot), alignof(Slot), m_Tag);
+            }
+        }
+
+        // an invalid handle once every index a handle can hold is in use,
+        // or when the memory manager has no page left
+        template<typename ...Arguments>
+        Handle<T> Create(Arguments&&... parameters)
+        {
+            uint32_t index = m_nFreeList;
+            if (index != kInvalidIndex)
+            {
+                m_nFreeList = SlotAt(index).nNextFree;
+            }
+            else
+            {
+                index = GrowByOne();
+                if (index == kInvalidIndex) return Handle<T>();
+            }
+
+            Slot& slot = SlotAt(index);
+            new (slot.storage) T(std::forward<Arguments>(parameters)...);
+            slot.bAlive = true;
+            m_nSize++;
+
+            return Handle<T>(index, slot.nGeneration);
+        }
+
+        // destroys the object, the handle and all its copies go stale
+        void Destroy(Handle<T> handle)
+        {
+            T* p = Get(handle);
+            if (!p) return;
+
+            Slot& slot = SlotAt(handle.GetIndex());
+            p->~T();
+            slot.bAlive = false;
+            slot.nGeneration = (slot.nGeneration == Handle<T>::kMaxGeneration) ? 1 : slot.nGeneration + 1;
+            slot.nNextFree = m_nFreeList;
+            m_nFreeList = handle.GetIndex();
+            m_nSize--;
+        }
+
+        // nullptr for invalid or stale handles
+        T* Get(Handle<T> handle) const
+        {
+            uint32_t index = handle.GetIndex();
+            if (index >= m_nSlotCount) return nullptr;
+
+            Slot& slot = SlotAt(index);
+            if (!slot.bAlive || slot.nGeneration != handle.GetGeneration()) return nullptr;
+
+            return reinterpret_cast<T*>(slot.storage);
+        }
+
+        bool IsAlive(Handle<T> handle) const { return Get(handle) != nullptr; }
+
+        // calls func(handle, object) for every live object in slot order
+        template<typename Func>
+        void ForEach(Func func)
+        {
+            for (uint32_t index = 0; index < m_nSlotCount; index++)
+            {
+                Slot& slot = SlotAt(index);
+                if (slot.bAlive)
+                {
+                    func(Handle<T>(index, slot.nGeneration), *reinterpret_cast<T*>(slot.storage));
+                }
+            }
+        }
+
+        // destroys every object, the pages are kept for reuse
+        void Clear()
+        {
+            for (uint32_t index = 0; index < m_nSlotCount; index++)
+            {
+                Slot& slot = SlotAt(index);
+                if (slot.bAlive)
+                {
+                    Destroy(Handle<T>(index, slot.nGeneration));
+                }
+            }
+        }
+
+        uint32_t Size() const { return m_nSize; }
+        bool Empty() const { return m_nSize == 0; }
+        uint32_t GetPageCount() const { return static_cast<uint32_t>(m_Pages.size()); }
+
+    private:
+        struct Slot
+        {
+            alignas(T) uint8_t storage[sizeof(T)];
+            uint32_t nGeneration;
+            uint32_t nNextFree;
+            bool bAlive;
+        };
+
+        static const uint32_t kInvalidIndex = 0xFFFFFFFF;
+        static const uint32_t kSlotsPerPage = (sizeof(Slot) < kPageSize) ? static_cast<uint32_t>(kPageSize / sizeof(Slot)) : 1;
+
+        Slot& SlotAt(uint32_t index) const
+        {
+            return m_Pages[index / kSlotsPerPage][index % kSlotsPerPage];
+        }
+
+        // kInvalidIndex when the pool is full
+        uint32_t GrowByOne()
+        {
+            // past kMaxIndex the index would run into the generation bits
+            if (m_nSlotCount > Handle<T>::kMaxIndex) return kInvalidIndex;
+
+            if (m_nSlotCount == m_Pages.size() * kSlotsPerPage)
+            {
+                void* p = g_pMemoryManager->AllocateAligned(kSlotsPerPage * sizeof(Slot), alignof(Slot), m_Tag);
+                if (!p) return kInvalidIndex;
+                m_Pages.push_back(static_cast<Slot*>(p));
+            }
+
+            Slot& slot = SlotAt(m_nSlotCount);
+            slot.nGeneration = 1;
+            slot.nNextFree = kInvalidIndex;
+            slot.bAlive = false;
+
+            return m_nSlotCount++;
+        }
+
+        std::vector<Slot*> m_Pages;
+        uint32_t m_nFreeList;
+        uint32_t m_nSlotCount;
+        uint32_t m_nSize;
+        MemoryTag m_Tag;
+
+        // disable copy & assignment
+        HandlePool(const HandlePool& clone);
+        HandlePool& operator=(const HandlePool& rhs);
+    };
+}
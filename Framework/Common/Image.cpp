@@ -1,4 +1,5 @@
 #include "Image.h"
+#include "PixelConversion.h"
 
 using namespace std;
 
@@ -16,11 +17,13 @@ Image::Image(Image&& rhs) noexcept {
     bitdepth = rhs.bitdepth;
     pixel_format = rhs.pixel_format;
     is_signed = rhs.is_signed;
+    mipmaps = std::move(rhs.mipmaps);
     rhs.data = nullptr;
 }
 
 Image& Image::operator=(Image&& rhs) noexcept {
     if (this != &rhs) {
+        if (data) delete[] data;
         Width = rhs.Width;
         Height = rhs.Height;
         data = rhs.data;
@@ -33,11 +36,21 @@ Image& Image::operator=(Image&& rhs) noexcept {
         bitdepth = rhs.bitdepth;
         pixel_format = rhs.pixel_format;
         is_signed = rhs.is_signed;
+        mipmaps = std::move(rhs.mipmaps);
         rhs.data = nullptr;
     }
     return *this;
 }
 
+R8G8B8A8Unorm Image::GetRGBA8(uint32_t x, uint32_t y) const {
+    R8G8B8A8Unorm pixel(0, 0, 0, 0xFF);
+    if (x >= Width || y >= Height || !data || compressed) return pixel;
+
+    ConvertToRGBA8(pixel_format, data + y * pitch + (size_t)x * (bitcount >> 3), 0,
+                   pixel.data, 0, 1, 1);
+    return pixel;
+}
+
 std::ostream& operator<<(std::ostream& out, COMPRESSED_FORMAT format) {
     switch (format) {
         case COMPRESSED_FORMAT::NONE:
@@ -74,6 +74,15 @@ enum class PIXEL_FORMAT : uint16_t {
 
 std::ostream& operator<<(std::ostream& out, COMPRESSED_FORMAT format);
 
+// a level of the mip chain of an image, within the data of the image
+struct Mipmap {
+    uint32_t Width{0};
+    uint32_t Height{0};
+    size_t pitch{0};
+    size_t offset{0};
+    size_t data_size{0};
+};
+
 struct Image {
     uint32_t Width{0};
     uint32_t Height{0};
@@ -84,9 +93,12 @@ struct Image {
     bool compressed{false};
     bool is_float{false};
     bool is_signed{false};
-    uint8_t* data;
+    uint8_t* data{nullptr};
     COMPRESSED_FORMAT compress_format{COMPRESSED_FORMAT::NONE};
     PIXEL_FORMAT pixel_format{PIXEL_FORMAT::UNKNOWN};
+    // every level from the full size image down to 1x1, the first one is the
+    // image itself. Empty without mips. data_size covers all of them.
+    std::vector<Mipmap> mipmaps;
 
     Image() = default;
     Image(const Image& rhs) = delete;  // disable copy contruct
@@ -97,140 +109,22 @@ struct Image {
         if (data) delete[] data;
     }
 
-    uint8_t GetR(uint32_t x, uint32_t y) const {
-        if (x >= Width || y >= Height) return 0;
-
-        switch (pixel_format) {
-            case PIXEL_FORMAT::UNKNOWN:
-                return 0;
-            case PIXEL_FORMAT::R8:
-            case PIXEL_FORMAT::RG8:
-            case PIXEL_FORMAT::RGB8:
-            case PIXEL_FORMAT::RGBA8:
-                return *(data + y * pitch + x * (bitcount >> 3));
-            case PIXEL_FORMAT::R5G6B5:
-                return *(data + y * pitch + x * (bitcount >> 3)) & 0xF8;
-            case PIXEL_FORMAT::R16:
-            case PIXEL_FORMAT::RG16:
-            case PIXEL_FORMAT::RGB16:
-            case PIXEL_FORMAT::RGBA16:
-                return *(data + y * pitch + x * (bitcount >> 3) + 1);
-            case PIXEL_FORMAT::R32:
-            case PIXEL_FORMAT::RG32:
-            case PIXEL_FORMAT::RGB32:
-            case PIXEL_FORMAT::RGBA32:
-                return *(data + y * pitch + x * (bitcount >> 3) + 3);
-            case PIXEL_FORMAT::R10G10B10A2:
-                // not supported
-                return 0;
-            default:
-                // return 0;
-                assert(0);
-        }
-
-        return 0;
+    uint32_t GetMipLevels() const {
+        return mipmaps.empty() ? 1 : static_cast<uint32_t>(mipmaps.size());
     }
 
-    uint8_t GetG(uint32_t x, uint32_t y) const {
-        if (x >= Width || y >= Height) return 0;
+    // the pixel at x, y as RGBA8, converted the way whole images are.
+    // Outside of the image and for formats without a conversion it is
+    // black and opaque.
+    R8G8B8A8Unorm GetRGBA8(uint32_t x, uint32_t y) const;
 
-        switch (pixel_format) {
-            case PIXEL_FORMAT::UNKNOWN:
-            case PIXEL_FORMAT::R8:
-            case PIXEL_FORMAT::R16:
-            case PIXEL_FORMAT::R32:
-                return GetR(x, y);
-            case PIXEL_FORMAT::RG8:
-            case PIXEL_FORMAT::RGB8:
-            case PIXEL_FORMAT::RGBA8:
-                return *(data + y * pitch + x * (bitcount >> 3) + 1);
-            case PIXEL_FORMAT::RG16:
-            case PIXEL_FORMAT::RGB16:
-            case PIXEL_FORMAT::RGBA16:
-            case PIXEL_FORMAT::RG32:
-            case PIXEL_FORMAT::RGB32:
-            case PIXEL_FORMAT::RGBA32:
-            case PIXEL_FORMAT::R10G10B10A2:
-                // not supported
-                return 0;
-            case PIXEL_FORMAT::R5G6B5:
-                return ((*(data + y * pitch + x * (bitcount >> 3)) & 0x07)
-                        << 3) +
-                       ((*(data + y * pitch + x * (bitcount >> 3) + 1) &
-                         0xE0) >>
-                        5);
-            default:
-                // return 0;
-                assert(0);
-        }
+    uint8_t GetR(uint32_t x, uint32_t y) const { return GetRGBA8(x, y).data[0]; }
 
-        return 0;
-    }
-
-    uint8_t GetB(uint32_t x, uint32_t y) const {
-        if (x >= Width || y >= Height) return 0;
+    uint8_t GetG(uint32_t x, uint32_t y) const { return GetRGBA8(x, y).data[1]; }
 
-        switch (pixel_format) {
-            case PIXEL_FORMAT::UNKNOWN:
-            case PIXEL_FORMAT::R8:
-            case PIXEL_FORMAT::R16:
-            case PIXEL_FORMAT::R32:
-                return GetR(x, y);
-            case PIXEL_FORMAT::RG8:
-                return GetG(x, y);
-            case PIXEL_FORMAT::RGB8:
-            case PIXEL_FORMAT::RGBA8:
-                return *(data + y * pitch + x * (bitcount >> 3) + 2);
-                break;
-            case PIXEL_FORMAT::RG16:
-            case PIXEL_FORMAT::RGB16:
-            case PIXEL_FORMAT::RGBA16:
-            case PIXEL_FORMAT::RG32:
-            case PIXEL_FORMAT::RGB32:
-            case PIXEL_FORMAT::RGBA32:
-            case PIXEL_FORMAT::R10G10B10A2:
-                // not supported
-                return 0;
-            case PIXEL_FORMAT::R5G6B5:
-                return (*(data + y * pitch + x * (bitcount >> 3) + 1) & 0x1F);
-            default:
-                // return 0;
-                assert(0);
-        }
-
-        return 0;
-    }
+    uint8_t GetB(uint32_t x, uint32_t y) const { return GetRGBA8(x, y).data[2]; }
 
-    uint8_t GetA(uint32_t x, uint32_t y) const {
-        if (x >= Width || y >= Height) return 0xFF;
-
-        switch (pixel_format) {
-            case PIXEL_FORMAT::UNKNOWN:
-            case PIXEL_FORMAT::R8:
-            case PIXEL_FORMAT::R16:
-            case PIXEL_FORMAT::R32:
-            case PIXEL_FORMAT::RG8:
-            case PIXEL_FORMAT::RGB8:
-            case PIXEL_FORMAT::R5G6B5:
-                return 0xFF;
-            case PIXEL_FORMAT::RGBA8:
-                return *(data + y * pitch + x * (bitcount >> 3) + 3);
-            case PIXEL_FORMAT::RG16:
-            case PIXEL_FORMAT::RGB16:
-            case PIXEL_FORMAT::RGBA16:
-            case PIXEL_FORMAT::RG32:
-            case PIXEL_FORMAT::RGB32:
-            case PIXEL_FORMAT::RGBA32:
-            case PIXEL_FORMAT::R10G10B10A2:
-                // not supported
-                return 0xFF;
-            default:
-                // return 0;
-                assert(0);
-        }
-
-        return 0;
-    }
+    uint8_t GetA(uint32_t x, uint32_t y) const { return GetRGBA8(x, y).data[3]; }
 
     uint8_t GetX(int32_t x, int32_t y) const { return GetR(x, y); }
 
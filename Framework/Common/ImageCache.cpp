@@ -0,0 +1,402 @@
+#include "ImageCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include "AssetLoader.h"
+#include "BMP.h"
+#include "JPEG.h"
+#include "PNG.h"
+
+namespace Corona
+{
+    // bump whenever a decoder changes what it puts out, the build cache drops
+    // the images decoded by the older one
+    static const uint32_t kImageCookVersion = 3;
+
+    // a decoded image in the build cache, the pixels follow
+    struct CookedImageHeader
+    {
+        uint32_t nWidth;
+        uint32_t nHeight;
+        uint16_t nBitcount;
+        uint16_t nBitdepth;
+        uint16_t nPixelFormat;
+        uint16_t nCompressFormat;
+        uint64_t nPitch;
+        uint64_t nDataSize;
+        uint32_t nFlags;        // 1 compressed, 2 float, 4 signed
+        uint32_t nMipLevels;    // 0 without mips
+    };
+
+    static std::shared_ptr<Image> ReadCookedImage(const BufferView& cooked)
+    {
+        CookedImageHeader header;
+        if (cooked.GetDataSize() < sizeof(header)) return nullptr;
+        memcpy(&header, cooked.GetData(), sizeof(header));
+        if (header.nDataSize != cooked.GetDataSize() - sizeof(header) || header.nDataSize == 0) return nullptr;
+
+        auto pImage = std::make_shared<Image>();
+        pImage->Width = header.nWidth;
+        pImage->Height = header.nHeight;
+        pImage->bitcount = header.nBitcount;
+        pImage->bitdepth = header.nBitdepth;
+        pImage->pixel_format = static_cast<PIXEL_FORMAT>(header.nPixelFormat);
+        pImage->compress_format = static_cast<COMPRESSED_FORMAT>(header.nCompressFormat);
+        pImage->pitch = static_cast<size_t>(header.nPitch);
+        pImage->data_size = static_cast<size_t>(header.nDataSize);
+        pImage->compressed = (header.nFlags & 1) != 0;
+        pImage->is_float = (header.nFlags & 2) != 0;
+        pImage->is_signed = (header.nFlags & 4) != 0;
+        if (header.nMipLevels > 1 && LayoutMipmaps(*pImage, header.nMipLevels) != pImage->data_size) return nullptr;
+        pImage->data = new uint8_t[pImage->data_size];
+        memcpy(pImage->data, cooked.GetData() + sizeof(header), pImage->data_size);
+        return pImage;
+    }
+
+    static std::string LowerExtension(const std::string& path)
+    {
+        size_t dot = path.find_last_of('.');
+        std::string ext = dot == std::string::npos ? std::string() : path.substr(dot);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower(c); });
+        return ext;
+    }
+
+    // the images decoded within a size limit are cached apart
+    static std::string SizeKey(uint32_t maxSize)
+    {
+        return maxSize ? "|max" + std::to_string(maxSize) : std::string();
+    }
+
+    static bool IsJpeg(const std::string& format)
+    {
+        return format == ".jpg" || format == ".jpeg";
+    }
+
+    // size of the image, read from the header of the encoded data, 0 when the
+    // header is not understood
+    static void ReadImageSize(const BufferView& data, const std::string& format, uint64_t& width, uint64_t& height)
+    {
+        width = height = 0;
+        const uint8_t* p = data.GetData();
+        size_t size = data.GetDataSize();
+        auto be16 = [&](size_t i) { return uint32_t(p[i]) << 8 | p[i + 1]; };
+        auto be32 = [&](size_t i) { return be16(i) << 16 | be16(i + 2); };
+        auto le32 = [&](size_t i) { return uint32_t(p[i]) | uint32_t(p[i + 1]) << 8 | uint32_t(p[i + 2]) << 16 | uint32_t(p[i + 3]) << 24; };
+
+        if (format == ".png" && size >= 25 && !memcmp(p, "\x89PNG", 4))
+        {
+            width = be32(16);
+            height = be32(20);
+        }
+        else if (IsJpeg(format) && size >= 4 && p[0] == 0xFF && p[1] == 0xD8)
+        {
+            // the first start of frame marker holds the size
+            size_t i = 2;
+            while (i + 9 <= size && p[i] == 0xFF)
+            {
+                uint8_t marker = p[i + 1];
+                if (marker == 0xFF) { i++; continue; }
+                if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+                {
+                    height = be16(i + 5);
+                    width = be16(i + 7);
+                    break;
+                }
+                i += 2 + be16(i + 2);
+            }
+        }
+        else if (format == ".bmp" && size >= 26 && p[0] == 'B' && p[1] == 'M')
+        {
+            width = le32(18);
+            height = static_cast<uint32_t>(std::abs(static_cast<int32_t>(le32(22))));
+        }
+    }
+
+    // the smallest JPEG scale that brings the larger side within maxSize,
+    // the decoder rounds the scaled size up
+    static uint32_t ScaleToFit(const BufferView& data, const std::string& format, uint32_t maxSize)
+    {
+        if (!maxSize || !IsJpeg(format)) return 1;
+
+        uint64_t width, height;
+        ReadImageSize(data, format, width, height);
+        uint64_t larger = std::max(width, height);
+        uint32_t scale = 1;
+        while (scale < 8 && (larger + scale - 1) / scale > maxSize) scale *= 2;
+        return scale;
+    }
+
+    int ImageCache::Initialize()
+    {
+        return 0;
+    }
+
+    void ImageCache::Finalize()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_DecodeFinished.wait(lock, [this]() { return m_nDecoding == 0; });
+        m_Recent.clear();
+        m_Entries.clear();
+        m_szRetained = 0;
+    }
+
+    void ImageCache::Tick()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        PurgeExpired();
+    }
+
+    std::shared_ptr<Image> ImageCache::Decode(const BufferView& data, const std::string& ext, uint32_t scale)
+    {
+        if (data.IsEmpty()) return nullptr;
+
+        std::string format = LowerExtension(ext);
+        Image image;
+        if (IsJpeg(format))
+        {
+            JpegParser jpeg_parser;
+            jpeg_parser.SetScale(scale);
+            image = jpeg_parser.Parse(data);
+        }
+        else if (format == ".png")
+        {
+            PngParser png_parser;
+            image = png_parser.Parse(data);
+        }
+        else if (format == ".bmp")
+        {
+            BmpParser bmp_parser;
+            image = bmp_parser.Parse(data);
+        }
+
+        if (!image.data) return nullptr;
+        return std::make_shared<Image>(std::move(image));
+    }
+
+    size_t ImageCache::GetDecodedSize(const BufferView& data, const std::string& ext)
+    {
+        // decoded to 4 channels of 8 bits at most
+        uint64_t width, height;
+        ReadImageSize(data, LowerExtension(ext), width, height);
+        if (!width || !height) return data.GetDataSize() * 4;
+        return static_cast<size_t>(width * height * 4);
+    }
+
+    std::shared_ptr<Image> ImageCache::GetImage(const char* filePath, const MipmapDesc& mips)
+    {
+        std::string ext = LowerExtension(filePath);
+        uint32_t maxSize = m_nMaxTextureSize;
+
+        // loose files are known by where they are and when they changed last,
+        // without reading them
+        std::string path = g_pAssetLoader->GetFilePath(filePath);
+        if (path != filePath)
+        {
+            std::error_code ec;
+            uintmax_t size = std::filesystem::file_size(path, ec);
+            auto time = ec ? std::filesystem::file_time_type() : std::filesystem::last_write_time(path, ec);
+            if (!ec)
+            {
+                std::string format = mips.GetKey() + SizeKey(maxSize);
+                std::string key = path + '|' + std::to_string(size) + '|' + std::to_string(time.time_since_epoch().count()) + format;
+                return Find(key, [&]() {
+                    BufferView data = g_pAssetLoader->MapFile(filePath);
+                    return DecodeCooked("image:" + path + format, data, ext, BuildCache::HashInput(data), mips, maxSize);
+                });
+            }
+        }
+
+        // packed files by their content, mapping them is cheap
+        BufferView data = g_pAssetLoader->MapFile(filePath);
+        if (data.IsEmpty()) return nullptr;
+        return GetImage(data, ext, mips);
+    }
+
+    std::shared_ptr<Image> ImageCache::GetImage(const BufferView& data, const std::string& ext, const MipmapDesc& mips)
+    {
+        if (data.IsEmpty()) return nullptr;
+
+        BuildInput input = BuildCache::HashInput(data);
+        char key[64];
+        snprintf(key, sizeof(key), "#%016llx|%zu", (unsigned long long)input.nHash, data.GetDataSize());
+        uint32_t maxSize = m_nMaxTextureSize;
+        std::string format = LowerExtension(ext) + mips.GetKey() + SizeKey(maxSize);
+        return Find(key + format, [&]() {
+            return DecodeCooked("image" + (key + format), data, LowerExtension(ext), input, mips, maxSize);
+        });
+    }
+
+    std::shared_ptr<Image> ImageCache::DecodeCooked(const std::string& key, const BufferView& data, const std::string& ext,
+                                                    const BuildInput& input, const MipmapDesc& mips, uint32_t maxSize)
+    {
+        if (data.IsEmpty()) return nullptr;
+
+        BuildCache& cache = g_pAssetLoader->GetBuildCache();
+        std::vector<BuildInput> inputs = { input };
+        BufferView cooked;
+        if (cache.Find(key, kImageCookVersion, inputs, cooked))
+        {
+            if (auto pImage = ReadCookedImage(cooked))
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stats.nCooked++;
+                return pImage;
+            }
+        }
+
+        std::shared_ptr<Image> pImage = Decode(data, ext, ScaleToFit(data, ext, maxSize));
+        // on one thread, the images come from the decode pool of the glTF
+        // parser, which is spread over the threads already
+        if (pImage && !GenerateMipmaps(*pImage, mips, 1))
+        {
+            fprintf(stderr, "[ImageCache] no mips for the format of %s\n", key.c_str());
+        }
+        if (pImage && cache.IsOpen())
+        {
+            CookedImageHeader header = {};
+            header.nWidth = pImage->Width;
+            header.nHeight = pImage->Height;
+            header.nBitcount = pImage->bitcount;
+            header.nBitdepth = pImage->bitdepth;
+            header.nPixelFormat = static_cast<uint16_t>(pImage->pixel_format);
+            header.nCompressFormat = static_cast<uint16_t>(pImage->compress_format);
+            header.nPitch = pImage->pitch;
+            header.nDataSize = pImage->data_size;
+            header.nFlags = (pImage->compressed ? 1u : 0u) | (pImage->is_float ? 2u : 0u) | (pImage->is_signed ? 4u : 0u);
+            header.nMipLevels = static_cast<uint32_t>(pImage->mipmaps.size());
+
+            // views of memory that outlives the call, nothing to keep alive
+            cache.Store(key, kImageCookVersion, inputs,
+                        { BufferView(nullptr, reinterpret_cast<const uint8_t*>(&header), sizeof(header)),
+                          BufferView(nullptr, pImage->data, pImage->data_size) });
+        }
+        return pImage;
+    }
+
+    template <typename DECODE>
+    std::shared_ptr<Image> ImageCache::Find(const std::string& key, DECODE decode)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        auto it = m_Entries.find(key);
+        if (it == m_Entries.end())
+        {
+            it = m_Entries.emplace(key, Entry()).first;
+            it->second.recent = m_Recent.end();
+        }
+        else if (auto pImage = it->second.pImage.lock())
+        {
+            m_Stats.nHits++;
+            Retain(it->second, key, pImage);
+            return pImage;
+        }
+        else if (it->second.pending.valid())
+        {
+            m_Stats.nWaits++;
+            auto pending = it->second.pending;
+            lock.unlock();
+            return pending.get();
+        }
+
+        // decoded outside of the lock, others asking for the same image wait for it
+        Entry* pEntry = &it->second;
+        std::promise<std::shared_ptr<Image>> promise;
+        pEntry->pending = promise.get_future().share();
+        m_Stats.nMisses++;
+        m_nDecoding++;
+        lock.unlock();
+
+        std::shared_ptr<Image> pImage = decode();
+
+        lock.lock();
+        m_nDecoding--;
+        pEntry->pending = std::shared_future<std::shared_ptr<Image>>();
+        if (pImage)
+        {
+            pEntry->pImage = pImage;
+            Retain(*pEntry, key, pImage);
+        }
+        else if (pEntry->recent == m_Recent.end())
+        {
+            // tried again next time
+            m_Entries.erase(key);
+        }
+        lock.unlock();
+        m_DecodeFinished.notify_all();
+
+        promise.set_value(pImage);
+        return pImage;
+    }
+
+    void ImageCache::Retain(Entry& entry, const std::string& key, const std::shared_ptr<Image>& pImage)
+    {
+        if (entry.recent != m_Recent.end())
+        {
+            m_Recent.splice(m_Recent.begin(), m_Recent, entry.recent);
+            return;
+        }
+
+        // an image larger than the whole budget is only shared while it is in use
+        if (pImage->data_size > m_szBudget) return;
+
+        m_Recent.emplace_front(key, pImage);
+        entry.recent = m_Recent.begin();
+        m_szRetained += pImage->data_size;
+        Trim();
+    }
+
+    void ImageCache::Trim()
+    {
+        while (m_szRetained > m_szBudget && !m_Recent.empty())
+        {
+            auto& oldest = m_Recent.back();
+            m_szRetained -= oldest.second->data_size;
+            m_Entries[oldest.first].recent = m_Recent.end();
+            m_Recent.pop_back();
+            m_Stats.nEvictions++;
+        }
+    }
+
+    void ImageCache::PurgeExpired()
+    {
+        for (auto it = m_Entries.begin(); it != m_Entries.end();)
+        {
+            const Entry& entry = it->second;
+            if (entry.recent == m_Recent.end() && !entry.pending.valid() && entry.pImage.expired())
+                it = m_Entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void ImageCache::SetMemoryBudget(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_szBudget = bytes;
+        Trim();
+    }
+
+    void ImageCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto& recent : m_Recent)
+        {
+            m_Entries[recent.first].recent = m_Recent.end();
+        }
+        m_Recent.clear();
+        m_szRetained = 0;
+        PurgeExpired();
+    }
+
+    ImageCache::Stats ImageCache::GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Stats stats = m_Stats;
+        stats.szRetainedBytes = m_szRetained;
+        stats.nEntries = m_Entries.size();
+        return stats;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "IRuntimeModule.h"
+#include "BufferView.h"
+#include "BuildCache.h"
+#include "Image.h"
+#include "Mipmaps.h"
+
+namespace Corona
+{
+    // Decoded images shared by every scene and material that uses them.
+    // Files are keyed by the resolved path plus size and modification time,
+    // packed files and in-memory images by a hash of their content. Entries
+    // are weak, only the most recently used images up to the memory budget
+    // are kept alive by the cache itself. Decoded images also go to the build
+    // cache of the asset loader, later runs read them back instead of decoding.
+    // Safe to use from several threads, concurrent requests for the same image
+    // wait for a single decode. The images are shared, treat them as read only.
+    class ImageCache : implements IRuntimeModule
+    {
+    public:
+        struct Stats
+        {
+            uint64_t nHits;         // found decoded
+            uint64_t nMisses;       // decoded
+            uint64_t nWaits;        // waited for the decode of another thread
+            uint64_t nCooked;       // of the misses, read decoded from the build cache
+            uint64_t nEvictions;    // dropped out of the budget
+            size_t   szRetainedBytes;
+            size_t   nEntries;
+        };
+
+        virtual ~ImageCache() {};
+
+        virtual int Initialize();
+        virtual void Finalize();
+
+        virtual void Tick();
+
+        // decoded image of an asset file, nullptr if it is missing or does not decode.
+        // With a mip filter the image comes with its mip chain, made on the
+        // calling thread and cached apart from the same file with other mips.
+        std::shared_ptr<Image> GetImage(const char* filePath, const MipmapDesc& mips = MipmapDesc());
+
+        // decoded image of encoded data, e.g. embedded into a .glb.
+        // ext is the file extension of the format, like ".png".
+        std::shared_ptr<Image> GetImage(const BufferView& data, const std::string& ext,
+                                        const MipmapDesc& mips = MipmapDesc());
+
+        // bytes of decoded images kept alive while nobody else uses them
+        void SetMemoryBudget(size_t bytes);
+        size_t GetMemoryBudget(void) const { return m_szBudget; }
+
+        // larger side of the decoded images, 0 for no limit. JPEG images above
+        // it decode at 1/2, 1/4 or 1/8 of their size with the DCT scaling of
+        // the decoder, the other formats still decode in full. Cached apart
+        // from the same images under another limit.
+        void SetMaxTextureSize(uint32_t size) { m_nMaxTextureSize = size; }
+        uint32_t GetMaxTextureSize(void) const { return m_nMaxTextureSize; }
+
+        // drops every image the cache keeps alive, images still in use stay shared
+        void Clear(void);
+
+        Stats GetStats(void);
+
+        // Decodes without the cache. A scale of 2, 4 or 8 decodes JPEG images
+        // at that fraction of their size, the other formats always decode in full.
+        static std::shared_ptr<Image> Decode(const BufferView& data, const std::string& ext, uint32_t scale = 1);
+
+        // bytes the decoded image will take, read from the header of the encoded
+        // data. A guess from the encoded size when the header is not understood.
+        static size_t GetDecodedSize(const BufferView& data, const std::string& ext);
+
+    private:
+        struct Entry
+        {
+            std::weak_ptr<Image> pImage;
+            // set while the image is being decoded
+            std::shared_future<std::shared_ptr<Image>> pending;
+            // position in m_Recent, m_Recent.end() when the budget does not hold it
+            std::list<std::pair<std::string, std::shared_ptr<Image>>>::iterator recent;
+        };
+
+        // Decode() within maxSize and the mips through the build cache of the asset loader
+        std::shared_ptr<Image> DecodeCooked(const std::string& key, const BufferView& data, const std::string& ext,
+                                            const BuildInput& input, const MipmapDesc& mips, uint32_t maxSize);
+
+        template <typename DECODE>
+        std::shared_ptr<Image> Find(const std::string& key, DECODE decode);
+        // m_Mutex is held by the callers
+        void Retain(Entry& entry, const std::string& key, const std::shared_ptr<Image>& pImage);
+        void Trim(void);
+        void PurgeExpired(void);
+
+        std::mutex m_Mutex;
+        // Find() holds on to its entry while it decodes, Finalize() waits for them
+        std::condition_variable m_DecodeFinished;
+        uint32_t m_nDecoding = 0;
+        std::unordered_map<std::string, Entry> m_Entries;
+        std::list<std::pair<std::string, std::shared_ptr<Image>>> m_Recent;
+        size_t m_szBudget = 256 * 1024 * 1024;
+        size_t m_szRetained = 0;
+        std::atomic<uint32_t> m_nMaxTextureSize { 0 };
+        Stats m_Stats = {};
+    };
+
+    extern ImageCache* g_pImageCache;
+}
@@ -0,0 +1,343 @@
+#include "IoUring.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Corona
+{
+#if defined(__linux__)
+    // no liburing, the ring is driven through the system calls directly
+    static int io_uring_setup(uint32_t entries, struct io_uring_params* p)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    static int io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    static int io_uring_register(int fd, uint32_t opcode, void* arg, uint32_t nr_args)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    // the kernel may cut reads short, one request reads at most this much
+    static const size_t kMaxReadSize = 1 << 30;
+
+    IoUringFileReader::IoUringFileReader()
+        : m_nRingFd(-1), m_nEntries(0),
+          m_pSqRing(nullptr), m_szSqRingSize(0), m_pCqRing(nullptr), m_szCqRingSize(0),
+          m_pSqes(nullptr), m_szSqesSize(0),
+          m_pSqHead(nullptr), m_pSqTail(nullptr), m_nSqMask(0), m_pSqArray(nullptr),
+          m_pCqHead(nullptr), m_pCqTail(nullptr), m_nCqMask(0), m_pCqes(nullptr),
+          m_nQueued(0)
+    {
+    }
+
+    IoUringFileReader::~IoUringFileReader()
+    {
+        Finalize();
+    }
+
+    bool IoUringFileReader::Initialize(uint32_t entries)
+    {
+        Finalize();
+
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        int fd = io_uring_setup(entries, &params);
+        if (fd < 0) return false;
+
+        // the opcodes of the batches, all there since 5.6
+        const uint32_t probe_ops = IORING_OP_LAST;
+        size_t probe_size = sizeof(struct io_uring_probe) + probe_ops * sizeof(struct io_uring_probe_op);
+        std::vector<uint8_t> probe_storage(probe_size, 0);
+        struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(probe_storage.data());
+        bool supported = io_uring_register(fd, IORING_REGISTER_PROBE, probe, probe_ops) == 0;
+        for (uint8_t op : { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE })
+        {
+            supported = supported && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        }
+
+        if (!supported)
+        {
+            close(fd);
+            return false;
+        }
+
+        m_szSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        m_szCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            if (m_szCqRingSize > m_szSqRingSize) m_szSqRingSize = m_szCqRingSize;
+            m_szCqRingSize = m_szSqRingSize;
+        }
+
+        m_pSqRing = mmap(nullptr, m_szSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        m_pCqRing = single_mmap ? m_pSqRing
+                                : mmap(nullptr, m_szCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        m_szSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        void* sqes = mmap(nullptr, m_szSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+        m_nRingFd = fd;
+        if (m_pSqRing == MAP_FAILED || m_pCqRing == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            if (m_pSqRing == MAP_FAILED) m_pSqRing = nullptr;
+            if (m_pCqRing == MAP_FAILED) m_pCqRing = nullptr;
+            if (sqes != MAP_FAILED) munmap(sqes, m_szSqesSize);
+            Finalize();
+            return false;
+        }
+
+        uint8_t* sq = static_cast<uint8_t*>(m_pSqRing);
+        uint8_t* cq = static_cast<uint8_t*>(m_pCqRing);
+        m_pSqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+        m_pSqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        m_nSqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        m_pSqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+        m_pCqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        m_pCqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        m_nCqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        m_pCqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+        m_pSqes = static_cast<struct io_uring_sqe*>(sqes);
+
+        m_nEntries = params.sq_entries;
+        m_nQueued = 0;
+        return true;
+    }
+
+    void IoUringFileReader::Finalize()
+    {
+        if (m_pSqes) munmap(m_pSqes, m_szSqesSize);
+        if (m_pCqRing && m_pCqRing != m_pSqRing) munmap(m_pCqRing, m_szCqRingSize);
+        if (m_pSqRing) munmap(m_pSqRing, m_szSqRingSize);
+        if (m_nRingFd >= 0) close(m_nRingFd);
+
+        m_pSqes = nullptr;
+        m_pCqRing = nullptr;
+        m_pSqRing = nullptr;
+        m_nRingFd = -1;
+        m_nEntries = 0;
+    }
+
+    bool IoUringFileReader::IsSupported()
+    {
+        IoUringFileReader reader;
+        return reader.Initialize(2);
+    }
+
+    struct io_uring_sqe* IoUringFileReader::GetSqe()
+    {
+        // only this thread produces, the kernel consumes up to the tail we publish
+        uint32_t tail = *m_pSqTail + m_nQueued;
+        uint32_t index = tail & m_nSqMask;
+
+        struct io_uring_sqe* sqe = &m_pSqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        m_pSqArray[index] = index;
+        m_nQueued++;
+
+        return sqe;
+    }
+
+    uint32_t IoUringFileReader::ReapCompletions(int32_t* results)
+    {
+        uint32_t reaped = 0;
+        uint32_t head = *m_pCqHead;
+        uint32_t tail = __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            const struct io_uring_cqe& cqe = m_pCqes[head & m_nCqMask];
+            results[cqe.user_data] = cqe.res;
+            reaped++;
+        }
+        __atomic_store_n(m_pCqHead, head, __ATOMIC_RELEASE);
+
+        return reaped;
+    }
+
+    bool IoUringFileReader::SubmitAndWait(uint32_t count, int32_t* results)
+    {
+        uint32_t sq_head = __atomic_load_n(m_pSqHead, __ATOMIC_ACQUIRE);
+        __atomic_store_n(m_pSqTail, *m_pSqTail + m_nQueued, __ATOMIC_RELEASE);
+        uint32_t to_submit = m_nQueued;
+        m_nQueued = 0;
+
+        // whatever does not complete because the ring broke counts as failed
+        for (uint32_t i = 0; i < count; i++) results[i] = -EIO;
+
+        uint32_t completed = 0;
+        while (completed < count)
+        {
+            int ret = io_uring_enter(m_nRingFd, to_submit, count - completed, IORING_ENTER_GETEVENTS);
+            if (ret < 0 && errno != EINTR) break;
+            if (ret > 0) to_submit -= static_cast<uint32_t>(ret) < to_submit ? static_cast<uint32_t>(ret) : to_submit;
+
+            completed += ReapCompletions(results);
+        }
+        if (completed == count) return true;
+
+        // The kernel owns what it took off the submission queue until it
+        // completes: reads still write into the buffers of the caller and late
+        // completions would be taken for the next batch. Wait for all of them,
+        // the rest of the queue goes with the ring.
+        uint32_t in_flight = __atomic_load_n(m_pSqHead, __ATOMIC_ACQUIRE) - sq_head;
+        while (completed < in_flight)
+        {
+            if (io_uring_enter(m_nRingFd, 0, in_flight - completed, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            {
+                // the completions are posted to the ring all the same
+                usleep(1000);
+            }
+            completed += ReapCompletions(results);
+        }
+
+        Finalize();
+        return false;
+    }
+
+    bool IoUringFileReader::ReadBatch(const std::string* paths, size_t count, Buffer* results, std::vector<bool>::iterator succeeded)
+    {
+        std::vector<int32_t> fds(count, -1);
+        std::vector<struct statx> stats(count);
+        std::vector<int32_t> status(2 * count);
+
+        // 1. open and query the size of every file in one go
+        for (size_t i = 0; i < count; i++)
+        {
+            struct io_uring_sqe* open = GetSqe();
+            open->opcode = IORING_OP_OPENAT;
+            open->fd = AT_FDCWD;
+            open->addr = reinterpret_cast<uint64_t>(paths[i].c_str());
+            open->open_flags = O_RDONLY | O_CLOEXEC;
+            open->user_data = i;
+
+            struct io_uring_sqe* stat = GetSqe();
+            stat->opcode = IORING_OP_STATX;
+            stat->fd = AT_FDCWD;
+            stat->addr = reinterpret_cast<uint64_t>(paths[i].c_str());
+            stat->len = STATX_SIZE;
+            stat->off = reinterpret_cast<uint64_t>(&stats[i]);
+            stat->statx_flags = 0;
+            stat->user_data = count + i;
+        }
+        bool ring_ok = SubmitAndWait(static_cast<uint32_t>(2 * count), status.data());
+
+        std::vector<size_t> done(count, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            fds[i] = status[i];
+            succeeded[i] = status[i] >= 0 && status[count + i] >= 0;
+            if (succeeded[i] && ring_ok) results[i] = Buffer(static_cast<size_t>(stats[i].stx_size), 4, MemoryTag::Transient);
+        }
+
+        // 2. read them, short reads go round again
+        while (ring_ok)
+        {
+            uint32_t reads = 0;
+            std::vector<size_t> read_file;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!succeeded[i] || done[i] == results[i].GetDataSize()) continue;
+
+                size_t remaining = results[i].GetDataSize() - done[i];
+                struct io_uring_sqe* read = GetSqe();
+                read->opcode = IORING_OP_READ;
+                read->fd = fds[i];
+                read->addr = reinterpret_cast<uint64_t>(results[i].GetData() + done[i]);
+                read->len = static_cast<uint32_t>(remaining < kMaxReadSize ? remaining : kMaxReadSize);
+                read->off = done[i];
+                read->user_data = reads++;
+                read_file.push_back(i);
+            }
+            if (!reads) break;
+
+            ring_ok = SubmitAndWait(reads, status.data());
+            for (uint32_t r = 0; r < reads; r++)
+            {
+                size_t i = read_file[r];
+                // 0 means the file shrank since the statx
+                if (status[r] > 0)
+                    done[i] += static_cast<size_t>(status[r]);
+                else
+                    succeeded[i] = false;
+            }
+        }
+
+        // 3. and close them all, one by one without the ring when it broke
+        uint32_t closes = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!succeeded[i] || !ring_ok) results[i] = Buffer();
+            if (fds[i] < 0) continue;
+
+            if (!ring_ok)
+            {
+                ::close(fds[i]);
+                continue;
+            }
+
+            struct io_uring_sqe* close = GetSqe();
+            close->opcode = IORING_OP_CLOSE;
+            close->fd = fds[i];
+            close->user_data = closes++;
+        }
+        if (closes) ring_ok = SubmitAndWait(closes, status.data());
+
+        return ring_ok;
+    }
+
+    bool IoUringFileReader::ReadFiles(const std::vector<std::string>& paths, std::vector<Buffer>& results, std::vector<bool>& succeeded)
+    {
+        results.clear();
+        results.resize(paths.size());
+        succeeded.assign(paths.size(), false);
+
+        if (!IsAvailable()) return false;
+
+        size_t batch = GetBatchSize();
+        for (size_t first = 0; first < paths.size(); first += batch)
+        {
+            size_t count = paths.size() - first < batch ? paths.size() - first : batch;
+            if (!ReadBatch(&paths[first], count, &results[first], succeeded.begin() + first)) return false;
+        }
+
+        return true;
+    }
+#else
+    IoUringFileReader::IoUringFileReader()
+        : m_nRingFd(-1), m_nEntries(0),
+          m_pSqRing(nullptr), m_szSqRingSize(0), m_pCqRing(nullptr), m_szCqRingSize(0),
+          m_pSqes(nullptr), m_szSqesSize(0),
+          m_pSqHead(nullptr), m_pSqTail(nullptr), m_nSqMask(0), m_pSqArray(nullptr),
+          m_pCqHead(nullptr), m_pCqTail(nullptr), m_nCqMask(0), m_pCqes(nullptr),
+          m_nQueued(0)
+    {
+    }
+
+    IoUringFileReader::~IoUringFileReader() {}
+
+    bool IoUringFileReader::Initialize(uint32_t) { return false; }
+    void IoUringFileReader::Finalize() {}
+    bool IoUringFileReader::IsSupported() { return false; }
+
+    bool IoUringFileReader::ReadFiles(const std::vector<std::string>& paths, std::vector<Buffer>& results, std::vector<bool>& succeeded)
+    {
+        results.clear();
+        results.resize(paths.size());
+        succeeded.assign(paths.size(), false);
+        return false;
+    }
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Buffer.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace Corona
+{
+    // Whole-file reads in batches through Linux io_uring: the opens (together with
+    // the size queries), the reads and the closes of a batch each go to the kernel
+    // with one system call instead of one open/fstat/read/close sequence per file.
+    // A reader belongs to one thread. Elsewhere Initialize() always fails.
+    class IoUringFileReader
+    {
+    public:
+        IoUringFileReader();
+        ~IoUringFileReader();
+
+        IoUringFileReader(const IoUringFileReader&) = delete;
+        IoUringFileReader& operator=(const IoUringFileReader&) = delete;
+
+        // false when the kernel lacks io_uring or one of the operations used
+        bool Initialize(uint32_t entries = 64);
+        void Finalize();
+        bool IsAvailable(void) const { return m_nRingFd >= 0; }
+
+        // files read per submission, longer lists are split
+        size_t GetBatchSize(void) const { return m_nEntries / 2; }
+
+        // reads every file completely into results[i], succeeded[i] is false when
+        // the file could not be opened or read. False when the ring broke on the
+        // way, it is finalized then and the files from the failed batch on are
+        // left unread.
+        bool ReadFiles(const std::vector<std::string>& paths, std::vector<Buffer>& results, std::vector<bool>& succeeded);
+
+        static bool IsSupported();
+
+    private:
+        // false when the ring broke, no read of the batch is in flight then
+        bool ReadBatch(const std::string* paths, size_t count, Buffer* results, std::vector<bool>::iterator succeeded);
+
+        // queues one submission entry, the caller fills it in
+        struct io_uring_sqe* GetSqe();
+        // submits everything queued and waits for count completions. When
+        // io_uring_enter fails it waits for what the kernel took to complete,
+        // finalizes the ring and returns false
+        bool SubmitAndWait(uint32_t count, int32_t* results);
+        // moves the posted completions into results by their user_data
+        uint32_t ReapCompletions(int32_t* results);
+
+        int m_nRingFd;
+        uint32_t m_nEntries;
+
+        void* m_pSqRing;
+        size_t m_szSqRingSize;
+        void* m_pCqRing;
+        size_t m_szCqRingSize;
+        struct io_uring_sqe* m_pSqes;
+        size_t m_szSqesSize;
+
+        uint32_t* m_pSqHead;
+        uint32_t* m_pSqTail;
+        uint32_t m_nSqMask;
+        uint32_t* m_pSqArray;
+        uint32_t* m_pCqHead;
+        uint32_t* m_pCqTail;
+        uint32_t m_nCqMask;
+        struct io_uring_cqe* m_pCqes;
+
+        uint32_t m_nQueued;
+    };
+}
@@ -0,0 +1,180 @@
+#include "LargeObjectAllocator.h"
+#include "VirtualMemory.h"
+#include <cassert>
+
+#ifndef ALIGN
+#define ALIGN(x, a) (((x) + ((a) - 1)) & ~((a) - 1))
+#endif
+
+namespace Corona
+{
+    // below this the buckets are one span alignment apart
+    static const size_t kLinearBucketLimit = 4 * LargeObjectAllocator::kSpanAlignment;
+
+    static inline size_t FloorPowerOfTwo(size_t x)
+    {
+        size_t p = 1;
+        while (p <= x / 2) p <<= 1;
+        return p;
+    }
+
+    static inline uint32_t Log2(size_t x)
+    {
+        uint32_t n = 0;
+        while (x >>= 1) ++n;
+        return n;
+    }
+
+    LargeObjectAllocator::LargeObjectAllocator()
+        : m_pDirectSpans(nullptr), m_szMappedSize(0), m_szCachedSize(0),
+        m_szCacheLimit(kDefaultCacheLimit), m_nEpoch(0), m_bHugePages(true)
+    {
+        for (uint32_t i = 0; i < kNumBuckets; i++)
+        {
+            m_pBuckets[i] = nullptr;
+        }
+    }
+
+    LargeObjectAllocator::~LargeObjectAllocator()
+    {
+        // spans still in use are left to the process teardown
+        Trim(true);
+    }
+
+    size_t LargeObjectAllocator::SpanSize(size_t size, uint32_t& bucket) const
+    {
+        size_t span = ALIGN(size, kSpanAlignment);
+
+        if (span > kMaxBucketSize)
+        {
+            bucket = kNumBuckets;
+            return span;
+        }
+
+        if (span <= kLinearBucketLimit)
+        {
+            bucket = uint32_t(span / kSpanAlignment - 1);
+            return span;
+        }
+
+        // 4 buckets per power of two
+        size_t base = FloorPowerOfTwo(span - 1);
+        size_t step = base / 4;
+        span = ALIGN(span, step);
+
+        bucket = uint32_t(4 + 4 * (Log2(base) - Log2(kLinearBucketLimit)) + (span - base) / step - 1);
+        assert(bucket < kNumBuckets);
+
+        return span;
+    }
+
+    void* LargeObjectAllocator::MapSpan(size_t span_size)
+    {
+        bool huge = m_bHugePages && span_size >= kHugePageThreshold;
+
+        void* p = AllocateVirtualMemory(span_size, kSpanAlignment, huge);
+        if (p) m_szMappedSize += span_size;
+
+        return p;
+    }
+
+    void LargeObjectAllocator::UnmapSpan(void* p, size_t span_size)
+    {
+        FreeVirtualMemory(p, span_size);
+        m_szMappedSize -= span_size;
+    }
+
+    void* LargeObjectAllocator::Allocate(size_t size)
+    {
+        assert(size >= kMinSize);
+
+        uint32_t bucket;
+        size_t span_size = SpanSize(size, bucket);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // reuse a recently freed span
+        FreeSpan** ppList = (bucket < kNumBuckets) ? &m_pBuckets[bucket] : &m_pDirectSpans;
+        for (FreeSpan** pp = ppList; *pp; pp = &(*pp)->pNext)
+        {
+            FreeSpan* pSpan = *pp;
+            if (pSpan->szSize == span_size)
+            {
+                *pp = pSpan->pNext;
+                m_szCachedSize -= span_size;
+                return reinterpret_cast<void*>(pSpan);
+            }
+        }
+
+        return MapSpan(span_size);
+    }
+
+    void LargeObjectAllocator::Free(void* p, size_t size)
+    {
+        if (!p) return;
+
+        uint32_t bucket;
+        size_t span_size = SpanSize(size, bucket);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_szCachedSize + span_size > m_szCacheLimit)
+        {
+            UnmapSpan(p, span_size);
+            return;
+        }
+
+        FreeSpan* pSpan = reinterpret_cast<FreeSpan*>(p);
+        FreeSpan*& pList = (bucket < kNumBuckets) ? m_pBuckets[bucket] : m_pDirectSpans;
+        pSpan->pNext = pList;
+        pSpan->szSize = span_size;
+        pSpan->nEpoch = m_nEpoch;
+        pList = pSpan;
+
+        m_szCachedSize += span_size;
+    }
+
+    size_t LargeObjectAllocator::ReleaseSpans(FreeSpan*& pList, uint32_t epoch)
+    {
+        size_t released = 0;
+
+        FreeSpan** pp = &pList;
+        while (*pp)
+        {
+            FreeSpan* pSpan = *pp;
+            if (pSpan->nEpoch < epoch)
+            {
+                *pp = pSpan->pNext;
+                released += pSpan->szSize;
+                UnmapSpan(pSpan, pSpan->szSize);
+            }
+            else
+            {
+                pp = &pSpan->pNext;
+            }
+        }
+
+        m_szCachedSize -= released;
+
+        return released;
+    }
+
+    size_t LargeObjectAllocator::Trim(bool force)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // spans freed during the interval that just ended survive one more interval
+        uint32_t epoch = force ? m_nEpoch + 1 : m_nEpoch;
+
+        size_t released = 0;
+        for (uint32_t i = 0; i < kNumBuckets; i++)
+        {
+            released += ReleaseSpans(m_pBuckets[i], epoch);
+        }
+        released += ReleaseSpans(m_pDirectSpans, epoch);
+
+        ++m_nEpoch;
+
+        return released;
+    }
+}
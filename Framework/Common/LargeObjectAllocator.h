@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace Corona
+{
+    // Allocator for blocks too big for the size-class pools. Spans are mapped
+    // straight from the OS and page aligned:
+    //  - up to kMaxBucketSize the request is rounded up to a size bucket
+    //    (4 buckets per power of two) so freed spans can be reused by similar requests
+    //  - above, the span is mapped for the exact (page rounded) size and large ones
+    //    get a transparent huge page hint
+    // Freed spans are cached up to a limit and reused, spans that are not reused
+    // within one trim interval go back to the OS. All functions are thread-safe.
+    class LargeObjectAllocator
+    {
+    public:
+        // smaller requests are left to the CRT heap
+        static const size_t kMinSize = 4 * 1024;
+        static const size_t kSpanAlignment = 4 * 1024;
+        static const size_t kMaxBucketSize = 1024 * 1024;
+        static const uint32_t kNumBuckets = 28;
+        static const size_t kHugePageThreshold = 2 * 1024 * 1024;
+        static const size_t kDefaultCacheLimit = 64 * 1024 * 1024;
+
+        LargeObjectAllocator();
+        ~LargeObjectAllocator();
+
+        // size must be at least kMinSize, the memory is kSpanAlignment aligned
+        void* Allocate(size_t size);
+        // size must be the one passed to Allocate()
+        void Free(void* p, size_t size);
+
+        // releases the cached spans that were not reused since the previous trim,
+        // with force all of them. Returns the number of bytes given back to the OS.
+        size_t Trim(bool force = false);
+
+        void SetCacheLimit(size_t limit) { m_szCacheLimit = limit; }
+        void SetHugePages(bool enable) { m_bHugePages = enable; }
+
+        size_t GetMappedSize() const { return m_szMappedSize; }
+        size_t GetCachedSize() const { return m_szCachedSize; }
+
+    private:
+        // lives in the first bytes of a cached span
+        struct FreeSpan
+        {
+            FreeSpan* pNext;
+            size_t szSize;
+            uint32_t nEpoch;
+        };
+
+        // size of the span serving a request and its bucket (kNumBuckets if none)
+        size_t SpanSize(size_t size, uint32_t& bucket) const;
+
+        void* MapSpan(size_t span_size);
+        void UnmapSpan(void* p, size_t span_size);
+
+        // releases the spans of a list older than epoch
+        size_t ReleaseSpans(FreeSpan*& pList, uint32_t epoch);
+
+        std::mutex m_Mutex;
+
+        // cached spans of each bucket, most recently freed first
+        FreeSpan* m_pBuckets[kNumBuckets];
+        // cached spans above kMaxBucketSize, reused for requests of the same size
+        FreeSpan* m_pDirectSpans;
+
+        size_t m_szMappedSize;
+        size_t m_szCachedSize;
+        size_t m_szCacheLimit;
+        uint32_t m_nEpoch;
+        bool m_bHugePages;
+
+        // disable copy & assignment
+        LargeObjectAllocator(const LargeObjectAllocator& clone);
+        LargeObjectAllocator& operator=(const LargeObjectAllocator& rhs);
+    };
+}
@@ -1,5 +1,11 @@
 #include "MemoryManager.h"
 #include <malloc.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#if defined(_DEBUG)
+#include <unordered_map>
+#endif
 
 // extern "C" void* malloc(size_t size);
 // extern "C" void free(void* p);
@@ -34,15 +40,236 @@ namespace Corona
     // largest valid block size
     static const uint32_t kMaxBlockSize = 
         kBlockSizes[kNumBlockSizes - 1];
+
+    // alignments served by natively aligned size classes, every family has
+    // classes of every multiple of its alignment up to kMaxAlignedBlockSize
+    static constexpr uint32_t kAlignedFamilies[] = { 8, 16, 32, 64, 256 };
+
+    static constexpr uint32_t kNumAlignedFamilies =
+        sizeof(kAlignedFamilies) / sizeof(kAlignedFamilies[0]);
+
+    static constexpr uint32_t kMaxAlignedBlockSize = 1024;
+
+    // number of aligned size classes over all families
+    static constexpr uint32_t CountAlignedBlockSizes()
+    {
+        uint32_t count = 0;
+        for (uint32_t alignment : kAlignedFamilies) count += kMaxAlignedBlockSize / alignment;
+        return count;
+    }
+
+    static constexpr uint32_t kNumAlignedBlockSizes = CountAlignedBlockSizes();
+
+    // bounds of the per-thread magazine of each size class
+    static const uint32_t kMinMagazineBlocks = 8;
+    static const uint32_t kMaxMagazineBlocks = 256;
         
     size_t*        MemoryManager::m_pBlockSizeLookup;
     Allocator*     MemoryManager::m_pAllocators;
+    Allocator*     MemoryManager::m_pAlignedAllocators;
+    LargeObjectAllocator* MemoryManager::m_pLargeObjectAllocator = nullptr;
+    bool           MemoryManager::m_bThreadSafe = false;
+    FrameArena*    MemoryManager::m_pFrameArenas = nullptr;
+    uint32_t       MemoryManager::m_nFrameArenaCount = 0;
+    uint32_t       MemoryManager::m_nCurrentFrameArena = 0;
+    uint32_t       MemoryManager::m_nTicksSinceTrim = 0;
+    uint32_t       MemoryManager::m_nReportInterval = 0;
+    uint32_t       MemoryManager::m_nTicksSinceReport = 0;
+
+    // index of the first allocator of each aligned family in m_pAlignedAllocators
+    static uint32_t s_nAlignedFamilyBase[kNumAlignedFamilies + 1];
+
+    static const uint32_t kMemoryTagCount = static_cast<uint32_t>(MemoryTag::Count);
+
+    // accounting of one tag, on its own cache line as threads update them concurrently
+    struct alignas(64) TagCounters
+    {
+        std::atomic<size_t>   szLiveBytes{0};
+        std::atomic<size_t>   szPeakBytes{0};
+        std::atomic<size_t>   szBudget{0};
+        std::atomic<uint64_t> nLiveAllocations{0};
+        std::atomic<uint64_t> nTotalAllocations{0};
+    };
+
+    static TagCounters s_TagCounters[kMemoryTagCount];
+    static MemoryManager::BudgetCallback s_BudgetCallback;
+
+    // in thread-safe mode the accounting is batched per thread and published when
+    // a delta grows over kTagPublishBytes or after kTagPublishOps operations,
+    // so the shared counters may lag behind by that much per thread
+    static const int64_t  kTagPublishBytes = 64 * 1024;
+    static const uint32_t kTagPublishOps = 256;
+
+    struct TagDelta
+    {
+        int64_t  nBytes = 0;
+        int64_t  nAllocations = 0;
+        uint64_t nTotalAllocations = 0;
+        uint32_t nOps = 0;
+    };
+
+    static void ApplyTagDelta(MemoryTag tag, const TagDelta& delta, bool shared)
+    {
+        TagCounters& counters = s_TagCounters[static_cast<uint32_t>(tag)];
+
+        size_t before, live;
+        if (shared)
+        {
+            before = counters.szLiveBytes.fetch_add(size_t(delta.nBytes), std::memory_order_relaxed);
+            live = before + size_t(delta.nBytes);
+            counters.nLiveAllocations.fetch_add(uint64_t(delta.nAllocations), std::memory_order_relaxed);
+            counters.nTotalAllocations.fetch_add(delta.nTotalAllocations, std::memory_order_relaxed);
+
+            size_t peak = counters.szPeakBytes.load(std::memory_order_relaxed);
+            while (live > peak && !counters.szPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            {
+            }
+        }
+        else
+        {
+            // single owner, no need for read-modify-write
+            before = counters.szLiveBytes.load(std::memory_order_relaxed);
+            live = before + size_t(delta.nBytes);
+            counters.szLiveBytes.store(live, std::memory_order_relaxed);
+            counters.nLiveAllocations.store(counters.nLiveAllocations.load(std::memory_order_relaxed) + uint64_t(delta.nAllocations), std::memory_order_relaxed);
+            counters.nTotalAllocations.store(counters.nTotalAllocations.load(std::memory_order_relaxed) + delta.nTotalAllocations, std::memory_order_relaxed);
+
+            if (live > counters.szPeakBytes.load(std::memory_order_relaxed))
+                counters.szPeakBytes.store(live, std::memory_order_relaxed);
+        }
+
+        // only the update crossing the budget reports it
+        size_t budget = counters.szBudget.load(std::memory_order_relaxed);
+        if (delta.nBytes > 0 && budget && live > budget && before <= budget && s_BudgetCallback)
+        {
+            s_BudgetCallback(tag, live, budget);
+        }
+    }
+
+#if defined(_DEBUG)
+    // every live allocation, for the leak list printed at Finalize()
+    struct LiveAllocation
+    {
+        size_t size;
+        MemoryTag tag;
+    };
+
+    static std::mutex s_LiveAllocationMutex;
+    static std::unordered_map<void*, LiveAllocation>* s_pLiveAllocations = nullptr;
+#endif
+
+    // bumped on every Finalize() so stale thread caches drop their blocks
+    static std::atomic<uint32_t> s_nAllocatorGeneration(0);
+
+    // a magazine holds about two pages worth of blocks, refills and drains move half of it
+    static inline uint32_t MagazineCapacity(const Allocator& allocator)
+    {
+        uint32_t blocks = uint32_t(2 * kPageSize / allocator.GetBlockSize());
+        return std::min(std::max(blocks, kMinMagazineBlocks), kMaxMagazineBlocks);
+    }
+
+    // trivially destructible, so accessing it needs no initialization check
+    static thread_local TagDelta t_TagDeltas[kMemoryTagCount];
+
+    static void PublishTagDelta(uint32_t tag)
+    {
+        TagDelta& delta = t_TagDeltas[tag];
+        if (delta.nOps)
+        {
+            ApplyTagDelta(static_cast<MemoryTag>(tag), delta, true);
+            delta = TagDelta();
+        }
+    }
+
+    struct ThreadCache
+    {
+        struct Magazine
+        {
+            BlockHeader* pHead = nullptr;
+            uint32_t     nCount = 0;
+        };
+
+        Magazine magazines[kNumBlockSizes];
+        // one per aligned size class, in the order of m_pAlignedAllocators
+        Magazine alignedMagazines[kNumAlignedBlockSizes];
+        uint32_t nGeneration;
+
+
+        ThreadCache() : nGeneration(s_nAllocatorGeneration.load(std::memory_order_acquire)) {}
+
+        ~ThreadCache()
+        {
+            Flush();
+        }
+
+        // drops the cached blocks if the allocators they came from were finalized
+        void Validate()
+        {
+            uint32_t generation = s_nAllocatorGeneration.load(std::memory_order_acquire);
+            if (nGeneration != generation)
+            {
+                for (auto& magazine : magazines)
+                {
+                    magazine = Magazine();
+                }
+                for (auto& magazine : alignedMagazines)
+                {
+                    magazine = Magazine();
+                }
+                nGeneration = generation;
+            }
+        }
+
+        // hands every cached block back to the shared allocators
+        void Flush()
+        {
+            for (uint32_t i = 0; i < kMemoryTagCount; i++)
+            {
+                PublishTagDelta(i);
+            }
+
+            Validate();
+            if (!MemoryManager::m_pAllocators) return;
+
+            for (size_t i = 0; i < kNumBlockSizes; i++)
+            {
+                Drain(magazines[i], MemoryManager::m_pAllocators[i]);
+            }
+
+            for (size_t i = 0; i < kNumAlignedBlockSizes; i++)
+            {
+                Drain(alignedMagazines[i], MemoryManager::m_pAlignedAllocators[i]);
+            }
+        }
+
+        static void Drain(Magazine& magazine, Allocator& allocator)
+        {
+            if (magazine.nCount)
+            {
+                BlockHeader* pTail = magazine.pHead;
+                while (pTail->pNext) pTail = pTail->pNext;
+                allocator.FreeRemote(magazine.pHead, pTail);
+                magazine = Magazine();
+            }
+        }
+
+        // the magazine caching the blocks of a plain or an aligned size class
+        Magazine& MagazineOf(const Allocator* pAlloc)
+        {
+            const Allocator* pPlain = MemoryManager::m_pAllocators;
+            if (pAlloc >= pPlain && pAlloc < pPlain + kNumBlockSizes)
+                return magazines[pAlloc - pPlain];
+
+            return alignedMagazines[pAlloc - MemoryManager::m_pAlignedAllocators];
+        }
+    };
+
+    static thread_local ThreadCache t_ThreadCache;
 
     int MemoryManager::Initialize()
     {
-        // one-time initialization
-        static bool s_bInitialized = false;
-        if(!s_bInitialized)
+        // one-time initialization (until the next Finalize)
+        if(!m_pAllocators)
         {
             // initialize block size lookup table
             m_pBlockSizeLookup = new size_t[kMaxBlockSize + 1];
@@ -60,7 +287,34 @@ namespace Corona
                 m_pAllocators[i].Reset(kBlockSizes[i], kPageSize, kAlignment);
             }
 
-            s_bInitialized = true;
+            // initialize the aligned allocators
+            s_nAlignedFamilyBase[0] = 0;
+            for (size_t f = 0; f < kNumAlignedFamilies; f++)
+            {
+                s_nAlignedFamilyBase[f + 1] = s_nAlignedFamilyBase[f] + kMaxAlignedBlockSize / kAlignedFamilies[f];
+            }
+
+            assert(s_nAlignedFamilyBase[kNumAlignedFamilies] == kNumAlignedBlockSizes);
+            m_pAlignedAllocators = new Allocator[kNumAlignedBlockSizes];
+            for (size_t f = 0; f < kNumAlignedFamilies; f++)
+            {
+                uint32_t alignment = kAlignedFamilies[f];
+                for (uint32_t i = s_nAlignedFamilyBase[f]; i < s_nAlignedFamilyBase[f + 1]; i++)
+                {
+                    size_t size = (i - s_nAlignedFamilyBase[f] + 1) * alignment;
+                    m_pAlignedAllocators[i].Reset(size, kPageSize, alignment);
+                }
+            }
+
+            m_pLargeObjectAllocator = new LargeObjectAllocator();
+
+            // the I/O threads of the AssetLoader and the decode workers allocate too
+            m_bThreadSafe = true;
+
+#if defined(_DEBUG)
+            std::lock_guard<std::mutex> lock(s_LiveAllocationMutex);
+            s_pLiveAllocations = new std::unordered_map<void*, LiveAllocation>();
+#endif
         }
 
         return 0;
@@ -68,12 +322,136 @@ namespace Corona
 
     void MemoryManager::Finalize()
     {
+        // publish the accounting of the calling thread before reporting
+        if (m_bThreadSafe) t_ThreadCache.Flush();
+
+#if defined(_DEBUG)
+        PrintReport();
+        PrintLeaks();
+        {
+            std::lock_guard<std::mutex> lock(s_LiveAllocationMutex);
+            delete s_pLiveAllocations;
+            s_pLiveAllocations = nullptr;
+        }
+#else
+        if (m_nReportInterval) PrintReport();
+#endif
+
+        s_nAllocatorGeneration.fetch_add(1, std::memory_order_acq_rel);
+        m_bThreadSafe = false;
+
+        delete[] m_pFrameArenas;
+        m_pFrameArenas = nullptr;
+        m_nFrameArenaCount = 0;
+        m_nCurrentFrameArena = 0;
+
+        delete m_pLargeObjectAllocator;
+        m_pLargeObjectAllocator = nullptr;
+
+        delete[] m_pAlignedAllocators;
         delete[] m_pAllocators;
         delete[] m_pBlockSizeLookup;
+        m_pAlignedAllocators = nullptr;
+        m_pAllocators = nullptr;
+        m_pBlockSizeLookup = nullptr;
+    }
+
+    void MemoryManager::SetThreadSafe(bool enable)
+    {
+        if (m_bThreadSafe && !enable)
+        {
+            // blocks cached by the calling thread go back to the shared allocators,
+            // other threads must be stopped (and have flushed) by now
+            t_ThreadCache.Flush();
+        }
+
+        m_bThreadSafe = enable;
     }
 
     void MemoryManager::Tick()
     {
+        // the allocators track the peak usage in between, so pages needed by the
+        // working set survive and only what a past peak left behind goes away
+        if (++m_nTicksSinceTrim >= kTrimIntervalTicks)
+        {
+            Trim();
+        }
+
+        if (m_nReportInterval && ++m_nTicksSinceReport >= m_nReportInterval)
+        {
+            m_nTicksSinceReport = 0;
+            PrintReport();
+        }
+    }
+
+    uint32_t MemoryManager::GetBlockSizeCount()
+    {
+        return kNumBlockSizes;
+    }
+
+    uint32_t MemoryManager::GetBlockSize(uint32_t index)
+    {
+        return kBlockSizes[index];
+    }
+
+    uint32_t MemoryManager::GetPageSize()
+    {
+        return kPageSize;
+    }
+
+    uint32_t MemoryManager::GetAlignment()
+    {
+        return kAlignment;
+    }
+
+    size_t MemoryManager::Trim(bool force)
+    {
+        m_nTicksSinceTrim = 0;
+        if (!m_pAllocators) return 0;
+
+        size_t released = 0;
+        for (size_t i = 0; i < kNumBlockSizes; i++)
+        {
+            released += m_pAllocators[i].Trim(force);
+        }
+
+        for (size_t i = 0; i < s_nAlignedFamilyBase[kNumAlignedFamilies]; i++)
+        {
+            released += m_pAlignedAllocators[i].Trim(force);
+        }
+
+        released += m_pLargeObjectAllocator->Trim(force);
+
+        return released;
+    }
+
+    void MemoryManager::InitializeFrameArenas(uint32_t frame_count, size_t capacity)
+    {
+        delete[] m_pFrameArenas;
+
+        m_pFrameArenas = new FrameArena[frame_count];
+        for (uint32_t i = 0; i < frame_count; i++)
+        {
+            m_pFrameArenas[i].Initialize(capacity);
+        }
+
+        m_nFrameArenaCount = frame_count;
+        m_nCurrentFrameArena = 0;
+    }
+
+    void MemoryManager::BeginFrame(uint32_t frame_index)
+    {
+        assert(frame_index < m_nFrameArenaCount);
+
+        m_nCurrentFrameArena = frame_index;
+        m_pFrameArenas[frame_index].Reset();
+    }
+
+    FrameArena& MemoryManager::GetFrameArena()
+    {
+        assert(m_pFrameArenas);
+
+        return m_pFrameArenas[m_nCurrentFrameArena];
     }
 
     Allocator* MemoryManager::LookUpAllocator(size_t size)
@@ -85,36 +463,350 @@ namespace Corona
             return nullptr;
     }
 
-    void* MemoryManager::Allocate(size_t size)
+    Allocator* MemoryManager::LookUpAlignedAllocator(size_t size, size_t alignment)
     {
+        if (size > kMaxAlignedBlockSize)
+            return nullptr;
+
+        // smallest family that satisfies the alignment
+        for (size_t f = 0; f < kNumAlignedFamilies; f++)
+        {
+            if (alignment <= kAlignedFamilies[f])
+            {
+                size_t index = (std::max<size_t>(size, 1) + kAlignedFamilies[f] - 1) / kAlignedFamilies[f] - 1;
+                return m_pAlignedAllocators + s_nAlignedFamilyBase[f] + index;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void* MemoryManager::AllocateFromThreadCache(Allocator* pAlloc)
+    {
+        ThreadCache& cache = t_ThreadCache;
+        cache.Validate();
+
+        ThreadCache::Magazine& magazine = cache.MagazineOf(pAlloc);
+        if (!magazine.pHead)
+        {
+            magazine.nCount = pAlloc->AllocateBatch(magazine.pHead, MagazineCapacity(*pAlloc) / 2);
+            // out of pages
+            if (!magazine.pHead) return nullptr;
+        }
+
+        BlockHeader* pBlock = magazine.pHead;
+        magazine.pHead = pBlock->pNext;
+        --magazine.nCount;
+
+        return reinterpret_cast<void*>(pBlock);
+    }
+
+    void MemoryManager::FreeToThreadCache(Allocator* pAlloc, void* p)
+    {
+        ThreadCache& cache = t_ThreadCache;
+        cache.Validate();
+
+        ThreadCache::Magazine& magazine = cache.MagazineOf(pAlloc);
+        BlockHeader* pBlock = reinterpret_cast<BlockHeader*>(p);
+        pBlock->pNext = magazine.pHead;
+        magazine.pHead = pBlock;
+        ++magazine.nCount;
+
+        uint32_t capacity = MagazineCapacity(*pAlloc);
+        if (magazine.nCount > capacity)
+        {
+            // drain the older half of the magazine, the recently freed (cache-hot) blocks stay
+            BlockHeader* pKeepTail = magazine.pHead;
+            for (uint32_t i = 1; i < capacity / 2; i++)
+            {
+                pKeepTail = pKeepTail->pNext;
+            }
+
+            BlockHeader* pDrainHead = pKeepTail->pNext;
+            BlockHeader* pDrainTail = pDrainHead;
+            while (pDrainTail->pNext) pDrainTail = pDrainTail->pNext;
+
+            pKeepTail->pNext = nullptr;
+            pAlloc->FreeRemote(pDrainHead, pDrainTail);
+            magazine.nCount = capacity / 2;
+        }
+    }
+
+    void* MemoryManager::AllocateUntracked(size_t size)
+    {
+        if (m_bThreadSafe && size <= kMaxBlockSize)
+            return AllocateFromThreadCache(m_pAllocators + m_pBlockSizeLookup[size]);
+
         Allocator* pAlloc = LookUpAllocator(size);
         if (pAlloc)
             return pAlloc->Allocate();
+        else if (size >= LargeObjectAllocator::kMinSize)
+            return m_pLargeObjectAllocator->Allocate(size);
         else
             return malloc(size);
     }
 
-	void* MemoryManager::Allocate(size_t size, size_t alignment)
-	{
-		uint8_t* p;
-		size += alignment;
-		Allocator* pAlloc = LookUpAllocator(size);
-		if (pAlloc)
-			p = reinterpret_cast<uint8_t*>(pAlloc->Allocate());
-		else
-			p = reinterpret_cast<uint8_t*>(malloc(size));
+    void* MemoryManager::AllocateAlignedUntracked(size_t size, size_t alignment)
+    {
+        assert((alignment & (alignment - 1)) == 0);
+
+        // the regular size classes already satisfy it
+        if (alignment <= kAlignment)
+            return AllocateUntracked(size);
+
+        Allocator* pAlloc = LookUpAlignedAllocator(size, alignment);
+        if (pAlloc)
+        {
+            if (m_bThreadSafe)
+                return AllocateFromThreadCache(pAlloc);
+
+            return pAlloc->Allocate();
+        }
+
+        // large spans are page aligned
+        if (size >= LargeObjectAllocator::kMinSize && alignment <= LargeObjectAllocator::kSpanAlignment)
+            return m_pLargeObjectAllocator->Allocate(size);
+
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+
+    void MemoryManager::FreeAlignedUntracked(void* p, size_t size, size_t alignment)
+    {
+        if (alignment <= kAlignment)
+        {
+            FreeUntracked(p, size);
+            return;
+        }
+
+        Allocator* pAlloc = LookUpAlignedAllocator(size, alignment);
+        if (pAlloc)
+        {
+            if (m_bThreadSafe)
+                FreeToThreadCache(pAlloc, p);
+            else
+                pAlloc->Free(p);
+            return;
+        }
 
-		p = reinterpret_cast<uint8_t*>(ALIGN(reinterpret_cast<size_t>(p), alignment));
+        if (size >= LargeObjectAllocator::kMinSize && alignment <= LargeObjectAllocator::kSpanAlignment)
+        {
+            m_pLargeObjectAllocator->Free(p, size);
+            return;
+        }
 
-		return static_cast<void*>(p);
-	}
+        ::operator delete(p, std::align_val_t(alignment));
+    }
 
-    void MemoryManager::Free(void* p, size_t size)
+    void MemoryManager::FreeUntracked(void* p, size_t size)
     {
+        if (m_bThreadSafe && size <= kMaxBlockSize)
+        {
+            FreeToThreadCache(m_pAllocators + m_pBlockSizeLookup[size], p);
+            return;
+        }
+
         Allocator* pAlloc = LookUpAllocator(size);
         if (pAlloc)
             pAlloc->Free(p);
+        else if (size >= LargeObjectAllocator::kMinSize)
+            m_pLargeObjectAllocator->Free(p, size);
         else
             free(p);
     }
-}
\ No newline at end of file
+
+    const char* GetMemoryTagName(MemoryTag tag)
+    {
+        static const char* names[] = { "General", "Texture", "Mesh", "Scene", "Physics", "Transient" };
+        static_assert(sizeof(names) / sizeof(names[0]) == kMemoryTagCount, "a memory tag has no name");
+
+        return (tag < MemoryTag::Count) ? names[static_cast<uint32_t>(tag)] : "Unknown";
+    }
+
+    void MemoryManager::UpdateTagCounters(MemoryTag tag, int64_t bytes, int64_t allocations)
+    {
+        if (m_bThreadSafe)
+        {
+            uint32_t index = static_cast<uint32_t>(tag);
+            TagDelta& delta = t_TagDeltas[index];
+            delta.nBytes += bytes;
+            delta.nAllocations += allocations;
+            if (allocations > 0) delta.nTotalAllocations += allocations;
+
+            if (++delta.nOps >= kTagPublishOps || delta.nBytes >= kTagPublishBytes || delta.nBytes <= -kTagPublishBytes)
+            {
+                PublishTagDelta(index);
+            }
+        }
+        else
+        {
+            TagDelta delta;
+            delta.nBytes = bytes;
+            delta.nAllocations = allocations;
+            delta.nTotalAllocations = (allocations > 0) ? allocations : 0;
+            ApplyTagDelta(tag, delta, false);
+        }
+    }
+
+    void MemoryManager::TrackAllocation(void* p, size_t size, MemoryTag tag)
+    {
+        if (!p) return;
+
+        UpdateTagCounters(tag, int64_t(size), 1);
+
+#if defined(_DEBUG)
+        std::lock_guard<std::mutex> lock(s_LiveAllocationMutex);
+        if (s_pLiveAllocations) (*s_pLiveAllocations)[p] = LiveAllocation{ size, tag };
+#endif
+    }
+
+    void MemoryManager::TrackFree([[maybe_unused]] void* p, size_t size, MemoryTag tag)
+    {
+        UpdateTagCounters(tag, -int64_t(size), -1);
+
+#if defined(_DEBUG)
+        std::lock_guard<std::mutex> lock(s_LiveAllocationMutex);
+        if (!s_pLiveAllocations) return;
+
+        auto it = s_pLiveAllocations->find(p);
+        if (it == s_pLiveAllocations->end())
+        {
+            fprintf(stderr, "[MemoryManager] freeing %p (%zu bytes, %s) which was not allocated by the memory manager\n",
+                p, size, GetMemoryTagName(tag));
+            return;
+        }
+
+        if (it->second.size != size || it->second.tag != tag)
+        {
+            fprintf(stderr, "[MemoryManager] %p allocated as %zu bytes (%s) but freed as %zu bytes (%s)\n",
+                p, it->second.size, GetMemoryTagName(it->second.tag), size, GetMemoryTagName(tag));
+        }
+
+        s_pLiveAllocations->erase(it);
+#endif
+    }
+
+    void* MemoryManager::Allocate(size_t size, MemoryTag tag)
+    {
+        void* p = AllocateUntracked(size);
+        TrackAllocation(p, size, tag);
+        return p;
+    }
+
+    void MemoryManager::Free(void* p, size_t size, MemoryTag tag)
+    {
+        if (!p) return;
+
+        TrackFree(p, size, tag);
+        FreeUntracked(p, size);
+    }
+
+    void* MemoryManager::AllocateAligned(size_t size, size_t alignment, MemoryTag tag)
+    {
+        void* p = AllocateAlignedUntracked(size, alignment);
+        TrackAllocation(p, size, tag);
+        return p;
+    }
+
+    void MemoryManager::FreeAligned(void* p, size_t size, size_t alignment, MemoryTag tag)
+    {
+        if (!p) return;
+
+        TrackFree(p, size, tag);
+        FreeAlignedUntracked(p, size, alignment);
+    }
+
+    void MemoryManager::SetBudget(MemoryTag tag, size_t budget)
+    {
+        s_TagCounters[static_cast<uint32_t>(tag)].szBudget.store(budget, std::memory_order_relaxed);
+    }
+
+    void MemoryManager::SetBudgetCallback(BudgetCallback callback)
+    {
+        s_BudgetCallback = callback;
+    }
+
+    MemoryTagStats MemoryManager::GetTagStats(MemoryTag tag) const
+    {
+        // what the calling thread did is always included
+        if (m_bThreadSafe) PublishTagDelta(static_cast<uint32_t>(tag));
+
+        const TagCounters& counters = s_TagCounters[static_cast<uint32_t>(tag)];
+
+        MemoryTagStats stats;
+        stats.szLiveBytes = counters.szLiveBytes.load(std::memory_order_relaxed);
+        stats.szPeakBytes = counters.szPeakBytes.load(std::memory_order_relaxed);
+        stats.szBudget = counters.szBudget.load(std::memory_order_relaxed);
+        stats.nLiveAllocations = counters.nLiveAllocations.load(std::memory_order_relaxed);
+        stats.nTotalAllocations = counters.nTotalAllocations.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    void MemoryManager::PrintReport() const
+    {
+        printf("[MemoryManager] %-10s %12s %12s %12s %12s %12s\n",
+            "tag", "live KB", "peak KB", "budget KB", "live allocs", "total allocs");
+
+        for (uint32_t i = 0; i < kMemoryTagCount; i++)
+        {
+            MemoryTagStats stats = GetTagStats(static_cast<MemoryTag>(i));
+            printf("[MemoryManager] %-10s %12zu %12zu %12zu %12llu %12llu%s\n",
+                GetMemoryTagName(static_cast<MemoryTag>(i)),
+                stats.szLiveBytes / 1024, stats.szPeakBytes / 1024, stats.szBudget / 1024,
+                (unsigned long long)stats.nLiveAllocations, (unsigned long long)stats.nTotalAllocations,
+                (stats.szBudget && stats.szLiveBytes > stats.szBudget) ? "  OVER BUDGET" : "");
+        }
+
+        if (!m_pAllocators) return;
+
+        // size-class pools, blocks cached by threads count as used
+        size_t pages = 0, blocks = 0, free_blocks = 0, empty_pages = 0, used_bytes = 0, page_bytes = 0;
+        auto accumulate = [&](const Allocator& allocator) {
+            pages += allocator.GetPageCount();
+            empty_pages += allocator.GetEmptyPageCount();
+            blocks += allocator.GetBlockCount();
+            free_blocks += allocator.GetFreeBlockCount();
+            used_bytes += size_t(allocator.GetUsedBlockCount()) * allocator.GetBlockSize();
+            page_bytes += size_t(allocator.GetPageCount()) * allocator.GetPageSize();
+        };
+
+        for (size_t i = 0; i < kNumBlockSizes; i++) accumulate(m_pAllocators[i]);
+        for (size_t i = 0; i < s_nAlignedFamilyBase[kNumAlignedFamilies]; i++) accumulate(m_pAlignedAllocators[i]);
+
+        printf("[MemoryManager] pools: %zu pages (%zu empty, %zu KB), %zu of %zu blocks used (%zu KB)\n",
+            pages, empty_pages, page_bytes / 1024, blocks - free_blocks, blocks, used_bytes / 1024);
+        printf("[MemoryManager] large objects: %zu KB mapped, %zu KB cached\n",
+            m_pLargeObjectAllocator->GetMappedSize() / 1024, m_pLargeObjectAllocator->GetCachedSize() / 1024);
+
+        for (uint32_t i = 0; i < m_nFrameArenaCount; i++)
+        {
+            printf("[MemoryManager] frame arena %u: %zu KB capacity, %zu KB peak\n",
+                i, m_pFrameArenas[i].GetCapacity() / 1024, m_pFrameArenas[i].GetPeakSize() / 1024);
+        }
+    }
+
+#if defined(_DEBUG)
+    void MemoryManager::PrintLeaks()
+    {
+        static const size_t kMaxPrintedLeaks = 32;
+
+        std::lock_guard<std::mutex> lock(s_LiveAllocationMutex);
+        if (!s_pLiveAllocations || s_pLiveAllocations->empty()) return;
+
+        fprintf(stderr, "[MemoryManager] %zu allocations were not freed:\n", s_pLiveAllocations->size());
+
+        size_t printed = 0;
+        for (auto& allocation : *s_pLiveAllocations)
+        {
+            if (printed++ == kMaxPrintedLeaks)
+            {
+                fprintf(stderr, "[MemoryManager]   ...\n");
+                break;
+            }
+
+            fprintf(stderr, "[MemoryManager]   %p %zu bytes (%s)\n", allocation.first,
+                allocation.second.size, GetMemoryTagName(allocation.second.tag));
+        }
+    }
+#endif
+}
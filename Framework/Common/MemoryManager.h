@@ -1,24 +1,56 @@
 #pragma once
 #include "IRuntimeModule.h"
 #include "Allocator.h"
+#include "FrameArena.h"
+#include "LargeObjectAllocator.h"
+#include <functional>
 #include <new>
 
 namespace Corona
 {
+    // the subsystem an allocation is accounted to
+    enum class MemoryTag : uint32_t
+    {
+        General,
+        Texture,
+        Mesh,
+        Scene,
+        Physics,
+        Transient,
+        Count
+    };
+
+    const char* GetMemoryTagName(MemoryTag tag);
+
+    struct MemoryTagStats
+    {
+        size_t szLiveBytes;
+        size_t szPeakBytes;
+        size_t szBudget;
+        uint64_t nLiveAllocations;
+        uint64_t nTotalAllocations;
+    };
+
     class MemoryManager : implements IRuntimeModule
     {
     public:
         template<typename T, typename ...Arguments>
         T* New(Arguments... parameters)
         {
-            return new (Allocate(sizeof(T))) T(parameters...);
+            return new (AllocateAligned(sizeof(T), alignof(T))) T(parameters...);
+        }
+
+        template<typename T, typename ...Arguments>
+        T* New(MemoryTag tag, Arguments... parameters)
+        {
+            return new (AllocateAligned(sizeof(T), alignof(T), tag)) T(parameters...);
         }
 
         template<typename T>
-        void Delete(T *p)
+        void Delete(T *p, MemoryTag tag = MemoryTag::General)
         {
             reinterpret_cast<T*>(p)->~T();
-            Free(p, sizeof(T));
+            FreeAligned(p, sizeof(T), alignof(T), tag);
         }
 
     public:
@@ -28,15 +60,96 @@ namespace Corona
         virtual void Finalize();
         virtual void Tick();
 
-        void* Allocate(size_t size);
-        void* Allocate(size_t size, size_t alignment);
-        void Free(void* p, size_t size);
+        // memory must be released with the same size and tag
+        void* Allocate(size_t size, MemoryTag tag = MemoryTag::General);
+        void Free(void* p, size_t size, MemoryTag tag = MemoryTag::General);
+
+        // alignment must be a power of two. Small requests come from size classes whose
+        // pages are natively aligned, so no padding is wasted and no header is needed.
+        // Memory must be released with FreeAligned() and the same size, alignment and tag.
+        void* AllocateAligned(size_t size, size_t alignment, MemoryTag tag = MemoryTag::General);
+        void FreeAligned(void* p, size_t size, size_t alignment, MemoryTag tag = MemoryTag::General);
+
+        // releases the empty allocator pages, see Allocator::Trim().
+        // Tick() trims periodically, keeping what the peak of the last interval needed
+        size_t Trim(bool force = false);
+
+        // same as AllocateAligned(), kept for existing callers
+        void* Allocate(size_t size, size_t alignment) { return AllocateAligned(size, alignment); }
+
+        // per tag accounting, the callback fires (on the allocating thread) when an
+        // allocation takes the live bytes of a tag over its budget, 0 means no budget
+        typedef std::function<void(MemoryTag tag, size_t live_bytes, size_t budget)> BudgetCallback;
+        void SetBudget(MemoryTag tag, size_t budget);
+        void SetBudgetCallback(BudgetCallback callback);
+        // in thread-safe mode each other thread publishes its share in batches, so the
+        // statistics may lag behind by up to 64KB per tag and thread
+        MemoryTagStats GetTagStats(MemoryTag tag) const;
+
+        // prints the per tag statistics and the allocator usage
+        void PrintReport() const;
+        // Tick() prints the report every interval ticks, 0 turns it off
+        void SetReportInterval(uint32_t interval) { m_nReportInterval = interval; }
+
+        // the size classes of the pools, for tools and benchmarks
+        static uint32_t GetBlockSizeCount();
+        static uint32_t GetBlockSize(uint32_t index);
+        static uint32_t GetPageSize();
+        static uint32_t GetAlignment();
+
+        // In thread-safe mode every thread allocates from its own magazines of
+        // blocks, which are refilled from / drained to the shared allocators in batches.
+        // Initialize() turns it on. Only turn it off while no other thread touches
+        // the memory manager, e.g. for single-threaded tools and benchmarks.
+        void SetThreadSafe(bool enable);
+        bool IsThreadSafe() const { return m_bThreadSafe; }
+
+        // one linear arena per frame in flight for per-frame scratch data
+        void InitializeFrameArenas(uint32_t frame_count, size_t capacity = kDefaultFrameArenaSize);
+        // resets the arena of frame_index and makes it the current one
+        void BeginFrame(uint32_t frame_index);
+        FrameArena& GetFrameArena();
+
+        template<typename T>
+        FrameAllocator<T> GetFrameAllocator() { return FrameAllocator<T>(GetFrameArena()); }
+
+        static const size_t kDefaultFrameArenaSize = 1024 * 1024;
+
+        // ticks between two periodic trims
+        static const uint32_t kTrimIntervalTicks = 300;
 
     private:
         static size_t* m_pBlockSizeLookup;
         static Allocator* m_pAllocators;
+        static Allocator* m_pAlignedAllocators;
+        static LargeObjectAllocator* m_pLargeObjectAllocator;
+        static bool m_bThreadSafe;
+        static FrameArena* m_pFrameArenas;
+        static uint32_t m_nFrameArenaCount;
+        static uint32_t m_nCurrentFrameArena;
+        static uint32_t m_nTicksSinceTrim;
+        static uint32_t m_nReportInterval;
+        static uint32_t m_nTicksSinceReport;
     private:
+        static void* AllocateUntracked(size_t size);
+        static void FreeUntracked(void* p, size_t size);
+        static void* AllocateAlignedUntracked(size_t size, size_t alignment);
+        static void FreeAlignedUntracked(void* p, size_t size, size_t alignment);
+
+        static void UpdateTagCounters(MemoryTag tag, int64_t bytes, int64_t allocations);
+        static void TrackAllocation(void* p, size_t size, MemoryTag tag);
+        static void TrackFree(void* p, size_t size, MemoryTag tag);
+
+#if defined(_DEBUG)
+        static void PrintLeaks();
+#endif
+
         static Allocator* LookUpAllocator(size_t size);
+        static Allocator* LookUpAlignedAllocator(size_t size, size_t alignment);
+        static void* AllocateFromThreadCache(Allocator* pAlloc);
+        static void FreeToThreadCache(Allocator* pAlloc, void* p);
+
+        friend struct ThreadCache;
     };
 
     extern MemoryManager* g_pMemoryManager;
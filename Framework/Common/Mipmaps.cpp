@@ -0,0 +1,171 @@
+#include "Mipmaps.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "PixelConversion.h"
+#include "portable.h"
+
+namespace Corona
+{
+    // every band of rows goes down this many levels on its own
+    static const uint32_t kBandLevels = 6;
+    static const uint32_t kBandRows = 1u << kBandLevels;
+
+    // steps of the search for the alpha scale that keeps the coverage
+    static const int kCoverageSteps = 16;
+
+    std::string MipmapDesc::GetKey() const
+    {
+        static const char* names[] = { "", "linear", "srgb", "normal" };
+        if (filter == MIPMAP_FILTER::NONE) return std::string();
+
+        char key[64];
+        snprintf(key, sizeof(key), "|mips:%s", names[static_cast<int>(filter)]);
+        std::string result = key;
+        if (fAlphaCutoff > 0.0f)
+        {
+            snprintf(key, sizeof(key), ":%g", fAlphaCutoff);
+            result += key;
+        }
+        return result;
+    }
+
+    uint32_t GetMipLevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t levels = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size >>= 1) levels++;
+        return levels;
+    }
+
+    size_t LayoutMipmaps(Image& image, uint32_t levels)
+    {
+        image.mipmaps.resize(levels);
+        size_t pixel_bytes = image.bitcount >> 3;
+        size_t offset = 0;
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            Mipmap& mip = image.mipmaps[level];
+            if (level == 0)
+            {
+                mip.Width = image.Width;
+                mip.Height = image.Height;
+                mip.pitch = image.pitch;
+            }
+            else
+            {
+                const Mipmap& above = image.mipmaps[level - 1];
+                mip.Width = std::max(1u, above.Width >> 1);
+                mip.Height = std::max(1u, above.Height >> 1);
+                mip.pitch = mip.Width * pixel_bytes;
+            }
+            mip.offset = ALIGN(offset, 16);
+            mip.data_size = mip.pitch * mip.Height;
+            offset = mip.offset + mip.data_size;
+        }
+        return offset;
+    }
+
+    bool GenerateMipmaps(Image& image, const MipmapDesc& desc, uint32_t threads)
+    {
+        if (desc.filter == MIPMAP_FILTER::NONE || !image.mipmaps.empty()) return true;
+        if (!image.data || image.compressed || !CanConvertToRGBA8(image.pixel_format)) return false;
+
+        // the full size level is copied, or converted, into the new chain
+        Image rgba;
+        rgba.Width = image.Width;
+        rgba.Height = image.Height;
+        rgba.bitcount = 32;
+        rgba.bitdepth = 8;
+        rgba.pixel_format = PIXEL_FORMAT::RGBA8;
+        rgba.pitch = image.pixel_format == PIXEL_FORMAT::RGBA8 ? image.pitch : ALIGN((size_t)image.Width * 4, 4);
+        uint32_t levels = GetMipLevelCount(image.Width, image.Height);
+        rgba.data_size = LayoutMipmaps(rgba, levels);
+        rgba.data = new uint8_t[rgba.data_size];
+        ConvertToRGBA8(image.pixel_format, image.data, (ptrdiff_t)image.pitch, rgba.data, (ptrdiff_t)rgba.pitch,
+                       image.Width, image.Height);
+
+        const std::vector<Mipmap>& mips = rgba.mipmaps;
+        uint8_t* data = rgba.data;
+        int32_t filter = desc.filter == MIPMAP_FILTER::SRGB ? 1 : desc.filter == MIPMAP_FILTER::NORMAL_MAP ? 2 : 0;
+        auto downsample = [&](uint32_t level, uint32_t first_row, uint32_t row_count) {
+            const Mipmap& src = mips[level - 1];
+            const Mipmap& dst = mips[level];
+            ispc::DownsampleRGBA8(data + src.offset, (int64_t)src.pitch, src.Width, src.Height, data + dst.offset,
+                                  (int64_t)dst.pitch, dst.Width, first_row, row_count, filter);
+        };
+
+        size_t thread_count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        auto run = [&](size_t count, const auto& work) {
+            if (!count) return;
+            size_t thread_total = std::min(thread_count, count);
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < thread_total; i++) workers.emplace_back(work);
+            work();
+            for (auto& worker : workers) worker.join();
+        };
+
+        // A row of a level only reads two rows of the level above, so every
+        // band of rows makes its part of the next levels without the others
+        uint32_t band_levels = std::min(levels - 1, kBandLevels);
+        uint32_t bands = (image.Height + kBandRows - 1) / kBandRows;
+        std::atomic<uint32_t> next{ 0 };
+        run(bands, [&]() {
+            for (uint32_t band = next++; band < bands; band = next++)
+            {
+                for (uint32_t level = 1; level <= band_levels; level++)
+                {
+                    uint32_t first_row = (band * kBandRows) >> level;
+                    uint32_t end_row = std::min(mips[level].Height, ((band + 1) * kBandRows) >> level);
+                    if (first_row < end_row) downsample(level, first_row, end_row - first_row);
+                }
+            }
+        });
+
+        for (uint32_t level = band_levels + 1; level < levels; level++)
+        {
+            downsample(level, 0, mips[level].Height);
+        }
+
+        // Alpha tested textures thin out in the smaller levels as the average
+        // alpha drops below the cutoff. Every level gets the alpha scale that
+        // lets about as many pixels pass as at full size.
+        if (desc.fAlphaCutoff > 0.0f && levels > 1)
+        {
+            float cutoff = desc.fAlphaCutoff * 255.0f;
+            double coverage = (double)ispc::CountAlphaCoverage(data, (int64_t)mips[0].pitch, mips[0].Width,
+                                                               mips[0].Height, cutoff, 1.0f) /
+                              ((double)mips[0].Width * mips[0].Height);
+
+            next = 1;
+            run(coverage > 0.0 ? levels - 1 : 0, [&]() {
+                for (uint32_t level = next++; level < levels; level = next++)
+                {
+                    const Mipmap& mip = mips[level];
+                    uint8_t* pixels = data + mip.offset;
+                    double target = coverage * mip.Width * mip.Height;
+                    auto passing = [&](float scale) {
+                        return (double)ispc::CountAlphaCoverage(pixels, (int64_t)mip.pitch, mip.Width, mip.Height, cutoff, scale);
+                    };
+
+                    // more pixels pass the larger the scale
+                    float low = 0.0f, high = 255.0f;
+                    for (int step = 0; step < kCoverageSteps; step++)
+                    {
+                        float middle = (low + high) * 0.5f;
+                        if (passing(middle) < target)
+                            low = middle;
+                        else
+                            high = middle;
+                    }
+                    float scale = std::abs(passing(low) - target) < std::abs(passing(high) - target) ? low : high;
+                    ispc::ScaleAlpha(pixels, (int64_t)mip.pitch, mip.Width, mip.Height, scale);
+                }
+            });
+        }
+
+        image = std::move(rgba);
+        return true;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Image.h"
+
+namespace Corona
+{
+    enum class MIPMAP_FILTER : uint8_t
+    {
+        NONE,           // no mips
+        LINEAR,         // samples averaged as they are, e.g. roughness or occlusion
+        SRGB,           // colors in sRGB, averaged in linear space
+        NORMAL_MAP      // unit vectors in RGB, renormalized
+    };
+
+    // how the mip chain of a texture is made
+    struct MipmapDesc
+    {
+        MIPMAP_FILTER filter = MIPMAP_FILTER::NONE;
+        // above 0, the alpha of every level is scaled to pass an alpha test at
+        // this cutoff about as often as it does at full size (ALPHA_MODE_MASK)
+        float fAlphaCutoff = 0.0f;
+
+        // tells the images with different mips apart, empty without mips
+        std::string GetKey() const;
+    };
+
+    // levels of the full mip chain of a width x height image, down to 1x1
+    uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+    // Lays the levels of the mip chain out one after the other. The first one
+    // is the image as it is, at its pitch. Fills in image.mipmaps and returns
+    // the bytes all of them take.
+    size_t LayoutMipmaps(Image& image, uint32_t levels);
+
+    // Adds the full mip chain to the image, which is converted to RGBA8 if it
+    // is not. The rows are cut into bands of 64 that go down 6 levels each on
+    // their own, spread over threads (0 for one per hardware thread). The
+    // smaller levels follow on the calling thread. False for compressed
+    // images and formats without a conversion to RGBA8.
+    bool GenerateMipmaps(Image& image, const MipmapDesc& desc, uint32_t threads = 0);
+}
@@ -163,9 +163,9 @@ namespace Corona
         auto& scene = g_pSceneManager->GetSceneForPhysicalSimulation();
 
         // Geometries
-        for (auto _it : scene.GeometryNodes)
+        for (auto hGeometryNode : scene.GeometryNodes)
         {
-            auto pGeometryNode = _it.second.lock();
+            auto pGeometryNode = scene.GetNode(hGeometryNode);
             if (pGeometryNode)
             {
                 auto pGeometry = scene.GetGeometry(pGeometryNode->GetSceneObjectRef());
@@ -183,9 +183,9 @@ namespace Corona
         auto& scene = g_pSceneManager->GetSceneForPhysicalSimulation();
 
         // Geometries
-        for (auto _it : scene.GeometryNodes)
+        for (auto hGeometryNode : scene.GeometryNodes)
         {
-            auto pGeometryNode = _it.second.lock();
+            auto pGeometryNode = scene.GetNode(hGeometryNode);
             if (pGeometryNode)
                 DeleteRigidBody(*pGeometryNode);
         }
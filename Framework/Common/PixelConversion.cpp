@@ -0,0 +1,105 @@
+#include "PixelConversion.h"
+
+namespace Corona
+{
+    bool CanConvertToRGBA8(PIXEL_FORMAT format)
+    {
+        switch (format)
+        {
+            case PIXEL_FORMAT::R8:
+            case PIXEL_FORMAT::RG8:
+            case PIXEL_FORMAT::RGB8:
+            case PIXEL_FORMAT::RGBA8:
+            case PIXEL_FORMAT::R16:
+            case PIXEL_FORMAT::RG16:
+            case PIXEL_FORMAT::RGB16:
+            case PIXEL_FORMAT::RGBA16:
+            case PIXEL_FORMAT::R5G6B5:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool ConvertToRGBA8(PIXEL_FORMAT format, const uint8_t* src, ptrdiff_t srcPitch,
+                        uint8_t* dst, ptrdiff_t dstPitch, uint32_t width, uint32_t height)
+    {
+        switch (format)
+        {
+            case PIXEL_FORMAT::R8:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 1, 8, true, false);
+                return true;
+            case PIXEL_FORMAT::RG8:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 2, 8, false, false);
+                return true;
+            case PIXEL_FORMAT::RGB8:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 3, 8, false, false);
+                return true;
+            case PIXEL_FORMAT::RGBA8:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 4, 8, false, false);
+                return true;
+            case PIXEL_FORMAT::R16:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 1, 16, true, false);
+                return true;
+            case PIXEL_FORMAT::RG16:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 2, 16, false, false);
+                return true;
+            case PIXEL_FORMAT::RGB16:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 3, 16, false, false);
+                return true;
+            case PIXEL_FORMAT::RGBA16:
+                ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, 4, 16, false, false);
+                return true;
+            case PIXEL_FORMAT::R5G6B5:
+                ispc::R5G6B5ToRGBA8(src, srcPitch, dst, dstPitch, width, height);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void ExpandToRGBA8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                       uint32_t width, uint32_t height, uint32_t channels, uint32_t bitDepth,
+                       bool gray, bool bigEndian, uint8_t alpha)
+    {
+        if (bitDepth == 16)
+        {
+            ispc::Expand16ToRGBA8(src, srcPitch, dst, dstPitch, width, height, channels, gray, bigEndian, alpha);
+        }
+        else
+        {
+            ispc::ExpandToRGBA8(src, srcPitch, dst, dstPitch, width, height, channels, gray, alpha);
+        }
+    }
+
+    void ConvertBGRToRGBA8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                           uint32_t width, uint32_t height, uint32_t channels, uint8_t alpha)
+    {
+        ispc::SwizzleToRGBA8(src, srcPitch, dst, dstPitch, width, height, channels, alpha);
+    }
+
+    void ConvertRGBA8ToBGRA8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                             uint32_t width, uint32_t height)
+    {
+        // swapping red and blue is its own inverse
+        ispc::SwizzleToRGBA8(src, srcPitch, dst, dstPitch, width, height, 4, 0xFF);
+    }
+
+    void ConvertRGBA8ToRGB8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                            uint32_t width, uint32_t height)
+    {
+        ispc::RGBA8ToRGB8(src, srcPitch, dst, dstPitch, width, height);
+    }
+
+    void ConvertSrgbToLinear(const uint8_t* src, ptrdiff_t srcPitch, float* dst, ptrdiff_t dstPitch,
+                             uint32_t width, uint32_t height, uint32_t channels)
+    {
+        ispc::SrgbToLinear(src, srcPitch, dst, dstPitch, width, height, channels);
+    }
+
+    void ConvertLinearToSrgb(const float* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                             uint32_t width, uint32_t height, uint32_t channels)
+    {
+        ispc::LinearToSrgb(src, srcPitch, dst, dstPitch, width, height, channels);
+    }
+}
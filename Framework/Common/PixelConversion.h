@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Image.h"
+
+namespace Corona
+{
+    // Pixel format conversions of whole blocks of rows, run by the ISPC
+    // kernels of GeomMath. Pitches are in bytes, a negative source pitch
+    // reads the rows bottom up. Source and destination must not overlap.
+
+    // false for the formats there is no conversion of, like float or
+    // compressed ones. One channel is gray, RG8 and RG16 get a blue of 0.
+    // 16 bit samples are little endian and keep their high byte.
+    bool ConvertToRGBA8(PIXEL_FORMAT format, const uint8_t* src, ptrdiff_t srcPitch,
+                        uint8_t* dst, ptrdiff_t dstPitch, uint32_t width, uint32_t height);
+    bool CanConvertToRGBA8(PIXEL_FORMAT format);
+
+    // 8 or 16 bit samples of 1 to 4 channels. With gray set, one channel is
+    // gray and two are gray and alpha. A missing alpha is alpha.
+    void ExpandToRGBA8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                       uint32_t width, uint32_t height, uint32_t channels, uint32_t bitDepth,
+                       bool gray, bool bigEndian, uint8_t alpha = 0xFF);
+
+    // BGR8 (3 channels) or BGRA8 (4 channels) to RGBA8, and back
+    void ConvertBGRToRGBA8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                           uint32_t width, uint32_t height, uint32_t channels, uint8_t alpha = 0xFF);
+    void ConvertRGBA8ToBGRA8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                             uint32_t width, uint32_t height);
+
+    void ConvertRGBA8ToRGB8(const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                            uint32_t width, uint32_t height);
+
+    // 8 bit sRGB samples to linear floats and back. With 4 channels the
+    // last one is alpha, which is linear already.
+    void ConvertSrgbToLinear(const uint8_t* src, ptrdiff_t srcPitch, float* dst, ptrdiff_t dstPitch,
+                             uint32_t width, uint32_t height, uint32_t channels);
+    void ConvertLinearToSrgb(const float* src, ptrdiff_t srcPitch, uint8_t* dst, ptrdiff_t dstPitch,
+                             uint32_t width, uint32_t height, uint32_t channels);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MemoryManager.h"
+
+namespace Corona
+{
+    // STL allocator adapter that takes the memory from the MemoryManager, so small
+    // container nodes come from its size-class pools instead of malloc. The tag is
+    // part of the type, the allocator is stateless and all instances are equal.
+    // Containers using it must go away before MemoryManager::Finalize().
+    template<typename T, MemoryTag Tag = MemoryTag::General>
+    class PoolAllocator
+    {
+    public:
+        typedef T value_type;
+
+        template<typename U>
+        struct rebind
+        {
+            typedef PoolAllocator<U, Tag> other;
+        };
+
+        PoolAllocator() noexcept {}
+
+        template<typename U>
+        PoolAllocator(const PoolAllocator<U, Tag>&) noexcept {}
+
+        // throws std::bad_alloc like std::allocator, the containers do not check the result
+        T* allocate(size_t n)
+        {
+            if (n > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+
+            void* p = g_pMemoryManager->AllocateAligned(n * sizeof(T), alignof(T), Tag);
+            if (!p && n) throw std::bad_alloc();
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, size_t n) noexcept
+        {
+            g_pMemoryManager->FreeAligned(p, n * sizeof(T), alignof(T), Tag);
+        }
+
+        template<typename U>
+        bool operator==(const PoolAllocator<U, Tag>&) const noexcept { return true; }
+
+        template<typename U>
+        bool operator!=(const PoolAllocator<U, Tag>&) const noexcept { return false; }
+    };
+
+    // containers allocating through PoolAllocator
+    namespace pooled
+    {
+        template<typename T, MemoryTag Tag = MemoryTag::General>
+        using vector = std::vector<T, PoolAllocator<T, Tag>>;
+
+        template<typename T, MemoryTag Tag = MemoryTag::General>
+        using list = std::list<T, PoolAllocator<T, Tag>>;
+
+        template<typename Key, typename Value, MemoryTag Tag = MemoryTag::General,
+                 typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+        using unordered_map = std::unordered_map<Key, Value, Hash, KeyEqual, PoolAllocator<std::pair<const Key, Value>, Tag>>;
+
+        template<MemoryTag Tag = MemoryTag::General>
+        using basic_string = std::basic_string<char, std::char_traits<char>, PoolAllocator<char, Tag>>;
+
+        typedef basic_string<> string;
+    }
+}
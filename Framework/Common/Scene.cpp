@@ -53,25 +53,25 @@ namespace Corona
         return (Materials.empty()? nullptr : Materials.cbegin()->second);
     }
 
-    const shared_ptr<SceneNode> Scene::GetFirstGeometryNode() const
+    SceneNode* Scene::GetFirstGeometryNode() const
     {
         return (GeometryNodes.empty()? 
                 nullptr 
-                : GeometryNodes.cbegin()->second.lock());
+                : NodePool.Get(GeometryNodes.front()));
     }
 
-    const shared_ptr<SceneNode> Scene::GetFirstLightNode() const
+    SceneNode* Scene::GetFirstLightNode() const
     {
         return (LightNodes.empty()? 
                 nullptr 
-                : LightNodes.cbegin()->second.lock());
+                : NodePool.Get(LightNodes.front()));
     }
 
-    const shared_ptr<SceneCameraNode> Scene::GetFirstCameraNode() const
+    SceneCameraNode* Scene::GetFirstCameraNode() const
     {
         return (CameraNodes.empty()? 
                 nullptr 
-                : CameraNodes.cbegin()->second.lock());
+                : CameraNodePool.Get(CameraNodes.front()));
     }
 
 //     void Scene::LoadResource()
@@ -2,6 +2,8 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include "HandlePool.h"
+#include "PoolAllocator.h"
 #include "SceneNode.h"
 
 namespace Corona
@@ -12,24 +14,35 @@ namespace Corona
         std::shared_ptr<SceneObjectMaterial> m_pDefaultMaterial;
     public:
         std::string name;
-        std::vector<std::weak_ptr<SceneNode>> RootNodes;
-        std::unordered_map<std::string, std::shared_ptr<SceneNode>> LUT_Name_LinearNodes;
+
+        // the scene owns its nodes through these pools, everything else refers to
+        // them by handle (or by plain pointer, pool objects never move)
+        HandlePool<SceneNode> NodePool;
+        HandlePool<SceneCameraNode> CameraNodePool;
+
+        pooled::vector<SceneNode*, MemoryTag::Scene> RootNodes;
+        pooled::unordered_map<std::string, Handle<SceneNode>, MemoryTag::Scene> LUT_Name_LinearNodes;
 
         // the strings here are hash values formed by crossguid
-        std::unordered_map<std::string, std::shared_ptr<SceneObjectCamera>> Cameras;
-        std::unordered_map<std::string, std::shared_ptr<SceneObjectLight>> Lights;
-        std::unordered_map<std::string, std::shared_ptr<SceneObjectMaterial>> Materials;
-        std::unordered_map<std::string, std::shared_ptr<SceneObjectMesh>> Geometries;
+        pooled::unordered_map<std::string, std::shared_ptr<SceneObjectCamera>, MemoryTag::Scene> Cameras;
+        pooled::unordered_map<std::string, std::shared_ptr<SceneObjectLight>, MemoryTag::Scene> Lights;
+        pooled::unordered_map<std::string, std::shared_ptr<SceneObjectMaterial>, MemoryTag::Scene> Materials;
+        pooled::unordered_map<std::string, std::shared_ptr<SceneObjectMesh>, MemoryTag::Scene> Geometries;
 
         // For binding meshes and materials
-        std::vector<std::weak_ptr<SceneObjectMaterial>> LinearMaterials;
-        // For binding nodes and lightObjects
-        std::vector<std::weak_ptr<SceneObjectLight>> LinearLights;
-
-        // TODO: why weak_ptr here ?
-        std::unordered_map<std::string, std::weak_ptr<SceneCameraNode>> CameraNodes;
-        std::unordered_map<std::string, std::weak_ptr<SceneNode>> LightNodes;
-        std::unordered_map<std::string, std::weak_ptr<SceneNode>> GeometryNodes;
+        pooled::vector<std::weak_ptr<SceneObjectMaterial>, MemoryTag::Scene> LinearMaterials;
+        // For binding nodes and lightObjects, owned by Lights
+        pooled::vector<SceneObjectLight*, MemoryTag::Scene> LinearLights;
+
+        // dense lists in load order, iterated every frame
+        pooled::vector<Handle<SceneCameraNode>, MemoryTag::Scene> CameraNodes;
+        pooled::vector<Handle<SceneNode>, MemoryTag::Scene> LightNodes;
+        pooled::vector<Handle<SceneNode>, MemoryTag::Scene> GeometryNodes;
+
+        // asset files the objects were read from, the scene manager watches them
+        // to reload only the objects of a file that changed
+        pooled::unordered_map<std::string, std::vector<std::weak_ptr<SceneObjectTexture>>, MemoryTag::Scene> TextureSources;
+        pooled::unordered_map<std::string, std::vector<std::string>, MemoryTag::Scene> MeshSources;     // keys of Geometries
         // std::unordered_map<std::string, std::weak_ptr<SceneBoneNode>>               BoneNodes;
 
         // std::vector<std::weak_ptr<BaseSceneNode>> AnimatableNodes;
@@ -43,13 +56,17 @@ namespace Corona
         ~Scene() = default;
 
         const std::shared_ptr<SceneObjectCamera> GetCamera(const std::string &key) const;
-        const std::shared_ptr<SceneCameraNode> GetFirstCameraNode() const;
+        SceneCameraNode* GetFirstCameraNode() const;
 
         const std::shared_ptr<SceneObjectLight> GetLight(const std::string &key) const;
-        const std::shared_ptr<SceneNode> GetFirstLightNode() const;
+        SceneNode* GetFirstLightNode() const;
 
         const std::shared_ptr<SceneObjectMesh> GetGeometry(const std::string &key) const;
-        const std::shared_ptr<SceneNode> GetFirstGeometryNode() const;
+        SceneNode* GetFirstGeometryNode() const;
+
+        // nullptr once the node is gone
+        SceneNode* GetNode(Handle<SceneNode> handle) const { return NodePool.Get(handle); }
+        SceneCameraNode* GetCameraNode(Handle<SceneCameraNode> handle) const { return CameraNodePool.Get(handle); }
 
         const std::shared_ptr<SceneObjectMaterial> GetMaterial(const std::string &key) const;
         const std::shared_ptr<SceneObjectMaterial> GetFirstMaterial() const;
@@ -1,6 +1,8 @@
 #include "SceneManager.h"
+#include <iostream>
 #include "AssetLoader.h"
 #include "GLTF.h"
+#include "ImageCache.h"
 
 namespace Corona
 {
@@ -19,6 +21,10 @@ namespace Corona
 
     void SceneManager::Finalize()
     {
+        UnwatchSceneFiles();
+        m_ChangedObjects.clear();
+        // the node pools give their pages back to the memory manager
+        m_pScene = nullptr;
     }
 
     void SceneManager::Tick()
@@ -39,6 +45,9 @@ namespace Corona
             m_bDirtyFlag = true;
             m_bRenderingQueued = false;
             m_bPhysicalSimulationQueued = false;
+            // everything is rebuilt anyway
+            m_ChangedObjects.clear();
+            WatchSceneFiles();
             return 0;
         }
         return 0;
@@ -51,18 +60,114 @@ namespace Corona
 
     bool SceneManager::LoadGltfScene(std::string gltf_scene_file_name)
     {
-        m_pScene->name = gltf_scene_file_name;
+        // what the last load of the scene read is on its way before parsing starts
+        std::vector<LoadTraceEntry> manifest;
+        if (g_pAssetLoader->ReadLoadManifest(gltf_scene_file_name.c_str(), manifest))
+            g_pAssetLoader->Prefetch(manifest);
 
+        g_pAssetLoader->BeginLoadTrace();
         GltfParser gltf_parser;
-        m_pScene = gltf_parser.Parse(gltf_scene_file_name);
+        std::shared_ptr<Scene> pScene = gltf_parser.Parse(gltf_scene_file_name);
+        std::vector<LoadTraceEntry> trace = g_pAssetLoader->EndLoadTrace();
 
-        if (!m_pScene) {
+        // a scene file saved halfway by an editor, the old scene and its watches stay
+        if (!pScene) {
+            std::cerr << "[SceneManager] cannot load " << gltf_scene_file_name.c_str() << ", the scene stays as it is" << std::endl;
             return false;
         }
 
+        m_pScene = pScene;
+
+        if (trace != manifest)
+            g_pAssetLoader->WriteLoadManifest(gltf_scene_file_name.c_str(), trace);
+
         return true;
     }
 
+    void SceneManager::WatchSceneFiles()
+    {
+        UnwatchSceneFiles();
+
+        auto watch = [this](const std::string& file, AssetLoader::FileChangedCallback callback) {
+            uint32_t id = g_pAssetLoader->WatchFile(file.c_str(), std::move(callback));
+            if (id) m_FileWatches.push_back(id);
+        };
+
+        // the scene file may change anything, it is loaded again as a whole
+        watch(m_pScene->name, [this](const std::string& file) { LoadScene(file); });
+
+        for (auto& source : m_pScene->TextureSources)
+        {
+            watch(source.first, [this](const std::string& file) { ReloadTexture(file); });
+        }
+
+        for (auto& source : m_pScene->MeshSources)
+        {
+            watch(source.first, [this](const std::string& file) { ReloadMeshes(file); });
+        }
+    }
+
+    void SceneManager::UnwatchSceneFiles()
+    {
+        for (uint32_t id : m_FileWatches)
+        {
+            g_pAssetLoader->UnwatchFile(id);
+        }
+        m_FileWatches.clear();
+    }
+
+    void SceneManager::ReloadTexture(const std::string& file)
+    {
+        auto it = m_pScene->TextureSources.find(file);
+        if (it == m_pScene->TextureSources.end()) return;
+
+        for (auto& wpTexture : it->second)
+        {
+            if (auto pTexture = wpTexture.lock())
+            {
+                // decoded again, the cache knows the file by its modification
+                // time. Textures with the same mips share the image.
+                std::shared_ptr<Image> pImage = g_pImageCache->GetImage(file.c_str(), pTexture->GetMipmaps());
+                if (!pImage)
+                {
+                    std::cerr << "[SceneManager] cannot decode " << file << ", the texture stays as it is" << std::endl;
+                    return;
+                }
+
+                pTexture->SetTextureImage(pImage);
+                m_ChangedObjects.push_back(pTexture);
+            }
+        }
+    }
+
+    void SceneManager::ReloadMeshes(const std::string& file)
+    {
+        auto it = m_pScene->MeshSources.find(file);
+        if (it == m_pScene->MeshSources.end()) return;
+
+        // the vertices are converted from the whole glTF again, its images come
+        // out of the image cache. Only the meshes reading the file are replaced.
+        GltfParser gltf_parser;
+        std::shared_ptr<Scene> pReloaded = gltf_parser.Parse(m_pScene->name);
+        if (!pReloaded) return;
+
+        for (auto& name : it->second)
+        {
+            auto pMesh = m_pScene->GetGeometry(name);
+            auto pReloadedMesh = pReloaded->GetGeometry(name);
+            if (pMesh && pReloadedMesh)
+            {
+                pMesh->SetMesh(pReloadedMesh->GetMesh());
+                m_ChangedObjects.push_back(pMesh);
+            }
+        }
+    }
+
+    void SceneManager::NotifySceneObjectChangesQueued()
+    {
+        m_ChangedObjects.clear();
+    }
+
     Scene& SceneManager::GetSceneForRendering()
     {
         // TODO: we should perform CPU scene crop at here
@@ -1,4 +1,6 @@
 #pragma once
+#include <memory>
+#include <vector>
 #include "geommath.h"
 #include "IRuntimeModule.h"
 #include "SceneParser.h"
@@ -27,6 +29,12 @@ namespace Corona
 
         void ResetScene();
 
+        // Textures and meshes reloaded since the renderer last picked them up,
+        // after their files changed on disk. A change of the scene file itself
+        // loads the whole scene again, see IsSceneChanged().
+        const std::vector<std::shared_ptr<BaseSceneObject>>& GetChangedSceneObjects() const { return m_ChangedObjects; }
+        void NotifySceneObjectChangesQueued();
+
         // std::weak_ptr<BaseSceneNode> GetRootNode();
         // std::weak_ptr<SceneGeometryNode> GetSceneNode(std::string name);
         // std::weak_ptr<SceneObjectMesh> GetSceneGeometryObject(std::string key);
@@ -34,12 +42,21 @@ namespace Corona
     protected:
         bool LoadGltfScene(std::string gltf_scene_file_name);
 
+        // hot reload of the files the scene was built from
+        void WatchSceneFiles();
+        void UnwatchSceneFiles();
+        void ReloadTexture(const std::string& file);
+        void ReloadMeshes(const std::string& file);
+
     protected:
         std::shared_ptr<Scene> m_pScene;
         bool m_bRenderingQueued = false;
         bool m_bPhysicalSimulationQueued = false;
         bool m_bAnimationQueued = false;
         bool m_bDirtyFlag = false;
+
+        std::vector<uint32_t> m_FileWatches;
+        std::vector<std::shared_ptr<BaseSceneObject>> m_ChangedObjects;
     };
 
     extern SceneManager* g_pSceneManager;
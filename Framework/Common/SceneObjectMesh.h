@@ -29,6 +29,7 @@ namespace Corona
         uint32_t GetMaterial() { return m_MaterialId; };
         // TODO
         std::vector<std::shared_ptr<SceneObjectPrimitive>> GetMesh() { return m_Primitive; }
+        void SetMesh(std::vector<std::shared_ptr<SceneObjectPrimitive>>&& primitives) { m_Primitive = std::move(primitives); }
         // const std::weak_ptr<SceneObjectPrimitive> GetMeshLOD(size_t lod) { return (lod < m_Primitive.size()? m_Primitive[lod] : nullptr); }
         // BoundingBox GetBoundingBox() const { return m_Primitive.empty()? BoundingBox() : m_Primitive[0]->GetBoundingBox(); }
         // ConvexHull GetConvexHull() const { return m_Primitive.empty()? ConvexHull() : m_Primitive[0]->GetConvexHull(); }
@@ -5,6 +5,7 @@
 #include "PNG.h"
 #include "BMP.h"
 #include "AssetLoader.h"
+#include "Mipmaps.h"
 
 namespace Corona
 {
@@ -14,6 +15,8 @@ namespace Corona
         // m_Name here is the path of image (like "Scene/DamagedHelmet/DamagedHelmet_albedo.jpg")
         std::string m_Name;
         std::shared_ptr<Image> m_pImage;
+        // how the mips of the image are made, e.g. when it is decoded again
+        MipmapDesc m_Mipmaps;
 
     public:
         SceneObjectTexture() : BaseSceneObject(SceneObjectType::kSceneObjectTypeTexture) {};
@@ -30,6 +33,10 @@ namespace Corona
         {
             return *m_pImage; 
         };
+        void SetTextureImage(const std::shared_ptr<Image>& image) { m_pImage = image; };
+
+        const MipmapDesc& GetMipmaps() const { return m_Mipmaps; };
+        void SetMipmaps(const MipmapDesc& mips) { m_Mipmaps = mips; };
 
         friend std::ostream& operator<<(std::ostream& out, const SceneObjectTexture& obj);
     };
@@ -1,13 +1,14 @@
 #pragma once
 #include <iostream>
 #include <list>
+#include "PoolAllocator.h"
 
 namespace Corona {
     class TreeNode
     {
     protected:
         TreeNode* m_Parent;
-        std::list<std::shared_ptr<TreeNode>> m_Children;
+        pooled::list<std::shared_ptr<TreeNode>, MemoryTag::Scene> m_Children;
 
     protected:
         virtual void dump(std::ostream& out) const {};
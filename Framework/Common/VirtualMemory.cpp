@@ -0,0 +1,143 @@
+#include "VirtualMemory.h"
+#include <cassert>
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Corona
+{
+#if defined(_WIN32)
+    size_t GetVirtualPageSize()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+    }
+
+    void* AllocateVirtualMemory(size_t size, size_t alignment, bool)
+    {
+        // regions start at the 64KB allocation granularity, large pages would
+        // need the lock memory privilege so the hint is ignored
+        assert(alignment <= 64 * 1024);
+        (void)alignment;
+
+        return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+    void FreeVirtualMemory(void* p, size_t)
+    {
+        if (p) VirtualFree(p, 0, MEM_RELEASE);
+    }
+
+    void* ReserveVirtualMemory(size_t size, size_t alignment)
+    {
+        assert(alignment <= 64 * 1024);
+        (void)alignment;
+
+        return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+    }
+
+    bool CommitVirtualMemory(void* p, size_t size)
+    {
+        return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+    }
+
+    void DecommitVirtualMemory(void* p, size_t size)
+    {
+        VirtualFree(p, size, MEM_DECOMMIT);
+    }
+
+    void ReleaseVirtualMemory(void* p, size_t)
+    {
+        if (p) VirtualFree(p, 0, MEM_RELEASE);
+    }
+#else
+    size_t GetVirtualPageSize()
+    {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return page_size;
+    }
+
+    static void* MapAligned(size_t size, size_t alignment)
+    {
+        size_t page_size = GetVirtualPageSize();
+
+        if (alignment <= page_size)
+        {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            return (p == MAP_FAILED) ? nullptr : p;
+        }
+
+        // over-map and cut off the unaligned head and the tail
+        size_t mapped_size = size + alignment - page_size;
+        void* p = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+
+        uintptr_t base = reinterpret_cast<uintptr_t>(p);
+        uintptr_t aligned = (base + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t head = aligned - base;
+        size_t tail = mapped_size - head - size;
+
+        if (head) munmap(p, head);
+        if (tail) munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void* AllocateVirtualMemory(size_t size, size_t alignment, bool huge_pages)
+    {
+        size_t page_size = GetVirtualPageSize();
+        size = (size + page_size - 1) & ~(page_size - 1);
+
+#if defined(MADV_HUGEPAGE)
+        // huge pages only back 2MB aligned ranges
+        static const size_t huge_page_size = 2 * 1024 * 1024;
+        if (huge_pages && alignment < huge_page_size) alignment = huge_page_size;
+
+        void* p = MapAligned(size, alignment);
+        if (p && huge_pages) madvise(p, size, MADV_HUGEPAGE);
+#else
+        void* p = MapAligned(size, alignment);
+        (void)huge_pages;
+#endif
+
+        return p;
+    }
+
+    void FreeVirtualMemory(void* p, size_t size)
+    {
+        if (!p) return;
+
+        size_t page_size = GetVirtualPageSize();
+        munmap(p, (size + page_size - 1) & ~(page_size - 1));
+    }
+
+    void* ReserveVirtualMemory(size_t size, size_t alignment)
+    {
+        // anonymous memory is only backed once it is touched, so the
+        // reservation is mapped read-write and committing costs nothing
+        size_t page_size = GetVirtualPageSize();
+        return MapAligned((size + page_size - 1) & ~(page_size - 1), alignment);
+    }
+
+    bool CommitVirtualMemory(void*, size_t)
+    {
+        return true;
+    }
+
+    void DecommitVirtualMemory(void* p, size_t size)
+    {
+        madvise(p, size, MADV_DONTNEED);
+    }
+
+    void ReleaseVirtualMemory(void* p, size_t size)
+    {
+        FreeVirtualMemory(p, size);
+    }
+#endif
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+namespace Corona
+{
+    // Memory mapped straight from the OS (VirtualAlloc / mmap), so releasing it
+    // really returns it to the OS instead of leaving it in the CRT heap.
+    // alignment must be a power of two, at most 64KB on Windows.
+    // huge_pages asks for transparent huge pages where the OS supports the hint.
+    void* AllocateVirtualMemory(size_t size, size_t alignment, bool huge_pages = false);
+    void FreeVirtualMemory(void* p, size_t size);
+
+    // Address space for pools that hand out parts of it. The parts are backed
+    // by CommitVirtualMemory() and given back to the OS by DecommitVirtualMemory()
+    // (MEM_DECOMMIT / MADV_DONTNEED) while the range stays reserved.
+    // Same alignment limits as AllocateVirtualMemory().
+    void* ReserveVirtualMemory(size_t size, size_t alignment);
+    // false when the OS is out of memory
+    bool CommitVirtualMemory(void* p, size_t size);
+    void DecommitVirtualMemory(void* p, size_t size);
+    void ReleaseVirtualMemory(void* p, size_t size);
+
+    // granularity of the OS page
+    size_t GetVirtualPageSize();
+}
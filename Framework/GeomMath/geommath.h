@@ -15,6 +15,8 @@
 #include "include/SubByElement.h"
 #include "include/InverseMatrix4X4f.h"
 #include "include/DCT.h"
+#include "include/PixelFormat.h"
+#include "include/Mipmap.h"
 
 #ifndef PI
 #define PI 3.14159265358979323846f
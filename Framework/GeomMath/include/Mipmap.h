@@ -0,0 +1,45 @@
+//
+// F:/work_space/Corona/Framework/GeomMath/include/Mipmap.h
+// (Header automatically generated by the ispc compiler.)
+// DO NOT EDIT THIS FILE.
+//
+
+#pragma once
+#include <stdint.h>
+
+
+
+#ifdef __cplusplus
+namespace ispc { /* namespace */
+#endif // __cplusplus
+
+#ifndef __ISPC_ALIGN__
+#if defined(__clang__) || !defined(_MSC_VER)
+// Clang, GCC, ICC
+#define __ISPC_ALIGN__(s) __attribute__((aligned(s)))
+#define __ISPC_ALIGNED_STRUCT__(s) struct __ISPC_ALIGN__(s)
+#else
+// Visual Studio
+#define __ISPC_ALIGN__(s) __declspec(align(s))
+#define __ISPC_ALIGNED_STRUCT__(s) __ISPC_ALIGN__(s) struct
+#endif
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////
+// Functions exported from ispc code
+///////////////////////////////////////////////////////////////////////////
+#if defined(__cplusplus) && (! defined(__ISPC_NO_EXTERN_C) || !__ISPC_NO_EXTERN_C )
+extern "C" {
+#endif // __cplusplus
+    extern int64_t CountAlphaCoverage(const uint8_t * src, const int64_t src_pitch, const int32_t width, const int32_t height, const float cutoff, const float scale);
+    extern void DownsampleRGBA8(const uint8_t * src, const int64_t src_pitch, const int32_t src_width, const int32_t src_height, uint8_t * dst, const int64_t dst_pitch, const int32_t dst_width, const int32_t first_row, const int32_t row_count, const int32_t filter);
+    extern void ScaleAlpha(uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height, const float scale);
+#if defined(__cplusplus) && (! defined(__ISPC_NO_EXTERN_C) || !__ISPC_NO_EXTERN_C )
+} /* end extern C */
+#endif // __cplusplus
+
+
+#ifdef __cplusplus
+} /* namespace */
+#endif // __cplusplus
@@ -0,0 +1,49 @@
+//
+// F:/work_space/Corona/Framework/GeomMath/include/PixelFormat.h
+// (Header automatically generated by the ispc compiler.)
+// DO NOT EDIT THIS FILE.
+//
+
+#pragma once
+#include <stdint.h>
+
+
+
+#ifdef __cplusplus
+namespace ispc { /* namespace */
+#endif // __cplusplus
+
+#ifndef __ISPC_ALIGN__
+#if defined(__clang__) || !defined(_MSC_VER)
+// Clang, GCC, ICC
+#define __ISPC_ALIGN__(s) __attribute__((aligned(s)))
+#define __ISPC_ALIGNED_STRUCT__(s) struct __ISPC_ALIGN__(s)
+#else
+// Visual Studio
+#define __ISPC_ALIGN__(s) __declspec(align(s))
+#define __ISPC_ALIGNED_STRUCT__(s) __ISPC_ALIGN__(s) struct
+#endif
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////
+// Functions exported from ispc code
+///////////////////////////////////////////////////////////////////////////
+#if defined(__cplusplus) && (! defined(__ISPC_NO_EXTERN_C) || !__ISPC_NO_EXTERN_C )
+extern "C" {
+#endif // __cplusplus
+    extern void Expand16ToRGBA8(const uint8_t * src, const int64_t src_pitch, uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height, const int32_t channels, const bool gray, const bool big_endian, const uint8_t alpha);
+    extern void ExpandToRGBA8(const uint8_t * src, const int64_t src_pitch, uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height, const int32_t channels, const bool gray, const uint8_t alpha);
+    extern void LinearToSrgb(const float * src, const int64_t src_pitch, uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height, const int32_t channels);
+    extern void R5G6B5ToRGBA8(const uint8_t * src, const int64_t src_pitch, uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height);
+    extern void RGBA8ToRGB8(const uint8_t * src, const int64_t src_pitch, uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height);
+    extern void SrgbToLinear(const uint8_t * src, const int64_t src_pitch, float * dst, const int64_t dst_pitch, const int32_t width, const int32_t height, const int32_t channels);
+    extern void SwizzleToRGBA8(const uint8_t * src, const int64_t src_pitch, uint8_t * dst, const int64_t dst_pitch, const int32_t width, const int32_t height, const int32_t channels, const uint8_t alpha);
+#if defined(__cplusplus) && (! defined(__ISPC_NO_EXTERN_C) || !__ISPC_NO_EXTERN_C )
+} /* end extern C */
+#endif // __cplusplus
+
+
+#ifdef __cplusplus
+} /* namespace */
+#endif // __cplusplus
@@ -1,7 +1,7 @@
 #pragma once
 #include "Interface.h"
 #include "Image.h"
-#include "Buffer.h"
+#include "BufferView.h"
 
 namespace Corona
 {
@@ -9,6 +9,6 @@ namespace Corona
     {
     public:
         virtual ~ImageParser() = default;
-        virtual Image Parse(Buffer & buf) = 0;
+        virtual Image Parse(const BufferView& buf) = 0;
     };
 }
\ No newline at end of file
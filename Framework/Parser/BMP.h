@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include "ImageParser.h"
+#include "PixelConversion.h"
 
 namespace Corona {
 #pragma pack(push, 1)
@@ -31,7 +32,7 @@ typedef struct _BITMAP_HEADER {
 
 class BmpParser : implements ImageParser {
    public:
-    Image Parse(Buffer& buf) override {
+    Image Parse(const BufferView& buf) override {
         Image img;
         const auto* pFileHeader =
             reinterpret_cast<const BITMAP_FILEHEADER*>(buf.GetData());
@@ -54,43 +55,43 @@ class BmpParser : implements ImageParser {
                       << std::endl;
             std::cerr << "Image Size: " << pBmpHeader->SizeImage << std::endl;
 
+            // rows are stored bottom up unless the height is negative
+            bool bottom_up = pBmpHeader->Height > 0;
             img.Width = pBmpHeader->Width;
-            img.Height = pBmpHeader->Height;
+            img.Height = bottom_up ? pBmpHeader->Height : -pBmpHeader->Height;
             img.bitcount = 32;
             img.bitdepth = 8;
             img.pixel_format = PIXEL_FORMAT::RGBA8;
             auto byte_count = img.bitcount >> 3;
             img.pitch = ((img.Width * byte_count) + 3) & ~3;
             img.data_size = (size_t)img.pitch * img.Height;
-            // img.data = new uint8_t[img.data_size];
 
-            if (img.bitcount < 24) {
+            uint32_t source_channels = pBmpHeader->BitCount >> 3;
+            size_t source_pitch = (((size_t)img.Width * pBmpHeader->BitCount >> 3) + 3) & ~(size_t)3;
+            if (pBmpHeader->BitCount < 24) {
                 std::cerr << "Sorry, only true color BMP is supported at now."
                           << std::endl;
+                img.data_size = 0;
+            } else if (pFileHeader->BitsOffset + source_pitch * img.Height > buf.GetDataSize()) {
+                std::cerr << "BMP pixel data is truncated." << std::endl;
+                img.data_size = 0;
             } else {
                 const uint8_t* pSourceData =
                     reinterpret_cast<const uint8_t*>(buf.GetData()) +
                     pFileHeader->BitsOffset;
-                for (int32_t y = img.Height - 1; y >= 0; y--) {
-                    for (uint32_t x = 0; x < img.Width; x++) {
-                        auto dst = reinterpret_cast<R8G8B8A8Unorm*>(
-                            (img.data) +
-                            (ptrdiff_t)img.pitch *
-                                ((ptrdiff_t)img.Height - y - 1) +
-                            (ptrdiff_t)x * byte_count);
-                        auto src = reinterpret_cast<const R8G8B8A8Unorm*>(
-                            pSourceData + (ptrdiff_t)img.pitch * y +
-                            (ptrdiff_t)x * byte_count);
-                        dst->data[2] = src->data[0];
-                        dst->data[1] = src->data[1];
-                        dst->data[0] = src->data[2];
-                        dst->data[3] = src->data[3];
-                    }
+                if (bottom_up) {
+                    pSourceData += source_pitch * (img.Height - 1);
                 }
+
+                // BGR(A) to RGBA, all rows in one go
+                img.data = new uint8_t[img.data_size];
+                ConvertBGRToRGBA8(pSourceData,
+                                  bottom_up ? -(ptrdiff_t)source_pitch : (ptrdiff_t)source_pitch,
+                                  img.data, (ptrdiff_t)img.pitch, img.Width,
+                                  img.Height, source_channels);
             }
         }
 
-
         return img;
     }
 };
@@ -1,5 +1,13 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include "BufferView.h"
+#include "ImageCache.h"
+#include "PoolAllocator.h"
 #include "SceneNode.h"
 #include "tinyglTF/tiny_gltf.h"
 #include "SceneParser.h"
@@ -56,13 +64,147 @@ namespace Corona
             bool IsInitialized() const { return VertexBasicDataOffset != ~size_t(0); }
         };
 
-        using ConvertedBufferViewMap = std::unordered_map<ConvertedBufferViewKey, ConvertedBufferViewData, ConvertedBufferViewKey::Hasher>;
+        using ConvertedBufferViewMap = pooled::unordered_map<ConvertedBufferViewKey, ConvertedBufferViewData, MemoryTag::Transient, ConvertedBufferViewKey::Hasher>;
+
+        // vertices and indices of all primitives, accumulated while loading
+        using VertexDataArray = pooled::vector<VertexBasicAttribs, MemoryTag::Mesh>;
+        using IndexDataArray = pooled::vector<uint32_t, MemoryTag::Mesh>;
+
+        // the glTF buffers of the scene being parsed, vertex data and embedded images are read through them
+        std::vector<BufferView> m_Buffers;
+        // asset files of the glTF buffers, empty for embedded ones
+        std::vector<std::string> m_BufferFiles;
+
+        // Converted vertices and indices of every primitive in the order LoadNode()
+        // meets them, kept in the build cache under the glTF file and its buffers.
+        // Bump the version whenever the conversion changes.
+        static const uint32_t kMeshCookVersion = 1;
+
+        struct CookedMeshesHeader
+        {
+            uint32_t nPrimitiveCount;
+            uint32_t nVertexSize;
+        };
+
+        struct CookedPrimitive
+        {
+            const uint8_t *pVertices;
+            uint32_t nVertexCount;
+            const uint8_t *pIndices;
+            uint32_t nIndexCount;
+        };
+
+        // read out of the cache, LoadNode() takes them one by one instead of converting
+        BufferView m_CookedMeshes;
+        std::vector<CookedPrimitive> m_CookedPrimitives;
+        size_t m_nNextCookedPrimitive = 0;
+        // converted by this load, stored when the load is done
+        bool m_bCooking = false;
+        std::vector<uint8_t> m_CookingMeshes;
+        uint32_t m_nCookingPrimitives = 0;
+
+        bool ReadCookedMeshes(const BufferView &cooked)
+        {
+            CookedMeshesHeader header;
+            if (cooked.GetDataSize() < sizeof(header)) return false;
+            memcpy(&header, cooked.GetData(), sizeof(header));
+            if (header.nVertexSize != sizeof(VertexBasicAttribs)) return false;
+
+            const uint8_t *p = cooked.GetData() + sizeof(header);
+            const uint8_t *end = cooked.GetData() + cooked.GetDataSize();
+            std::vector<CookedPrimitive> primitives(header.nPrimitiveCount);
+            for (auto &primitive : primitives)
+            {
+                uint32_t counts[2];
+                if (size_t(end - p) < sizeof(counts)) return false;
+                memcpy(counts, p, sizeof(counts));
+                p += sizeof(counts);
+
+                size_t vertex_bytes = size_t(counts[0]) * sizeof(VertexBasicAttribs);
+                size_t index_bytes = size_t(counts[1]) * sizeof(uint32_t);
+                if (size_t(end - p) < vertex_bytes || size_t(end - p) - vertex_bytes < index_bytes) return false;
+
+                primitive = { p, counts[0], p + vertex_bytes, counts[1] };
+                p += vertex_bytes + index_bytes;
+            }
+
+            m_CookedMeshes = cooked;
+            m_CookedPrimitives = std::move(primitives);
+            return true;
+        }
+
+        void AppendCookedPrimitive(const std::vector<VertexBasicAttribs> &vertices, const std::vector<uint32_t> &indices)
+        {
+            uint32_t counts[2] = { static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()) };
+            const uint8_t *pCounts = reinterpret_cast<const uint8_t *>(counts);
+            const uint8_t *pVertices = reinterpret_cast<const uint8_t *>(vertices.data());
+            const uint8_t *pIndices = reinterpret_cast<const uint8_t *>(indices.data());
+
+            m_CookingMeshes.insert(m_CookingMeshes.end(), pCounts, pCounts + sizeof(counts));
+            m_CookingMeshes.insert(m_CookingMeshes.end(), pVertices, pVertices + vertices.size() * sizeof(VertexBasicAttribs));
+            m_CookingMeshes.insert(m_CookingMeshes.end(), pIndices, pIndices + indices.size() * sizeof(uint32_t));
+            m_nCookingPrimitives++;
+        }
+
+        // an image of the scene, decoded once for all the textures using it
+        struct ImageDecode
+        {
+            std::string file;           // the asset file, empty for embedded images
+            BufferView data;            // embedded images
+            std::string ext;
+            size_t szDecoded = 0;       // estimated from the header
+            MipmapDesc mips;
+            std::shared_ptr<Image> pImage;
+        };
+
+        // threads decoding the images of a scene, 0 for one per hardware thread
+        uint32_t m_nDecodeThreads = 0;
+        bool m_bGenerateMipmaps = true;
+        // decoded bytes of the images being decoded at once
+        size_t m_szDecodeBudget = 512 * 1024 * 1024;
+
+        // image loader for tinygltf that keeps the images undecoded, our own parsers decode them
+        static bool SkipImageDecoding(tinygltf::Image *, const int, std::string *, std::string *,
+                                      int, int, const unsigned char *, int, void *)
+        {
+            return true;
+        }
+
+        // file system of tinygltf for external buffers: resolved by the asset loader,
+        // so they are found in mounted packs too
+        static bool AssetFileExists(const std::string &path, void *)
+        {
+            return g_pAssetLoader->FileExists(path.c_str());
+        }
+
+        static std::string AssetExpandFilePath(const std::string &path, void *)
+        {
+            return path;
+        }
+
+        static bool AssetReadWholeFile(std::vector<unsigned char> *out, std::string *err, const std::string &path, void *)
+        {
+            BufferView file = g_pAssetLoader->MapFile(path.c_str());
+            if (file.IsEmpty())
+            {
+                if (err) *err += "cannot read " + path + "\n";
+                return false;
+            }
+
+            out->assign(file.GetData(), file.GetData() + file.GetDataSize());
+            return true;
+        }
 
     public:
+        void SetDecodeThreads(uint32_t count) { m_nDecodeThreads = count; }
+        void SetDecodeMemoryBudget(size_t bytes) { m_szDecodeBudget = bytes; }
+        // textures come with their mip chains, made as the materials using them need
+        void SetGenerateMipmaps(bool generate) { m_bGenerateMipmaps = generate; }
+
         void ConvertBuffers(const ConvertedBufferViewKey &Key,
                             ConvertedBufferViewData &Data,
                             const tinygltf::Model &gltf_model,
-                            std::vector<VertexBasicAttribs> &VertexData) const
+                            VertexDataArray &VertexData) const
         {
             const float *bufferPos = nullptr;
             const float *bufferNormals = nullptr;
@@ -88,7 +230,7 @@ namespace Corona
                 // VERIFY(posAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT, "Position component type is expected to be float");
                 // VERIFY(posAccessor.type == TINYGLTF_TYPE_VEC3, "Position type is expected to be vec3");
 
-                bufferPos = reinterpret_cast<const float *>(&(gltf_model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
+                bufferPos = reinterpret_cast<const float *>(m_Buffers[posView.buffer].GetData() + posAccessor.byteOffset + posView.byteOffset);
                 vertexCount = static_cast<uint32_t>(posAccessor.count);
 
                 posStride = posAccessor.ByteStride(posView) / tinygltf::GetComponentSizeInBytes(posAccessor.componentType);
@@ -104,7 +246,7 @@ namespace Corona
                 // VERIFY(normAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT, "Normal component type is expected to be float");
                 // VERIFY(normAccessor.type == TINYGLTF_TYPE_VEC3, "Normal type is expected to be vec3");
 
-                bufferNormals = reinterpret_cast<const float *>(&(gltf_model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
+                bufferNormals = reinterpret_cast<const float *>(m_Buffers[normView.buffer].GetData() + normAccessor.byteOffset + normView.byteOffset);
                 normalsStride = normAccessor.ByteStride(normView) / tinygltf::GetComponentSizeInBytes(normAccessor.componentType);
                 // VERIFY(normalsStride > 0, "Normal stride is invalid");
             }
@@ -116,7 +258,7 @@ namespace Corona
                 // VERIFY(normAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT, "Normal component type is expected to be float");
                 // VERIFY(normAccessor.type == TINYGLTF_TYPE_VEC3, "Normal type is expected to be vec3");
 
-                bufferTangents = reinterpret_cast<const float *>(&(gltf_model.buffers[tanView.buffer].data[tanAccessor.byteOffset + tanView.byteOffset]));
+                bufferTangents = reinterpret_cast<const float *>(m_Buffers[tanView.buffer].GetData() + tanAccessor.byteOffset + tanView.byteOffset);
                 tangentsStride = tanAccessor.ByteStride(tanView) / tinygltf::GetComponentSizeInBytes(tanAccessor.componentType);
                 // VERIFY(normalsStride > 0, "tangent stride is invalid");
             }
@@ -132,7 +274,7 @@ namespace Corona
                 // VERIFY(uvAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT, "UV0 component type is expected to be float");
                 // VERIFY(uvAccessor.type == TINYGLTF_TYPE_VEC2, "UV0 type is expected to be vec2");
 
-                bufferTexCoordSet0 = reinterpret_cast<const float *>(&(gltf_model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+                bufferTexCoordSet0 = reinterpret_cast<const float *>(m_Buffers[uvView.buffer].GetData() + uvAccessor.byteOffset + uvView.byteOffset);
                 texCoordSet0Stride = uvAccessor.ByteStride(uvView) / tinygltf::GetComponentSizeInBytes(uvAccessor.componentType);
                 // VERIFY(texCoordSet0Stride > 0, "Texcoord0 stride is invalid");
             }
@@ -144,7 +286,7 @@ namespace Corona
                 // VERIFY(uvAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT, "UV1 component type is expected to be float");
                 // VERIFY(uvAccessor.type == TINYGLTF_TYPE_VEC2, "UV1 type is expected to be vec2");
 
-                bufferTexCoordSet1 = reinterpret_cast<const float *>(&(gltf_model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+                bufferTexCoordSet1 = reinterpret_cast<const float *>(m_Buffers[uvView.buffer].GetData() + uvAccessor.byteOffset + uvView.byteOffset);
                 texCoordSet1Stride = uvAccessor.ByteStride(uvView) / tinygltf::GetComponentSizeInBytes(uvAccessor.componentType);
                 // VERIFY(texCoordSet1Stride > 0, "Texcoord1 stride is invalid");
             }
@@ -169,14 +311,33 @@ namespace Corona
                       const tinygltf::Node &gltf_node,
                       uint32_t nodeIndex,
                       const tinygltf::Model &gltf_model,
-                      std::vector<VertexBasicAttribs> &VertexData,
-                      std::vector<uint32_t> &IndexData,
+                      VertexDataArray &VertexData,
+                      IndexDataArray &IndexData,
                       ConvertedBufferViewMap &ConvertedBuffers,
                       std::shared_ptr<Scene> &pScene)
         {
             std::unique_ptr<SceneNode> pTempNode(new SceneNode());
-            std::shared_ptr<SceneNode> pNewNode(new SceneNode());
-            std::shared_ptr<SceneNode> pNewNodeForTest;
+            // camera nodes are SceneCameraNodes from the start so they stay in the hierarchy,
+            // only one of the two handles is valid
+            Handle<SceneNode> hNewNode;
+            Handle<SceneCameraNode> hNewCameraNode;
+            SceneNode* pNewNode;
+            if (gltf_node.camera >= 0)
+            {
+                hNewCameraNode = pScene->CameraNodePool.Create();
+                pNewNode = pScene->GetCameraNode(hNewCameraNode);
+            }
+            else
+            {
+                hNewNode = pScene->NodePool.Create();
+                pNewNode = pScene->GetNode(hNewNode);
+            }
+            if (!pNewNode)
+            {
+                // the pool is out of handles, the node and its children are left out
+                fprintf(stderr, "Too many nodes in the scene, '%s' is left out\n", gltf_node.name.c_str());
+                return;
+            }
             pNewNode->Index = nodeIndex;
             pNewNode->m_Parent = parent;
             pNewNode->m_strName = gltf_node.name;
@@ -224,7 +385,7 @@ namespace Corona
 
             if (gltf_node.matrix.size() == 16)
             {
-                std::vector<double> vals = gltf_node.matrix;
+                const std::vector<double> &vals = gltf_node.matrix;
                 pNewNode->Matrix = Matrix4X4f //
                     {
                         static_cast<float>(vals[0]), static_cast<float>(vals[1]), static_cast<float>(vals[2]), static_cast<float>(vals[3]),
@@ -238,10 +399,46 @@ namespace Corona
                 const tinygltf::Mesh &gltf_mesh = gltf_model.meshes[gltf_node.mesh];
                 std::shared_ptr<SceneObjectMesh> pNewMesh(new SceneObjectMesh);
 
+                // the files the mesh is read from, to reload it when one changes
+                for (const tinygltf::Primitive &primitive : gltf_mesh.primitives)
+                {
+                    std::vector<int> accessors;
+                    for (auto &attribute : primitive.attributes) accessors.push_back(attribute.second);
+                    if (primitive.indices > -1) accessors.push_back(primitive.indices);
+
+                    for (int accessor : accessors)
+                    {
+                        int view = gltf_model.accessors[accessor].bufferView;
+                        if (view < 0) continue;
+                        const std::string &file = m_BufferFiles[gltf_model.bufferViews[view].buffer];
+                        if (file.empty()) continue;
+
+                        auto &meshes = pScene->MeshSources[file];
+                        if (std::find(meshes.begin(), meshes.end(), gltf_mesh.name) == meshes.end())
+                            meshes.push_back(gltf_mesh.name);
+                    }
+                }
+
                 for (size_t j = 0; j < gltf_mesh.primitives.size(); j++)
                 {
                     const tinygltf::Primitive &primitive = gltf_mesh.primitives[j];
 
+                    // converted by an earlier load of the same files
+                    if (m_nNextCookedPrimitive < m_CookedPrimitives.size())
+                    {
+                        const CookedPrimitive &cooked = m_CookedPrimitives[m_nNextCookedPrimitive++];
+                        std::vector<VertexBasicAttribs> cookedVertexData(cooked.nVertexCount);
+                        std::vector<uint32_t> cookedIndexData(cooked.nIndexCount);
+                        if (cooked.nVertexCount) memcpy(cookedVertexData.data(), cooked.pVertices, cooked.nVertexCount * sizeof(VertexBasicAttribs));
+                        if (cooked.nIndexCount) memcpy(cookedIndexData.data(), cooked.pIndices, cooked.nIndexCount * sizeof(uint32_t));
+
+                        std::shared_ptr<SceneObjectPrimitive> pNewPrimitive(
+                            new SceneObjectPrimitive(std::move(cookedVertexData), std::move(cookedIndexData)));
+                        pNewMesh->AddPrimitive(pNewPrimitive);
+                        pNewMesh->SetMaterial(primitive.material >= 0 ? static_cast<uint32_t>(primitive.material) : -1 );
+                        continue;
+                    }
+
                     uint32_t indexStart = static_cast<uint32_t>(IndexData.size());
                     uint32_t vertexStart = 0;
 
@@ -315,11 +512,11 @@ namespace Corona
                         {
                             const tinygltf::Accessor &accessor = gltf_model.accessors[primitive.indices > -1 ? primitive.indices : 0];
                             const tinygltf::BufferView &bufferView = gltf_model.bufferViews[accessor.bufferView];
-                            const tinygltf::Buffer &buffer = gltf_model.buffers[bufferView.buffer];
+                            const BufferView &buffer = m_Buffers[bufferView.buffer];
 
                             indexCount = static_cast<uint32_t>(accessor.count);
 
-                            const void *dataPtr = &(buffer.data[accessor.byteOffset + bufferView.byteOffset]);
+                            const void *dataPtr = buffer.GetData() + accessor.byteOffset + bufferView.byteOffset;
 
                             IndexData.reserve(IndexData.size() + accessor.count);
                             // IndexData.reserve(IndexData.GetIndexCount() + accessor.count);
@@ -354,12 +551,15 @@ namespace Corona
                             }
                             default:
                                 std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
+                                // the primitives after this one would not line up
+                                m_bCooking = false;
                                 return;
                             }
                         }
                         // TODO: Should i use a std::move here ? NO.
                         std::vector<VertexBasicAttribs> cutVertexData(VertexData.begin() + vertexStart, VertexData.begin() + vertexStart + vertexCount);
                         std::vector<uint32_t> cutIndexData(IndexData.begin() + indexStart, IndexData.begin() + indexStart + indexCount);
+                        if (m_bCooking) AppendCookedPrimitive(cutVertexData, cutIndexData);
                         std::shared_ptr<SceneObjectPrimitive> pNewPrimitive(
                             new SceneObjectPrimitive(std::move(cutVertexData), std::move(cutIndexData)));
                         pNewMesh->AddPrimitive(pNewPrimitive);
@@ -368,14 +568,19 @@ namespace Corona
                 }
                 pNewNode->pMesh = pNewMesh;
                 m_Geometries[gltf_mesh.name] = std::move(pNewMesh);
-                m_GeometryNodes[gltf_node.name] = pNewNode; // TODO: Attention
+                // TODO: meshes on camera nodes are not drawn
+                if (hNewNode)
+                {
+                    m_GeometryNodes.push_back(hNewNode);
+                }
                 // pNewNode->pMesh = std::move(pNewMesh);
             }
 
             // Node contains camera
             if (gltf_node.camera >= 0)
             {
-                pNewNodeForTest = std::make_shared<SceneCameraNode>(*pNewNode);
+                SceneCameraNode* pCameraNode = pScene->GetCameraNode(hNewCameraNode);
+                pCameraNode->m_type = "Camera";
                 const auto &gltf_cam = gltf_model.cameras[gltf_node.camera];
 
                 if (gltf_cam.type == "perspective")
@@ -393,7 +598,7 @@ namespace Corona
                         static_cast<float>(gltf_cam.perspective.yfov));
 
                     // TODO: A cleaner way?
-                    std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest)->pCamera = pNewCamera;
+                    pCameraNode->pCamera = pNewCamera;
                     m_Cameras[gltf_cam.name] = std::move(pNewCamera);
                     // TODO: add ref of pNewCamera and pNewCamNode
                 }
@@ -411,7 +616,7 @@ namespace Corona
                         static_cast<float>(gltf_cam.orthographic.xmag),
                         static_cast<float>(gltf_cam.orthographic.ymag));
 
-                    std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest)->pCamera = pNewCamera;
+                    pCameraNode->pCamera = pNewCamera;
                     m_Cameras[gltf_cam.name] = std::move(pNewCamera);
                     // TODO
                 }
@@ -422,35 +627,47 @@ namespace Corona
                     printf("Unexpected camera type");
                 }
 
-                m_CameraNodes[gltf_node.name] = std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest); // TODO
+                m_CameraNodes.push_back(hNewCameraNode);
             }
 
-            // use dynamic_cast and dynamic_pointer_cast to get various Nodes (?)
-            pScene->LUT_Name_LinearNodes[gltf_node.name] = pNewNode;
+            if (hNewNode)
+            {
+                pScene->LUT_Name_LinearNodes[gltf_node.name] = hNewNode;
+            }
 
 			// temporary for light
 			if (gltf_node.extensions.find("KHR_lights_punctual") != gltf_node.extensions.end())
             {
-                pScene->LUT_Name_LinearNodes[parent->GetName()]->m_type = "Light";
-				m_LightNodes[parent->GetName()] = pScene->LUT_Name_LinearNodes[parent->GetName()];
+                parent->m_type = "Light";
+                auto parent_it = pScene->LUT_Name_LinearNodes.find(parent->GetName());
+                if (parent_it != pScene->LUT_Name_LinearNodes.end() &&
+                    std::find(m_LightNodes.begin(), m_LightNodes.end(), parent_it->second) == m_LightNodes.end())
+                {
+                    m_LightNodes.push_back(parent_it->second);
+                }
 				auto _it = gltf_node.extensions.find("KHR_lights_punctual");
                 pNewNode->m_type = "Light_Orietation";
 				pNewNode->lightIndex = ((*_it).second).Get("light").GetNumberAsInt();
-                m_LightNodes[pNewNode->GetName()] = pNewNode;
+                if (hNewNode)
+                {
+                    m_LightNodes.push_back(hNewNode);
+                }
 			}
 
             if (parent)
             {
-                parent->m_Children.push_back(std::move(pNewNode));
+                parent->m_Children.push_back(pNewNode);
             }
             else
             {
-                pScene->RootNodes.push_back(std::move(pNewNode));
+                pScene->RootNodes.push_back(pNewNode);
             }
 
-            if(m_CameraNodes.find("Default_Camera") == m_CameraNodes.end())
+            Handle<SceneCameraNode> hDefaultCamera;
+            if (m_Cameras.find("Default_Camera") == m_Cameras.end() &&
+                (hDefaultCamera = pScene->CameraNodePool.Create()))
             {
-                pNewNodeForTest = std::make_shared<SceneCameraNode>();
+                SceneCameraNode* pDefaultCamera = pScene->GetCameraNode(hDefaultCamera);
 
                 auto pNewCamera = std::make_shared<SceneObjectPerspectiveCamera>(
                     "perspective",
@@ -459,23 +676,22 @@ namespace Corona
                     static_cast<float>(16.0f / 9.0f),
                     static_cast<float>(PI / 2.0f));
 
-                std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest)->pCamera = pNewCamera;
+                pDefaultCamera->pCamera = pNewCamera;
                 m_Cameras["Default_Camera"] = std::move(pNewCamera);
 
-                std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest)->m_type = "Camera";
-                std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest)->Translation = Vector3f{ 0.0f, 0.0f, 3.0f };
-                m_CameraNodes["Default_Camera"] = std::dynamic_pointer_cast<SceneCameraNode>(pNewNodeForTest);
+                pDefaultCamera->m_strName = "Default_Camera";
+                pDefaultCamera->m_type = "Camera";
+                pDefaultCamera->Translation = Vector3f{ 0.0f, 0.0f, 3.0f };
+                // the default camera stays the first one, GetFirstCameraNode() drives the view with it
+                m_CameraNodes.insert(m_CameraNodes.begin(), hDefaultCamera);
 
-                // use dynamic_cast and dynamic_pointer_cast to get various Nodes (?)
-                // Just because there is no NEW METHOD for mesh
-                pScene->LUT_Name_LinearNodes["Default_Camera"] = pNewNodeForTest;
                 if (parent)
                 {
-                    parent->m_Children.push_back(std::move(pNewNodeForTest));
+                    parent->m_Children.push_back(pDefaultCamera);
                 }
                 else
                 {
-                    pScene->RootNodes.push_back(std::move(pNewNodeForTest));
+                    pScene->RootNodes.push_back(pDefaultCamera);
                 }
             }
 
@@ -484,65 +700,203 @@ namespace Corona
 			{
 				for (size_t i = 0; i < gltf_node.children.size(); i++)
 				{
-					LoadNode(pNewNode.get(), gltf_model.nodes[gltf_node.children[i]], gltf_node.children[i],
+					LoadNode(pNewNode, gltf_model.nodes[gltf_node.children[i]], gltf_node.children[i],
 						gltf_model, VertexData, IndexData, ConvertedBuffers, pScene);
 				}
 			}
 
         }
 
-        void ParseImage(std::string &imagePath, std::shared_ptr<Image> &pImage)
+        // Decodes the images on a pool of threads, the largest first. Every image
+        // goes to its own slot, so the result does not depend on which decode
+        // finishes first. Decodes wait while the bytes they will need would take
+        // the ones in flight over the budget, one at a time always proceeds.
+        void DecodeImages(std::vector<ImageDecode> &Decodes)
         {
-            // we should lookup if the texture has been loaded already to prevent
-                // duplicated load. This could be done in Asset Loader Manager.
-            Buffer buf = g_pAssetLoader->SyncOpenAndReadBinary(imagePath.c_str());
-            std::string ext = imagePath.substr(imagePath.find_last_of("."));
-            if (ext == ".jpg" || ext == ".jpeg")
-            {
-             	JpegParser jpeg_parser;
-             	pImage = std::make_shared<Image>(jpeg_parser.Parse(buf));
-            }
-            else if (ext == ".png")
+            std::vector<size_t> order(Decodes.size());
+            for (size_t i = 0; i < order.size(); i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return Decodes[a].szDecoded > Decodes[b].szDecoded;
+            });
+
+            std::atomic<size_t> next{ 0 };
+            std::mutex mutex;
+            std::condition_variable budget_freed;
+            size_t in_flight = 0;
+
+            auto work = [&]() {
+                for (size_t i = next++; i < order.size(); i = next++)
+                {
+                    ImageDecode &decode = Decodes[order[i]];
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        budget_freed.wait(lock, [&]() {
+                            return in_flight == 0 || in_flight + decode.szDecoded <= m_szDecodeBudget;
+                        });
+                        in_flight += decode.szDecoded;
+                    }
+
+                    if (!decode.file.empty())
+                        ParseImage(decode.file, decode.mips, decode.pImage);
+                    else
+                        ParseImage(decode.data, decode.ext, decode.mips, decode.pImage);
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        in_flight -= decode.szDecoded;
+                    }
+                    budget_freed.notify_all();
+                }
+            };
+
+            size_t thread_count = m_nDecodeThreads ? m_nDecodeThreads : std::max(1u, std::thread::hardware_concurrency());
+            thread_count = std::min(thread_count, Decodes.size());
+            // the decodes allocate their images from the pools, which other
+            // threads may only share in thread-safe mode
+            if (!g_pMemoryManager->IsThreadSafe()) thread_count = 1;
+
+            // the calling thread decodes too
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < thread_count; i++) workers.emplace_back(work);
+            work();
+            for (auto &worker : workers) worker.join();
+        }
+
+        void ParseImage(std::string &imagePath, const MipmapDesc &mips, std::shared_ptr<Image> &pImage)
+        {
+            // shared with every other material and scene using the same file
+            pImage = g_pImageCache->GetImage(imagePath.c_str(), mips);
+            if (!pImage) pImage = std::make_shared<Image>();
+        }
+
+        void ParseImage(const BufferView &buf, const std::string &ext, const MipmapDesc &mips, std::shared_ptr<Image> &pImage)
+        {
+            pImage = g_pImageCache->GetImage(buf, ext, mips);
+            if (!pImage) pImage = std::make_shared<Image>();
+        }
+
+        // How the mips of every texture are made: colors in linear space,
+        // normal maps renormalized and the base color of alpha tested
+        // materials keeping its coverage. The first material using a texture
+        // decides, textures of no material are filtered as they are.
+        std::vector<MipmapDesc> GetTextureMipmaps(const tinygltf::Model &gltf_model) const
+        {
+            std::vector<MipmapDesc> Mipmaps(gltf_model.textures.size());
+            if (!m_bGenerateMipmaps) return Mipmaps;
+
+            std::vector<bool> decided(gltf_model.textures.size(), false);
+            auto use = [&](int index, MIPMAP_FILTER filter, float alphaCutoff) {
+                if (index < 0 || index >= static_cast<int>(Mipmaps.size()) || decided[index]) return;
+                Mipmaps[index].filter = filter;
+                Mipmaps[index].fAlphaCutoff = alphaCutoff;
+                decided[index] = true;
+            };
+            auto index_of = [](const tinygltf::ParameterMap &Params, const char *Name) {
+                auto it = Params.find(Name);
+                return it != Params.end() ? it->second.TextureIndex() : -1;
+            };
+
+            for (const tinygltf::Material &gltf_mat : gltf_model.materials)
             {
-             	PngParser png_parser;
-             	pImage = std::make_shared<Image>(png_parser.Parse(buf));
+                float alphaCutoff = 0.0f;
+                auto alpha_mode_it = gltf_mat.additionalValues.find("alphaMode");
+                if (alpha_mode_it != gltf_mat.additionalValues.end() && alpha_mode_it->second.string_value == "MASK")
+                {
+                    auto cutoff_it = gltf_mat.additionalValues.find("alphaCutoff");
+                    alphaCutoff = cutoff_it != gltf_mat.additionalValues.end() ? static_cast<float>(cutoff_it->second.Factor()) : 0.5f;
+                }
+
+                use(index_of(gltf_mat.values, "baseColorTexture"), MIPMAP_FILTER::SRGB, alphaCutoff);
+                use(index_of(gltf_mat.values, "metallicRoughnessTexture"), MIPMAP_FILTER::LINEAR, 0.0f);
+                use(index_of(gltf_mat.additionalValues, "normalTexture"), MIPMAP_FILTER::NORMAL_MAP, 0.0f);
+                use(index_of(gltf_mat.additionalValues, "occlusionTexture"), MIPMAP_FILTER::LINEAR, 0.0f);
+                use(index_of(gltf_mat.additionalValues, "emissiveTexture"), MIPMAP_FILTER::SRGB, 0.0f);
+
+                auto ext_it = gltf_mat.extensions.find("KHR_materials_pbrSpecularGlossiness");
+                if (ext_it != gltf_mat.extensions.end())
+                {
+                    if (ext_it->second.Has("diffuseTexture"))
+                        use(ext_it->second.Get("diffuseTexture").Get("index").Get<int>(), MIPMAP_FILTER::SRGB, alphaCutoff);
+                    if (ext_it->second.Has("specularGlossinessTexture"))
+                        use(ext_it->second.Get("specularGlossinessTexture").Get("index").Get<int>(), MIPMAP_FILTER::SRGB, 0.0f);
+                }
             }
-            // else if (ext == ".bmp")
-            // {
-            //     BmpParser bmp_parser;
-            //     pImage = std::make_shared<Image>(bmp_parser.Parse(buf));
-            // }
-            // else if (ext == ".tga")
-            // {
-            //     TgaParser tga_parser;
-            //     pImage = std::make_shared<Image>(tga_parser.Parse(buf));
-            // }
-            else if (ext == ".bmp")
+
+            for (size_t i = 0; i < Mipmaps.size(); i++)
             {
-             	BmpParser bmp_parser;
-             	pImage = std::make_shared<Image>(bmp_parser.Parse(buf));
+                if (!decided[i]) Mipmaps[i].filter = MIPMAP_FILTER::LINEAR;
             }
+            return Mipmaps;
         }
 
         void LoadMaterialsAndTextures(const tinygltf::Model &gltf_model, std::shared_ptr<Scene> &pScene, std::string &BasePath)
         {
-            std::vector<std::string> NameOfTextures;
-            std::vector<std::shared_ptr<Image>> m_pImages;
-			// TODO: put every map on its own position
-			for (const tinygltf::Texture& gltf_tex : gltf_model.textures)
-			{
-				const tinygltf::Image& gltf_image = gltf_model.images[gltf_tex.source];
-				auto& ImageId = !gltf_image.uri.empty() ? (BasePath + gltf_image.uri) : "";
+            // every image once for each kind of mips, however many textures use it
+            std::vector<MipmapDesc> MipmapsOfTexture = GetTextureMipmaps(gltf_model);
+            std::vector<ImageDecode> Decodes;
+            std::unordered_map<std::string, int> DecodeOfImage;
+            std::vector<int> DecodeOfTexture(gltf_model.textures.size(), -1);
+            for (size_t i = 0; i < gltf_model.textures.size(); i++)
+            {
+                const tinygltf::Texture &gltf_tex = gltf_model.textures[i];
+                if (gltf_tex.source < 0) continue;
 
-				if (!ImageId.empty())
-				{
-					std::shared_ptr<Image> m_pImage(new Image());
-					ParseImage(ImageId, m_pImage); // TODO
+                std::string image_key = std::to_string(gltf_tex.source) + MipmapsOfTexture[i].GetKey();
+                auto image_it = DecodeOfImage.find(image_key);
+                if (image_it != DecodeOfImage.end())
+                {
+                    DecodeOfTexture[i] = image_it->second;
+                    continue;
+                }
 
-                    NameOfTextures.push_back(gltf_image.uri);
-                    m_pImages.push_back(m_pImage);
-				}
-			}
+                const tinygltf::Image &gltf_image = gltf_model.images[gltf_tex.source];
+                ImageDecode decode;
+                decode.mips = MipmapsOfTexture[i];
+                BufferView data;
+                if (!gltf_image.uri.empty())
+                {
+                    decode.file = BasePath + gltf_image.uri;
+                    size_t dot = decode.file.find_last_of('.');
+                    decode.ext = dot == std::string::npos ? std::string() : decode.file.substr(dot);
+                    data = g_pAssetLoader->MapFile(decode.file.c_str());
+                }
+                else if (gltf_image.bufferView >= 0)
+                {
+                    // embedded into a .glb, decoded straight out of the binary chunk
+                    const tinygltf::BufferView &gltf_view = gltf_model.bufferViews[gltf_image.bufferView];
+                    decode.data = m_Buffers[gltf_view.buffer].SubView(gltf_view.byteOffset, gltf_view.byteLength);
+                    decode.ext = gltf_image.mimeType == "image/png" ? ".png" : ".jpg";
+                    data = decode.data;
+                }
+                else
+                {
+                    continue;
+                }
+
+                decode.szDecoded = ImageCache::GetDecodedSize(data, decode.ext);
+                DecodeOfImage[image_key] = static_cast<int>(Decodes.size());
+                DecodeOfTexture[i] = static_cast<int>(Decodes.size());
+                Decodes.push_back(std::move(decode));
+            }
+
+            DecodeImages(Decodes);
+
+            pooled::vector<std::string, MemoryTag::Transient> NameOfTextures;
+            // the image files, empty for embedded images
+            pooled::vector<std::string, MemoryTag::Transient> FileOfTextures;
+            pooled::vector<std::shared_ptr<Image>, MemoryTag::Transient> m_pImages;
+            // TODO: put every map on its own position
+            for (size_t i = 0; i < gltf_model.textures.size(); i++)
+            {
+                const tinygltf::Texture &gltf_tex = gltf_model.textures[i];
+                int decode = DecodeOfTexture[i];
+                if (decode < 0) continue;
+
+                const tinygltf::Image &gltf_image = gltf_model.images[gltf_tex.source];
+                NameOfTextures.push_back(Decodes[decode].file.empty() ? gltf_image.name : gltf_image.uri);
+                FileOfTextures.push_back(Decodes[decode].file);
+                m_pImages.push_back(Decodes[decode].pImage);
+            }
 
             auto &m_Materials = pScene->Materials;
             for (const tinygltf::Material &gltf_mat : gltf_model.materials)
@@ -729,7 +1083,12 @@ namespace Corona
                     {
 						auto texture = std::make_shared<SceneObjectTexture>(m_pImages[pMat->TextureIds[i]]);
 						texture->SetName(NameOfTextures[pMat->TextureIds[i]]);
+						texture->SetMipmaps(MipmapsOfTexture[pMat->TextureIds[i]]);
 						pMat->Textures[i] = texture;
+						if (!FileOfTextures[pMat->TextureIds[i]].empty())
+						{
+							pScene->TextureSources[FileOfTextures[pMat->TextureIds[i]]].push_back(texture);
+						}
 
                         if (i == 0)
                         {
@@ -784,7 +1143,7 @@ namespace Corona
                     m_Light->m_type = "point";
 
                     m_Lights[light.name] = m_Light;
-                    m_LinearLights.emplace_back(m_Light);
+                    m_LinearLights.emplace_back(m_Light.get());
                 }
                 else if (light.type == "spot")
                 {
@@ -797,7 +1156,7 @@ namespace Corona
                     m_Light->m_type = "spot";
 
 					m_Lights[light.name] = m_Light;
-                    m_LinearLights.emplace_back(m_Light);
+                    m_LinearLights.emplace_back(m_Light.get());
                 }
             }
         }
@@ -809,29 +1168,50 @@ namespace Corona
             if (pScene->name == "")
                 assert("File path must not be empty");
 
-            std::string filePath = g_pAssetLoader->GetFilePath(FileName.c_str());
-
             bool binary = false;
-            size_t extpos = filePath.rfind('.', filePath.length());
+            size_t extpos = FileName.rfind('.', FileName.length());
             if (extpos != std::string::npos)
             {
-                binary = (filePath.substr(extpos + 1, filePath.length() - extpos) == "glb");
+                binary = (FileName.substr(extpos + 1, FileName.length() - extpos) == "glb");
             }
 
             std::string error;
             std::string warning;
             tinygltf::Model gltf_model;
 
+            // buffers and images are looked up by their path below Asset/, the
+            // asset loader resolves it from its file index or a mounted pack
+            std::string basePath;
+            extpos = FileName.find_last_of("/\\");
+            if (extpos != std::string::npos)
+            {
+                basePath = FileName.substr(0, extpos + 1);
+            }
+
+            // tinygltf parses straight out of the mapped file instead of its own copy
+            BufferView file = g_pAssetLoader->MapFile(FileName.c_str());
+            BuildCache &cache = g_pAssetLoader->GetBuildCache();
+            std::vector<BuildInput> meshInputs;
+            if (cache.IsOpen()) meshInputs.push_back(BuildCache::HashInput(file));
+
             tinygltf::TinyGLTF loader;
+            loader.SetImageLoader(&GltfParser::SkipImageDecoding, nullptr);
+            loader.SetFsCallbacks({ &GltfParser::AssetFileExists, &GltfParser::AssetExpandFilePath,
+                                    &GltfParser::AssetReadWholeFile, &tinygltf::WriteWholeFile, nullptr });
             bool fileLoaded = false;
             if (binary)
-                fileLoaded = loader.LoadBinaryFromFile(&gltf_model, &error, &warning, filePath);
+                fileLoaded = loader.LoadBinaryFromMemory(&gltf_model, &error, &warning,
+                    file.GetData(), static_cast<unsigned int>(file.GetDataSize()), basePath);
             else
-                fileLoaded = loader.LoadASCIIFromFile(&gltf_model, &error, &warning, filePath);
+                fileLoaded = loader.LoadASCIIFromString(&gltf_model, &error, &warning,
+                    reinterpret_cast<const char*>(file.GetData()), static_cast<unsigned int>(file.GetDataSize()), basePath);
+            file = BufferView();
 
             if (!fileLoaded)
             {
-                printf("Failed to load gltf file");
+                // a half written file while it is edited, the caller keeps what it has
+                fprintf(stderr, "Failed to load gltf file %s: %s\n", FileName.c_str(), error.c_str());
+                return nullptr;
             }
             if (!warning.empty())
             {
@@ -842,11 +1222,34 @@ namespace Corona
                 printf("Loaded gltf file");
             }
 
-            std::string basePath;
-            extpos = filePath.rfind('/', filePath.length());
-            if (extpos != std::string::npos)
+            // the buffers move into views, nothing below copies them
+            m_Buffers.clear();
+            m_BufferFiles.clear();
+            for (auto &gltf_buffer : gltf_model.buffers)
             {
-                basePath = filePath.substr(0, extpos + 1);
+                m_Buffers.emplace_back(std::move(gltf_buffer.data));
+                bool external = !gltf_buffer.uri.empty() && gltf_buffer.uri.compare(0, 5, "data:") != 0;
+                m_BufferFiles.push_back(external ? basePath + gltf_buffer.uri : std::string());
+            }
+
+            // the vertex data depends on the glTF file and on the external buffers,
+            // the embedded ones are part of the file
+            std::string meshKey = "meshes:" + FileName;
+            m_CookedMeshes = BufferView();
+            m_CookedPrimitives.clear();
+            m_nNextCookedPrimitive = 0;
+            m_CookingMeshes.clear();
+            m_nCookingPrimitives = 0;
+            m_bCooking = false;
+            if (cache.IsOpen())
+            {
+                for (size_t i = 0; i < m_Buffers.size(); i++)
+                {
+                    if (!m_BufferFiles[i].empty()) meshInputs.push_back(BuildCache::HashInput(m_Buffers[i]));
+                }
+
+                BufferView cooked;
+                m_bCooking = !cache.Find(meshKey, kMeshCookVersion, meshInputs, cooked) || !ReadCookedMeshes(cooked);
             }
 
             // LoadTextureSamplers(pDevice, gltf_model);
@@ -855,8 +1258,8 @@ namespace Corona
             LoadLights(gltf_model, pScene);
 
             // these are vertices and indices of all primitive (accumulated)
-            std::vector<VertexBasicAttribs> VertexData;
-            std::vector<uint32_t> IndexData;
+            VertexDataArray VertexData;
+            IndexDataArray IndexData;
 
             ConvertedBufferViewMap ConvertedBuffers;
 
@@ -888,12 +1291,26 @@ namespace Corona
             // Initial pose
             for (auto &root_node : pScene->RootNodes)
             {
-                root_node.lock()->UpdateTransforms();
+                root_node->UpdateTransforms();
             }
             // TODO: use this function to get boundbox and BVH
             // CalculateSceneDimensions();
 
+            if (m_bCooking)
+            {
+                CookedMeshesHeader header = { m_nCookingPrimitives, static_cast<uint32_t>(sizeof(VertexBasicAttribs)) };
+                cache.Store(meshKey, kMeshCookVersion, meshInputs,
+                            { BufferView(nullptr, reinterpret_cast<const uint8_t *>(&header), sizeof(header)),
+                              BufferView(nullptr, m_CookingMeshes.data(), m_CookingMeshes.size()) });
+            }
+
             // UpdatePrimitiveData();
+            m_Buffers.clear();
+            m_BufferFiles.clear();
+            m_CookedMeshes = BufferView();
+            m_CookedPrimitives.clear();
+            m_CookingMeshes.clear();
+            m_bCooking = false;
             return pScene;
         }
     };
@@ -4,6 +4,7 @@
 #include <setjmp.h>
 #include <stdio.h>
 #include <assert.h>
+#include <vector>
 
 #include "ImageParser.h"
 #include "portable.h"
@@ -34,10 +35,19 @@ my_error_exit(j_common_ptr cinfo)
 
 namespace Corona
 {
+    // Decodes to RGBA8 with an opaque alpha, the format the textures are
+    // uploaded in, so nothing widens the pixels afterwards. Other color spaces
+    // (CMYK) come out as the library converts them by default.
     class JpegParser : implements ImageParser
     {
     public:
-        Image Parse(Buffer& buf) override 
+        // decodes at 1/denominator of the size (1, 2, 4 or 8) with the DCT
+        // scaling of libjpeg, far cheaper than decoding in full and downsampling
+        void SetScale(uint32_t denominator) { m_nScaleDenom = denominator; }
+        // of the rows of the decoded image, in bytes
+        void SetPitchAlignment(size_t alignment) { m_szPitchAlignment = alignment; }
+
+        Image Parse(const BufferView& buf) override 
         {
             // https://stackoverflow.com/questions/5616216/need-help-in-reading-jpeg-file-using-libjpeg
             
@@ -50,6 +60,11 @@ namespace Corona
             // struct, to avoid dangling-pointer problems.
             my_jpeg_error_mgr jerr;
 
+            // in scope of the setjmp() below, the pixels are volatile to survive the longjmp()
+            Image m_Img;
+            std::vector<JSAMPROW> rows;
+            uint8_t* volatile data = nullptr;
+
             // Step 1: allocate and initialize JPEG decompression object
 
             // We set up the normal JPEG error routines, then override error_exit.
@@ -59,16 +74,17 @@ namespace Corona
             if (setjmp(jerr.setjmp_buffer))
             {
                 // If we get here, the JPEG code has signaled an error.
-                // We need to clean up the JPEG object, close the input file, and return.
+                // We need to clean up the JPEG object and return an empty image.
                 jpeg_destroy_decompress(&cinfo);
-                assert(0);
+                delete[] data;
+                return Image();
             }
 
             // Now we can initialize the JPEG decompression object.
             jpeg_create_decompress(&cinfo);
 
             // Step 2: specify data source
-            unsigned char* pSrcPtr = buf.GetData();
+            const unsigned char* pSrcPtr = buf.GetData();
             unsigned long  SrcSize = (unsigned long)buf.GetDataSize();
             jpeg_mem_src(&cinfo, pSrcPtr, SrcSize);
 
@@ -81,9 +97,14 @@ namespace Corona
 
             // Step 4: set parameters for decompression
 
-            // In this example, we don't need to change any of the defaults set by
-            // jpeg_read_header(), so we do nothing here.
-
+            // straight to RGBA, libjpeg-turbo fills in the alpha
+            if (cinfo.jpeg_color_space == JCS_GRAYSCALE || cinfo.jpeg_color_space == JCS_RGB ||
+                cinfo.jpeg_color_space == JCS_YCbCr)
+            {
+                cinfo.out_color_space = JCS_EXT_RGBA;
+            }
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = m_nScaleDenom;
 
             // Step 5: Start decompressor
 
@@ -91,40 +112,42 @@ namespace Corona
             // We can ignore the return value since suspension is not possible
             // with the stdio data source.
 
-            // We may need to do some setup of our own at this point before reading
-            // the data.  After jpeg_start_decompress() we have the correct scaled
-            // output image dimensions available, as well as the output colormap
-            // if we asked for color quantization.
+            // After jpeg_start_decompress() we have the correct scaled
+            // output image dimensions available.
 
-            Image m_Img;
             m_Img.Width = cinfo.output_width;
             m_Img.Height = cinfo.output_height;
-            // TODO
-            m_Img.pixel_format = PIXEL_FORMAT::RGB8;
-            m_Img.bitcount = (size_t)PIXEL_FORMAT::RGB8 * 8;
+            switch (cinfo.output_components)
+            {
+                case 1:
+                    m_Img.pixel_format = PIXEL_FORMAT::R8;
+                    break;
+                case 3:
+                    m_Img.pixel_format = PIXEL_FORMAT::RGB8;
+                    break;
+                default:
+                    m_Img.pixel_format = PIXEL_FORMAT::RGBA8;
+                    break;
+            }
+            m_Img.bitcount = (uint16_t)(cinfo.output_components * 8);
             m_Img.bitdepth = 8;
-            m_Img.pitch = ALIGN(m_Img.Width * (size_t)m_Img.pixel_format, 4);  // for GPU address alignment
+            m_Img.pitch = ALIGN((size_t)m_Img.Width * cinfo.output_components, m_szPitchAlignment);  // for GPU address alignment
             m_Img.data_size = (size_t)(m_Img.pitch * m_Img.Height);
 
-            uint8_t* data = new uint8_t[m_Img.data_size];
-            // Step 6: while (scan lines remain to be read)
-            //           jpeg_read_scanlines(...);
+            data = new uint8_t[m_Img.data_size];
 
-            // Here we use the library's state variable cinfo.output_scanline as the
-            // loop counter, so that we don't have to keep track ourselves.
+            // Step 6: read the scanlines into their rows of the image, the
+            // library puts out as many per call as it has decoded (an iMCU row)
+            rows.resize(m_Img.Height);
+            for (uint32_t row = 0; row < m_Img.Height; row++)
+            {
+                rows[row] = (JSAMPROW)(data + row * m_Img.pitch);
+            }
             while (cinfo.output_scanline < cinfo.output_height)
             {
-                // jpeg_read_scanlines expects an array of pointers to scanlines.
-                // Here the array is only one element long, but you could ask for
-                // more than one scanline at a time if that's more convenient.
-                uint8_t* pScanline0 = data;
-                uint8_t* pDstScanline = pScanline0 + cinfo.output_scanline * ((size_t)m_Img.pitch);
-                JSAMPROW RowPtrs[1];
-                RowPtrs[0] = (JSAMPROW)pDstScanline;
-                jpeg_read_scanlines(&cinfo, RowPtrs, 1);
+                jpeg_read_scanlines(&cinfo, rows.data() + cinfo.output_scanline,
+                                    cinfo.output_height - cinfo.output_scanline);
             }
-            m_Img.data = data;
-
             // Step 7: Finish decompression
 
             jpeg_finish_decompress(&cinfo);
@@ -136,7 +159,12 @@ namespace Corona
             // This is an important step since it will release a good deal of memory.
             jpeg_destroy_decompress(&cinfo);
 
+            m_Img.data = data;
             return m_Img;
         }
+
+    private:
+        uint32_t m_nScaleDenom = 1;
+        size_t m_szPitchAlignment = 4;
     };
-}
\ No newline at end of file
+}
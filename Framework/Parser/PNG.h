@@ -1,147 +1,494 @@
 #pragma once
-#include <algorithm>
-#include <cassert>
-#include <cstdio>
-#include <iostream>
-#include <queue>
-#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 #include "ImageParser.h"
+#include "PixelConversion.h"
 #include "portable.h"
 #include "zlib/zlib.h"
-#include "lodepng/lodepng.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CORONA_PNG_SSE2 1
+#endif
 
 namespace Corona {
 
-    class PngParser : implements ImageParser 
+    // Decodes PNG images of every color type, bit depth and interlace method
+    // to RGBA8 on zlib's inflate. Rows are inflated and unfiltered one at a
+    // time and converted straight into the destination; 8 bit RGBA rows are
+    // even unfiltered in place there. 16 bit samples keep their high byte.
+    // Rows of whole byte samples convert through PixelConversion.
+    class PngParser : implements ImageParser
     {
-    protected:
-        uint16_t m_Width;
-        uint16_t m_Height;
-        uint8_t m_BitDepth;
-        uint8_t m_ColorType;
-        uint8_t m_CompressionMethod;
-        uint8_t m_FilterMethod;
-        uint8_t m_InterlaceMethod;
-        int32_t m_ScanLineSize;
-        uint8_t m_BytesPerPixel;
-
     public:
-        Image Parse(Buffer& buf) override 
+        struct Header
         {
-            Image m_Img;
+            uint32_t width;
+            uint32_t height;
+            uint8_t  bit_depth;
+            uint8_t  color_type;    // 0 gray, 2 RGB, 3 palette, 4 gray alpha, 6 RGBA
+            uint8_t  interlace;     // 0 none, 1 Adam7
+        };
 
-            const unsigned char* pData = buf.GetData();
-            size_t size = (size_t)buf.GetDataSize();
-
-            std::vector<unsigned char> image;
-            unsigned int width, height;
-            lodepng::State state; //optionally customize this one
-            unsigned int error = lodepng::decode(image, width, height, state, pData, size);
-
-            bool imageDataStarted = false;
-            bool imageDataEnded = false;
-            uint8_t* imageDataStartPos = nullptr;
-            uint8_t* imageDataEndPos = nullptr;
-
-            m_Width = width;
-            m_Height = height;
-            m_BitDepth = state.info_raw.bitdepth;
-            m_ColorType = state.info_raw.colortype;
-            m_CompressionMethod = state.info_png.compression_method;
-            m_FilterMethod = state.info_png.filter_method;
-            m_InterlaceMethod = state.info_png.interlace_method;
-
-            switch (m_ColorType) {
-                case 0:  // grayscale
-                    m_BytesPerPixel = (m_BitDepth + 7) >> 3;
-                    switch (m_BytesPerPixel) {
-                        case 1:
-                            m_Img.pixel_format = PIXEL_FORMAT::R8;
-                            break;
-                        case 2:
-                            m_Img.pixel_format = PIXEL_FORMAT::R16;
-                            break;
-                        case 4:
-                            m_Img.pixel_format = PIXEL_FORMAT::R32;
-                            break;
-                        default:
-                            assert(0);
-                    }
-                    break;
-                case 2:  // rgb true color
-                    m_BytesPerPixel = (m_BitDepth * 3 + 7) >> 3;
-                    switch (m_BytesPerPixel) {
-                        case 3:
-                            m_Img.pixel_format = PIXEL_FORMAT::RGB8;
-                            break;
-                        case 6:
-                            m_Img.pixel_format = PIXEL_FORMAT::RGB16;
-                            break;
-                        case 12:
-                            m_Img.pixel_format = PIXEL_FORMAT::RGB32;
-                            break;
-                        default:
-                            assert(0);
-                    }
+        // of the rows of the decoded image, in bytes
+        void SetPitchAlignment(size_t alignment) { m_szPitchAlignment = alignment; }
+
+        // reads the IHDR chunk, false when the data is no PNG this parser decodes
+        static bool ReadHeader(const BufferView& buf, Header& header)
+        {
+            static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            const uint8_t* p = buf.GetData();
+            if (buf.GetDataSize() < 33 || memcmp(p, signature, 8) || ReadBE32(p + 8) != 13 || memcmp(p + 12, "IHDR", 4))
+                return false;
+
+            header.width = ReadBE32(p + 16);
+            header.height = ReadBE32(p + 20);
+            header.bit_depth = p[24];
+            header.color_type = p[25];
+            header.interlace = p[28];
+
+            uint8_t depth = header.bit_depth;
+            bool valid_depth = false;
+            switch (header.color_type)
+            {
+                case 0:
+                    valid_depth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
                     break;
-                case 3:  // indexed
-                    m_BytesPerPixel = (m_BitDepth + 7) >> 3;
-                    std::cerr
-                        << "Color Type 3 is not supported yet: "
-                        << m_ColorType << std::endl;
-                    assert(0);
+                case 3:
+                    valid_depth = depth == 1 || depth == 2 || depth == 4 || depth == 8;
                     break;
-                case 4:  // grayscale with alpha
-                    m_BytesPerPixel = (m_BitDepth * 2 + 7) >> 3;
-                    std::cerr
-                        << "Color Type 4 is not supported yet: "
-                        << m_ColorType << std::endl;
-                    assert(0);
+                case 2:
+                case 4:
+                case 6:
+                    valid_depth = depth == 8 || depth == 16;
                     break;
-                case 6:  // RGBA
-                    m_BytesPerPixel = (m_BitDepth * 4 + 7) >> 3;
-                    switch (m_BytesPerPixel) {
-                        case 4:
-                            m_Img.pixel_format = PIXEL_FORMAT::RGBA8;
-                            break;
-                        case 8:
-                            m_Img.pixel_format = PIXEL_FORMAT::RGBA16;
-                            break;
-                        case 16:
-                            m_Img.pixel_format = PIXEL_FORMAT::RGBA32;
-                            break;
-                        default:
-                            assert(0);
+            }
+
+            // compression and filter method 0 are the only ones there are
+            return valid_depth && p[26] == 0 && p[27] == 0 && header.interlace <= 1 &&
+                   header.width && header.height && header.width <= (1u << 24) && header.height <= (1u << 24);
+        }
+
+        // Decodes into rows of width * 4 bytes, pitch bytes apart, false when
+        // the data is broken. Rows not reached by then are left as they were.
+        bool Decode(const BufferView& buf, uint8_t* pDest, size_t pitch)
+        {
+            Header header;
+            if (!ReadHeader(buf, header)) return false;
+
+            m_Header = header;
+            uint32_t channels = header.color_type == 2 ? 3 : header.color_type == 4 ? 2 : header.color_type == 6 ? 4 : 1;
+            m_nPixelBits = channels * header.bit_depth;
+            m_bHasKey = false;
+            for (int i = 0; i < 256; i++)
+            {
+                m_Palette[i][0] = m_Palette[i][1] = m_Palette[i][2] = 0;
+                m_Palette[i][3] = 0xFF;
+            }
+
+            // the image data may be split over any number of IDAT chunks
+            std::vector<std::pair<const uint8_t*, uint32_t>> idat;
+            const uint8_t* p = buf.GetData();
+            size_t size = buf.GetDataSize();
+            for (size_t offset = 8; offset + 12 <= size; )
+            {
+                uint32_t length = ReadBE32(p + offset);
+                const uint8_t* type = p + offset + 4;
+                const uint8_t* data = p + offset + 8;
+                if (length > size - offset - 12) return false;
+
+                if (!memcmp(type, "IDAT", 4))
+                {
+                    idat.emplace_back(data, length);
+                }
+                else if (!memcmp(type, "PLTE", 4))
+                {
+                    for (uint32_t i = 0; i < length / 3 && i < 256; i++)
+                    {
+                        m_Palette[i][0] = data[i * 3];
+                        m_Palette[i][1] = data[i * 3 + 1];
+                        m_Palette[i][2] = data[i * 3 + 2];
+                    }
+                }
+                else if (!memcmp(type, "tRNS", 4))
+                {
+                    // palette alphas, or the one gray or RGB value that is transparent
+                    if (header.color_type == 3)
+                    {
+                        for (uint32_t i = 0; i < length && i < 256; i++) m_Palette[i][3] = data[i];
+                    }
+                    else if (header.color_type == 0 && length >= 2)
+                    {
+                        m_bHasKey = true;
+                        m_Key[0] = m_Key[1] = m_Key[2] = (uint16_t)(data[0] << 8 | data[1]);
+                    }
+                    else if (header.color_type == 2 && length >= 6)
+                    {
+                        m_bHasKey = true;
+                        for (int i = 0; i < 3; i++) m_Key[i] = (uint16_t)(data[i * 2] << 8 | data[i * 2 + 1]);
                     }
+                }
+                else if (!memcmp(type, "IEND", 4))
+                {
                     break;
-                default:
-                    std::cerr
-                        << "Unkown Color Type: " << m_ColorType
-                        << std::endl;
-                    assert(0);
+                }
+                offset += 12 + size_t(length);
+            }
+            if (idat.empty()) return false;
+
+            z_stream stream = {};
+            if (inflateInit(&stream) != Z_OK) return false;
+            size_t next_idat = 0;
+
+            // inflates exactly size bytes, taking in the IDAT chunks as needed
+            auto inflate_to = [&](uint8_t* out, size_t size) {
+                stream.next_out = out;
+                stream.avail_out = (uInt)size;
+                while (stream.avail_out)
+                {
+                    if (!stream.avail_in)
+                    {
+                        if (next_idat == idat.size()) return false;
+                        stream.next_in = const_cast<Bytef*>(idat[next_idat].first);
+                        stream.avail_in = idat[next_idat].second;
+                        next_idat++;
+                        continue;
+                    }
+                    int ret = inflate(&stream, Z_NO_FLUSH);
+                    if (ret == Z_STREAM_END) return stream.avail_out == 0;
+                    if (ret != Z_OK && ret != Z_BUF_ERROR) return false;
+                }
+                return true;
+            };
+
+            static const uint32_t adam7_x[7] = { 0, 4, 0, 2, 0, 1, 0 };
+            static const uint32_t adam7_y[7] = { 0, 0, 4, 0, 2, 0, 1 };
+            static const uint32_t adam7_dx[7] = { 8, 8, 4, 4, 2, 2, 1 };
+            static const uint32_t adam7_dy[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+            uint32_t bpp = m_nPixelBits < 8 ? 1 : m_nPixelBits / 8;
+            size_t max_stride = (size_t(header.width) * m_nPixelBits + 7) / 8;
+            // 8 bit RGBA is what the destination holds, unfiltered right there
+            bool in_place = !header.interlace && header.color_type == 6 && header.bit_depth == 8;
+            std::vector<uint8_t> rows(in_place ? max_stride : 3 * max_stride, 0);
+            uint8_t* zeros = rows.data();
+            uint8_t* scratch[2] = { rows.data() + (in_place ? 0 : max_stride), rows.data() + (in_place ? 0 : 2 * max_stride) };
+
+            bool ok = true;
+            uint32_t pass_count = header.interlace ? 7 : 1;
+            for (uint32_t pass = 0; ok && pass < pass_count; pass++)
+            {
+                uint32_t x0 = header.interlace ? adam7_x[pass] : 0;
+                uint32_t y0 = header.interlace ? adam7_y[pass] : 0;
+                uint32_t dx = header.interlace ? adam7_dx[pass] : 1;
+                uint32_t dy = header.interlace ? adam7_dy[pass] : 1;
+                if (x0 >= header.width || y0 >= header.height) continue;
+                uint32_t pass_width = (header.width - x0 + dx - 1) / dx;
+                uint32_t pass_height = (header.height - y0 + dy - 1) / dy;
+                size_t stride = (size_t(pass_width) * m_nPixelBits + 7) / 8;
+
+                // the row above the first one is all zeros
+                const uint8_t* prev = zeros;
+                for (uint32_t y = 0; ok && y < pass_height; y++)
+                {
+                    uint8_t* dest_row = pDest + (y0 + size_t(y) * dy) * pitch;
+                    uint8_t* cur = in_place ? dest_row : scratch[y & 1];
+                    uint8_t filter;
+                    ok = inflate_to(&filter, 1) && inflate_to(cur, stride) && Unfilter(filter, cur, prev, stride, bpp);
+                    if (ok && !in_place) ConvertRow(cur, pass_width, dest_row + size_t(x0) * 4, size_t(dx) * 4);
+                    prev = cur;
+                }
             }
 
-            assert(m_Img.pixel_format != PIXEL_FORMAT::UNKNOWN);
+            // reads on to the checksum at the end of the stream, broken data
+            // leaves a message. An end cut off is let go.
+            if (ok)
+            {
+                uint8_t extra;
+                inflate_to(&extra, 1);
+                ok = stream.msg == nullptr;
+            }
+
+            inflateEnd(&stream);
+            return ok;
+        }
+
+        Image Parse(const BufferView& buf) override
+        {
+            Image m_Img;
+            Header header;
+            if (!ReadHeader(buf, header)) return m_Img;
 
-            m_ScanLineSize = m_BytesPerPixel * m_Width;
+            m_Img.Width = header.width;
+            m_Img.Height = header.height;
+            m_Img.pixel_format = PIXEL_FORMAT::RGBA8;
+            m_Img.bitcount = 32;
+            m_Img.bitdepth = 8;
+            m_Img.pitch = ALIGN((size_t)m_Img.Width * 4, m_szPitchAlignment);  // for GPU address alignment
+            m_Img.data_size = m_Img.pitch * m_Img.Height;
 
-            m_Img.Width = m_Width;
-            m_Img.Height = m_Height;
-            m_Img.bitcount = m_BytesPerPixel * 8;
-            m_Img.bitdepth = m_BitDepth;
-            m_Img.pitch = ALIGN(m_Width * m_BytesPerPixel,
-                                4);  // for GPU address alignment
-            m_Img.data_size = (size_t)m_Img.pitch * m_Img.Height;
-            // TODO: you need to have image copied to pass in to m_Img.data or will get access violation
-            uint8_t* data = new uint8_t[image.size()];
-            for (int i = 0; i < image.size(); i++)
+            uint8_t* data = new uint8_t[m_Img.data_size];
+            if (!Decode(buf, data, m_Img.pitch))
             {
-                data[i] = image[i];
+                delete[] data;
+                return Image();
             }
             m_Img.data = data;
 
             return m_Img;
         }
+
+    private:
+        static uint32_t ReadBE32(const uint8_t* p)
+        {
+            return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+        }
+
+        static uint8_t Paeth(int a, int b, int c)
+        {
+            int pa = abs(b - c);
+            int pb = abs(a - c);
+            int pc = abs(a + b - 2 * c);
+            return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+        }
+
+        // reverses the filter of a row in place, false for an unknown filter.
+        // bpp is the distance in bytes to the same sample of the pixel to the left.
+        static bool Unfilter(uint8_t filter, uint8_t* cur, const uint8_t* prev, size_t size, uint32_t bpp)
+        {
+            switch (filter)
+            {
+                case 0:
+                    return true;
+                case 2:
+                    UnfilterUp(cur, prev, size);
+                    return true;
+                case 1:
+                case 3:
+                case 4:
+#ifdef CORONA_PNG_SSE2
+                    // one pixel per register, for the formats where the left
+                    // neighbour is a whole pixel of 3 to 8 bytes
+                    switch (bpp)
+                    {
+                        case 3: UnfilterPixels<3>(filter, cur, prev, size); return true;
+                        case 4: UnfilterPixels<4>(filter, cur, prev, size); return true;
+                        case 6: UnfilterPixels<6>(filter, cur, prev, size); return true;
+                        case 8: UnfilterPixels<8>(filter, cur, prev, size); return true;
+                    }
+#endif
+                    UnfilterBytes(filter, cur, prev, size, bpp);
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        static void UnfilterUp(uint8_t* cur, const uint8_t* prev, size_t size)
+        {
+            size_t i = 0;
+#ifdef CORONA_PNG_SSE2
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(cur + i), _mm_add_epi8(x, b));
+            }
+#endif
+            for (; i < size; i++) cur[i] = (uint8_t)(cur[i] + prev[i]);
+        }
+
+        static void UnfilterBytes(uint8_t filter, uint8_t* cur, const uint8_t* prev, size_t size, uint32_t bpp)
+        {
+            size_t first = bpp < size ? bpp : size;
+            switch (filter)
+            {
+                case 1:
+                    for (size_t i = bpp; i < size; i++) cur[i] = (uint8_t)(cur[i] + cur[i - bpp]);
+                    break;
+                case 3:
+                    for (size_t i = 0; i < first; i++) cur[i] = (uint8_t)(cur[i] + (prev[i] >> 1));
+                    for (size_t i = bpp; i < size; i++) cur[i] = (uint8_t)(cur[i] + ((cur[i - bpp] + prev[i]) >> 1));
+                    break;
+                case 4:
+                    for (size_t i = 0; i < first; i++) cur[i] = (uint8_t)(cur[i] + prev[i]);
+                    for (size_t i = bpp; i < size; i++) cur[i] = (uint8_t)(cur[i] + Paeth(cur[i - bpp], prev[i], prev[i - bpp]));
+                    break;
+            }
+        }
+
+#ifdef CORONA_PNG_SSE2
+        template <uint32_t BPP>
+        static __m128i LoadPixel(const uint8_t* p)
+        {
+            uint8_t bytes[8] = {};
+            memcpy(bytes, p, BPP);
+            return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes));
+        }
+
+        template <uint32_t BPP>
+        static void StorePixel(uint8_t* p, __m128i x)
+        {
+            uint8_t bytes[8];
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(bytes), x);
+            memcpy(p, bytes, BPP);
+        }
+
+        // Sub, Average and Paeth depend on the pixel to the left, so the
+        // samples of one pixel go through the register together
+        template <uint32_t BPP>
+        static void UnfilterPixels(uint8_t filter, uint8_t* cur, const uint8_t* prev, size_t size)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i a = zero;
+            __m128i c = zero;
+            if (filter == 1)
+            {
+                for (size_t i = 0; i + BPP <= size; i += BPP)
+                {
+                    a = _mm_add_epi8(LoadPixel<BPP>(cur + i), a);
+                    StorePixel<BPP>(cur + i, a);
+                }
+            }
+            else if (filter == 3)
+            {
+                const __m128i one = _mm_set1_epi8(1);
+                for (size_t i = 0; i + BPP <= size; i += BPP)
+                {
+                    // the rounding average minus the bit it rounded up
+                    __m128i b = LoadPixel<BPP>(prev + i);
+                    __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+                    a = _mm_add_epi8(LoadPixel<BPP>(cur + i), average);
+                    StorePixel<BPP>(cur + i, a);
+                }
+            }
+            else
+            {
+                // in 16 bit lanes, the distances do not fit into 8 bits
+                for (size_t i = 0; i + BPP <= size; i += BPP)
+                {
+                    __m128i b = _mm_unpacklo_epi8(LoadPixel<BPP>(prev + i), zero);
+                    __m128i pa = _mm_sub_epi16(b, c);
+                    __m128i pb = _mm_sub_epi16(a, c);
+                    __m128i pc = _mm_add_epi16(pa, pb);
+                    pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+                    pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+                    pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+                    // ties go to a, then to b
+                    __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                    __m128i use_a = _mm_cmpeq_epi16(smallest, pa);
+                    __m128i use_b = _mm_andnot_si128(use_a, _mm_cmpeq_epi16(smallest, pb));
+                    __m128i use_c = _mm_andnot_si128(_mm_or_si128(use_a, use_b), _mm_set1_epi16(-1));
+                    __m128i predicted = _mm_or_si128(_mm_or_si128(_mm_and_si128(use_a, a), _mm_and_si128(use_b, b)),
+                                                     _mm_and_si128(use_c, c));
+
+                    __m128i x = _mm_add_epi8(LoadPixel<BPP>(cur + i), _mm_packus_epi16(predicted, predicted));
+                    StorePixel<BPP>(cur + i, x);
+                    a = _mm_unpacklo_epi8(x, zero);
+                    c = b;
+                }
+            }
+        }
+#endif
+
+        // sample i of a row of packed samples below 8 bits
+        uint32_t PackedSample(const uint8_t* src, uint32_t i) const
+        {
+            uint32_t depth = m_Header.bit_depth;
+            uint32_t bit = i * depth;
+            return (src[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+        }
+
+        // count pixels of an unfiltered row to RGBA8, step bytes apart
+        void ConvertRow(const uint8_t* src, uint32_t count, uint8_t* dst, size_t step) const
+        {
+            uint32_t depth = m_Header.bit_depth;
+
+            // whole bytes per sample and no transparent key, the batch
+            // conversion does these
+            uint8_t color_type = m_Header.color_type;
+            if (step == 4 && depth >= 8 && color_type != 3 && !m_bHasKey && !(color_type == 6 && depth == 8))
+            {
+                uint32_t channels = color_type == 2 ? 3 : color_type == 4 ? 2 : color_type == 6 ? 4 : 1;
+                ExpandToRGBA8(src, 0, dst, 0, count, 1, channels, depth, true, true);
+                return;
+            }
+
+            switch (m_Header.color_type)
+            {
+                case 0:
+                    for (uint32_t i = 0; i < count; i++, dst += step)
+                    {
+                        uint32_t value = depth == 16 ? uint32_t(src[i * 2]) << 8 | src[i * 2 + 1] :
+                                         depth == 8 ? src[i] : PackedSample(src, i);
+                        uint8_t gray = depth == 16 ? src[i * 2] : depth == 8 ? src[i] : (uint8_t)(value * 255 / ((1u << depth) - 1));
+                        dst[0] = dst[1] = dst[2] = gray;
+                        dst[3] = m_bHasKey && value == m_Key[0] ? 0 : 0xFF;
+                    }
+                    break;
+                case 2:
+                    if (depth == 8)
+                    {
+                        for (uint32_t i = 0; i < count; i++, src += 3, dst += step)
+                        {
+                            dst[0] = src[0];
+                            dst[1] = src[1];
+                            dst[2] = src[2];
+                            dst[3] = m_bHasKey && src[0] == m_Key[0] && src[1] == m_Key[1] && src[2] == m_Key[2] ? 0 : 0xFF;
+                        }
+                    }
+                    else
+                    {
+                        for (uint32_t i = 0; i < count; i++, src += 6, dst += step)
+                        {
+                            dst[0] = src[0];
+                            dst[1] = src[2];
+                            dst[2] = src[4];
+                            dst[3] = m_bHasKey && (src[0] << 8 | src[1]) == m_Key[0] && (src[2] << 8 | src[3]) == m_Key[1] &&
+                                     (src[4] << 8 | src[5]) == m_Key[2] ? 0 : 0xFF;
+                        }
+                    }
+                    break;
+                case 3:
+                    for (uint32_t i = 0; i < count; i++, dst += step)
+                    {
+                        memcpy(dst, m_Palette[depth == 8 ? src[i] : PackedSample(src, i)], 4);
+                    }
+                    break;
+                case 4:
+                    for (uint32_t i = 0; i < count; i++, dst += step)
+                    {
+                        const uint8_t* pixel = src + i * (depth / 4);
+                        dst[0] = dst[1] = dst[2] = pixel[0];
+                        dst[3] = pixel[depth / 8];
+                    }
+                    break;
+                case 6:
+                    if (depth == 8 && step == 4)
+                    {
+                        memcpy(dst, src, size_t(count) * 4);
+                        break;
+                    }
+                    for (uint32_t i = 0; i < count; i++, dst += step)
+                    {
+                        const uint8_t* pixel = src + i * (depth / 2);
+                        for (int k = 0; k < 4; k++) dst[k] = pixel[k * (depth / 8)];
+                    }
+                    break;
+            }
+        }
+
+        size_t m_szPitchAlignment = 4;
+
+        // of the image being decoded
+        Header m_Header = {};
+        uint32_t m_nPixelBits = 0;
+        uint8_t m_Palette[256][4];
+        bool m_bHasKey = false;
+        uint16_t m_Key[3] = {};
     };
 }  // namespace Corona
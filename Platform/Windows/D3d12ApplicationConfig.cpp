@@ -9,6 +9,7 @@ namespace Corona
     GraphicsManager* g_pGraphicsManager = static_cast<GraphicsManager*>(new D3d12GraphicsManager);
     MemoryManager*   g_pMemoryManager   = static_cast<MemoryManager*>(new MemoryManager);
     AssetLoader*     g_pAssetLoader     = static_cast<AssetLoader*>(new AssetLoader);
+    ImageCache*      g_pImageCache      = static_cast<ImageCache*>(new ImageCache);
     SceneManager*    g_pSceneManager    = static_cast<SceneManager*>(new SceneManager);
     InputManager*    g_pInputManager    = static_cast<InputManager*>(new InputManager);
 #ifdef _DEBUG
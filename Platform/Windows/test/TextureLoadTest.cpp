@@ -42,6 +42,7 @@ namespace Corona {
     GraphicsManager* g_pGraphicsManager = static_cast<GraphicsManager*>(new TestGraphicsManager);
     MemoryManager*   g_pMemoryManager   = static_cast<MemoryManager*>(new MemoryManager);
     AssetLoader*     g_pAssetLoader     = static_cast<AssetLoader*>(new AssetLoader);
+    ImageCache*      g_pImageCache      = static_cast<ImageCache*>(new ImageCache);
     SceneManager*    g_pSceneManager    = static_cast<SceneManager*>(new SceneManager);
     InputManager*    g_pInputManager    = static_cast<InputManager*>(new InputManager);
 }
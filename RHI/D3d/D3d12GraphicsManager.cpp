@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <objbase.h>
 #include "D3d12GraphicsManager.h"
 #include "WindowsApplication.h"
 #include "SceneManager.h"
 #include "AssetLoader.h"
+#include "PixelConversion.h"
 
 using namespace std;
 namespace Corona
@@ -620,135 +622,156 @@ namespace Corona
         auto it = m_TextureIndex.find(texture.GetName());
         if (it == m_TextureIndex.end())
         {
-            auto& image = texture.GetTextureImage();
-
-            // Describe and create a Texture2D.
-            D3D12_HEAP_PROPERTIES prop = {};
-            prop.Type = D3D12_HEAP_TYPE_DEFAULT;
-            prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-            prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-            prop.CreationNodeMask = 1;
-            prop.VisibleNodeMask = 1;
-
-            D3D12_RESOURCE_DESC textureDesc = {};
-            textureDesc.MipLevels = 1;
-            textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-            textureDesc.Width = image.Width;
-            textureDesc.Height = image.Height;
-            textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-            textureDesc.DepthOrArraySize = 1;
-            textureDesc.SampleDesc.Count = 1;
-            textureDesc.SampleDesc.Quality = 0;
-            textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-
+            int32_t texture_id = static_cast<uint32_t>(m_TextureIndex.size());
             ID3D12Resource* pTextureBuffer;
             ID3D12Resource* pTextureUploadHeap;
-
-            if (FAILED(hr = m_pDev->CreateCommittedResource(
-                &prop,
-                D3D12_HEAP_FLAG_NONE,
-                &textureDesc,
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                nullptr,
-                IID_PPV_ARGS(&pTextureBuffer))))
-            {
-                return hr;
-            }
-
-            const UINT subresourceCount = textureDesc.DepthOrArraySize * textureDesc.MipLevels;
-            const UINT64 uploadBufferSize = GetRequiredIntermediateSize(pTextureBuffer, 0, subresourceCount);
-
-            prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-
-            D3D12_RESOURCE_DESC resourceDesc = {};
-            resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-            resourceDesc.Alignment = 0;
-            resourceDesc.Width = uploadBufferSize;
-            resourceDesc.Height = 1;
-            resourceDesc.DepthOrArraySize = 1;
-            resourceDesc.MipLevels = 1;
-            resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
-            resourceDesc.SampleDesc.Count = 1;
-            resourceDesc.SampleDesc.Quality = 0;
-            resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-            resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-            if (FAILED(hr = m_pDev->CreateCommittedResource(
-                &prop,
-                D3D12_HEAP_FLAG_NONE,
-                &resourceDesc,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&pTextureUploadHeap)
-            )))
+            if (FAILED(hr = UploadTexture(texture.GetTextureImage(), texture_id, pTextureBuffer, pTextureUploadHeap)))
             {
                 return hr;
             }
 
-            // Copy data to the intermediate upload heap and then schedule a copy 
-            // from the upload heap to the Texture2D.
-            D3D12_SUBRESOURCE_DATA textureData = {};
-            if (image.bitcount == 24)
-            {
-                // DXGI does not have 24bit formats so we have to extend it to 32bit
-                uint32_t new_pitch = (uint32_t)image.pitch / 3 * 4;
-                size_t data_size = new_pitch * image.Height;
-                void* data = g_pMemoryManager->Allocate(data_size);
-                uint8_t* buf = reinterpret_cast<uint8_t*>(data);
-                uint8_t* src = reinterpret_cast<uint8_t*>(image.data);
-                for (uint32_t row = 0; row < image.Height; row++) {
-                    buf = reinterpret_cast<uint8_t*>(data) + row * new_pitch;
-                    src = reinterpret_cast<uint8_t*>(image.data) + row * image.pitch;
-                    for (uint32_t col = 0; col < image.Width; col++) {
-                        *(uint32_t*)buf = *(uint32_t*)src;
-                        buf[3] = 0;  // set alpha to 0
-                        buf += 4;
-                        src += 3;
-                    }
-                }
-                // we do not need to free the old data because the old data is still referenced by the
-                // SceneObject
-                // g_pMemoryManager->Free(image.data, image.data_size);
-                image.data = (uint8_t*)data;
-                image.data_size = data_size;
-                image.pitch = new_pitch;
-            }
-
-            textureData.pData = image.data;
-            textureData.RowPitch = image.pitch;
-            textureData.SlicePitch = image.pitch * image.Height;
-
-            UpdateSubresources(m_pCommandList, pTextureBuffer, pTextureUploadHeap, 0, 0, subresourceCount, &textureData);
-            D3D12_RESOURCE_BARRIER barrier = {};
-            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            barrier.Transition.pResource = pTextureBuffer;
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
-            barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            m_pCommandList->ResourceBarrier(1, &barrier);
-
-            // Describe and create a SRV for the texture.
-            D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-            srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-            srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-            srvDesc.Texture2D.MipLevels = -1;
-            srvDesc.Texture2D.MostDetailedMip = 0;
-            D3D12_CPU_DESCRIPTOR_HANDLE srvHandle;
-            // TODO
-            int32_t texture_id = static_cast<uint32_t>(m_TextureIndex.size());
-            // int32_t texture_id = 1;
-            srvHandle.ptr = m_pCbvHeap->GetCPUDescriptorHandleForHeapStart().ptr + (kTextureDescStartIndex + texture_id) * m_nCbvSrvDescriptorSize;
-            m_pDev->CreateShaderResourceView(pTextureBuffer, &srvDesc, srvHandle);
             // TODO: 为了应对大于五张贴图的情况，必须要对进入heap的texture blob的index进行记录
             // 不然要不就是贴图不匹配，要不就是多了或者少了贴图
             m_TextureIndex[texture.GetName()] = texture_id;
 
             m_Buffers.push_back(pTextureUploadHeap);
-            m_Textures.push_back(pTextureBuffer);
+            m_Textures[texture.GetName()] = pTextureBuffer;
+        }
+
+        return hr;
+    }
+
+    HRESULT D3d12GraphicsManager::UploadTexture(const Image& image, int32_t texture_id, ID3D12Resource*& pTextureBuffer, ID3D12Resource*& pTextureUploadHeap)
+    {
+        HRESULT hr = S_OK;
+        pTextureBuffer = nullptr;
+        pTextureUploadHeap = nullptr;
+
+        // Describe and create a Texture2D.
+        D3D12_HEAP_PROPERTIES prop = {};
+        prop.Type = D3D12_HEAP_TYPE_DEFAULT;
+        prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        prop.CreationNodeMask = 1;
+        prop.VisibleNodeMask = 1;
+
+        D3D12_RESOURCE_DESC textureDesc = {};
+        textureDesc.MipLevels = static_cast<UINT16>(image.GetMipLevels());
+        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        textureDesc.Width = image.Width;
+        textureDesc.Height = image.Height;
+        textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+        textureDesc.DepthOrArraySize = 1;
+        textureDesc.SampleDesc.Count = 1;
+        textureDesc.SampleDesc.Quality = 0;
+        textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+        if (FAILED(hr = m_pDev->CreateCommittedResource(
+            &prop,
+            D3D12_HEAP_FLAG_NONE,
+            &textureDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&pTextureBuffer))))
+        {
+            return hr;
+        }
+
+        const UINT subresourceCount = textureDesc.DepthOrArraySize * textureDesc.MipLevels;
+        const UINT64 uploadBufferSize = GetRequiredIntermediateSize(pTextureBuffer, 0, subresourceCount);
+
+        prop.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+        D3D12_RESOURCE_DESC resourceDesc = {};
+        resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        resourceDesc.Alignment = 0;
+        resourceDesc.Width = uploadBufferSize;
+        resourceDesc.Height = 1;
+        resourceDesc.DepthOrArraySize = 1;
+        resourceDesc.MipLevels = 1;
+        resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+        resourceDesc.SampleDesc.Count = 1;
+        resourceDesc.SampleDesc.Quality = 0;
+        resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+        if (FAILED(hr = m_pDev->CreateCommittedResource(
+            &prop,
+            D3D12_HEAP_FLAG_NONE,
+            &resourceDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&pTextureUploadHeap)
+        )))
+        {
+            SafeRelease(&pTextureBuffer);
+            return hr;
+        }
+
+        // Copy data to the intermediate upload heap and then schedule a copy 
+        // from the upload heap to the Texture2D. Every mip level is a subresource.
+        std::vector<D3D12_SUBRESOURCE_DATA> subresources(subresourceCount);
+        for (UINT level = 0; level < subresourceCount; level++)
+        {
+            D3D12_SUBRESOURCE_DATA& textureData = subresources[level];
+            if (image.mipmaps.empty())
+            {
+                textureData.pData = image.data;
+                textureData.RowPitch = image.pitch;
+                textureData.SlicePitch = image.pitch * image.Height;
+            }
+            else
+            {
+                const Mipmap& mip = image.mipmaps[level];
+                textureData.pData = image.data + mip.offset;
+                textureData.RowPitch = mip.pitch;
+                textureData.SlicePitch = mip.data_size;
+            }
+        }
+        D3D12_SUBRESOURCE_DATA& textureData = subresources[0];
+
+        // the image is shared through the image cache, so it is left untouched
+        void* expanded = nullptr;
+        size_t expanded_size = 0;
+        if (image.pixel_format != PIXEL_FORMAT::RGBA8 && CanConvertToRGBA8(image.pixel_format))
+        {
+            // the texture is RGBA8, e.g. DXGI does not have 24bit formats.
+            // Images with mips are RGBA8 already.
+            uint32_t new_pitch = image.Width * 4;
+            expanded_size = (size_t)new_pitch * image.Height;
+            expanded = g_pMemoryManager->Allocate(expanded_size);
+            ConvertToRGBA8(image.pixel_format, image.data, (ptrdiff_t)image.pitch,
+                           reinterpret_cast<uint8_t*>(expanded), new_pitch, image.Width, image.Height);
+
+            textureData.pData = expanded;
+            textureData.RowPitch = new_pitch;
+            textureData.SlicePitch = expanded_size;
         }
 
+        // copies into the upload heap right away
+        UpdateSubresources(m_pCommandList, pTextureBuffer, pTextureUploadHeap, 0, 0, subresourceCount, subresources.data());
+        if (expanded) g_pMemoryManager->Free(expanded, expanded_size);
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.pResource = pTextureBuffer;
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        m_pCommandList->ResourceBarrier(1, &barrier);
+
+        // Describe and create a SRV for the texture.
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = -1;
+        srvDesc.Texture2D.MostDetailedMip = 0;
+        D3D12_CPU_DESCRIPTOR_HANDLE srvHandle;
+        srvHandle.ptr = m_pCbvHeap->GetCPUDescriptorHandleForHeapStart().ptr + (kTextureDescStartIndex + texture_id) * m_nCbvSrvDescriptorSize;
+        m_pDev->CreateShaderResourceView(pTextureBuffer, &srvDesc, srvHandle);
+
         return hr;
     }
 
@@ -1049,6 +1072,8 @@ namespace Corona
         // load the shaders
         Buffer vertexShader = g_pAssetLoader->SyncOpenAndReadBinary(vsFilename);
         Buffer pixelShader = g_pAssetLoader->SyncOpenAndReadBinary(fsFilename);
+        WatchShaderFile(vsFilename);
+        WatchShaderFile(fsFilename);
 
         D3D12_SHADER_BYTECODE vertexShaderByteCode;
         vertexShaderByteCode.pShaderBytecode = vertexShader.GetData();
@@ -1142,6 +1167,8 @@ namespace Corona
         // load the shaders
         vertexShader = g_pAssetLoader->SyncOpenAndReadBinary(vsFilename);
         pixelShader = g_pAssetLoader->SyncOpenAndReadBinary(fsFilename);
+        WatchShaderFile(vsFilename);
+        WatchShaderFile(fsFilename);
 
         vertexShaderByteCode.pShaderBytecode = vertexShader.GetData();
         vertexShaderByteCode.BytecodeLength = vertexShader.GetDataSize();
@@ -1235,9 +1262,9 @@ namespace Corona
         int32_t n = 0;
         uint32_t startIndex = 0; // 暂且没有那么复杂的模型，不用考虑这里超出uint32_t表示范围的情况
         uint32_t startVertex = 0;
-        for (auto _it : scene.GeometryNodes)
+        for (auto hGeometryNode : scene.GeometryNodes)
         {
-            auto pGeometryNode = _it.second.lock();
+            auto pGeometryNode = scene.GetNode(hGeometryNode);
     
             if (pGeometryNode)
             {
@@ -1275,7 +1302,7 @@ namespace Corona
                     dbc.material = material;
                 }
 
-                dbc.node = pGeometryNode;
+                dbc.node = hGeometryNode;
 
                 m_DrawBatchContext.push_back(dbc);
 
@@ -1334,7 +1361,7 @@ namespace Corona
 		}
 		m_Buffers.clear();
 		for (auto p : m_Textures) {
-			SafeRelease(&p);
+			SafeRelease(&p.second);
 		}
 		m_Textures.clear();
 		m_TextureIndex.clear();
@@ -1344,6 +1371,173 @@ namespace Corona
 	}
 
 
+    HRESULT D3d12GraphicsManager::BeginUpload()
+    {
+        HRESULT hr;
+
+        // the last frame may still use what is about to be replaced
+        if (FAILED(hr = WaitForPreviousFrame()))
+        {
+            return hr;
+        }
+
+        if (FAILED(hr = m_pCommandAllocator->Reset()))
+        {
+            return hr;
+        }
+
+        return m_pCommandList->Reset(m_pCommandAllocator, m_pPipelineState["opaque"]);
+    }
+
+    HRESULT D3d12GraphicsManager::EndUpload()
+    {
+        HRESULT hr;
+
+        if (SUCCEEDED(hr = m_pCommandList->Close()))
+        {
+            ID3D12CommandList* ppCommandLists[] = { m_pCommandList };
+            m_pCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+            hr = WaitForPreviousFrame();
+        }
+
+        return hr;
+    }
+
+    bool D3d12GraphicsManager::UpdateTexture(SceneObjectTexture& texture)
+    {
+        auto it = m_TextureIndex.find(texture.GetName());
+        if (!m_pFence || it == m_TextureIndex.end())
+        {
+            return false;
+        }
+
+        if (FAILED(BeginUpload()))
+        {
+            return false;
+        }
+
+        // the new texture takes the descriptor of the old one, the draw calls stay as they are
+        ID3D12Resource* pTextureBuffer;
+        ID3D12Resource* pTextureUploadHeap;
+        HRESULT hr = UploadTexture(texture.GetTextureImage(), it->second, pTextureBuffer, pTextureUploadHeap);
+        if (FAILED(EndUpload()))
+        {
+            hr = E_FAIL;
+        }
+
+        SafeRelease(&pTextureUploadHeap);
+        if (FAILED(hr))
+        {
+            SafeRelease(&pTextureBuffer);
+            return false;
+        }
+
+        SafeRelease(&m_Textures[texture.GetName()]);
+        m_Textures[texture.GetName()] = pTextureBuffer;
+
+        return true;
+    }
+
+    bool D3d12GraphicsManager::UpdateGeometry(SceneObjectMesh& mesh)
+    {
+        // InitializeBuffers() makes one vertex and index buffer per batch
+        auto primitives = mesh.GetMesh();
+        if (!m_pFence || primitives.size() != 1)
+        {
+            return false;
+        }
+
+        if (FAILED(BeginUpload()))
+        {
+            return false;
+        }
+
+        auto& scene = g_pSceneManager->GetSceneForRendering();
+        size_t first = m_Buffers.size();
+        std::vector<D3D12_GPU_VIRTUAL_ADDRESS> replaced;
+        HRESULT hr = S_OK;
+        for (size_t i = 0; i < m_DrawBatchContext.size(); i++)
+        {
+            auto pNode = scene.GetNode(m_DrawBatchContext[i].node);
+            if (!pNode || pNode->pMesh.get() != &mesh)
+            {
+                continue;
+            }
+
+            // the views of the new buffers are appended, then take the place of the old ones
+            if (FAILED(hr = CreateVertexBuffer(primitives[0]->GetVertexData())) ||
+                FAILED(hr = CreateIndexBuffer(primitives[0]->GetIndexData())))
+            {
+                break;
+            }
+
+            replaced.push_back(m_VertexBufferView[i].BufferLocation);
+            replaced.push_back(m_IndexBufferView[i].BufferLocation);
+            m_VertexBufferView[i] = m_VertexBufferView.back();
+            m_VertexBufferView.pop_back();
+            m_IndexBufferView[i] = m_IndexBufferView.back();
+            m_IndexBufferView.pop_back();
+            m_DrawBatchContext[i].IndexCount = (uint32_t)primitives[0]->GetIndexCount();
+        }
+
+        if (FAILED(EndUpload()))
+        {
+            hr = E_FAIL;
+        }
+
+        // the copies are done, the upload heaps of the new buffers are not needed any more
+        std::vector<ID3D12Resource*> created(m_Buffers.begin() + first, m_Buffers.end());
+        m_Buffers.resize(first);
+        for (auto p : created)
+        {
+            D3D12_HEAP_PROPERTIES heap;
+            if (SUCCEEDED(p->GetHeapProperties(&heap, nullptr)) && heap.Type == D3D12_HEAP_TYPE_UPLOAD)
+            {
+                SafeRelease(&p);
+            }
+            else
+            {
+                m_Buffers.push_back(p);
+            }
+        }
+
+        // nor are the buffers replaced
+        for (auto it = m_Buffers.begin(); it != m_Buffers.end(); )
+        {
+            if (std::find(replaced.begin(), replaced.end(), (*it)->GetGPUVirtualAddress()) != replaced.end())
+            {
+                SafeRelease(&*it);
+                it = m_Buffers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        return SUCCEEDED(hr);
+    }
+
+    bool D3d12GraphicsManager::ReloadShaders()
+    {
+        if (!m_pFence)
+        {
+            return false;
+        }
+
+        // the last frame may still use the old pipeline states
+        WaitForPreviousFrame();
+        for (auto& it : m_pPipelineState)
+        {
+            SafeRelease(&it.second);
+        }
+
+        // the command list stays, PopulateCommandList() resets it with the new state
+        InitializeShaders();
+
+        return m_pPipelineState["opaque"] != nullptr && m_pPipelineState["debug"] != nullptr;
+    }
+
 	void D3d12GraphicsManager::Finalize()
 	{
         WaitForPreviousFrame();
@@ -1623,7 +1817,15 @@ namespace Corona
         PerBatchConstants pbc;
         memset(&pbc, 0x00, sizeof(pbc));
 
-        Matrix4X4f trans = m_DrawBatchContext[index].node->Transforms.matrix;
+        auto& scene = g_pSceneManager->GetSceneForRendering();
+        // the node was removed since the batch was made, its handle is stale
+        auto pNode = scene.GetNode(m_DrawBatchContext[index].node);
+        if (!pNode)
+        {
+            return false;
+        }
+
+        Matrix4X4f trans = pNode->Transforms.matrix;
         // 这里和GraphicsManager里面的操作一样，也需要转置
         Transpose(trans);
         pbc.objectMatrix = trans;
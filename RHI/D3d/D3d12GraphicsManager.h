@@ -39,6 +39,10 @@ namespace Corona
         void ClearShaders();
         void RenderBuffers();
 
+        bool UpdateTexture(SceneObjectTexture& texture) override;
+        bool UpdateGeometry(SceneObjectMesh& mesh) override;
+        bool ReloadShaders() override;
+
     private:
         HRESULT CreateDescriptorHeaps();
         HRESULT CreateRenderTarget();
@@ -46,6 +50,8 @@ namespace Corona
         HRESULT CreateGraphicsResources();
         HRESULT CreateSamplerBuffer();
         HRESULT CreateTextureBuffer(SceneObjectTexture& texture);
+        // records the upload on the command list and puts the SRV at the descriptor of texture_id
+        HRESULT UploadTexture(const Image& image, int32_t texture_id, ID3D12Resource*& pTextureBuffer, ID3D12Resource*& pTextureUploadHeap);
         HRESULT CreateConstantBuffer();
         // HRESULT CreateIndexBuffer(const Buffer& buffer);
         // HRESULT CreateVertexBuffer(const Buffer& buffer);
@@ -54,6 +60,9 @@ namespace Corona
         HRESULT CreateRootSignature();
         HRESULT WaitForPreviousFrame();
         HRESULT PopulateCommandList();
+        // uploads outside of InitializeBuffers(), the GPU is idle in between
+        HRESULT BeginUpload();
+        HRESULT EndUpload();
 
     private:
         static const uint32_t           kFrameCount  = 2;
@@ -85,7 +94,7 @@ namespace Corona
         uint32_t                        m_nCbvSrvDescriptorSize;
 
         std::vector<ID3D12Resource*>    m_Buffers;                          // the pointer to the vertex buffer
-        std::vector<ID3D12Resource*>    m_Textures;                          // the pointer to the vertex buffer
+        std::map<std::string, ID3D12Resource*>  m_Textures;                 // by the name in m_TextureIndex
         std::map<std::string, int32_t>  m_TextureIndex;
         std::vector<D3D12_VERTEX_BUFFER_VIEW>       m_VertexBufferView;                 // a view of the vertex buffer
         std::vector<D3D12_INDEX_BUFFER_VIEW>        m_IndexBufferView;                  // a view of the vertex buffer
@@ -115,7 +124,7 @@ namespace Corona
             uint32_t IndexCount;
             uint32_t StartIndexLocation;
             uint32_t BaseVertexLocation;
-            std::shared_ptr<SceneNode> node;
+            Handle<SceneNode> node;
             std::shared_ptr<SceneObjectMaterial> material;
         };
 
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "MemoryManager.h"
+#include "Buffer.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+struct alignas(64) CacheLine
+{
+    float data[16];
+};
+
+static void check_alignment(size_t size, size_t alignment)
+{
+    vector<void*> blocks;
+    for (int i = 0; i < 64; i++)
+    {
+        void* p = g_pMemoryManager->AllocateAligned(size, alignment);
+        if (reinterpret_cast<size_t>(p) & (alignment - 1))
+        {
+            printf("FAILED: size %zu alignment %zu got %p\n", size, alignment, p);
+            failures++;
+        }
+        memset(p, 0xAB, size);
+        blocks.push_back(p);
+    }
+
+    for (auto p : blocks)
+    {
+        g_pMemoryManager->FreeAligned(p, size, alignment);
+    }
+}
+
+static void run_checks()
+{
+    const size_t sizes[] = { 1, 4, 12, 16, 48, 64, 100, 256, 600, 1024, 1500, 65536 };
+    const size_t alignments[] = { 1, 4, 8, 16, 32, 64, 128, 256, 512, 4096 };
+
+    for (auto size : sizes)
+        for (auto alignment : alignments)
+            check_alignment(size, alignment);
+
+    CacheLine* pLine = g_pMemoryManager->New<CacheLine>();
+    if (reinterpret_cast<size_t>(pLine) & 63)
+    {
+        printf("FAILED: New<CacheLine> got %p\n", pLine);
+        failures++;
+    }
+    g_pMemoryManager->Delete(pLine);
+
+    Buffer buf(300, 16);
+    Buffer copy(buf);
+    if (reinterpret_cast<size_t>(copy.GetData()) & 15)
+    {
+        printf("FAILED: Buffer copy got %p\n", copy.GetData());
+        failures++;
+    }
+}
+
+// threads allocate aligned blocks from their magazines and free the blocks
+// of their neighbour, so blocks travel between the caches of the threads
+static void run_threads()
+{
+    const int kThreads = 4;
+    const int kBlocks = 2000;
+    vector<vector<void*>> blocks(kThreads);
+    vector<int> misaligned(kThreads, 0);
+
+    vector<thread> workers;
+    for (int t = 0; t < kThreads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < kBlocks; i++)
+            {
+                size_t size = 8 + (i % 16) * 24;
+                void* p = g_pMemoryManager->AllocateAligned(size, 16);
+                if (reinterpret_cast<size_t>(p) & 15) misaligned[t]++;
+                memset(p, t, size);
+                blocks[t].push_back(p);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+
+    for (int t = 0; t < kThreads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            vector<void*>& theirs = blocks[(t + 1) % kThreads];
+            for (int i = 0; i < kBlocks; i++)
+            {
+                size_t size = 8 + (i % 16) * 24;
+                if (*reinterpret_cast<uint8_t*>(theirs[i]) != (t + 1) % kThreads) misaligned[t]++;
+                g_pMemoryManager->FreeAligned(theirs[i], size, 16);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    for (int t = 0; t < kThreads; t++)
+    {
+        if (misaligned[t])
+        {
+            printf("FAILED: thread %d got %d bad aligned blocks\n", t, misaligned[t]);
+            failures++;
+        }
+    }
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    run_checks();
+
+    g_pMemoryManager->SetThreadSafe(true);
+    run_checks();
+    run_threads();
+    g_pMemoryManager->SetThreadSafe(false);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "aligned allocation test failed\n" : "aligned allocation test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "AssetLoader.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static void touch(const filesystem::path& path)
+{
+    filesystem::create_directories(path.parent_path());
+    FILE* fp = fopen(path.string().c_str(), "wb");
+    fputs(path.filename().string().c_str(), fp);
+    fclose(fp);
+}
+
+// what every lookup cost before the index: fopen at each search path and level
+static string probe(const vector<string>& search_paths, const string& name)
+{
+    string up_path;
+    for (int i = 0; i < 10; i++)
+    {
+        vector<string> candidates;
+        for (auto& path : search_paths) candidates.push_back(up_path + path + "/Asset/" + name);
+        candidates.push_back(up_path + "Asset/" + name);
+
+        for (auto& candidate : candidates)
+        {
+            if (FILE* fp = fopen(candidate.c_str(), "rb"))
+            {
+                fclose(fp);
+                return candidate;
+            }
+        }
+        up_path.append("../");
+    }
+    return name;
+}
+
+#if defined(__linux__)
+static size_t open_descriptors()
+{
+    size_t count = 0;
+    for (auto& entry : filesystem::directory_iterator("/proc/self/fd")) { (void)entry; count++; }
+    return count;
+}
+#endif
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    filesystem::path tmp = filesystem::temp_directory_path() / "AssetIndexTest";
+    string project = (tmp / "Project").generic_string();
+    string mod = (tmp / "Mod").generic_string();
+
+    // a scene referencing a few hundred textures, one of them overridden by a mod
+    const int textures = 300;
+    for (int i = 0; i < textures; i++)
+        touch(tmp / "Project" / "Asset" / "Scene" / "Textures" / ("tex_" + to_string(i) + ".png"));
+    touch(tmp / "Project" / "Asset" / "Scene" / "scene.gltf");
+    touch(tmp / "Mod" / "Asset" / "Scene" / "Textures" / "tex_7.png");
+
+    // the mod is searched first
+    g_pAssetLoader->AddSearchPath(mod.c_str());
+    g_pAssetLoader->AddSearchPath(project.c_str());
+    g_pAssetLoader->Initialize();
+
+    check(g_pAssetLoader->FileExists("Scene/scene.gltf"), "indexed file exists");
+    check(!g_pAssetLoader->FileExists("Scene/missing.gltf"), "missing file");
+    check(g_pAssetLoader->GetFilePath("Scene/scene.gltf") == project + "/Asset/Scene/scene.gltf", "resolved path");
+    check(g_pAssetLoader->GetFilePath("Scene/Textures/tex_7.png") == mod + "/Asset/Scene/Textures/tex_7.png", "earlier search path wins");
+    check(g_pAssetLoader->GetFilePath("Scene/./Textures/../scene.gltf") == project + "/Asset/Scene/scene.gltf", "names are normalized");
+    check(g_pAssetLoader->GetFilePath("Scene\\Textures\\tex_1.png") == project + "/Asset/Scene/Textures/tex_1.png", "backslashes");
+
+    AssetLoader::AssetFilePtr fp = g_pAssetLoader->OpenFile("Scene/Textures/tex_2.png", AssetLoader::MY_OPEN_BINARY);
+    check(fp != nullptr, "OpenFile through the index");
+    if (fp) g_pAssetLoader->CloseFile(fp);
+
+    // added after the scan: unknown until the next one
+    touch(tmp / "Project" / "Asset" / "Scene" / "late.gltf");
+    check(!g_pAssetLoader->FileExists("Scene/late.gltf"), "file created after the scan");
+    g_pAssetLoader->RescanFiles();
+    check(g_pAssetLoader->FileExists("Scene/late.gltf"), "file found by the rescan");
+
+    // outside of the roots the hierarchy is still walked
+    touch(tmp / "Project" / "outside.txt");
+    check(g_pAssetLoader->GetFilePath("../outside.txt") == project + "/Asset/../outside.txt", "name outside of the roots");
+
+    // a search path change invalidates the index
+    g_pAssetLoader->RemoveSearchPath(mod.c_str());
+    check(g_pAssetLoader->GetFilePath("Scene/Textures/tex_7.png") == project + "/Asset/Scene/Textures/tex_7.png", "removed search path");
+
+#if defined(__linux__)
+    size_t descriptors = open_descriptors();
+    for (int i = 0; i < 100; i++) g_pAssetLoader->GetFilePath("Scene/late.gltf");
+    check(open_descriptors() == descriptors, "GetFilePath does not leak file handles");
+#endif
+
+    // resolving every texture of the scene
+    vector<string> names;
+    for (int i = 0; i < textures; i++) names.push_back("Scene/Textures/tex_" + to_string(i) + ".png");
+    vector<string> search_paths = { mod, project };
+
+    auto start = chrono::high_resolution_clock::now();
+    for (auto& name : names) probe(search_paths, name);
+    chrono::duration<double, milli> probe_time = chrono::high_resolution_clock::now() - start;
+
+    g_pAssetLoader->AddSearchPath(mod.c_str());
+    start = chrono::high_resolution_clock::now();
+    for (auto& name : names) g_pAssetLoader->GetFilePath(name.c_str());
+    chrono::duration<double, milli> index_time = chrono::high_resolution_clock::now() - start;
+
+    printf("%d paths: fopen probing %.3f ms, index %.3f ms (including the rescan)\n", textures, probe_time.count(), index_time.count());
+
+    // misses are answered by the index as well
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < textures; i++) probe(search_paths, "Scene/missing.png");
+    chrono::duration<double, milli> probe_miss_time = chrono::high_resolution_clock::now() - start;
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < textures; i++) g_pAssetLoader->FileExists("Scene/missing.png");
+    chrono::duration<double, milli> index_miss_time = chrono::high_resolution_clock::now() - start;
+    printf("%d misses: fopen probing %.3f ms, index %.3f ms\n", textures, probe_miss_time.count(), index_miss_time.count());
+
+    g_pAssetLoader->Finalize();
+    filesystem::remove_all(tmp);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "asset index test failed\n" : "asset index test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "AssetLoader.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+// Loads every file below Asset/ through each AssetLoader read path, cold and warm.
+// usage: AssetLoadBench [--threads n] [--rounds n] [project directory]
+// The project directory holds Asset/, by default it is searched like the loader
+// does from the working directory. Cold runs drop the files from the page cache
+// first (Linux only, elsewhere every run is warm).
+
+typedef chrono::high_resolution_clock Clock;
+
+static vector<string> g_Files;
+static size_t g_szTotalBytes = 0;
+
+static void drop_page_cache()
+{
+#if defined(__linux__)
+    for (auto& file : g_Files)
+    {
+        int fd = open(g_pAssetLoader->GetFilePath(file.c_str()).c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+// every file on the calling thread through FILE*
+static size_t load_sync()
+{
+    size_t bytes = 0;
+    for (auto& file : g_Files)
+    {
+        bytes += g_pAssetLoader->SyncOpenAndReadBinary(file.c_str()).GetDataSize();
+    }
+    return bytes;
+}
+
+// every file queued at once, completions collected from Tick()
+static size_t load_async()
+{
+    size_t bytes = 0;
+    size_t completed = 0;
+    for (auto& file : g_Files)
+    {
+        g_pAssetLoader->AsyncRead(file.c_str(), 0, [&](const AsyncReadHandle& handle) {
+            bytes += handle.GetData().GetDataSize();
+            completed++;
+        });
+    }
+
+    while (completed < g_Files.size())
+    {
+        g_pAssetLoader->Tick();
+        this_thread::yield();
+    }
+    return bytes;
+}
+
+static void run(const char* name, size_t (*load)(), int rounds)
+{
+    for (int cold = 1; cold >= 0; cold--)
+    {
+        double best = 0;
+        size_t bytes = 0;
+        for (int round = 0; round < rounds; round++)
+        {
+            if (cold) drop_page_cache();
+            else if (round == 0) load();
+
+            auto start = Clock::now();
+            bytes = load();
+            double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+            if (round == 0 || ms < best) best = ms;
+        }
+
+        printf("%-10s %-5s %8.2f ms %9.1f MB/s%s\n", name, cold ? "cold" : "warm", best,
+               bytes / (1024.0 * 1024.0) / (best / 1000.0), bytes == g_szTotalBytes ? "" : "  (incomplete)");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t threads = 2;
+    int rounds = 5;
+    const char* project = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) rounds = atoi(argv[++i]);
+        else if (argv[i][0] != '-') project = argv[i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--threads n] [--rounds n] [project directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    g_pMemoryManager->Initialize();
+    if (project) g_pAssetLoader->AddSearchPath(project);
+
+    // the same Asset/ the loader resolves to
+    string root;
+    string up_path;
+    for (int i = 0; i < 10 && root.empty(); i++, up_path += "../")
+    {
+        string candidate = project ? up_path + project + "/Asset" : up_path + "Asset";
+        if (filesystem::is_directory(candidate)) root = candidate;
+    }
+    if (root.empty())
+    {
+        fprintf(stderr, "no Asset directory found\n");
+        return 1;
+    }
+
+    for (auto& entry : filesystem::recursive_directory_iterator(root))
+    {
+        if (!entry.is_regular_file()) continue;
+        g_Files.push_back(entry.path().generic_string().substr(root.size() + 1));
+        g_szTotalBytes += (size_t)entry.file_size();
+    }
+    printf("%zu files, %.1f MB below %s, %u I/O threads\n", g_Files.size(), g_szTotalBytes / (1024.0 * 1024.0), root.c_str(), threads);
+
+    g_pAssetLoader->SetIoThreadCount(threads);
+
+    g_pAssetLoader->Initialize();
+    run("sync", load_sync, rounds);
+    run("stdio", load_async, rounds);
+    g_pAssetLoader->Finalize();
+
+    if (g_pAssetLoader->SetIoBackend(AssetLoader::IoBackend::IoUring))
+    {
+        if (project) g_pAssetLoader->AddSearchPath(project);
+        g_pAssetLoader->Initialize();
+        run("io_uring", load_async, rounds);
+        g_pAssetLoader->Finalize();
+    }
+    else
+    {
+        printf("io_uring is not supported here\n");
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    return 0;
+}
@@ -11,11 +11,13 @@ namespace Corona
 {
     MemoryManager* g_pMemoryManager = new MemoryManager();
     AssetLoader* g_pAssetLoader = new AssetLoader();
+    ImageCache* g_pImageCache = new ImageCache();
 }
 
 int main(int , char** )
 {
     g_pMemoryManager->Initialize();
+    g_pImageCache->Initialize();
 
     // string shader_pgm = asset_loader.SyncOpenAndReadTextFileToString("Shaders/illum.hs");
     // cout << shader_pgm;
@@ -25,8 +27,10 @@ int main(int , char** )
     GltfParser gltf_parser;
     gltf_parser.ParseImage(imgPath, img);
 
+    g_pImageCache->Finalize();
     g_pMemoryManager->Finalize();
 
+    delete g_pImageCache;
     delete g_pMemoryManager;
 
     return 0;
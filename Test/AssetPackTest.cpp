@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static bool same(const BufferView& view, const string& content)
+{
+    return view.GetDataSize() == content.size() && !memcmp(view.GetData(), content.data(), content.size());
+}
+
+static size_t transient_bytes()
+{
+    return g_pMemoryManager->GetTagStats(MemoryTag::Transient).szLiveBytes;
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    filesystem::path root = filesystem::temp_directory_path() / "AssetPackTest";
+    filesystem::remove_all(root);
+    filesystem::create_directories(root / "Asset");
+
+    // a shader compresses well, noise does not
+    string shader;
+    for (int i = 0; i < 500; i++) shader += "float4 main(float4 pos : POSITION) : SV_POSITION { return pos; }\n";
+    string noise(100000, '\0');
+    uint32_t seed = 1;
+    for (auto& c : noise) { seed = seed * 1664525 + 1013904223; c = (char)(seed >> 24); }
+
+    BufferView shader_view(vector<uint8_t>(shader.begin(), shader.end()));
+    BufferView noise_view(vector<uint8_t>(noise.begin(), noise.end()));
+
+    AssetPackWriter writer;
+    writer.AddFile("Shaders/default.hlsl", shader_view, true);
+    writer.AddFile("Scene/helmet.bin", noise_view, true);
+    writer.AddFile("Scene/empty.txt", BufferView(), false);
+    for (int i = 0; i < 200; i++)
+        writer.AddFile("Textures/small_" + to_string(i) + ".bin", noise_view.SubView(i, 2000), false);
+    check(writer.Write((root / "Asset" / "Game.cpk").string().c_str()), "write pack");
+
+    {
+        AssetPack pack;
+        check(pack.Open((root / "Asset" / "Game.cpk").string().c_str()), "open pack");
+        check(pack.GetEntryCount() == 203, "entry count");
+
+        const AssetPackEntry* pShader = pack.Find("Shaders/default.hlsl");
+        const AssetPackEntry* pNoise = pack.Find("Scene/helmet.bin");
+        check(pShader && (pShader->nFlags & PACK_ENTRY_ZLIB) && pShader->nStoredSize < shader.size() / 10, "shader is compressed");
+        check(pNoise && !(pNoise->nFlags & PACK_ENTRY_ZLIB), "noise is stored as is");
+        check(pNoise && pNoise->nOffset % kPackAlignment == 0, "entries are aligned");
+        check(!pack.Find("Scene/missing.bin"), "missing entry");
+    }
+
+    // loose files next to the pack, the pack hides them once it is mounted
+    write_file(root / "Asset" / "Shaders" / "default.hlsl", "loose");
+    for (int i = 0; i < 200; i++)
+        write_file(root / "Asset" / "Textures" / ("small_" + to_string(i) + ".bin"), noise.substr(i, 2000));
+
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    g_pAssetLoader->Initialize();
+
+    check(!g_pAssetLoader->MountPack("Missing.cpk"), "missing pack");
+    check(g_pAssetLoader->MountPack("Game.cpk"), "mount a pack below Asset/");
+
+    {
+        BufferView view = g_pAssetLoader->MapFile("Scene/helmet.bin");
+        check(same(view, noise), "packed file content");
+        check(transient_bytes() == 0, "uncompressed entries are not copied");
+
+        BufferView text = g_pAssetLoader->MapFile("Shaders/./default.hlsl");
+        check(same(text, shader), "compressed entry inflates, the pack wins over the loose file");
+
+        check(g_pAssetLoader->FileExists("Scene/empty.txt"), "empty entry exists");
+        check(g_pAssetLoader->MapFile("Scene/empty.txt").IsEmpty(), "empty entry");
+
+        string source = g_pAssetLoader->SyncOpenAndReadTextFileToString("Shaders/default.hlsl");
+        check(source == shader, "text read from the pack");
+
+        AssetLoader::AssetFilePtr fp = g_pAssetLoader->OpenFile("Scene/helmet.bin", AssetLoader::MY_OPEN_BINARY);
+        check(fp && g_pAssetLoader->GetSize(fp) == noise.size(), "OpenFile on a packed file");
+        Buffer chunk(16);
+        check(g_pAssetLoader->Seek(fp, 1000, AssetLoader::MY_SEEK_SET) == 0 && g_pAssetLoader->SyncRead(fp, chunk) == 1
+              && !memcmp(chunk.GetData(), noise.data() + 1000, 16), "seek and read inside an entry");
+        check(g_pAssetLoader->Seek(fp, -8, AssetLoader::MY_SEEK_END) == 0 && g_pAssetLoader->SyncRead(fp, chunk) == 0, "short read at the end");
+        g_pAssetLoader->CloseFile(fp);
+
+        AsyncReadHandle handle = g_pAssetLoader->AsyncRead("Scene/helmet.bin");
+        handle.Wait();
+        check(same(handle.GetData(), noise), "async read from the pack");
+
+        // unmounted packs stay mapped for the views still around
+        check(g_pAssetLoader->UnmountPack(g_pAssetLoader->GetFilePath("Game.cpk").c_str()), "unmount");
+        check(same(view, noise), "view outlives the mount");
+        check(g_pAssetLoader->SyncOpenAndReadTextFileToString("Shaders/default.hlsl") == "loose", "loose file again");
+    }
+
+    // 200 small files: loose versus out of the pack
+    auto start = chrono::high_resolution_clock::now();
+    size_t loose_bytes = 0;
+    for (int i = 0; i < 200; i++)
+        loose_bytes += g_pAssetLoader->SyncOpenAndReadBinary(("Textures/small_" + to_string(i) + ".bin").c_str()).GetDataSize();
+    chrono::duration<double, milli> loose_time = chrono::high_resolution_clock::now() - start;
+
+    g_pAssetLoader->MountPack("Game.cpk");
+    start = chrono::high_resolution_clock::now();
+    size_t packed_bytes = 0;
+    for (int i = 0; i < 200; i++)
+        packed_bytes += g_pAssetLoader->MapFile(("Textures/small_" + to_string(i) + ".bin").c_str()).GetDataSize();
+    chrono::duration<double, milli> packed_time = chrono::high_resolution_clock::now() - start;
+
+    check(loose_bytes == packed_bytes, "same files");
+    printf("200 small files: loose %.3f ms, packed %.3f ms\n", loose_time.count(), packed_time.count());
+
+    g_pAssetLoader->Finalize();
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "asset pack test failed\n" : "asset pack test passed\n");
+
+    return failures ? 1 : 0;
+}
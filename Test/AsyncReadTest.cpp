@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetLoader.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+    // the I/O threads allocate their buffers from the pools
+    check(g_pMemoryManager->IsThreadSafe(), "the memory manager starts thread-safe");
+
+    filesystem::path root = filesystem::temp_directory_path() / "AsyncReadTest";
+    for (int i = 0; i < 64; i++)
+        write_file(root / "Asset" / "Textures" / ("tex_" + to_string(i) + ".bin"), vector<uint8_t>(64 * 1024 + i, (uint8_t)i));
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    thread::id main_thread = this_thread::get_id();
+    vector<string> completed;
+    bool callbacks_on_main_thread = true;
+    auto record = [&](const AsyncReadHandle& handle) {
+        completed.push_back(handle.GetPath());
+        callbacks_on_main_thread &= (this_thread::get_id() == main_thread);
+    };
+
+    {
+        // queued before the I/O thread starts, so one thread reads them strictly by priority
+        g_pAssetLoader->SetIoThreadCount(1);
+
+        AsyncReadHandle a = g_pAssetLoader->AsyncRead("Textures/tex_0.bin", 0, record);
+        AsyncReadHandle b = g_pAssetLoader->AsyncRead("Textures/tex_1.bin", 0, record);
+        AsyncReadHandle c = g_pAssetLoader->AsyncRead("Textures/tex_2.bin", 10, record);
+        AsyncReadHandle d = g_pAssetLoader->AsyncRead("Textures/tex_3.bin", 0, record);
+        AsyncReadHandle e = g_pAssetLoader->AsyncRead("Textures/tex_4.bin", 0, record);
+        AsyncReadHandle missing = g_pAssetLoader->AsyncRead("Textures/missing.bin", -1, record);
+        d.SetPriority(20);
+        e.Cancel();
+        check(e.GetState() == AsyncReadState::Cancelled, "cancelled while queued");
+
+        g_pAssetLoader->Initialize();
+
+        missing.Wait();
+        check(a.IsReady() && b.IsReady() && c.IsReady() && d.IsReady(), "reads finish in priority order");
+        check(completed.empty(), "callbacks wait for Tick");
+
+        g_pAssetLoader->Tick();
+
+        vector<string> expected = { "Textures/tex_3.bin", "Textures/tex_2.bin", "Textures/tex_0.bin",
+                                    "Textures/tex_1.bin", "Textures/missing.bin" };
+        check(completed == expected, "completion order follows the priorities");
+        check(callbacks_on_main_thread, "callbacks run on the main thread");
+        check(c.GetState() == AsyncReadState::Done && c.GetData().GetDataSize() == 64 * 1024 + 2 && c.GetData().GetData()[0] == 2, "read content");
+        check(missing.GetState() == AsyncReadState::Failed && missing.GetData().IsEmpty(), "missing file fails");
+
+        // finished but not delivered yet: cancelling still suppresses the callback
+        completed.clear();
+        AsyncReadHandle f = g_pAssetLoader->AsyncRead("Textures/tex_5.bin", 0, record);
+        f.Wait();
+        f.Cancel();
+        g_pAssetLoader->Tick();
+        check(completed.empty(), "no callback after cancel");
+
+        g_pAssetLoader->Finalize();
+    }
+
+    for (auto backend : { AssetLoader::IoBackend::Stdio, AssetLoader::IoBackend::IoUring })
+    {
+        if (!g_pAssetLoader->SetIoBackend(backend))
+        {
+            printf("io_uring is not supported here, skipped\n");
+            continue;
+        }
+
+        // a scene worth of textures on four I/O threads while the main thread keeps ticking
+        g_pAssetLoader->SetIoThreadCount(4);
+        g_pAssetLoader->AddSearchPath(root.string().c_str());
+        g_pAssetLoader->Initialize();
+
+        completed.clear();
+        size_t bytes = 0;
+        bool content_ok = true;
+        vector<AsyncReadHandle> handles;
+        for (int i = 0; i < 64; i++)
+        {
+            handles.push_back(g_pAssetLoader->AsyncRead(("Textures/tex_" + to_string(i) + ".bin").c_str(), i % 3,
+                [&, i](const AsyncReadHandle& handle) {
+                    completed.push_back(handle.GetPath());
+                    bytes += handle.GetData().GetDataSize();
+                    content_ok &= handle.GetData().GetData()[handle.GetData().GetDataSize() - 1] == (uint8_t)i;
+                }));
+        }
+
+        int frames = 0;
+        auto start = chrono::high_resolution_clock::now();
+        while (completed.size() < handles.size() && frames < 100000)
+        {
+            g_pAssetLoader->Tick();
+            frames++;
+            this_thread::sleep_for(chrono::microseconds(100));
+        }
+        chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+
+        check(completed.size() == handles.size(), "every read completes");
+        check(content_ok && bytes == 64 * 64 * 1024 + 63 * 64 / 2, "every read has its content");
+        printf("%s: %zu reads (%zu KB) in %.2f ms, main thread ticked %d times meanwhile\n",
+               backend == AssetLoader::IoBackend::IoUring ? "io_uring" : "stdio", completed.size(), bytes / 1024, elapsed.count(), frames);
+
+        // reads still referenced by handles and callbacks go away with the loader
+        g_pAssetLoader->AsyncRead("Textures/tex_0.bin", 0, [](const AsyncReadHandle&) {});
+        g_pAssetLoader->Finalize();
+    }
+
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "async read test failed\n" : "async read test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <cstring>
+#include "BufferView.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static size_t live_bytes()
+{
+    return g_pMemoryManager->GetTagStats(MemoryTag::Mesh).szLiveBytes;
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    {
+        // a .glb like file: vertex positions followed by an embedded image
+        Buffer file(64 * 1024, 16, MemoryTag::Mesh);
+        for (size_t i = 0; i < file.GetDataSize(); i++) file.GetData()[i] = (uint8_t)i;
+        const uint8_t* pBytes = file.GetData();
+
+        BufferView whole(std::move(file));
+        check(whole.GetData() == pBytes && whole.GetDataSize() == 64 * 1024, "view takes the buffer over");
+        check(file.GetData() == nullptr, "source buffer is emptied");
+
+        BufferView positions = whole.SubView(0, 12 * 1000, 12);
+        BufferView image = whole.SubView(48 * 1024, 16 * 1024);
+        check(positions.GetElementCount() == 1000 && positions.GetStride() == 12, "strided view");
+        check(image.GetData() == pBytes + 48 * 1024 && image.GetData()[0] == (uint8_t)(48 * 1024), "no copy");
+        check(image.SubView(16, 16).GetData() == pBytes + 48 * 1024 + 16, "view of a view");
+        check(whole.GetUseCount() == 3, "views share the store");
+
+        size_t backing_size = live_bytes();
+        check(backing_size == 64 * 1024, "one backing allocation");
+
+        whole = BufferView();
+        positions = BufferView();
+        check(live_bytes() == backing_size, "the last view keeps the store alive");
+
+        image = BufferView();
+        check(live_bytes() == 0, "the store goes with the last view");
+    }
+
+    {
+        // SetData takes over MemoryManager memory and gives the old one back the same way
+        Buffer buf(100, 4, MemoryTag::Mesh);
+        uint8_t* p = reinterpret_cast<uint8_t*>(g_pMemoryManager->AllocateAligned(300, 16, MemoryTag::Mesh));
+        buf.SetData(p, 300, 16, MemoryTag::Mesh);
+        check(live_bytes() == 300, "SetData frees the old memory");
+    }
+    check(live_bytes() == 0, "SetData memory is released");
+
+    {
+        vector<uint8_t> bytes(1000, 7);
+        const uint8_t* p = bytes.data();
+        BufferView view(std::move(bytes));
+        check(view.GetData() == p && view.GetDataSize() == 1000, "view over a vector");
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "buffer view test failed\n" : "buffer view test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "BuildCache.h"
+#include "ImageCache.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+    ImageCache* g_pImageCache = new ImageCache();
+}
+
+static BufferView bytes(const string& s)
+{
+    return BufferView(vector<uint8_t>(s.begin(), s.end()));
+}
+
+static string text(const BufferView& data)
+{
+    return string(reinterpret_cast<const char*>(data.GetData()), data.GetDataSize());
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    filesystem::path root = filesystem::temp_directory_path() / "BuildCacheTest";
+    filesystem::remove_all(root);
+
+    // artifacts by key, inputs and version
+    {
+        BuildCache cache;
+        check(cache.Open((root / "Cache").string()), "open");
+
+        vector<BuildInput> inputs = { BuildCache::HashInput(bytes("source a")), BuildCache::HashInput(bytes("source b")) };
+        BufferView data;
+        check(!cache.Find("cooked", 1, inputs, data) && data.IsEmpty(), "nothing cooked yet");
+
+        check(cache.Store("cooked", 1, inputs, { bytes("part 1, "), bytes("part 2") }), "store");
+        check(cache.Find("cooked", 1, inputs, data) && text(data) == "part 1, part 2", "found");
+        check(reinterpret_cast<uintptr_t>(data.GetData()) % kBuildCacheAlignment == 0, "data aligned");
+
+        vector<BuildInput> changed = { inputs[0], BuildCache::HashInput(bytes("source B")) };
+        check(!cache.Find("cooked", 1, changed, data), "an input changed");
+        check(!cache.Find("cooked", 2, inputs, data), "another version of the processor");
+        check(!cache.Find("other", 1, inputs, data), "another key");
+
+        BuildCache::Stats stats = cache.GetStats();
+        check(stats.nHits == 1 && stats.nStale == 2 && stats.nMisses == 2 && stats.nStores == 1, "stats");
+
+        // replaced while the old one is still mapped
+        check(cache.Store("cooked", 2, changed, bytes("recooked")), "replace");
+        check(text(data) == "part 1, part 2" || data.IsEmpty(), "the old view stays valid");
+        check(cache.Find("cooked", 2, changed, data) && text(data) == "recooked", "the new one");
+        check(cache.Store("empty", 1, {}, BufferView()) && cache.Find("empty", 1, {}, data) && data.IsEmpty(), "empty artifact");
+
+        cache.Clear();
+        check(!cache.Find("cooked", 2, changed, data), "cleared");
+    }
+
+    g_pAssetLoader->SetBuildCacheDirectory((root / "Cache").string().c_str());
+    g_pAssetLoader->Initialize();
+    g_pImageCache->Initialize();
+    if (!g_pAssetLoader->FileExists("Textures/heli.jpg"))
+    {
+        printf("textures not found, run the test below the project directory\n");
+        return 1;
+    }
+
+    // decoded images come out of the cache once the memory cache has let them go
+    {
+        auto start = Clock::now();
+        shared_ptr<Image> pDecoded = g_pImageCache->GetImage("Textures/heli.jpg");
+        double decode_ms = ms_since(start);
+        check(pDecoded && pDecoded->data, "decodes");
+        size_t size = pDecoded->data_size;
+        vector<uint8_t> pixels(pDecoded->data, pDecoded->data + size);
+        uint32_t width = pDecoded->Width;
+        pDecoded.reset();
+        g_pImageCache->Clear();
+
+        start = Clock::now();
+        shared_ptr<Image> pCooked = g_pImageCache->GetImage("Textures/heli.jpg");
+        double cooked_ms = ms_since(start);
+        check(g_pImageCache->GetStats().nCooked == 1, "read from the build cache");
+        check(pCooked && pCooked->Width == width && pCooked->data_size == size &&
+              vector<uint8_t>(pCooked->data, pCooked->data + size) == pixels, "same pixels");
+        printf("Textures/heli.jpg: decoded %.3f ms, from the build cache %.3f ms\n", decode_ms, cooked_ms);
+
+        // embedded images by their content
+        BufferView data = g_pAssetLoader->MapFile("Textures/test.jpg");
+        check(g_pImageCache->GetImage(data, ".jpg") != nullptr, "embedded image");
+        g_pImageCache->Clear();
+        check(g_pImageCache->GetImage(data, ".jpg") && g_pImageCache->GetStats().nCooked == 2, "embedded image from the build cache");
+    }
+
+    // compressed pack entries are not compressed again
+    {
+        vector<uint8_t> compressible(256 * 1024);
+        for (size_t i = 0; i < compressible.size(); i++) compressible[i] = (uint8_t)(i / 64);
+
+        auto write = [&](const char* name, int level) {
+            AssetPackWriter writer;
+            writer.SetBuildCache(&g_pAssetLoader->GetBuildCache());
+            writer.AddFile("a.bin", BufferView(vector<uint8_t>(compressible)), true);
+            writer.AddFile("b.jpg", g_pAssetLoader->MapFile("Textures/heli.jpg"), true);
+            return writer.Write((root / name).string().c_str(), level);
+        };
+
+        BuildCache::Stats before = g_pAssetLoader->GetBuildCache().GetStats();
+        check(write("first.cpk", 6), "first pack");
+        BuildCache::Stats first = g_pAssetLoader->GetBuildCache().GetStats();
+        check(write("second.cpk", 6), "second pack");
+        BuildCache::Stats second = g_pAssetLoader->GetBuildCache().GetStats();
+        check(first.nStores == before.nStores + 2 && second.nHits == first.nHits + 2 && second.nStores == first.nStores,
+              "entries and the files not worth compressing come out of the cache");
+
+        AssetPack pack;
+        check(pack.Open((root / "second.cpk").string().c_str()), "open the pack");
+        const AssetPackEntry* pEntry = pack.Find("a.bin");
+        BufferView inflated = pEntry ? pack.Read(*pEntry) : BufferView();
+        check(pEntry && (pEntry->nFlags & PACK_ENTRY_ZLIB) && inflated.GetDataSize() == compressible.size() &&
+              !memcmp(inflated.GetData(), compressible.data(), compressible.size()), "the cached entry inflates");
+        check(filesystem::file_size(root / "first.cpk") == filesystem::file_size(root / "second.cpk"), "the same pack");
+
+        check(write("third.cpk", 9), "another level");
+        check(g_pAssetLoader->GetBuildCache().GetStats().nStores == second.nStores + 2, "compressed again");
+    }
+
+    g_pImageCache->Finalize();
+    g_pAssetLoader->Finalize();
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pImageCache;
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "build cache test failed\n" : "build cache test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include "AssetLoader.h"
+#include "FileMapping.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static uint64_t checksum(const BufferView& view)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < view.GetDataSize(); i++) sum += view.GetData()[i];
+    return sum;
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+    // <tmp>/FileMappingTest/Asset/Scene is searched like a project directory
+    filesystem::path root = filesystem::temp_directory_path() / "FileMappingTest";
+    filesystem::create_directories(root / "Asset" / "Scene");
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+    // a .bin sized like the FlightHelmet buffers
+    vector<uint8_t> bytes(32 * 1024 * 1024);
+    for (size_t i = 0; i < bytes.size(); i++) bytes[i] = (uint8_t)(i * 7);
+    write_file(root / "Asset" / "Scene" / "big.bin", bytes);
+    write_file(root / "Asset" / "Scene" / "empty.bin", vector<uint8_t>());
+
+    {
+        FileMapping mapping;
+        check(mapping.Open((root / "Asset" / "Scene" / "big.bin").string().c_str()), "open a mapping");
+        check(mapping.GetDataSize() == bytes.size(), "mapping size");
+        check(memcmp(mapping.GetData(), bytes.data(), bytes.size()) == 0, "mapping content");
+        mapping.Close();
+        check(!mapping.IsOpen() && mapping.GetData() == nullptr, "closed mapping");
+
+        check(!mapping.Open((root / "Asset" / "Scene" / "empty.bin").string().c_str()), "empty files are not mapped");
+        check(!mapping.Open((root / "Asset" / "Scene" / "missing.bin").string().c_str()), "missing files are not mapped");
+    }
+
+    {
+        BufferView file = g_pAssetLoader->MapFile("Scene/big.bin");
+        check(file.GetDataSize() == bytes.size() && memcmp(file.GetData(), bytes.data(), bytes.size()) == 0, "MapFile content");
+        check(g_pMemoryManager->GetTagStats(MemoryTag::Transient).szLiveBytes == 0, "MapFile does not copy the file");
+
+        // a parser keeps a slice, the mapping lives as long as the slice
+        BufferView tail = file.SubView(bytes.size() - 16, 16);
+        file = BufferView();
+        check(tail.GetData()[15] == bytes.back(), "slice keeps the mapping alive");
+    }
+
+    {
+        BufferView file = g_pAssetLoader->MapFile("Scene/empty.bin");
+        check(file.IsEmpty(), "empty file falls back to a read");
+    }
+
+    // whole-file load cost: mapping versus read into a buffer, every byte touched
+    const int rounds = 5;
+    uint64_t sum_read = 0, sum_map = 0;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        BufferView file(g_pAssetLoader->SyncOpenAndReadBinary("Scene/big.bin"));
+        sum_read += checksum(file);
+    }
+    chrono::duration<double, milli> read_time = chrono::high_resolution_clock::now() - start;
+
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        BufferView file = g_pAssetLoader->MapFile("Scene/big.bin");
+        sum_map += checksum(file);
+    }
+    chrono::duration<double, milli> map_time = chrono::high_resolution_clock::now() - start;
+
+    check(sum_read == sum_map, "both paths read the same bytes");
+    printf("32MB file (warm cache): SyncOpenAndReadBinary %.2f ms, MapFile %.2f ms\n",
+           read_time.count() / rounds, map_time.count() / rounds);
+
+    filesystem::remove_all(root);
+
+    g_pAssetLoader->Finalize();
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "file mapping test failed\n" : "file mapping test passed\n");
+
+    return failures ? 1 : 0;
+}
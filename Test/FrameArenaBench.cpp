@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "MemoryManager.h"
+#include "geommath.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static const uint32_t kFrameCount = 2;
+static const int kFrames = 2000;
+
+// mimics the per-frame scratch work of GraphicsManager: one matrix per object
+// and a debug box (8 points + 12 edges + the flattened point list) per object
+template<typename PointAlloc, typename EdgeAlloc, typename MatrixVector>
+static void BuildFrame(int object_count, PointAlloc point_allocator, EdgeAlloc edge_allocator, MatrixVector& matrices)
+{
+    matrices.reserve(object_count);
+
+    for (int i = 0; i < object_count; i++)
+    {
+        Matrix4X4f m = {};
+        m[0][0] = m[1][1] = m[2][2] = m[3][3] = (float)i;
+        matrices.push_back(m);
+
+        Vector3f bbMin = { -1.0f, -1.0f, -1.0f };
+        PointPtr points[8];
+        for (int j = 0; j < 8; j++)
+            points[j] = allocate_shared<Point>(point_allocator, bbMin);
+
+        EdgeList edges;
+        edges.reserve(12);
+        for (int j = 0; j < 12; j++)
+            edges.push_back(allocate_shared<Edge>(edge_allocator, make_pair(points[j % 8], points[(j + 1) % 8])));
+
+        PointList point_list;
+        point_list.reserve(edges.size() * 2);
+        for (auto& edge : edges)
+        {
+            point_list.push_back(edge->first);
+            point_list.push_back(edge->second);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int object_count = 200;
+    if (argc >= 2) object_count = atoi(argv[1]);
+
+    g_pMemoryManager->Initialize();
+    g_pMemoryManager->InitializeFrameArenas(kFrameCount);
+
+    // general heap
+    auto start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < kFrames; frame++)
+    {
+        vector<Matrix4X4f> matrices;
+        BuildFrame(object_count, allocator<Point>(), allocator<Edge>(), matrices);
+    }
+    chrono::duration<double, milli> heap_time = chrono::high_resolution_clock::now() - start;
+
+    // frame arena
+    start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < kFrames; frame++)
+    {
+        g_pMemoryManager->BeginFrame(frame % kFrameCount);
+        vector<Matrix4X4f, FrameAllocator<Matrix4X4f>> matrices(g_pMemoryManager->GetFrameAllocator<Matrix4X4f>());
+        BuildFrame(object_count, g_pMemoryManager->GetFrameAllocator<Point>(),
+            g_pMemoryManager->GetFrameAllocator<Edge>(), matrices);
+    }
+    chrono::duration<double, milli> arena_time = chrono::high_resolution_clock::now() - start;
+
+    printf("objects per frame: %d\n", object_count);
+    printf("heap:  %.4f ms/frame\n", heap_time.count() / kFrames);
+    printf("arena: %.4f ms/frame (peak %zu bytes)\n", arena_time.count() / kFrames,
+        g_pMemoryManager->GetFrameArena().GetPeakSize());
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    return 0;
+}
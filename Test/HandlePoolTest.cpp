@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "HandlePool.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+struct Node
+{
+    Node(int v) : value(v), transform() { live++; }
+    ~Node() { live--; }
+    int value;
+    float transform[16];
+
+    static int live;
+};
+
+int Node::live = 0;
+
+static void test_pool()
+{
+    HandlePool<Node> pool;
+
+    Handle<Node> invalid;
+    check(!invalid && pool.Get(invalid) == nullptr, "default handle is invalid");
+
+    Handle<Node> a = pool.Create(1);
+    Handle<Node> b = pool.Create(2);
+    check(a && b && a != b, "handles are distinct");
+    check(pool.Get(a)->value == 1 && pool.Get(b)->value == 2, "get");
+    check(pool.Size() == 2 && Node::live == 2, "size");
+
+    Node* pB = pool.Get(b);
+    pool.Destroy(a);
+    check(pool.Get(a) == nullptr && !pool.IsAlive(a), "stale handle");
+    check(pool.Get(b) == pB, "objects do not move");
+
+    // the slot is reused with a new generation
+    Handle<Node> c = pool.Create(3);
+    check(c.GetIndex() == a.GetIndex() && c.GetGeneration() != a.GetGeneration(), "slot reuse");
+    check(pool.Get(a) == nullptr && pool.Get(c)->value == 3, "old handle stays stale");
+
+    // destroying a stale handle does nothing
+    pool.Destroy(a);
+    check(pool.Size() == 2, "double destroy");
+
+    const int count = 10000;
+    vector<Handle<Node>> handles;
+    for (int i = 0; i < count; i++) handles.push_back(pool.Create(i));
+    check(pool.GetPageCount() > 1, "pool grows by pages");
+
+    int sum = 0;
+    pool.ForEach([&sum, &pool](Handle<Node> handle, Node& node) { if (pool.Get(handle) == &node) sum++; });
+    check(sum == count + 2, "for each visits every node by its handle");
+
+    check(g_pMemoryManager->GetTagStats(MemoryTag::Scene).szLiveBytes > 0, "pages accounted to the scene tag");
+
+    pool.Clear();
+    check(pool.Empty() && Node::live == 0, "clear");
+    for (auto h : handles) check(pool.Get(h) == nullptr, "handles stale after clear");
+}
+
+// every index a handle can hold is in use, the index must not run into the generation
+static void test_full()
+{
+    HandlePool<int> pool;
+    bool valid = true;
+    for (uint32_t i = 0; i <= Handle<int>::kMaxIndex; i++) valid = pool.Create(int(i)) && valid;
+    check(valid && pool.Size() == Handle<int>::kMaxIndex + 1, "fills every index");
+
+    check(!pool.Create(-1), "invalid handle when full");
+    check(pool.Size() == Handle<int>::kMaxIndex + 1, "a full pool stays as it is");
+
+    Handle<int> last(Handle<int>::kMaxIndex, 1);
+    check(pool.Get(last) && *pool.Get(last) == int(Handle<int>::kMaxIndex), "last index");
+    pool.Destroy(last);
+    Handle<int> reused = pool.Create(7);
+    check(reused && reused.GetIndex() == Handle<int>::kMaxIndex, "a freed slot is reused");
+}
+
+// per frame walk over a side table, as GraphicsManager::UpdateConstants() does
+static void bench()
+{
+    const int count = 4096;
+    const int frames = 500;
+
+    HandlePool<Node> pool;
+    vector<Handle<Node>> handles;
+    vector<shared_ptr<Node>> owners;
+    vector<weak_ptr<Node>> weak_nodes;
+    for (int i = 0; i < count; i++)
+    {
+        handles.push_back(pool.Create(i));
+        owners.push_back(make_shared<Node>(i));
+        weak_nodes.push_back(owners.back());
+    }
+
+    float sum = 0.0f;
+    auto start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+        for (auto h : handles)
+            if (auto p = pool.Get(h)) sum += p->transform[0] + p->value;
+    chrono::duration<double, nano> pool_time = chrono::high_resolution_clock::now() - start;
+
+    start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+        for (auto& w : weak_nodes)
+            if (auto p = w.lock()) sum += p->transform[0] + p->value;
+    chrono::duration<double, nano> weak_time = chrono::high_resolution_clock::now() - start;
+
+    printf("per node: handle %.2f ns, weak_ptr %.2f ns (%g)\n",
+        pool_time.count() / (count * frames), weak_time.count() / (count * frames), sum);
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    test_pool();
+    test_full();
+    bench();
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "handle pool test failed\n" : "handle pool test passed\n");
+
+    return failures ? 1 : 0;
+}
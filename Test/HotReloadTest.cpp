@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "FileWatcher.h"
+#include "ImageCache.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+    ImageCache* g_pImageCache = new ImageCache();
+}
+
+static void copy_asset_file(const filesystem::path& from, const filesystem::path& to)
+{
+    // written in place, as an editor saving the file would
+    string content(filesystem::file_size(from), '\0');
+    FILE* fp = fopen(from.string().c_str(), "rb");
+    fread(&content[0], 1, content.size(), fp);
+    fclose(fp);
+    write_file(to, content);
+}
+
+// polls until something changed or a second passed
+static vector<string> wait_for_changes(FileWatcher& watcher)
+{
+    vector<string> changed;
+    for (int i = 0; i < 1000 && changed.empty(); i++)
+    {
+        watcher.Poll(changed);
+        if (changed.empty()) this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return changed;
+}
+
+typedef chrono::high_resolution_clock Clock;
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pImageCache->Initialize();
+
+    if (!g_pAssetLoader->FileExists("Textures/test.jpg") || !g_pAssetLoader->FileExists("Textures/heli.jpg"))
+    {
+        printf("textures not found, run the test below the project directory\n");
+        return 1;
+    }
+    string test_jpg = g_pAssetLoader->GetFilePath("Textures/test.jpg");
+    string heli_jpg = g_pAssetLoader->GetFilePath("Textures/heli.jpg");
+
+    filesystem::path root = filesystem::temp_directory_path() / "HotReloadTest";
+    filesystem::remove_all(root);
+    filesystem::create_directories(root / "Asset" / "Textures");
+    filesystem::create_directories(root / "Asset" / "Meshes");
+
+    // the watcher on its own
+    {
+        filesystem::path a = root / "Asset" / "Meshes" / "a.bin";
+        filesystem::path b = root / "Asset" / "Meshes" / "b.bin";
+        write_file(a, "a");
+        write_file(b, "b");
+
+        FileWatcher watcher;
+        check(watcher.Watch(a.string()) && watcher.Watch(b.string()), "watch");
+        check(!watcher.Watch((root / "missing.bin").string()), "missing file");
+        printf("file watcher: %s\n", watcher.IsNotified() ? "inotify" : "polling");
+
+        vector<string> changed;
+        watcher.Poll(changed);
+        check(changed.empty(), "nothing changed yet");
+
+        write_file(a, "aa");
+        write_file(root / "Asset" / "Meshes" / "other.bin", "not watched");
+        changed = wait_for_changes(watcher);
+        check(changed == vector<string>({ a.string() }), "written file reported once");
+
+        // saved through a temporary file
+        write_file(root / "Asset" / "Meshes" / "b.tmp", "bbb");
+        filesystem::rename(root / "Asset" / "Meshes" / "b.tmp", b);
+        changed = wait_for_changes(watcher);
+        check(changed == vector<string>({ b.string() }), "file replaced by a rename");
+
+        watcher.Unwatch(a.string());
+        write_file(a, "aaa");
+        write_file(b, "bbbb");
+        changed = wait_for_changes(watcher);
+        check(changed == vector<string>({ b.string() }), "unwatched file not reported");
+    }
+
+    // through the asset loader, a texture reloaded on its own
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    copy_asset_file(test_jpg, root / "Asset" / "Textures" / "hot.jpg");
+    {
+        shared_ptr<Image> pImage = g_pImageCache->GetImage("Textures/hot.jpg");
+        check(pImage && pImage->data, "decodes");
+
+        int notified = 0;
+        double reload_ms = 0.0;
+        Clock::time_point saved;
+        uint32_t id = g_pAssetLoader->WatchFile("Textures/hot.jpg", [&](const string& name) {
+            check(name == "Textures/hot.jpg", "called back with the watched name");
+            pImage = g_pImageCache->GetImage(name.c_str());
+            reload_ms = chrono::duration<double, milli>(Clock::now() - saved).count();
+        });
+        uint32_t other = g_pAssetLoader->WatchFile("Textures/hot.jpg", [&](const string& ) { notified++; });
+        check(id && other && id != other, "watch ids");
+        check(g_pAssetLoader->WatchFile("Textures/missing.jpg", nullptr) == 0, "missing file is not watched");
+
+        g_pAssetLoader->Tick();
+        check(notified == 0, "no change, no callback");
+
+        size_t before = pImage->data_size;
+        saved = Clock::now();
+        copy_asset_file(heli_jpg, root / "Asset" / "Textures" / "hot.jpg");
+        for (int i = 0; i < 1000 && !notified; i++)
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            g_pAssetLoader->Tick();
+        }
+        check(notified == 1, "every watcher is called back once");
+        check(pImage && pImage->data_size != before, "the new image");
+        printf("texture reloaded %.3f ms after saving\n", reload_ms);
+
+        // the other watch of the same file still works
+        g_pAssetLoader->UnwatchFile(id);
+        copy_asset_file(test_jpg, root / "Asset" / "Textures" / "hot.jpg");
+        for (int i = 0; i < 1000 && notified < 2; i++)
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            g_pAssetLoader->Tick();
+        }
+        check(notified == 2, "still watched by the other");
+        g_pAssetLoader->UnwatchFile(other);
+
+        // packed files do not change
+        AssetPackWriter writer;
+        writer.AddFile("Textures/packed.jpg", g_pAssetLoader->MapFile("Textures/hot.jpg"), false);
+        check(writer.Write((root / "Asset" / "Textures.cpk").string().c_str()), "write pack");
+        check(g_pAssetLoader->MountPack("Textures.cpk"), "mount");
+        check(g_pAssetLoader->WatchFile("Textures/packed.jpg", nullptr) == 0, "packed file is not watched");
+    }
+
+    g_pImageCache->Finalize();
+    g_pAssetLoader->Finalize();
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pImageCache;
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "hot reload test failed\n" : "hot reload test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "ImageCache.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+    ImageCache* g_pImageCache = new ImageCache();
+}
+
+static void copy_asset(const char* name, const filesystem::path& to)
+{
+    filesystem::create_directories(to.parent_path());
+    filesystem::copy_file(g_pAssetLoader->GetFilePath(name), to, filesystem::copy_options::overwrite_existing);
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+    g_pImageCache->Initialize();
+
+    const char* textures[] = { "Textures/test.jpg", "Textures/heli.jpg", "Textures/5.jpg" };
+    for (auto texture : textures)
+    {
+        if (!g_pAssetLoader->FileExists(texture))
+        {
+            printf("%s not found, run the test below the project directory\n", texture);
+            return 1;
+        }
+    }
+
+    {
+        auto start = Clock::now();
+        shared_ptr<Image> pFirst = g_pImageCache->GetImage(textures[0]);
+        double decode_ms = ms_since(start);
+
+        start = Clock::now();
+        shared_ptr<Image> pAgain = g_pImageCache->GetImage(textures[0]);
+        double cached_ms = ms_since(start);
+
+        check(pFirst && pFirst->data && pFirst->Width > 0, "decodes");
+        check(pAgain == pFirst, "the second request shares the image");
+        check(g_pImageCache->GetImage("Textures/./test.jpg") == pFirst, "the same file by another name");
+        printf("%s: decoded %.3f ms, cached %.3f ms\n", textures[0], decode_ms, cached_ms);
+
+        ImageCache::Stats stats = g_pImageCache->GetStats();
+        check(stats.nMisses == 1 && stats.nHits == 2, "one decode, two hits");
+        check(stats.szRetainedBytes == pFirst->data_size, "retained bytes");
+
+        check(!g_pImageCache->GetImage("Textures/missing.jpg"), "missing file");
+        check(g_pImageCache->GetStats().nEntries == 1, "failures are not cached");
+    }
+
+    // in-memory data, e.g. embedded into a .glb, by content
+    {
+        BufferView data = g_pAssetLoader->MapFile(textures[1]);
+        BufferView copy(vector<uint8_t>(data.GetData(), data.GetData() + data.GetDataSize()));
+        shared_ptr<Image> pEmbedded = g_pImageCache->GetImage(data, ".jpg");
+        check(pEmbedded && g_pImageCache->GetImage(copy, ".JPG") == pEmbedded, "same content, same image");
+    }
+
+    // the LRU keeps the images alive up to the budget, the weak entries while they are used
+    {
+        g_pImageCache->Clear();
+        shared_ptr<Image> pHeld = g_pImageCache->GetImage(textures[0]);
+        g_pImageCache->SetMemoryBudget(pHeld->data_size);
+
+        uint64_t misses = g_pImageCache->GetStats().nMisses;
+        g_pImageCache->GetImage(textures[1]);
+        g_pImageCache->GetImage(textures[2]);
+        ImageCache::Stats stats = g_pImageCache->GetStats();
+        check(stats.szRetainedBytes <= pHeld->data_size, "stays within the budget");
+        check(stats.nEvictions >= 1, "evicts");
+        check(g_pImageCache->GetImage(textures[0]) == pHeld, "evicted but still in use");
+        check(g_pImageCache->GetStats().nMisses == misses + 2, "no decode for images in use");
+
+        pHeld.reset();
+        g_pImageCache->SetMemoryBudget(0);
+        g_pImageCache->Tick();
+        check(g_pImageCache->GetStats().nEntries == 0, "expired entries are purged");
+        g_pImageCache->SetMemoryBudget(256 * 1024 * 1024);
+    }
+
+    // concurrent requests wait for a single decode
+    {
+        uint64_t misses = g_pImageCache->GetStats().nMisses;
+        vector<shared_ptr<Image>> results(8);
+        vector<thread> threads;
+        for (size_t i = 0; i < results.size(); i++)
+            threads.emplace_back([&results, i, &textures]() { results[i] = g_pImageCache->GetImage(textures[2]); });
+        for (auto& t : threads) t.join();
+
+        bool same = results[0] != nullptr;
+        for (auto& pImage : results) same = same && pImage == results[0];
+        check(same, "every thread gets the same image");
+        check(g_pImageCache->GetStats().nMisses == misses + 1, "decoded once");
+    }
+
+    // JPEG images above the size limit decode smaller, cached apart from the full ones
+    {
+        shared_ptr<Image> pFull = g_pImageCache->GetImage(textures[1]);
+        uint32_t larger = max(pFull->Width, pFull->Height);
+        g_pImageCache->SetMaxTextureSize(larger / 2);
+        shared_ptr<Image> pLimited = g_pImageCache->GetImage(textures[1]);
+        check(pLimited && pLimited != pFull, "limited image is decoded apart");
+        check(pLimited && max(pLimited->Width, pLimited->Height) <= larger / 2 &&
+              pLimited->Width == (pFull->Width + 1) / 2, "decoded at half the size");
+        check(g_pImageCache->GetImage(textures[1]) == pLimited, "limited image is cached");
+        g_pImageCache->SetMaxTextureSize(0);
+        check(g_pImageCache->GetImage(textures[1]) == pFull, "no limit, the full image again");
+    }
+
+    // a file changed on disk is decoded again, packed files are keyed by content
+    filesystem::path root = filesystem::temp_directory_path() / "ImageCacheTest";
+    filesystem::remove_all(root);
+    copy_asset(textures[0], root / "Asset" / "Textures" / "changing.jpg");
+    {
+        AssetPackWriter writer;
+        writer.AddFile("Textures/packed.jpg", g_pAssetLoader->MapFile(textures[1]), false);
+        check(writer.Write((root / "Asset" / "Images.cpk").string().c_str()), "write pack");
+    }
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    {
+        shared_ptr<Image> pBefore = g_pImageCache->GetImage("Textures/changing.jpg");
+        copy_asset(textures[1], root / "Asset" / "Textures" / "changing.jpg");
+        filesystem::last_write_time(root / "Asset" / "Textures" / "changing.jpg",
+                                    filesystem::last_write_time(root / "Asset" / "Textures" / "changing.jpg") + chrono::seconds(2));
+        shared_ptr<Image> pAfter = g_pImageCache->GetImage("Textures/changing.jpg");
+        check(pBefore && pAfter && pBefore != pAfter && pAfter->data_size != pBefore->data_size, "changed file is decoded again");
+
+        check(g_pAssetLoader->MountPack("Images.cpk"), "mount");
+        shared_ptr<Image> pPacked = g_pImageCache->GetImage("Textures/packed.jpg");
+        check(pPacked && g_pImageCache->GetImage("Textures/packed.jpg") == pPacked, "packed file is cached");
+    }
+
+    // finalizing waits for the decodes in flight, they leave no entry behind
+    {
+        g_pImageCache->Clear();
+        uint64_t misses = g_pImageCache->GetStats().nMisses;
+        shared_ptr<Image> pInFlight;
+        thread decoder([&pInFlight, &textures]() { pInFlight = g_pImageCache->GetImage(textures[1]); });
+        while (g_pImageCache->GetStats().nMisses == misses) this_thread::yield();
+        g_pImageCache->Finalize();
+        decoder.join();
+        check(pInFlight != nullptr, "decode in flight while finalizing");
+        ImageCache::Stats stats = g_pImageCache->GetStats();
+        check(stats.nEntries == 0 && stats.szRetainedBytes == 0, "finalize waits for the decode");
+    }
+
+    g_pImageCache->Finalize();
+    g_pAssetLoader->Finalize();
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pImageCache;
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "image cache test failed\n" : "image cache test passed\n");
+
+    return failures ? 1 : 0;
+}
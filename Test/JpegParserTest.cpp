@@ -1,8 +1,11 @@
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "AssetLoader.h"
 #include "MemoryManager.h"
 #include "JPEG.h"
+#include "TestUtil.h"
 
 using namespace std;
 using namespace Corona;
@@ -12,6 +15,47 @@ namespace Corona {
     AssetLoader*   g_pAssetLoader = new AssetLoader();
 }
 
+// the way the textures used to be decoded: RGB one scanline per call,
+// widened to RGBA for the upload afterwards
+static vector<uint8_t> decode_rgb_and_widen(const BufferView& buf, uint32_t& width, uint32_t& height)
+{
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, buf.GetData(), (unsigned long)buf.GetDataSize());
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    size_t pitch = ALIGN((size_t)width * 3, 4);
+    vector<uint8_t> rgb(pitch * height);
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        JSAMPROW row = rgb.data() + cinfo.output_scanline * pitch;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    vector<uint8_t> rgba((size_t)width * 4 * height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* src = rgb.data() + y * pitch;
+        uint8_t* dst = rgba.data() + (size_t)y * width * 4;
+        for (uint32_t x = 0; x < width; x++, src += 3, dst += 4)
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = 0xFF;
+        }
+    }
+    return rgba;
+}
+
 int main(int argc, const char** argv)
 {
     g_pMemoryManager->Initialize();
@@ -28,12 +72,55 @@ int main(int argc, const char** argv)
         } else {
             buf = g_pAssetLoader->SyncOpenAndReadBinary("Textures/BoomBoxWithAxes_baseColor.jpg");
         }
+        if (!buf.GetDataSize())
+        {
+            printf("texture not found, run the test below the project directory\n");
+            return 1;
+        }
+        BufferView view(nullptr, buf.GetData(), buf.GetDataSize());
+
+        // RGBA8 with an opaque alpha, the same colors as decoding to RGB
+        auto start = Clock::now();
+        uint32_t width, height;
+        vector<uint8_t> expected = decode_rgb_and_widen(view, width, height);
+        double rgb_ms = ms_since(start);
+
+        start = Clock::now();
+        JpegParser jpeg_parser;
+        Image image = jpeg_parser.Parse(view);
+        double rgba_ms = ms_since(start);
 
-        // JfifParser jfif_parser;
+        check(image.data && image.pixel_format == PIXEL_FORMAT::RGBA8 && image.bitcount == 32, "RGBA8");
+        check(image.Width == width && image.Height == height && image.pitch == (size_t)width * 4 &&
+              image.data_size == image.pitch * height, "size");
+        check(image.data && vector<uint8_t>(image.data, image.data + image.data_size) == expected, "same pixels");
+        printf("%ux%u: RGB and widened %.3f ms, RGBA %.3f ms\n", width, height, rgb_ms, rgba_ms);
 
-        // Image image = jfif_parser.Parse(buf);
+        // rows at the asked alignment
+        JpegParser aligned_parser;
+        aligned_parser.SetPitchAlignment(256);
+        Image aligned = aligned_parser.Parse(view);
+        check(aligned.pitch % 256 == 0 && aligned.pitch >= (size_t)width * 4 &&
+              !memcmp(aligned.data + (height - 1) * aligned.pitch, image.data + (height - 1) * image.pitch, (size_t)width * 4),
+              "aligned rows");
 
-        // cout << image;
+        // scaled decode, for the lower mip levels
+        for (uint32_t scale : { 2u, 4u, 8u })
+        {
+            JpegParser scaled_parser;
+            scaled_parser.SetScale(scale);
+            start = Clock::now();
+            Image scaled = scaled_parser.Parse(view);
+            double ms = ms_since(start);
+            check(scaled.data && scaled.Width == (width + scale - 1) / scale && scaled.Height == (height + scale - 1) / scale,
+                  "scaled size");
+            printf("1/%u: %ux%u %.3f ms\n", scale, scaled.Width, scaled.Height, ms);
+        }
+
+        // broken data does not decode
+        vector<uint8_t> truncated(buf.GetData(), buf.GetData() + 16);
+        Image broken = jpeg_parser.Parse(BufferView(nullptr, truncated.data(), truncated.size()));
+        check(broken.data == nullptr, "truncated data");
     }
 
     g_pAssetLoader->Finalize();
@@ -42,6 +129,7 @@ int main(int argc, const char** argv)
     delete g_pAssetLoader;
     delete g_pMemoryManager;
 
-    return 0;
-}
+    printf(failures ? "jpeg parser test failed\n" : "jpeg parser test passed\n");
 
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "MemoryManager.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static void test_allocator()
+{
+    LargeObjectAllocator allocator;
+
+    const size_t sizes[] = { 4096, 5000, 17000, 65536, 300000, 1024 * 1024, 1024 * 1024 + 1, 3 * 1024 * 1024 };
+    for (auto size : sizes)
+    {
+        void* p = allocator.Allocate(size);
+        check(p != nullptr, "allocation");
+        check((reinterpret_cast<size_t>(p) & (LargeObjectAllocator::kSpanAlignment - 1)) == 0, "span alignment");
+        memset(p, 0xCD, size);
+        allocator.Free(p, size);
+
+        // a request of the same bucket gets the span back
+        void* q = allocator.Allocate(size);
+        check(p == q, "span reuse");
+        allocator.Free(q, size);
+    }
+
+    check(allocator.GetCachedSize() == allocator.GetMappedSize(), "everything cached");
+
+    // the spans were freed during this interval, they survive the first trim
+    check(allocator.Trim() == 0, "first trim keeps recent spans");
+    check(allocator.Trim() > 0, "second trim releases idle spans");
+    check(allocator.GetMappedSize() == 0, "nothing mapped");
+}
+
+// a scene reload: the same set of buffers is allocated and released again
+template<typename AllocFunc, typename FreeFunc>
+static double reload(AllocFunc alloc, FreeFunc dealloc)
+{
+    srand(42);
+    vector<pair<void*, size_t>> buffers;
+    auto start = chrono::high_resolution_clock::now();
+
+    for (int round = 0; round < 20; round++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            size_t size = 4096 + (size_t)(rand() % (512 * 1024));
+            if (i % 20 == 0) size = 4 * 1024 * 1024;
+            void* p = alloc(size);
+            // touch every page like a loader filling the buffer
+            for (size_t offset = 0; offset < size; offset += 4096) reinterpret_cast<uint8_t*>(p)[offset] = 1;
+            buffers.push_back(make_pair(p, size));
+        }
+
+        for (auto& buffer : buffers) dealloc(buffer.first, buffer.second);
+        buffers.clear();
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / 20;
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    test_allocator();
+
+    void* p = g_pMemoryManager->AllocateAligned(100000, 256);
+    check((reinterpret_cast<size_t>(p) & 255) == 0, "aligned large allocation");
+    g_pMemoryManager->FreeAligned(p, 100000, 256);
+
+    double pool = reload([](size_t size) { return g_pMemoryManager->Allocate(size); },
+        [](void* p, size_t size) { g_pMemoryManager->Free(p, size); });
+    double sys = reload([](size_t size) { return malloc(size); },
+        [](void* p, size_t) { free(p); });
+    printf("scene reload: MemoryManager %.3f ms, malloc %.3f ms\n", pool, sys);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "large object test failed\n" : "large object test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "MemoryManager.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+// Allocation benchmarks for every size class of the MemoryManager.
+// usage: MemoryBench [--json] [--quick] [--out file]
+// Every result is a row of (benchmark, allocator, block size, metric, value), written as
+// CSV or JSON so runs before and after a change of the size classes or page size can be diffed.
+
+struct Result
+{
+    string benchmark;
+    string allocator;
+    uint32_t block_size;
+    string metric;
+    double value;
+};
+
+static vector<Result> results;
+static int g_nBlocks = 8192;
+static int g_nRounds = 20;
+static size_t g_szCacheWorkingSet = 16 * 1024 * 1024;
+
+static void record(const char* benchmark, const char* allocator, uint32_t block_size, const char* metric, double value)
+{
+    results.push_back({ benchmark, allocator, block_size, metric, value });
+}
+
+typedef chrono::high_resolution_clock Clock;
+
+static double elapsed_ns(Clock::time_point start)
+{
+    return chrono::duration<double, nano>(Clock::now() - start).count();
+}
+
+// hardware cache misses of the calling thread, Stop() returns -1 where the counter is not available
+class CacheMissCounter
+{
+public:
+    CacheMissCounter() : m_Fd(-1)
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_Fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+#if defined(__linux__)
+        if (m_Fd >= 0) close(m_Fd);
+#endif
+    }
+
+    bool IsAvailable() const { return m_Fd >= 0; }
+
+    void Start()
+    {
+#if defined(__linux__)
+        if (m_Fd < 0) return;
+        ioctl(m_Fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long Stop()
+    {
+        long long count = -1;
+#if defined(__linux__)
+        if (m_Fd < 0) return -1;
+        ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m_Fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+        return count;
+    }
+
+private:
+    int m_Fd;
+};
+
+// the allocators under test
+struct PoolBench
+{
+    explicit PoolBench(uint32_t size) : allocator(size, MemoryManager::GetPageSize(), MemoryManager::GetAlignment()) {}
+    void* Alloc(size_t) { return allocator.Allocate(); }
+    void Free(void* p, size_t) { allocator.Free(p); }
+    static const char* Name() { return "Allocator"; }
+
+    Allocator allocator;
+};
+
+struct ManagerBench
+{
+    explicit ManagerBench(uint32_t) {}
+    void* Alloc(size_t size) { return g_pMemoryManager->Allocate(size); }
+    void Free(void* p, size_t size) { g_pMemoryManager->Free(p, size); }
+    static const char* Name() { return "MemoryManager"; }
+};
+
+struct MallocBench
+{
+    explicit MallocBench(uint32_t) {}
+    void* Alloc(size_t size) { return malloc(size); }
+    void Free(void* p, size_t) { free(p); }
+    static const char* Name() { return "malloc"; }
+};
+
+// allocates a batch of blocks and frees it again in the given order
+template<typename Bench>
+static void run_pattern(const char* pattern, uint32_t size, const vector<int>& order)
+{
+    Bench bench(size);
+    vector<void*> blocks(g_nBlocks);
+    double alloc_ns = 0.0;
+    double free_ns = 0.0;
+
+    for (int round = 0; round < g_nRounds; round++)
+    {
+        auto start = Clock::now();
+        for (int i = 0; i < g_nBlocks; i++)
+        {
+            blocks[i] = bench.Alloc(size);
+            *reinterpret_cast<uint8_t*>(blocks[i]) = (uint8_t)i;
+        }
+        alloc_ns += elapsed_ns(start);
+
+        start = Clock::now();
+        for (int i = 0; i < g_nBlocks; i++) bench.Free(blocks[order[i]], size);
+        free_ns += elapsed_ns(start);
+    }
+
+    double ops = (double)g_nBlocks * g_nRounds;
+    record(pattern, Bench::Name(), size, "alloc_ns", alloc_ns / ops);
+    record(pattern, Bench::Name(), size, "free_ns", free_ns / ops);
+    record(pattern, Bench::Name(), size, "mops", 2.0 * ops / (alloc_ns + free_ns) * 1.0e3);
+}
+
+// the same batches from a frame arena, released all at once by Reset()
+static void run_arena(uint32_t size)
+{
+    FrameArena arena;
+    arena.Initialize((size_t)g_nBlocks * size + 4096);
+    double alloc_ns = 0.0;
+    double reset_ns = 0.0;
+
+    for (int round = 0; round < g_nRounds; round++)
+    {
+        auto start = Clock::now();
+        for (int i = 0; i < g_nBlocks; i++)
+        {
+            void* p = arena.Allocate(size, MemoryManager::GetAlignment());
+            *reinterpret_cast<uint8_t*>(p) = (uint8_t)i;
+        }
+        alloc_ns += elapsed_ns(start);
+
+        start = Clock::now();
+        arena.Reset();
+        reset_ns += elapsed_ns(start);
+    }
+
+    arena.Finalize();
+
+    double ops = (double)g_nBlocks * g_nRounds;
+    record("arena", "FrameArena", size, "alloc_ns", alloc_ns / ops);
+    record("arena", "FrameArena", size, "free_ns", reset_ns / ops);
+    record("arena", "FrameArena", size, "mops", 2.0 * ops / (alloc_ns + reset_ns) * 1.0e3);
+}
+
+// one thread allocates, another one frees, handing the blocks over through a ring
+template<typename Bench>
+static void run_producer_consumer(uint32_t size)
+{
+    static const uint32_t kRingSize = 1024;
+
+    Bench bench(size);
+    const uint32_t count = (uint32_t)g_nBlocks * g_nRounds / 4;
+    vector<void*> ring(kRingSize);
+    atomic<uint32_t> head(0);
+    atomic<uint32_t> tail(0);
+
+    auto start = Clock::now();
+
+    thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            void* p = bench.Alloc(size);
+            while (i - tail.load(memory_order_acquire) == kRingSize) this_thread::yield();
+            ring[i % kRingSize] = p;
+            head.store(i + 1, memory_order_release);
+        }
+    });
+
+    thread consumer([&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            while (head.load(memory_order_acquire) == i) this_thread::yield();
+            bench.Free(ring[i % kRingSize], size);
+            tail.store(i + 1, memory_order_release);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    record("producer_consumer", Bench::Name(), size, "mops", 2.0 * count / elapsed_ns(start) * 1.0e3);
+}
+
+// random alloc/free churn, then the live set shrinks to a tenth. Reports how much of
+// the committed pages is in use and how many pages the scattered survivors pin down
+static void run_fragmentation(uint32_t size)
+{
+    const uint32_t page_size = MemoryManager::GetPageSize();
+    Allocator allocator(size, page_size, MemoryManager::GetAlignment());
+    mt19937 rng(size);
+    vector<void*> live;
+
+    for (int i = 0; i < g_nBlocks; i++) live.push_back(allocator.Allocate());
+
+    for (int step = 0; step < 4 * g_nBlocks; step++)
+    {
+        if ((rng() & 1) && !live.empty())
+        {
+            size_t index = rng() % live.size();
+            allocator.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        else
+        {
+            live.push_back(allocator.Allocate());
+        }
+    }
+
+    shuffle(live.begin(), live.end(), rng);
+    while (live.size() > (size_t)g_nBlocks / 10)
+    {
+        allocator.Free(live.back());
+        live.pop_back();
+    }
+
+    double live_bytes = (double)allocator.GetUsedBlockCount() * size;
+    record("fragmentation", "Allocator", size, "pages", allocator.GetPageCount());
+    record("fragmentation", "Allocator", size, "utilization", live_bytes / ((double)allocator.GetPageCount() * page_size));
+
+    allocator.Trim(true);
+    record("fragmentation", "Allocator", size, "pinned_pages", allocator.GetPageCount());
+    record("fragmentation", "Allocator", size, "utilization_after_trim", live_bytes / ((double)allocator.GetPageCount() * page_size));
+
+    for (auto p : live) allocator.Free(p);
+}
+
+// allocates and touches a working set larger than the caches from a free list that was
+// built in address order and from one scrambled by random frees
+static void run_free_list_walk(uint32_t size, CacheMissCounter& counter)
+{
+    Allocator allocator(size, MemoryManager::GetPageSize(), MemoryManager::GetAlignment());
+    const int count = max(g_nBlocks, (int)(g_szCacheWorkingSet / size));
+    vector<void*> blocks(count);
+    vector<int> order(count);
+    mt19937 rng(size);
+
+    for (int scrambled = 0; scrambled < 2; scrambled++)
+    {
+        for (int i = 0; i < count; i++) blocks[i] = allocator.Allocate();
+
+        for (int i = 0; i < count; i++) order[i] = i;
+        if (scrambled) shuffle(order.begin(), order.end(), rng);
+        for (int i = 0; i < count; i++) allocator.Free(blocks[order[i]]);
+
+        counter.Start();
+        auto start = Clock::now();
+        for (int i = 0; i < count; i++)
+        {
+            blocks[i] = allocator.Allocate();
+            *reinterpret_cast<uint32_t*>(blocks[i]) = (uint32_t)i;
+        }
+        double ns = elapsed_ns(start);
+        long long misses = counter.Stop();
+
+        const char* name = scrambled ? "free_list_scrambled" : "free_list_ordered";
+        record(name, "Allocator", size, "ns", ns / count);
+        if (misses >= 0) record(name, "Allocator", size, "cache_misses", (double)misses / count);
+
+        for (int i = 0; i < count; i++) allocator.Free(blocks[i]);
+    }
+}
+
+static void write_csv(FILE* out)
+{
+    fprintf(out, "# page_size=%u block_sizes=%u\n", MemoryManager::GetPageSize(), MemoryManager::GetBlockSizeCount());
+    fprintf(out, "benchmark,allocator,block_size,metric,value\n");
+    for (auto& r : results)
+    {
+        fprintf(out, "%s,%s,%u,%s,%.4f\n", r.benchmark.c_str(), r.allocator.c_str(), r.block_size, r.metric.c_str(), r.value);
+    }
+}
+
+static void write_json(FILE* out)
+{
+    fprintf(out, "{\n  \"page_size\": %u,\n  \"block_sizes\": %u,\n  \"results\": [\n",
+        MemoryManager::GetPageSize(), MemoryManager::GetBlockSizeCount());
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        auto& r = results[i];
+        fprintf(out, "    {\"benchmark\": \"%s\", \"allocator\": \"%s\", \"block_size\": %u, \"metric\": \"%s\", \"value\": %.4f}%s\n",
+            r.benchmark.c_str(), r.allocator.c_str(), r.block_size, r.metric.c_str(), r.value,
+            i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    const char* out_path = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--json")) json = true;
+        else if (!strcmp(argv[i], "--quick")) { g_nBlocks = 1024; g_nRounds = 4; g_szCacheWorkingSet = 1024 * 1024; }
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) out_path = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--json] [--quick] [--out file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    g_pMemoryManager->Initialize();
+    // the single-threaded paths, only the producer / consumer runs need the magazines
+    g_pMemoryManager->SetThreadSafe(false);
+
+    vector<int> lifo(g_nBlocks), fifo(g_nBlocks), random_order(g_nBlocks);
+    for (int i = 0; i < g_nBlocks; i++)
+    {
+        fifo[i] = i;
+        lifo[i] = g_nBlocks - 1 - i;
+        random_order[i] = i;
+    }
+    shuffle(random_order.begin(), random_order.end(), mt19937(42));
+
+    CacheMissCounter counter;
+    if (!counter.IsAvailable()) fprintf(stderr, "cache miss counter not available, only timings are reported\n");
+
+    for (uint32_t c = 0; c < MemoryManager::GetBlockSizeCount(); c++)
+    {
+        uint32_t size = MemoryManager::GetBlockSize(c);
+        fprintf(stderr, "block size %u\n", size);
+
+        run_pattern<PoolBench>("lifo", size, lifo);
+        run_pattern<ManagerBench>("lifo", size, lifo);
+        run_pattern<MallocBench>("lifo", size, lifo);
+
+        run_pattern<PoolBench>("fifo", size, fifo);
+        run_pattern<ManagerBench>("fifo", size, fifo);
+        run_pattern<MallocBench>("fifo", size, fifo);
+
+        run_pattern<PoolBench>("random", size, random_order);
+        run_pattern<ManagerBench>("random", size, random_order);
+        run_pattern<MallocBench>("random", size, random_order);
+
+        run_arena(size);
+
+        g_pMemoryManager->SetThreadSafe(true);
+        run_producer_consumer<ManagerBench>(size);
+        g_pMemoryManager->SetThreadSafe(false);
+        run_producer_consumer<MallocBench>(size);
+
+        run_fragmentation(size);
+        run_free_list_walk(size, counter);
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "cannot open %s\n", out_path);
+        return 1;
+    }
+
+    if (json) write_json(out);
+    else write_csv(out);
+
+    if (out != stdout) fclose(out);
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <cstdio>
+#include "MemoryManager.h"
+#include "Buffer.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+struct Node
+{
+    Node(int v) : value(v) {}
+    int value;
+    float transform[16];
+};
+
+int main(int , char** )
+{
+    int failures = 0;
+    int budget_hits = 0;
+
+    g_pMemoryManager->Initialize();
+
+    g_pMemoryManager->SetBudget(MemoryTag::Texture, 1024 * 1024);
+    g_pMemoryManager->SetBudgetCallback([&budget_hits](MemoryTag tag, size_t live_bytes, size_t budget) {
+        printf("%s over budget: %zu of %zu bytes\n", GetMemoryTagName(tag), live_bytes, budget);
+        budget_hits++;
+    });
+
+    {
+        // 1.5 MB of textures crosses the budget once
+        Buffer textures[3] = {
+            Buffer(512 * 1024, 16, MemoryTag::Texture),
+            Buffer(512 * 1024, 16, MemoryTag::Texture),
+            Buffer(512 * 1024, 16, MemoryTag::Texture)
+        };
+
+        Node* pNode = g_pMemoryManager->New<Node>(MemoryTag::Scene, 42);
+        void* pMesh = g_pMemoryManager->Allocate(3000, MemoryTag::Mesh);
+
+        MemoryTagStats texture_stats = g_pMemoryManager->GetTagStats(MemoryTag::Texture);
+        if (texture_stats.szLiveBytes != 3 * 512 * 1024 || texture_stats.nLiveAllocations != 3) failures++;
+        if (g_pMemoryManager->GetTagStats(MemoryTag::Scene).szLiveBytes != sizeof(Node)) failures++;
+        if (g_pMemoryManager->GetTagStats(MemoryTag::Mesh).szLiveBytes != 3000) failures++;
+
+        g_pMemoryManager->PrintReport();
+
+        g_pMemoryManager->Free(pMesh, 3000, MemoryTag::Mesh);
+        g_pMemoryManager->Delete(pNode, MemoryTag::Scene);
+    }
+
+    MemoryTagStats texture_stats = g_pMemoryManager->GetTagStats(MemoryTag::Texture);
+    if (texture_stats.szLiveBytes != 0 || texture_stats.szPeakBytes != 3 * 512 * 1024) failures++;
+    if (budget_hits != 1) failures++;
+
+    // left alive on purpose, shows up in the leak list of debug builds
+    g_pMemoryManager->Allocate(100, MemoryTag::Physics);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "memory tag test failed\n" : "memory tag test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include "MemoryManager.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static const int kRounds = 2000;
+static const int kBatch = 256;
+
+// each thread repeatedly allocates a batch of random small blocks and frees them again,
+// half of the batches are freed in reverse order to mix LIFO and FIFO reuse
+template<typename AllocFunc, typename FreeFunc>
+static double RunThreads(int thread_count, AllocFunc alloc, FreeFunc dealloc)
+{
+    vector<thread> workers;
+    auto start = chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < thread_count; t++)
+    {
+        workers.emplace_back([t, &alloc, &dealloc]() {
+            mt19937 rng(1234 + t);
+            uniform_int_distribution<size_t> dist(4, 1024);
+            size_t sizes[kBatch];
+            void* blocks[kBatch];
+
+            for (int i = 0; i < kBatch; i++) sizes[i] = dist(rng);
+
+            for (int round = 0; round < kRounds; round++)
+            {
+                for (int i = 0; i < kBatch; i++) blocks[i] = alloc(sizes[i]);
+
+                if (round & 1)
+                {
+                    for (int i = kBatch - 1; i >= 0; i--) dealloc(blocks[i], sizes[i]);
+                }
+                else
+                {
+                    for (int i = 0; i < kBatch; i++) dealloc(blocks[i], sizes[i]);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) worker.join();
+
+    chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+    double ops = 2.0 * kRounds * kBatch * thread_count;
+    return ops / elapsed.count() / 1.0e6;
+}
+
+int main(int argc, char** argv)
+{
+    int max_threads = (int)thread::hardware_concurrency();
+    if (argc >= 2) max_threads = atoi(argv[1]);
+    if (max_threads < 1) max_threads = 1;
+
+    g_pMemoryManager->Initialize();
+    g_pMemoryManager->SetThreadSafe(true);
+
+    printf("threads, MemoryManager (Mops/s), malloc (Mops/s)\n");
+    for (int n = 1; n <= max_threads; n *= 2)
+    {
+        double pool = RunThreads(n,
+            [](size_t size) { return g_pMemoryManager->Allocate(size); },
+            [](void* p, size_t size) { g_pMemoryManager->Free(p, size); });
+
+        double sys = RunThreads(n,
+            [](size_t size) { return malloc(size); },
+            [](void* p, size_t) { free(p); });
+
+        printf("%d, %.2f, %.2f\n", n, pool, sys);
+
+        if (n < max_threads && n * 2 > max_threads) n = max_threads / 2;
+    }
+
+    g_pMemoryManager->SetThreadSafe(false);
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <vector>
+#include "MemoryManager.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static const size_t kBlockSize = 64;
+
+static vector<void*> load_scene(size_t block_count)
+{
+    vector<void*> blocks;
+    blocks.reserve(block_count);
+    for (size_t i = 0; i < block_count; i++)
+    {
+        blocks.push_back(g_pMemoryManager->Allocate(kBlockSize));
+    }
+    return blocks;
+}
+
+static void unload_scene(vector<void*>& blocks)
+{
+    for (auto p : blocks)
+    {
+        g_pMemoryManager->Free(p, kBlockSize);
+    }
+    blocks.clear();
+}
+
+static void tick(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) g_pMemoryManager->Tick();
+}
+
+int main(int , char** )
+{
+    int failures = 0;
+
+    g_pMemoryManager->Initialize();
+    g_pMemoryManager->Trim(true);
+
+    // a big scene followed by a small one
+    auto big_scene = load_scene(200000);
+    unload_scene(big_scene);
+    auto small_scene = load_scene(1000);
+
+    // the first trim still sees the big scene in its window and keeps the pages
+    size_t released = g_pMemoryManager->Trim();
+    printf("first trim released %zu bytes\n", released);
+    if (released != 0) failures++;
+
+    // the next window only needs the small scene
+    released = g_pMemoryManager->Trim();
+    printf("second trim released %zu bytes\n", released);
+    if (released < 200000 * kBlockSize / 2) failures++;
+
+    // periodic trim from Tick()
+    big_scene = load_scene(200000);
+    unload_scene(big_scene);
+    tick(2 * MemoryManager::kTrimIntervalTicks);
+    released = g_pMemoryManager->Trim();
+    printf("trim after ticks released %zu bytes\n", released);
+    if (released != 0) failures++;
+
+    unload_scene(small_scene);
+    released = g_pMemoryManager->Trim(true);
+    printf("forced trim released %zu bytes\n", released);
+    if (released == 0) failures++;
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "memory trim test failed\n" : "memory trim test passed\n");
+
+    return failures ? 1 : 0;
+}
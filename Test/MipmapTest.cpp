@@ -0,0 +1,205 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "MemoryManager.h"
+#include "Mipmaps.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static Image make_image(uint32_t width, uint32_t height, PIXEL_FORMAT format = PIXEL_FORMAT::RGBA8)
+{
+    uint32_t bytes = format == PIXEL_FORMAT::RGB8 ? 3 : 4;
+    Image image;
+    image.Width = width;
+    image.Height = height;
+    image.bitcount = bytes * 8;
+    image.bitdepth = 8;
+    image.pixel_format = format;
+    image.pitch = (size_t)width * bytes;
+    image.data_size = image.pitch * height;
+    image.data = new uint8_t[image.data_size];
+    return image;
+}
+
+static const uint8_t* pixel(const Image& image, uint32_t level, uint32_t x, uint32_t y)
+{
+    const Mipmap& mip = image.mipmaps[level];
+    return image.data + mip.offset + y * mip.pitch + x * 4;
+}
+
+static double coverage(const Image& image, uint32_t level, uint8_t cutoff)
+{
+    const Mipmap& mip = image.mipmaps[level];
+    size_t passing = 0;
+    for (uint32_t y = 0; y < mip.Height; y++)
+        for (uint32_t x = 0; x < mip.Width; x++)
+            if (pixel(image, level, x, y)[3] >= cutoff) passing++;
+    return (double)passing / ((double)mip.Width * mip.Height);
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    check(GetMipLevelCount(1024, 512) == 11, "1024x512 has 11 levels");
+    check(GetMipLevelCount(1, 1) == 1, "1x1 has 1 level");
+    check(GetMipLevelCount(5, 3) == 3, "5x3 has 3 levels");
+
+    {
+        Image image = make_image(37, 300, PIXEL_FORMAT::RGB8);
+        size_t size = LayoutMipmaps(image, GetMipLevelCount(image.Width, image.Height));
+        bool aligned = true;
+        for (auto& mip : image.mipmaps) aligned = aligned && mip.offset % 16 == 0;
+        check(image.mipmaps.size() == 9 && image.mipmaps[1].Width == 18 && image.mipmaps[1].Height == 150 &&
+              image.mipmaps[1].pitch == 54 && image.mipmaps[8].Width == 1 && image.mipmaps[8].Height == 1,
+              "layout halves every level down to 1x1");
+        check(aligned && image.mipmaps[0].offset == 0 && size == image.mipmaps[8].offset + 3, "layout is aligned");
+    }
+
+    {
+        // a 4x4 image where every 2x2 block has its own values
+        Image image = make_image(4, 4);
+        for (uint32_t y = 0; y < 4; y++)
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                uint8_t* p = image.data + y * image.pitch + x * 4;
+                p[0] = (uint8_t)(x * 40 + y * 10);
+                p[1] = (uint8_t)(200 - x * 20);
+                p[2] = (uint8_t)(y * 60);
+                p[3] = 255;
+            }
+        MipmapDesc desc;
+        desc.filter = MIPMAP_FILTER::LINEAR;
+        check(GenerateMipmaps(image, desc, 1), "linear mips");
+        check(image.GetMipLevels() == 3, "4x4 gets 3 levels");
+        const uint8_t* p = pixel(image, 1, 1, 0);
+        // x = 2, 3 and y = 0, 1
+        check(abs(p[0] - 105) <= 1 && abs(p[1] - 150) <= 1 && abs(p[2] - 30) <= 1 && p[3] == 255, "linear box average");
+        p = pixel(image, 2, 0, 0);
+        check(abs(p[0] - 75) <= 1 && abs(p[1] - 170) <= 1 && abs(p[2] - 90) <= 1, "linear average of the whole image");
+    }
+
+    {
+        // three black pixels and a white one average to a quarter of the light
+        Image image = make_image(2, 2);
+        memset(image.data, 0, image.data_size);
+        memset(image.data + image.pitch + 4, 255, 4);
+        image.data[3] = image.data[7] = image.data[image.pitch + 3] = 255;
+        MipmapDesc desc;
+        desc.filter = MIPMAP_FILTER::SRGB;
+        check(GenerateMipmaps(image, desc, 1), "srgb mips");
+        const uint8_t* p = pixel(image, 1, 0, 0);
+        check(abs(p[0] - 137) <= 1 && p[0] == p[1] && p[1] == p[2], "srgb averages in linear space");
+        check(p[3] == 255, "alpha is averaged as it is");
+    }
+
+    {
+        // +x and +z average to a unit vector halfway in between
+        Image image = make_image(2, 2);
+        const uint8_t plus_x[] = { 255, 128, 128, 255 }, plus_z[] = { 128, 128, 255, 255 };
+        memcpy(image.data, plus_x, 4);
+        memcpy(image.data + 4, plus_z, 4);
+        memcpy(image.data + image.pitch, plus_x, 4);
+        memcpy(image.data + image.pitch + 4, plus_z, 4);
+        MipmapDesc desc;
+        desc.filter = MIPMAP_FILTER::NORMAL_MAP;
+        check(GenerateMipmaps(image, desc, 1), "normal map mips");
+        const uint8_t* p = pixel(image, 1, 0, 0);
+        float n[3];
+        for (int i = 0; i < 3; i++) n[i] = p[i] / 127.5f - 1.0f;
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        check(abs(p[0] - 218) <= 1 && abs(p[2] - 218) <= 1 && abs(p[1] - 128) <= 1, "normals average to the half vector");
+        check(fabsf(length - 1.0f) < 0.02f, "normals are renormalized");
+    }
+
+    {
+        // foliage like alpha: opaque specks over a clear background, denser
+        // to the right, but never dense enough for an average to pass
+        const uint32_t size = 256;
+        Image plain = make_image(size, size), tested = make_image(size, size);
+        uint32_t seed = 12345;
+        for (uint32_t y = 0; y < size; y++)
+            for (uint32_t x = 0; x < size; x++)
+            {
+                seed = seed * 1103515245 + 12345;
+                uint8_t* p = plain.data + y * plain.pitch + x * 4;
+                p[0] = p[1] = p[2] = 128;
+                p[3] = (seed >> 16) % 1000 < x * 400 / size ? 255 : 0;
+            }
+        memcpy(tested.data, plain.data, plain.data_size);
+
+        MipmapDesc desc;
+        desc.filter = MIPMAP_FILTER::SRGB;
+        check(GenerateMipmaps(plain, desc), "mips without the alpha cutoff");
+        desc.fAlphaCutoff = 0.5f;
+        check(GenerateMipmaps(tested, desc), "mips with the alpha cutoff");
+
+        double full = coverage(tested, 0, 128);
+        bool kept = true;
+        for (uint32_t level = 2; level < 6; level++)
+        {
+            kept = kept && fabs(coverage(tested, level, 128) - full) < 0.05;
+        }
+        check(kept, "alpha coverage is kept down the chain");
+        check(coverage(plain, 4, 128) < full * 0.5, "plain averaging loses the coverage");
+        printf("alpha coverage %.3f, level 4 plain %.3f, scaled %.3f\n", full, coverage(plain, 4, 128),
+               coverage(tested, 4, 128));
+    }
+
+    {
+        // the bands come out the same however many threads make them
+        Image rgb = make_image(37, 300, PIXEL_FORMAT::RGB8);
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < rgb.data_size; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            rgb.data[i] = (uint8_t)(seed >> 16);
+        }
+        Image other = make_image(37, 300, PIXEL_FORMAT::RGB8);
+        memcpy(other.data, rgb.data, rgb.data_size);
+
+        MipmapDesc desc;
+        desc.filter = MIPMAP_FILTER::SRGB;
+        check(GenerateMipmaps(rgb, desc, 1), "rgb8 mips on one thread");
+        check(GenerateMipmaps(other, desc, 4), "rgb8 mips on four threads");
+        check(rgb.pixel_format == PIXEL_FORMAT::RGBA8 && rgb.bitcount == 32, "rgb8 is converted to rgba8");
+        check(pixel(rgb, 0, 5, 7)[3] == 255, "converted pixels are opaque");
+        check(rgb.data_size == other.data_size && memcmp(rgb.data, other.data, rgb.data_size) == 0,
+              "threads do not change the result");
+    }
+
+    for (uint32_t size : { 1024u, 4096u })
+    {
+        Image image = make_image(size, size);
+        memset(image.data, 0x80, image.data_size);
+        MipmapDesc desc;
+        desc.filter = MIPMAP_FILTER::SRGB;
+
+        auto start = Clock::now();
+        GenerateMipmaps(image, desc, 1);
+        double single_ms = ms_since(start);
+
+        Image again = make_image(size, size);
+        memset(again.data, 0x80, again.data_size);
+        start = Clock::now();
+        GenerateMipmaps(again, desc);
+        double parallel_ms = ms_since(start);
+        printf("%ux%u srgb mip chain: one thread %.3f ms, all threads %.3f ms\n", size, size, single_ms, parallel_ms);
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "mipmap test failed\n" : "mipmap test passed\n");
+
+    return failures ? 1 : 0;
+}
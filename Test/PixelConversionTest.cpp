@@ -0,0 +1,199 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "MemoryManager.h"
+#include "PixelConversion.h"
+#include "BMP.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static vector<uint8_t> random_bytes(size_t count)
+{
+    vector<uint8_t> bytes(count);
+    uint32_t seed = 12345;
+    for (auto& byte : bytes)
+    {
+        seed = seed * 1103515245 + 12345;
+        byte = (uint8_t)(seed >> 16);
+    }
+    return bytes;
+}
+
+// the way RGB8 textures used to be widened for the upload, a pixel at a time
+static void widen_rgb(const uint8_t* src, size_t src_pitch, uint8_t* dst, size_t dst_pitch, uint32_t width, uint32_t height)
+{
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* s = src + y * src_pitch;
+        uint8_t* d = dst + y * dst_pitch;
+        for (uint32_t x = 0; x < width; x++, s += 3, d += 4)
+        {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+            d[3] = 0xFF;
+        }
+    }
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    const uint32_t width = 37, height = 11;
+    const size_t src_pitch = 160, dst_pitch = 256;    // padded rows
+    vector<uint8_t> src = random_bytes(src_pitch * height);
+
+    // RGB8 to RGBA8 and back
+    {
+        vector<uint8_t> expected(dst_pitch * height), rgba(dst_pitch * height);
+        widen_rgb(src.data(), src_pitch, expected.data(), dst_pitch, width, height);
+        check(ConvertToRGBA8(PIXEL_FORMAT::RGB8, src.data(), src_pitch, rgba.data(), dst_pitch, width, height), "RGB8 converts");
+        bool same = true;
+        for (uint32_t y = 0; y < height; y++)
+            same = same && !memcmp(rgba.data() + y * dst_pitch, expected.data() + y * dst_pitch, width * 4);
+        check(same, "RGB8 to RGBA8");
+
+        vector<uint8_t> rgb(src_pitch * height);
+        ConvertRGBA8ToRGB8(rgba.data(), dst_pitch, rgb.data(), src_pitch, width, height);
+        same = true;
+        for (uint32_t y = 0; y < height; y++)
+            same = same && !memcmp(rgb.data() + y * src_pitch, src.data() + y * src_pitch, width * 3);
+        check(same, "RGBA8 to RGB8");
+    }
+
+    // gray, gray alpha and two channels
+    {
+        vector<uint8_t> rgba(dst_pitch * height);
+        ConvertToRGBA8(PIXEL_FORMAT::R8, src.data(), src_pitch, rgba.data(), dst_pitch, width, height);
+        const uint8_t* s = src.data() + 3 * src_pitch + 5;
+        const uint8_t* d = rgba.data() + 3 * dst_pitch + 5 * 4;
+        check(d[0] == s[0] && d[1] == s[0] && d[2] == s[0] && d[3] == 0xFF, "R8 is gray");
+
+        ExpandToRGBA8(src.data(), src_pitch, rgba.data(), dst_pitch, width, height, 2, 8, true, false);
+        s = src.data() + 3 * src_pitch + 5 * 2;
+        check(d[0] == s[0] && d[1] == s[0] && d[2] == s[0] && d[3] == s[1], "gray alpha");
+
+        ConvertToRGBA8(PIXEL_FORMAT::RG8, src.data(), src_pitch, rgba.data(), dst_pitch, width, height);
+        check(d[0] == s[0] && d[1] == s[1] && d[2] == 0 && d[3] == 0xFF, "RG8");
+    }
+
+    // 16 bit samples keep their high byte, either endianness
+    {
+        vector<uint8_t> rgba(dst_pitch * height);
+        ConvertToRGBA8(PIXEL_FORMAT::RGBA16, src.data(), src_pitch, rgba.data(), dst_pitch, 20, height);
+        const uint8_t* s = src.data() + 7 * src_pitch + 3 * 8;
+        const uint8_t* d = rgba.data() + 7 * dst_pitch + 3 * 4;
+        check(d[0] == s[1] && d[1] == s[3] && d[2] == s[5] && d[3] == s[7], "RGBA16");
+
+        ExpandToRGBA8(src.data(), src_pitch, rgba.data(), dst_pitch, 20, height, 3, 16, false, true, 0x80);
+        s = src.data() + 7 * src_pitch + 3 * 6;
+        check(d[0] == s[0] && d[1] == s[2] && d[2] == s[4] && d[3] == 0x80, "big endian RGB16");
+    }
+
+    // 5:6:5 widened to the full range
+    {
+        const uint16_t words[4] = { 0x0000, 0xFFFF, 0xF800, 0x07E0 };
+        uint8_t rgba[16];
+        ConvertToRGBA8(PIXEL_FORMAT::R5G6B5, reinterpret_cast<const uint8_t*>(words), 8, rgba, 16, 4, 1);
+        const uint8_t expected[16] = { 0, 0, 0, 255, 255, 255, 255, 255, 255, 0, 0, 255, 0, 255, 0, 255 };
+        check(!memcmp(rgba, expected, 16), "R5G6B5");
+    }
+
+    // BGR rows bottom up, as BMP stores them
+    {
+        vector<uint8_t> rgba(dst_pitch * height);
+        const uint8_t* last_row = src.data() + (height - 1) * src_pitch;
+        ConvertBGRToRGBA8(last_row, -(ptrdiff_t)src_pitch, rgba.data(), dst_pitch, width, height, 3);
+        const uint8_t* s = src.data() + (height - 1 - 2) * src_pitch + 4 * 3;
+        const uint8_t* d = rgba.data() + 2 * dst_pitch + 4 * 4;
+        check(d[0] == s[2] && d[1] == s[1] && d[2] == s[0] && d[3] == 0xFF, "BGR8 bottom up");
+
+        vector<uint8_t> bgra(dst_pitch * height), back(dst_pitch * height);
+        ConvertRGBA8ToBGRA8(src.data(), src_pitch, bgra.data(), dst_pitch, 40, height);
+        ConvertBGRToRGBA8(bgra.data(), dst_pitch, back.data(), dst_pitch, 40, height, 4);
+        check(!memcmp(back.data() + 5 * dst_pitch, src.data() + 5 * src_pitch, 160), "BGRA8 round trip");
+    }
+
+    // sRGB to linear and back, every value survives
+    {
+        vector<uint8_t> values(256);
+        for (int i = 0; i < 256; i++) values[i] = (uint8_t)i;
+        vector<float> linear(256);
+        ConvertSrgbToLinear(values.data(), 256, linear.data(), 256 * sizeof(float), 64, 1, 4);
+        check(linear[0] == 0.0f && fabs(linear[254] - 0.9911f) < 1e-3f && fabs(linear[188] - 0.5029f) < 1e-3f, "sRGB to linear");
+        check(fabs(linear[3] - 3.0f / 255) < 1e-6f && fabs(linear[191] - 191.0f / 255) < 1e-6f, "alpha stays linear");
+
+        vector<uint8_t> srgb(256);
+        ConvertLinearToSrgb(linear.data(), 256 * sizeof(float), srgb.data(), 256, 64, 1, 4);
+        check(srgb == values, "linear to sRGB");
+    }
+
+    // the pixel accessors of Image
+    {
+        Image image;
+        image.Width = width;
+        image.Height = height;
+        image.pixel_format = PIXEL_FORMAT::RGB8;
+        image.bitcount = 24;
+        image.bitdepth = 8;
+        image.pitch = src_pitch;
+        image.data_size = src.size();
+        image.data = new uint8_t[image.data_size];
+        memcpy(image.data, src.data(), src.size());
+        const uint8_t* s = src.data() + 4 * src_pitch + 6 * 3;
+        check(image.GetR(6, 4) == s[0] && image.GetG(6, 4) == s[1] && image.GetB(6, 4) == s[2] && image.GetA(6, 4) == 0xFF,
+              "Image::GetR/G/B/A");
+        check(image.GetR(width, 0) == 0 && image.GetA(0, height) == 0xFF, "outside of the image");
+    }
+
+    // a 24 bit BMP, stored bottom up
+    {
+        const uint32_t bmp_width = 3, bmp_height = 2, row = 12;
+        vector<uint8_t> bmp(54 + row * bmp_height, 0);
+        BITMAP_FILEHEADER file_header = { 0x4D42, (uint32_t)bmp.size(), 0, 54 };
+        BITMAP_HEADER header = { 40, (int32_t)bmp_width, (int32_t)bmp_height, 1, 24, 0, row * bmp_height, 0, 0, 0, 0 };
+        memcpy(bmp.data(), &file_header, sizeof(file_header));
+        memcpy(bmp.data() + 14, &header, sizeof(header));
+        uint8_t* pixels = bmp.data() + 54;
+        pixels[row] = 0x30;          // the top left pixel, blue
+        pixels[row + 2] = 0x10;      // red
+
+        BmpParser parser;
+        Image image = parser.Parse(BufferView(nullptr, bmp.data(), bmp.size()));
+        check(image.data && image.Width == bmp_width && image.Height == bmp_height &&
+              image.data[0] == 0x10 && image.data[1] == 0 && image.data[2] == 0x30 && image.data[3] == 0xFF, "BMP");
+    }
+
+    // 2048x2048 RGB8 to RGBA8
+    {
+        const uint32_t size = 2048;
+        vector<uint8_t> rgb = random_bytes((size_t)size * size * 3);
+        vector<uint8_t> rgba((size_t)size * size * 4);
+
+        auto start = Clock::now();
+        widen_rgb(rgb.data(), size * 3, rgba.data(), size * 4, size, size);
+        double scalar_ms = ms_since(start);
+
+        start = Clock::now();
+        ConvertToRGBA8(PIXEL_FORMAT::RGB8, rgb.data(), size * 3, rgba.data(), size * 4, size, size);
+        double batch_ms = ms_since(start);
+        printf("%ux%u RGB8 to RGBA8: per pixel %.3f ms, batch %.3f ms\n", size, size, scalar_ms, batch_ms);
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "pixel conversion test failed\n" : "pixel conversion test passed\n");
+
+    return failures ? 1 : 0;
+}
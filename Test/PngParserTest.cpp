@@ -0,0 +1,309 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "MemoryManager.h"
+#include "PNG.h"
+#include "lodepng/lodepng.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader*   g_pAssetLoader = new AssetLoader();
+}
+
+// an image of arbitrary samples, encoded with every filter type and the
+// decoded RGBA8 it has to come out as
+struct TestImage
+{
+    uint32_t width, height;
+    uint8_t depth, color_type;
+    bool interlace;
+    bool transparent;           // a tRNS chunk
+    vector<uint16_t> samples;
+    vector<uint8_t> palette;    // RGBA
+    uint16_t key[3];
+};
+
+static uint32_t channels_of(uint8_t color_type)
+{
+    return color_type == 2 ? 3 : color_type == 4 ? 2 : color_type == 6 ? 4 : 1;
+}
+
+static void put_be32(vector<uint8_t>& out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t)(value >> shift));
+}
+
+static void put_chunk(vector<uint8_t>& out, const char* type, const vector<uint8_t>& data)
+{
+    put_be32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_be32(out, (uint32_t)crc32(0, out.data() + start, (uInt)(out.size() - start)));
+}
+
+static uint8_t paeth(int a, int b, int c)
+{
+    int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+    return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+static vector<uint8_t> encode(const TestImage& image)
+{
+    uint32_t channels = channels_of(image.color_type);
+    uint32_t pixel_bits = channels * image.depth;
+    uint32_t bpp = pixel_bits < 8 ? 1 : pixel_bits / 8;
+
+    static const uint32_t adam7[7][4] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+                                          { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+    static const uint32_t whole[1][4] = { { 0, 0, 1, 1 } };
+
+    vector<uint8_t> raw;
+    uint32_t pass_count = image.interlace ? 7 : 1;
+    for (uint32_t pass = 0; pass < pass_count; pass++)
+    {
+        const uint32_t* p = image.interlace ? adam7[pass] : whole[0];
+        if (p[0] >= image.width || p[1] >= image.height) continue;
+        uint32_t w = (image.width - p[0] + p[2] - 1) / p[2];
+        uint32_t h = (image.height - p[1] + p[3] - 1) / p[3];
+        size_t stride = ((size_t)w * pixel_bits + 7) / 8;
+
+        vector<uint8_t> prev(stride, 0);
+        for (uint32_t y = 0; y < h; y++)
+        {
+            vector<uint8_t> row(stride, 0);
+            for (uint32_t x = 0; x < w; x++)
+            {
+                size_t pixel = (size_t)(p[1] + y * p[3]) * image.width + p[0] + x * p[2];
+                for (uint32_t k = 0; k < channels; k++)
+                {
+                    uint16_t value = image.samples[pixel * channels + k];
+                    size_t bit = ((size_t)x * channels + k) * image.depth;
+                    if (image.depth == 16)
+                    {
+                        row[bit / 8] = (uint8_t)(value >> 8);
+                        row[bit / 8 + 1] = (uint8_t)value;
+                    }
+                    else
+                    {
+                        row[bit / 8] |= (uint8_t)(value << (8 - image.depth - bit % 8));
+                    }
+                }
+            }
+
+            uint8_t filter = (uint8_t)((y + pass) % 5);
+            raw.push_back(filter);
+            for (size_t i = 0; i < stride; i++)
+            {
+                int a = i >= bpp ? row[i - bpp] : 0, b = prev[i], c = i >= bpp ? prev[i - bpp] : 0;
+                int predicted = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2 : filter == 4 ? paeth(a, b, c) : 0;
+                raw.push_back((uint8_t)(row[i] - predicted));
+            }
+            prev = row;
+        }
+    }
+
+    vector<uint8_t> compressed(compressBound((uLong)raw.size()));
+    uLongf compressed_size = (uLongf)compressed.size();
+    compress2(compressed.data(), &compressed_size, raw.data(), (uLong)raw.size(), 6);
+    compressed.resize(compressed_size);
+
+    vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    vector<uint8_t> ihdr;
+    put_be32(ihdr, image.width);
+    put_be32(ihdr, image.height);
+    ihdr.insert(ihdr.end(), { image.depth, image.color_type, 0, 0, (uint8_t)(image.interlace ? 1 : 0) });
+    put_chunk(png, "IHDR", ihdr);
+
+    if (image.color_type == 3)
+    {
+        vector<uint8_t> plte, trns;
+        for (size_t i = 0; i < image.palette.size() / 4; i++)
+        {
+            plte.insert(plte.end(), { image.palette[i * 4], image.palette[i * 4 + 1], image.palette[i * 4 + 2] });
+            trns.push_back(image.palette[i * 4 + 3]);
+        }
+        put_chunk(png, "PLTE", plte);
+        if (image.transparent) put_chunk(png, "tRNS", trns);
+    }
+    else if (image.transparent)
+    {
+        vector<uint8_t> trns;
+        for (uint32_t k = 0; k < (image.color_type == 2 ? 3u : 1u); k++)
+            trns.insert(trns.end(), { (uint8_t)(image.key[k] >> 8), (uint8_t)image.key[k] });
+        put_chunk(png, "tRNS", trns);
+    }
+
+    // the image data over two chunks
+    size_t half = compressed.size() / 2;
+    put_chunk(png, "IDAT", vector<uint8_t>(compressed.begin(), compressed.begin() + half));
+    put_chunk(png, "IDAT", vector<uint8_t>(compressed.begin() + half, compressed.end()));
+    put_chunk(png, "IEND", {});
+    return png;
+}
+
+static vector<uint8_t> expected_rgba(const TestImage& image)
+{
+    uint32_t channels = channels_of(image.color_type);
+    uint32_t max = (1u << image.depth) - 1;
+    auto to8 = [&](uint16_t value) { return (uint8_t)(image.depth == 16 ? value >> 8 : value * 255 / max); };
+
+    vector<uint8_t> rgba;
+    for (size_t pixel = 0; pixel < (size_t)image.width * image.height; pixel++)
+    {
+        const uint16_t* s = &image.samples[pixel * channels];
+        switch (image.color_type)
+        {
+            case 0:
+                rgba.insert(rgba.end(), { to8(s[0]), to8(s[0]), to8(s[0]),
+                                          (uint8_t)(image.transparent && s[0] == image.key[0] ? 0 : 255) });
+                break;
+            case 2:
+                rgba.insert(rgba.end(), { to8(s[0]), to8(s[1]), to8(s[2]),
+                                          (uint8_t)(image.transparent && s[0] == image.key[0] && s[1] == image.key[1] &&
+                                                    s[2] == image.key[2] ? 0 : 255) });
+                break;
+            case 3:
+                rgba.insert(rgba.end(), image.palette.begin() + s[0] * 4, image.palette.begin() + s[0] * 4 + 4);
+                if (!image.transparent) rgba.back() = 255;
+                break;
+            case 4:
+                rgba.insert(rgba.end(), { to8(s[0]), to8(s[0]), to8(s[0]), to8(s[1]) });
+                break;
+            case 6:
+                rgba.insert(rgba.end(), { to8(s[0]), to8(s[1]), to8(s[2]), to8(s[3]) });
+                break;
+        }
+    }
+    return rgba;
+}
+
+static TestImage make_image(uint8_t color_type, uint8_t depth, bool interlace, bool transparent)
+{
+    TestImage image = {};
+    image.width = 37;
+    image.height = 23;
+    image.depth = depth;
+    image.color_type = color_type;
+    image.interlace = interlace;
+    image.transparent = transparent;
+
+    uint32_t max = (1u << depth) - 1;
+    uint32_t channels = channels_of(color_type);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < (size_t)image.width * image.height * channels; i++)
+    {
+        // smooth in places, noisy in others, so every filter gets work
+        seed = seed * 1103515245 + 12345;
+        uint32_t pixel = (uint32_t)(i / channels);
+        uint32_t value = pixel % 3 ? (pixel * 7 + (uint32_t)(i % channels) * 50) : (seed >> 8);
+        image.samples.push_back((uint16_t)(value & max));
+    }
+    image.key[0] = image.samples[0];
+    image.key[1] = image.samples[channels > 1 ? 1 : 0];
+    image.key[2] = image.samples[channels > 2 ? 2 : 0];
+
+    if (color_type == 3)
+    {
+        for (uint32_t i = 0; i <= max; i++)
+            image.palette.insert(image.palette.end(), { (uint8_t)(i * 3), (uint8_t)(255 - i), (uint8_t)(i * 11), (uint8_t)(i * 5) });
+    }
+    return image;
+}
+
+int main(int argc, const char** argv)
+{
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+    // every color type and bit depth, with and without interlacing
+    {
+        const pair<uint8_t, vector<uint8_t>> formats[] = {
+            { 0, { 1, 2, 4, 8, 16 } }, { 2, { 8, 16 } }, { 3, { 1, 2, 4, 8 } }, { 4, { 8, 16 } }, { 6, { 8, 16 } } };
+        for (auto& format : formats)
+        {
+            for (uint8_t depth : format.second)
+            {
+                for (int variant = 0; variant < 4; variant++)
+                {
+                    TestImage image = make_image(format.first, depth, variant & 1, (variant & 2) != 0);
+                    vector<uint8_t> png = encode(image);
+
+                    PngParser parser;
+                    parser.SetPitchAlignment(256);
+                    Image decoded = parser.Parse(BufferView(nullptr, png.data(), png.size()));
+                    vector<uint8_t> expected = expected_rgba(image);
+                    bool same = decoded.data && decoded.pixel_format == PIXEL_FORMAT::RGBA8 &&
+                                decoded.Width == image.width && decoded.Height == image.height && decoded.pitch == 256;
+                    for (uint32_t y = 0; same && y < image.height; y++)
+                        same = !memcmp(decoded.data + y * decoded.pitch, expected.data() + (size_t)y * image.width * 4, image.width * 4);
+
+                    char what[96];
+                    snprintf(what, sizeof(what), "color type %u, %u bits%s%s", format.first, depth,
+                             variant & 1 ? ", interlaced" : "", variant & 2 ? ", transparent" : "");
+                    check(same, what);
+                }
+            }
+        }
+
+        // broken data
+        vector<uint8_t> png = encode(make_image(6, 8, false, false));
+        PngParser parser;
+        check(!parser.Parse(BufferView(nullptr, png.data(), png.size() / 2)).data, "truncated data");
+        png[24] = 3;
+        check(!parser.Parse(BufferView(nullptr, png.data(), png.size())).data, "bit depth of no color type");
+    }
+
+    // the assets, the same pixels as lodepng
+    {
+        vector<string> files = { "Textures/Spheres_BaseColor.png", "Textures/SciFiHelmet_AmbientOcclusion.png",
+                                 "Textures/Corona.png", "Textures/test.png" };
+        if (argc >= 2) files.assign(argv + 1, argv + argc);
+        for (auto& file : files)
+        {
+            BufferView data = g_pAssetLoader->MapFile(file.c_str());
+            if (data.IsEmpty())
+            {
+                printf("%s not found, run the test below the project directory\n", file.c_str());
+                failures++;
+                continue;
+            }
+
+            // the way it was decoded before: lodepng into a vector, copied again
+            auto start = Clock::now();
+            vector<unsigned char> reference;
+            unsigned width = 0, height = 0;
+            lodepng::State state;
+            unsigned error = lodepng::decode(reference, width, height, state, data.GetData(), data.GetDataSize());
+            uint8_t* copy = new uint8_t[reference.size()];
+            for (size_t i = 0; i < reference.size(); i++) copy[i] = reference[i];
+            double lodepng_ms = ms_since(start);
+            delete[] copy;
+
+            start = Clock::now();
+            PngParser parser;
+            Image image = parser.Parse(data);
+            double parser_ms = ms_since(start);
+
+            check(!error && image.data && image.Width == width && image.Height == height &&
+                  image.data_size == reference.size() && !memcmp(image.data, reference.data(), reference.size()), file.c_str());
+            printf("%s %ux%u: lodepng and a copy %.3f ms, PngParser %.3f ms\n", file.c_str(), width, height, lodepng_ms, parser_ms);
+        }
+    }
+
+    g_pAssetLoader->Finalize();
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "png parser test failed\n" : "png parser test passed\n");
+
+    return failures ? 1 : 0;
+}
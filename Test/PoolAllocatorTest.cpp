@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "PoolAllocator.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+static size_t live_bytes(MemoryTag tag)
+{
+    return g_pMemoryManager->GetTagStats(tag).szLiveBytes;
+}
+
+static void test_containers()
+{
+    {
+        pooled::vector<int, MemoryTag::Scene> numbers;
+        for (int i = 0; i < 1000; i++) numbers.push_back(i);
+        check(numbers[999] == 999, "vector");
+        check(live_bytes(MemoryTag::Scene) == numbers.capacity() * sizeof(int), "vector accounted to its tag");
+
+        pooled::list<int, MemoryTag::Scene> linked(numbers.begin(), numbers.end());
+        check(linked.size() == 1000 && linked.back() == 999, "list");
+
+        pooled::unordered_map<string, int, MemoryTag::Mesh> lookup;
+        for (int i = 0; i < 1000; i++) lookup["node_" + to_string(i)] = i;
+        check(lookup.at("node_500") == 500, "unordered_map");
+        check(live_bytes(MemoryTag::Mesh) > 1000 * sizeof(int), "map nodes accounted to its tag");
+
+        pooled::string text("a string that does not fit into the small string buffer");
+        text += text;
+        check(text.size() == 110, "string");
+    }
+
+    check(live_bytes(MemoryTag::Scene) == 0 && live_bytes(MemoryTag::Mesh) == 0, "containers give everything back");
+
+    // out of memory throws like std::allocator, the containers never see nullptr
+    bool thrown = false;
+    try
+    {
+        PoolAllocator<char, MemoryTag::Scene>().allocate(size_t(1) << 60);
+    }
+    catch (const bad_alloc&)
+    {
+        thrown = true;
+    }
+    check(thrown, "bad_alloc when out of memory");
+    check(live_bytes(MemoryTag::Scene) == 0, "failed allocation is not accounted");
+}
+
+// a scene load: name lookup tables filled and torn down
+template<typename Map>
+static double fill_maps()
+{
+    auto start = chrono::high_resolution_clock::now();
+    for (int round = 0; round < 20; round++)
+    {
+        Map nodes;
+        for (int i = 0; i < 5000; i++) nodes[i] = i;
+    }
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / 20;
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    test_containers();
+
+    double pool = fill_maps<pooled::unordered_map<int, int>>();
+    double sys = fill_maps<unordered_map<int, int>>();
+    printf("5000 map nodes: PoolAllocator %.3f ms, std::allocator %.3f ms\n", pool, sys);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    printf(failures ? "pool allocator test failed\n" : "pool allocator test passed\n");
+
+    return failures ? 1 : 0;
+}
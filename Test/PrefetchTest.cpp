@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static LoadTraceEntry entry(const char* name, size_t offset = 0, size_t size = 0)
+{
+    LoadTraceEntry e;
+    e.name = name;
+    e.szOffset = offset;
+    e.szSize = size;
+    return e;
+}
+
+typedef chrono::high_resolution_clock Clock;
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    filesystem::path root = filesystem::temp_directory_path() / "PrefetchTest";
+    filesystem::remove_all(root);
+    write_file(root / "Asset" / "Scene" / "test.gltf", pattern(1000));
+    write_file(root / "Asset" / "Scene" / "test.bin", pattern(256 * 1024));
+    write_file(root / "Asset" / "Textures" / "a.png", pattern(64 * 1024));
+    write_file(root / "Asset" / "Textures" / "b.png", pattern(64 * 1024));
+    write_file(root / "Asset" / "Stream" / "lod.bin", pattern(128 * 1024));
+
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    g_pAssetLoader->SetStreamingBudget(0, 0.0);
+    g_pAssetLoader->Initialize();
+
+    vector<LoadTraceEntry> expected = {
+        entry("Scene/test.gltf"),
+        entry("Scene/test.bin"),
+        entry("Textures/a.png"),
+        entry("Stream/lod.bin", 4096, 8192),
+        entry("Stream/lod.bin", 65536, 0),
+        entry("Textures/b.png"),
+    };
+
+    // what one load reads, in order, each file once
+    vector<LoadTraceEntry> trace;
+    {
+        g_pAssetLoader->MapFile("Scene/missing.bin");
+        g_pAssetLoader->BeginLoadTrace();
+
+        g_pAssetLoader->MapFile("Scene/test.gltf");
+        g_pAssetLoader->MapFile("Scene/missing.bin");
+        Buffer bin = g_pAssetLoader->SyncOpenAndReadBinary("Scene/test.bin");
+        AsyncReadHandle a = g_pAssetLoader->AsyncRead("Textures/a.png");
+        StreamingRead range;
+        range.szOffset = 4096;
+        range.szSize = 8192;
+        AsyncReadHandle lod = g_pAssetLoader->StreamRead("Stream/lod.bin", range);
+        AsyncReadHandle again = g_pAssetLoader->StreamRead("Stream/lod.bin", range);
+        StreamingRead tail;
+        tail.szOffset = 65536;
+        AsyncReadHandle rest = g_pAssetLoader->StreamRead("Stream/lod.bin", tail);
+        g_pAssetLoader->MapFile("Scene/./test.gltf");
+        g_pAssetLoader->Tick();
+        a.Wait();
+        lod.Wait();
+        again.Wait();
+        rest.Wait();
+        g_pAssetLoader->MapFile("Textures/b.png");
+
+        trace = g_pAssetLoader->EndLoadTrace();
+        g_pAssetLoader->MapFile("Textures/b.png");
+        g_pAssetLoader->Tick();
+
+        check(trace == expected, "ordered files and ranges, each once");
+        check(g_pAssetLoader->EndLoadTrace().empty(), "nothing recorded after the trace");
+    }
+
+    // saved next to the scene and read back
+    {
+        vector<LoadTraceEntry> manifest;
+        check(!g_pAssetLoader->ReadLoadManifest("Scene/test.gltf", manifest), "no manifest before the first load");
+        check(g_pAssetLoader->WriteLoadManifest("Scene/test.gltf", trace), "write");
+        check(filesystem::exists(root / "Asset" / "Scene" / "test.gltf.prefetch"), "next to the scene");
+        check(g_pAssetLoader->ReadLoadManifest("Scene/test.gltf", manifest) && manifest == trace, "read back");
+    }
+
+    // the manifest drives the read ahead, whatever is gone is skipped
+    {
+        vector<LoadTraceEntry> manifest = trace;
+        manifest.push_back(entry("Textures/deleted.png"));
+        manifest.push_back(entry("Stream/lod.bin", 1024 * 1024, 0));
+
+        auto start = Clock::now();
+        size_t bytes = g_pAssetLoader->Prefetch(manifest);
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+        size_t expected_bytes = 1000 + 256 * 1024 + 64 * 1024 + 8192 + 64 * 1024 + 64 * 1024;
+        check(bytes == expected_bytes, "bytes read ahead");
+        printf("prefetch of %zu bytes issued in %.3f ms\n", bytes, ms);
+    }
+
+    // packed files are read ahead within the pack, packed manifests are read too
+    {
+        AssetPackWriter writer;
+        writer.AddFile("Packed/scene.gltf", g_pAssetLoader->MapFile("Scene/test.gltf"), false);
+        writer.AddFile("Packed/scene.bin", g_pAssetLoader->MapFile("Scene/test.bin"), false);
+        writer.AddFile("Packed/scene.gltf.prefetch", BufferView(vector<uint8_t>(
+            { 'C', 'P', 'R', 'E', 'F', 'E', 'T', 'C', 'H', ' ', '1', '\n',
+              '0', ' ', '0', ' ', 'P', 'a', 'c', 'k', 'e', 'd', '/', 's', 'c', 'e', 'n', 'e', '.', 'b', 'i', 'n', '\n' })), false);
+        check(writer.Write((root / "Asset" / "Scene.cpk").string().c_str()), "write pack");
+        check(g_pAssetLoader->MountPack("Scene.cpk"), "mount");
+
+        vector<LoadTraceEntry> manifest;
+        check(g_pAssetLoader->ReadLoadManifest("Packed/scene.gltf", manifest) &&
+              manifest == vector<LoadTraceEntry>({ entry("Packed/scene.bin") }), "packed manifest");
+        check(g_pAssetLoader->Prefetch(manifest) == 256 * 1024, "packed entry read ahead");
+        check(g_pAssetLoader->Prefetch({ entry("Packed/scene.bin", 1000, 24) }) == 24, "range of a packed entry");
+        check(!g_pAssetLoader->WriteLoadManifest("Packed/scene.gltf", manifest), "packs are read only");
+    }
+
+    g_pAssetLoader->Finalize();
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "prefetch test failed\n" : "prefetch test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "ImageCache.h"
+#include "GLTF.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+    ImageCache* g_pImageCache = new ImageCache();
+}
+
+typedef chrono::high_resolution_clock Clock;
+
+// the images of every material slot, in order
+static vector<uint64_t> texture_hashes(const shared_ptr<Scene>& pScene)
+{
+    vector<uint64_t> hashes;
+    for (auto& weak_material : pScene->LinearMaterials)
+    {
+        auto pMaterial = weak_material.lock();
+        if (!pMaterial) continue;
+        for (auto& pTexture : pMaterial->Textures)
+        {
+            if (!pTexture) continue;
+            Image& image = pTexture->GetTextureImage();
+            hashes.push_back(image.data ? BuildCache::HashContent(image.data, image.data_size) : 0);
+        }
+    }
+    return hashes;
+}
+
+static shared_ptr<Scene> load(const string& scene, uint32_t threads, size_t budget, double& ms)
+{
+    // decoded again every time
+    g_pImageCache->Clear();
+
+    GltfParser parser;
+    parser.SetDecodeThreads(threads);
+    if (budget) parser.SetDecodeMemoryBudget(budget);
+    auto start = Clock::now();
+    shared_ptr<Scene> pScene = parser.Parse(scene);
+    ms = chrono::duration<double, milli>(Clock::now() - start).count();
+    return pScene;
+}
+
+int main(int argc, char** argv)
+{
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->SetBuildCacheDirectory("");
+    g_pAssetLoader->Initialize();
+    g_pImageCache->Initialize();
+
+    string scene = argc >= 2 ? argv[1] : "Scene/DamagedHelmet/DamagedHelmet.gltf";
+    if (!g_pAssetLoader->FileExists(scene.c_str()))
+    {
+        printf("scene not found, run the test below the project directory\n");
+        return 1;
+    }
+
+    // the decode threads allocate from the pools as the memory manager starts up
+    check(g_pMemoryManager->IsThreadSafe(), "the memory manager starts thread-safe");
+
+    // the same images in the same slots, however many threads decode them
+    double ms;
+    vector<uint64_t> expected = texture_hashes(load(scene, 1, 0, ms));
+    printf("%s, 1 thread: %.1f ms\n", scene.c_str(), ms);
+    check(!expected.empty(), "textures");
+    for (uint32_t threads : { 2u, 4u, 8u })
+    {
+        check(texture_hashes(load(scene, threads, 0, ms)) == expected, "same images with more threads");
+        printf("%s, %u threads: %.1f ms\n", scene.c_str(), threads, ms);
+    }
+
+    // an image larger than the budget still decodes, one at a time
+    check(texture_hashes(load(scene, 4, 1, ms)) == expected, "same images one at a time");
+
+    g_pImageCache->Finalize();
+    g_pAssetLoader->Finalize();
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pImageCache;
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "scene decode test failed\n" : "scene decode test passed\n");
+
+    return failures ? 1 : 0;
+}
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include "AssetLoader.h"
+#include "ImageCache.h"
 #include "MemoryManager.h"
 #include "SceneManager.h"
 
@@ -10,6 +11,7 @@ using namespace std;
 namespace Corona {
 	MemoryManager* g_pMemoryManager = new MemoryManager();
 	AssetLoader* g_pAssetLoader = new AssetLoader();
+	ImageCache* g_pImageCache = new ImageCache();
 	SceneManager* g_pSceneManager = new SceneManager();
 }
 
@@ -29,6 +31,7 @@ int main(int argc, char** argv)
 	g_pMemoryManager->Initialize();
 	g_pSceneManager->Initialize();
 	g_pAssetLoader->Initialize();
+	g_pImageCache->Initialize();
 
 	if (argc >= 2) {
 		g_pSceneManager->LoadScene(argv[1]);
@@ -106,10 +109,12 @@ int main(int argc, char** argv)
 // 	}
 
 	g_pSceneManager->Finalize();
+	g_pImageCache->Finalize();
 	g_pAssetLoader->Finalize();
 	g_pMemoryManager->Finalize();
 
 	delete g_pSceneManager;
+	delete g_pImageCache;
 	delete g_pAssetLoader;
 	delete g_pMemoryManager;
 
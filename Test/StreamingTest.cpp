@@ -0,0 +1,219 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetLoader.h"
+#include "TestUtil.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+    AssetLoader* g_pAssetLoader = new AssetLoader();
+}
+
+static const size_t kFileSize = 64 * 1024;
+
+// byte i of a file is (i + seed) % 251, so every range can be checked
+static bool has_range(const AsyncReadHandle& handle, size_t offset, size_t size, uint32_t seed)
+{
+    const BufferView& data = handle.GetData();
+    if (data.GetDataSize() != size) return false;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data.GetData()[i] != (uint8_t)((offset + i + seed) % 251)) return false;
+    }
+    return true;
+}
+
+static void wait_all(vector<AsyncReadHandle>& handles)
+{
+    for (auto& handle : handles) handle.Wait();
+}
+
+static void run(AssetLoader::IoBackend backend, const filesystem::path& root)
+{
+    g_pAssetLoader->SetIoBackend(backend);
+    g_pAssetLoader->AddSearchPath(root.string().c_str());
+    g_pAssetLoader->SetStreamingBudget(0, 0.0);
+    g_pAssetLoader->Initialize();
+
+    StreamingStats base = g_pAssetLoader->GetStreamingStats();
+
+    // bytes per frame, by priority
+    {
+        g_pAssetLoader->SetStreamingBudget(2 * kFileSize, 0.0);
+
+        vector<int> completed;
+        vector<AsyncReadHandle> handles;
+        for (int i = 0; i < 8; i++)
+        {
+            StreamingRead read;
+            read.nPriority = i;
+            handles.push_back(g_pAssetLoader->StreamRead(("Stream/mesh_" + to_string(i) + ".bin").c_str(), read,
+                [&completed, i](const AsyncReadHandle& handle) {
+                    // the completion hands over the read with its data
+                    if (has_range(handle, 0, kFileSize, i)) completed.push_back(i);
+                }));
+        }
+        check(g_pAssetLoader->GetStreamingStats().nQueued == 8, "queued until Tick");
+
+        g_pAssetLoader->Tick();
+        StreamingStats stats = g_pAssetLoader->GetStreamingStats();
+        check(stats.nQueued == 6 && stats.szBytesLastFrame == 2 * kFileSize, "two files per frame");
+        // waiting on a read still held back would issue it
+        handles[7].Wait();
+        handles[6].Wait();
+        check(g_pAssetLoader->GetStreamingStats().nQueued == 6, "the highest priorities go first");
+
+        for (int frame = 0; frame < 8 && completed.size() < 8; frame++)
+        {
+            handles[7 - 2 * frame].Wait();
+            handles[6 - 2 * frame].Wait();
+            g_pAssetLoader->Tick();
+        }
+        check(completed == vector<int>({ 7, 6, 5, 4, 3, 2, 1, 0 }), "delivered by priority");
+        check(has_range(handles[3], 0, kFileSize, 3), "whole file content");
+    }
+
+    // a read due now is issued ahead of the budget and of higher priorities
+    {
+        g_pAssetLoader->SetStreamingBudget(1, 0.0);
+
+        StreamingRead high;
+        high.nPriority = 100;
+        StreamingRead urgent;
+        urgent.nPriority = -100;
+        urgent.fDeadlineMs = 1.0;
+        AsyncReadHandle a = g_pAssetLoader->StreamRead("Stream/mesh_0.bin", high);
+        AsyncReadHandle b = g_pAssetLoader->StreamRead("Stream/mesh_1.bin", urgent);
+        this_thread::sleep_for(chrono::milliseconds(2));
+
+        g_pAssetLoader->Tick();
+        b.Wait();
+        check(g_pAssetLoader->GetStreamingStats().nQueued == 1 && a.GetState() == AsyncReadState::Queued, "deadline first");
+        g_pAssetLoader->Tick();
+        a.Wait();
+        g_pAssetLoader->Tick();
+        check(g_pAssetLoader->GetStreamingStats().nMissedDeadlines == base.nMissedDeadlines + 1, "missed deadline counted");
+    }
+
+    // adjacent ranges of one file become one read
+    {
+        g_pAssetLoader->SetStreamingBudget(0, 0.0);
+        uint64_t issued = g_pAssetLoader->GetStreamingStats().nIssuedReads;
+        uint64_t merged = g_pAssetLoader->GetStreamingStats().nMergedReads;
+
+        vector<AsyncReadHandle> handles;
+        for (size_t i = 0; i < 4; i++)
+        {
+            StreamingRead read;
+            read.szOffset = i * 4096;
+            read.szSize = 4096;
+            handles.push_back(g_pAssetLoader->StreamRead("Stream/mesh_5.bin", read));
+        }
+        StreamingRead tail;
+        tail.szOffset = kFileSize - 100;
+        tail.szSize = 1000;
+        handles.push_back(g_pAssetLoader->StreamRead("Stream/mesh_5.bin", tail));
+        StreamingRead other;
+        other.szSize = 4096;
+        handles.push_back(g_pAssetLoader->StreamRead("Stream/mesh_6.bin", other));
+
+        g_pAssetLoader->Tick();
+        wait_all(handles);
+        g_pAssetLoader->Tick();
+
+        StreamingStats stats = g_pAssetLoader->GetStreamingStats();
+        check(stats.nIssuedReads == issued + 3 && stats.nMergedReads == merged + 3, "four ranges merged into one read");
+        bool ranges = true;
+        for (size_t i = 0; i < 4; i++) ranges = ranges && has_range(handles[i], i * 4096, 4096, 5);
+        check(ranges, "each range gets its own part");
+        check(has_range(handles[4], kFileSize - 100, 100, 5), "range clipped at the end of the file");
+        check(has_range(handles[5], 0, 4096, 6), "other file");
+    }
+
+    // callbacks within the decode budget, at least one per frame
+    {
+        g_pAssetLoader->SetStreamingBudget(0, 3.0);
+
+        int delivered = 0;
+        vector<AsyncReadHandle> handles;
+        for (int i = 0; i < 6; i++)
+        {
+            handles.push_back(g_pAssetLoader->StreamRead(("Stream/mesh_" + to_string(i) + ".bin").c_str(), StreamingRead(),
+                [&delivered](const AsyncReadHandle& ) {
+                    this_thread::sleep_for(chrono::milliseconds(2));
+                    delivered++;
+                }));
+        }
+
+        // issued by Wait(), all of them are read before the next Tick()
+        wait_all(handles);
+        g_pAssetLoader->Tick();
+        StreamingStats stats = g_pAssetLoader->GetStreamingStats();
+        check(delivered == 2 && stats.nCompleted == 4, "decode budget per frame");
+        check(stats.fDecodeMsLastFrame >= 3.0, "decode time measured");
+
+        for (int frame = 0; frame < 6 && delivered < 6; frame++) g_pAssetLoader->Tick();
+        check(delivered == 6, "the rest in later frames");
+    }
+
+    // waiting on a read the scheduler holds back, cancelling one
+    {
+        g_pAssetLoader->SetStreamingBudget(1, 0.0);
+
+        bool called = false;
+        AsyncReadHandle a = g_pAssetLoader->StreamRead("Stream/mesh_2.bin", StreamingRead());
+        AsyncReadHandle b = g_pAssetLoader->StreamRead("Stream/mesh_3.bin", StreamingRead(), [&called](const AsyncReadHandle& ) { called = true; });
+        AsyncReadHandle missing = g_pAssetLoader->StreamRead("Stream/missing.bin", StreamingRead());
+        b.Cancel();
+        a.Wait();
+        check(has_range(a, 0, kFileSize, 2), "Wait() issues the read");
+
+        missing.Wait();
+        check(missing.GetState() == AsyncReadState::Failed, "missing file");
+
+        for (int frame = 0; frame < 4; frame++) g_pAssetLoader->Tick();
+        check(!called && b.GetState() == AsyncReadState::Cancelled, "cancelled");
+        check(g_pAssetLoader->GetStreamingStats().nQueued == 0, "queue drained");
+    }
+
+    StreamingStats stats = g_pAssetLoader->GetStreamingStats();
+    printf("%s: %llu reads for %llu requests, latency avg %.3f ms, max %.3f ms\n",
+           backend == AssetLoader::IoBackend::IoUring ? "io_uring" : "stdio",
+           (unsigned long long)(stats.nIssuedReads - base.nIssuedReads),
+           (unsigned long long)(stats.nIssuedReads - base.nIssuedReads + stats.nMergedReads - base.nMergedReads),
+           stats.fAverageLatencyMs, stats.fMaxLatencyMs);
+    check(stats.nInFlight == 0, "nothing left in flight");
+
+    g_pAssetLoader->Finalize();
+}
+
+int main(int , char** )
+{
+    g_pMemoryManager->Initialize();
+
+    filesystem::path root = filesystem::temp_directory_path() / "StreamingTest";
+    filesystem::remove_all(root);
+    for (uint32_t i = 0; i < 8; i++)
+        write_file(root / "Asset" / "Stream" / ("mesh_" + to_string(i) + ".bin"), pattern(kFileSize, i));
+
+    run(AssetLoader::IoBackend::Stdio, root);
+    if (g_pAssetLoader->SetIoBackend(AssetLoader::IoBackend::IoUring))
+        run(AssetLoader::IoBackend::IoUring, root);
+
+    filesystem::remove_all(root);
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pAssetLoader;
+    delete g_pMemoryManager;
+
+    printf(failures ? "streaming test failed\n" : "streaming test passed\n");
+
+    return failures ? 1 : 0;
+}
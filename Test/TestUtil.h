@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Helpers shared by the test programs, each of them is a single translation
+// unit: count the failed checks and print "... test passed/failed" from main().
+
+inline int failures = 0;
+
+inline void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+typedef std::chrono::high_resolution_clock Clock;
+
+inline double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// bytes that tell the files and their offsets apart
+inline std::vector<uint8_t> pattern(size_t size, uint32_t seed = 0)
+{
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++) bytes[i] = (uint8_t)((i + seed) % 251);
+    return bytes;
+}
+
+// creates the directories on the way
+inline void write_file(const std::filesystem::path& path, const void* data, size_t size)
+{
+    std::filesystem::create_directories(path.parent_path());
+    FILE* fp = fopen(path.string().c_str(), "wb");
+    if (size) fwrite(data, 1, size, fp);
+    fclose(fp);
+}
+
+inline void write_file(const std::filesystem::path& path, const std::string& content)
+{
+    write_file(path, content.data(), content.size());
+}
+
+inline void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& bytes)
+{
+    write_file(path, bytes.data(), bytes.size());
+}
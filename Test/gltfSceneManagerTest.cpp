@@ -1,4 +1,7 @@
+#include <cstdio>
+#include <filesystem>
 #include "AssetLoader.h"
+#include "ImageCache.h"
 #include "MemoryManager.h"
 #include "SceneManager.h"
 
@@ -8,6 +11,7 @@ namespace Corona
 {
 	MemoryManager* g_pMemoryManager = static_cast<MemoryManager*>(new MemoryManager);
 	AssetLoader* g_pAssetLoader = static_cast<AssetLoader*>(new AssetLoader);
+	ImageCache* g_pImageCache = static_cast<ImageCache*>(new ImageCache);
 	SceneManager* g_pSceneManager = static_cast<SceneManager*>(new SceneManager);
 }
 
@@ -16,10 +20,24 @@ int main()
 	g_pMemoryManager->Initialize();
 	g_pSceneManager->Initialize();
 	g_pAssetLoader->Initialize();
+	g_pImageCache->Initialize();
 
 	g_pSceneManager->LoadScene("Scene/Box.glb");
 	auto& scene = g_pSceneManager->GetSceneForRendering();
 
+	// a scene file saved halfway, as a hot reload may see it, keeps the scene
+	std::filesystem::path root = std::filesystem::temp_directory_path() / "gltfSceneManagerTest";
+	std::filesystem::create_directories(root / "Asset" / "Scene");
+	FILE* fp = fopen((root / "Asset" / "Scene" / "Broken.gltf").string().c_str(), "wb");
+	fputs("{ \"asset\": { \"version\": ", fp);
+	fclose(fp);
+	g_pAssetLoader->AddSearchPath(root.string().c_str());
+
+	size_t nodes = scene.GeometryNodes.size();
+	g_pSceneManager->LoadScene("Scene/Broken.gltf");
+	bool kept = &g_pSceneManager->GetSceneForRendering() == &scene && scene.GeometryNodes.size() == nodes;
+	std::filesystem::remove_all(root);
+
 // 	cout << "Dump of Cameras" << endl;
 // 	cout << "---------------------------" << endl;
 // 	weak_ptr<SceneObjectCamera> pCamera = scene.GetFirstCamera();
@@ -41,13 +59,17 @@ int main()
 
 
 	g_pSceneManager->Finalize();
+	g_pImageCache->Finalize();
 	g_pAssetLoader->Finalize();
 	g_pMemoryManager->Finalize();
 
 	delete g_pSceneManager;
+	delete g_pImageCache;
 	delete g_pAssetLoader;
 	delete g_pMemoryManager;
 
-	return 0;
+	printf(kept ? "gltf scene manager test passed\n" : "FAILED: a broken scene file replaced the scene\n");
+
+	return kept ? 0 : 1;
 }
 
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "FileMapping.h"
+
+using namespace std;
+using namespace Corona;
+
+namespace Corona {
+    MemoryManager* g_pMemoryManager = new MemoryManager();
+}
+
+// Packs a directory (usually Asset/) into a Corona pack for AssetLoader::MountPack().
+// usage: AssetPacker [--compress] [--level 1-9] [--cache <directory>] <directory> <pack.cpk>
+// With a cache, files compressed by an earlier run are not compressed again.
+
+// formats that are compressed already, zlib only burns time on them
+static bool is_compressed_format(const filesystem::path& path)
+{
+    string ext = path.extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower(c); });
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".cpk";
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = false;
+    bool usage = false;
+    int level = 6;
+    const char* cache = nullptr;
+    vector<const char*> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--compress")) compress = true;
+        else if (!strcmp(argv[i], "--level") && i + 1 < argc) level = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--cache") && i + 1 < argc) cache = argv[++i];
+        else if (argv[i][0] != '-') paths.push_back(argv[i]);
+        else usage = true;
+    }
+
+    if (usage || paths.size() != 2 || level < 1 || level > 9)
+    {
+        fprintf(stderr, "usage: %s [--compress] [--level 1-9] [--cache <directory>] <directory> <pack.cpk>\n", argv[0]);
+        return 1;
+    }
+
+    filesystem::path root = paths[0];
+    if (!filesystem::is_directory(root))
+    {
+        fprintf(stderr, "'%s' is no directory\n", paths[0]);
+        return 1;
+    }
+
+    g_pMemoryManager->Initialize();
+
+    // sorted, so the same tree always gives the same pack
+    vector<filesystem::path> files;
+    for (auto& entry : filesystem::recursive_directory_iterator(root))
+    {
+        if (entry.is_regular_file() && entry.path().filename() != "CMakeLists.txt") files.push_back(entry.path());
+    }
+    sort(files.begin(), files.end());
+
+    BuildCache build_cache;
+    if (cache && !build_cache.Open(cache)) return 1;
+
+    AssetPackWriter writer;
+    if (cache) writer.SetBuildCache(&build_cache);
+    size_t total = 0;
+    for (auto& file : files)
+    {
+        string name = file.lexically_relative(root).generic_string();
+
+        // the writer keeps the views, the files stay mapped until the pack is written
+        BufferView data;
+        auto pMapping = make_shared<FileMapping>();
+        if (pMapping->Open(file.string().c_str()))
+        {
+            const uint8_t* pData = pMapping->GetData();
+            size_t size = pMapping->GetDataSize();
+            data = BufferView(std::move(pMapping), pData, size);
+        }
+        else if (filesystem::file_size(file) != 0)
+        {
+            fprintf(stderr, "Cannot read '%s'\n", file.string().c_str());
+            return 1;
+        }
+
+        total += data.GetDataSize();
+        writer.AddFile(name, data, compress && !is_compressed_format(file));
+    }
+
+    if (!writer.Write(paths[1], level)) return 1;
+
+    AssetPack pack;
+    if (!pack.Open(paths[1])) return 1;
+
+    uint32_t compressed = 0;
+    for (uint32_t i = 0; i < pack.GetEntryCount(); i++)
+    {
+        if (pack.GetEntry(i).nFlags & PACK_ENTRY_ZLIB) compressed++;
+    }
+
+    printf("%u files (%u compressed), %.1f MB -> %.1f MB in %s\n", pack.GetEntryCount(), compressed,
+           total / (1024.0 * 1024.0), filesystem::file_size(paths[1]) / (1024.0 * 1024.0), paths[1]);
+    if (cache)
+        printf("%llu compressed files taken from the cache\n", (unsigned long long)build_cache.GetStats().nHits);
+
+    g_pMemoryManager->Finalize();
+    delete g_pMemoryManager;
+
+    return 0;
+}